@@ -0,0 +1,675 @@
+/******************************************************************************
+
+ @file       ant_config.c
+
+ @brief Runtime antenna array configuration for the AoA Receiver.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+
+#include <icall.h>
+#include "icall_ble_api.h"
+
+#include "ant_config.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// No array is being loaded
+#define ANT_CONFIG_NO_ARRAY                   0xFF
+
+// Words holding an AoA_Pattern followed by its toggles
+#define ANT_CONFIG_PATTERN_WORDS              ((sizeof(AoA_Pattern) + ANT_CONFIG_MAX_PATTERNS * sizeof(uint32_t) + 3) / 4)
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// SNV items, must stay below the 255 byte item limit
+typedef struct
+{
+  uint8_t version;            // ANT_CONFIG_NV_VERSION, 0 if erased
+  AntConfig_Desc desc;
+} AntConfig_NvItem;
+
+typedef struct
+{
+  uint8_t version;            // ANT_CONFIG_NV_VERSION, 0 if erased
+  AntConfig_Geometry geometry;
+} AntConfig_NvGeometry;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Pins the patterns may drive
+static uint32_t antPinMask;
+
+// Built-in configuration of each array
+static AoA_AntennaConfig *antBuiltin[ANT_CONFIG_NUM_ARRAYS];
+
+// Active configuration of each array
+static uint32_t antPatterns[ANT_CONFIG_NUM_ARRAYS][ANT_CONFIG_PATTERN_WORDS];
+static AoA_AntennaPair antPairs[ANT_CONFIG_NUM_ARRAYS][ANT_CONFIG_MAX_PAIRS];
+static AoA_AntennaConfig antConfigs[ANT_CONFIG_NUM_ARRAYS];
+static uint8_t antSource[ANT_CONFIG_NUM_ARRAYS];
+static AoAEst_Geometry antSolvers[ANT_CONFIG_NUM_ARRAYS];
+
+// Result buffers of each array
+static uint32_t antSignalStrength[ANT_CONFIG_NUM_ARRAYS][ANT_CONFIG_MAX_PAIRS];
+static int16_t antPairAngle[ANT_CONFIG_NUM_ARRAYS][ANT_CONFIG_MAX_PAIRS];
+static AoA_AntennaResult antResults[ANT_CONFIG_NUM_ARRAYS];
+
+// Load in progress, with one bit per pattern and pair received
+static AntConfig_Desc antPending;
+static uint8_t antPendingArray = ANT_CONFIG_NO_ARRAY;
+static uint32_t antPendingPatterns;
+static uint8_t antPendingPairs;
+static AntConfig_Geometry antPendingGeometry;
+
+// SNV transfer buffers, too large for the caller's stack
+static AntConfig_NvItem antNvItem;
+static AntConfig_NvGeometry antNvGeometry;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void AntConfig_fromBuiltin(const AoA_AntennaConfig *pConfig, AntConfig_Desc *pDesc);
+static bool AntConfig_validate(const AntConfig_Desc *pDesc);
+static void AntConfig_apply(uint8_t array, const AntConfig_Desc *pDesc,
+                            const AntConfig_Geometry *pGeometry);
+static bStatus_t AntConfig_store(uint8_t array, const AntConfig_Desc *pDesc,
+                                 const AntConfig_Geometry *pGeometry, uint8_t version);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      AntConfig_init
+ *
+ * @brief   Load the configuration of every array, from SNV when a valid
+ *          item is stored and from the built-in configuration otherwise.
+ *
+ * @param   pinMask   - antenna switch pins handed to AOA_init
+ * @param   ppBuiltin - built-in configuration of each array
+ *
+ * @return  None
+ */
+void AntConfig_init(uint32_t pinMask,
+                    AoA_AntennaConfig *const ppBuiltin[ANT_CONFIG_NUM_ARRAYS])
+{
+  uint8_t array;
+
+  antPinMask = pinMask;
+
+  for (array = 0; array < ANT_CONFIG_NUM_ARRAYS; array++)
+  {
+    antBuiltin[array] = ppBuiltin[array];
+
+    antConfigs[array].pattern = (AoA_Pattern *)antPatterns[array];
+    antConfigs[array].pairs = antPairs[array];
+
+    antResults[array].signalStrength = antSignalStrength[array];
+    antResults[array].pairAngle = antPairAngle[array];
+
+    if (osal_snv_read(ANT_CONFIG_NV_ID(array), sizeof(antNvItem), &antNvItem) == SUCCESS &&
+        antNvItem.version == ANT_CONFIG_NV_VERSION &&
+        AntConfig_validate(&antNvItem.desc))
+    {
+      // A missing or stale geometry only costs the elevation
+      if (osal_snv_read(ANT_CONFIG_NV_GEOMETRY_ID(array), sizeof(antNvGeometry),
+                        &antNvGeometry) != SUCCESS ||
+          antNvGeometry.version != ANT_CONFIG_NV_VERSION ||
+          antNvGeometry.geometry.numElements != antNvItem.desc.numAntennas)
+      {
+        antNvGeometry.geometry.numElements = 0;
+      }
+
+      AntConfig_apply(array, &antNvItem.desc, &antNvGeometry.geometry);
+      antSource[array] = ANT_CONFIG_SOURCE_NV;
+    }
+    else
+    {
+      AntConfig_fromBuiltin(antBuiltin[array], &antNvItem.desc);
+      AntConfig_apply(array, &antNvItem.desc, NULL);
+      antSource[array] = ANT_CONFIG_SOURCE_BUILTIN;
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      AntConfig_get
+ *
+ * @brief   Active configuration of an array.
+ *
+ * @param   array - ANT_CONFIG_ARRAY_xxx
+ *
+ * @return  configuration
+ */
+AoA_AntennaConfig *AntConfig_get(uint8_t array)
+{
+  return &antConfigs[array];
+}
+
+/*********************************************************************
+ * @fn      AntConfig_getResult
+ *
+ * @brief   Result buffers of an array.
+ *
+ * @param   array - ANT_CONFIG_ARRAY_xxx
+ *
+ * @return  result
+ */
+AoA_AntennaResult *AntConfig_getResult(uint8_t array)
+{
+  return &antResults[array];
+}
+
+/*********************************************************************
+ * @fn      AntConfig_getSolver
+ *
+ * @brief   Direction solver of an array.
+ *
+ * @param   array - ANT_CONFIG_ARRAY_xxx
+ *
+ * @return  solver
+ */
+const AoAEst_Geometry *AntConfig_getSolver(uint8_t array)
+{
+  return &antSolvers[array];
+}
+
+/*********************************************************************
+ * @fn      AntConfig_getSource
+ *
+ * @brief   Where the active configuration of an array came from.
+ *
+ * @param   array - ANT_CONFIG_ARRAY_xxx
+ *
+ * @return  ANT_CONFIG_SOURCE_xxx
+ */
+uint8_t AntConfig_getSource(uint8_t array)
+{
+  return antSource[array];
+}
+
+/*********************************************************************
+ * @fn      AntConfig_begin
+ *
+ * @brief   Start loading a configuration.
+ *
+ * @param   array          - ANT_CONFIG_ARRAY_xxx
+ * @param   numAntennas    - antennas in the array
+ * @param   numPatterns    - antenna switch slots per capture
+ * @param   numPairs       - antenna pairs to estimate
+ * @param   initialPattern - pins set before the first slot
+ *
+ * @return  SUCCESS or INVALIDPARAMETER
+ */
+bStatus_t AntConfig_begin(uint8_t array, uint8_t numAntennas,
+                          uint8_t numPatterns, uint8_t numPairs,
+                          uint32_t initialPattern)
+{
+  if (array >= ANT_CONFIG_NUM_ARRAYS ||
+      numPatterns > ANT_CONFIG_MAX_PATTERNS ||
+      numPairs > ANT_CONFIG_MAX_PAIRS)
+  {
+    return INVALIDPARAMETER;
+  }
+
+  memset(&antPending, 0, sizeof(antPending));
+  antPending.numAntennas = numAntennas;
+  antPending.numPatterns = numPatterns;
+  antPending.numPairs = numPairs;
+  antPending.initialPattern = initialPattern;
+
+  memset(&antPendingGeometry, 0, sizeof(antPendingGeometry));
+
+  antPendingArray = array;
+  antPendingPatterns = 0;
+  antPendingPairs = 0;
+
+  return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      AntConfig_setPatterns
+ *
+ * @brief   Load consecutive slot patterns.
+ *
+ * @param   array     - array being loaded
+ * @param   first     - index of the first pattern
+ * @param   numValues - number of patterns in pValues
+ * @param   pValues   - pins set in each slot, little endian uint32
+ *
+ * @return  SUCCESS, INVALIDPARAMETER or bleIncorrectMode
+ */
+bStatus_t AntConfig_setPatterns(uint8_t array, uint8_t first,
+                                uint8_t numValues, const uint8_t *pValues)
+{
+  uint8_t i;
+
+  if (array != antPendingArray)
+  {
+    return bleIncorrectMode;
+  }
+
+  if (first + numValues > antPending.numPatterns)
+  {
+    return INVALIDPARAMETER;
+  }
+
+  for (i = 0; i < numValues; i++, pValues += 4)
+  {
+    antPending.patterns[first + i] = BUILD_UINT32(pValues[0], pValues[1], pValues[2], pValues[3]);
+    antPendingPatterns |= 1UL << (first + i);
+  }
+
+  return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      AntConfig_setPair
+ *
+ * @brief   Load one antenna pair.
+ *
+ * @param   array - array being loaded
+ * @param   index - pair index
+ * @param   pPair - pair
+ *
+ * @return  SUCCESS, INVALIDPARAMETER or bleIncorrectMode
+ */
+bStatus_t AntConfig_setPair(uint8_t array, uint8_t index,
+                            const AoA_AntennaPair *pPair)
+{
+  if (array != antPendingArray)
+  {
+    return bleIncorrectMode;
+  }
+
+  if (index >= antPending.numPairs)
+  {
+    return INVALIDPARAMETER;
+  }
+
+  antPending.pairs[index] = *pPair;
+  antPendingPairs |= 1 << index;
+
+  return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      AntConfig_setGeometry
+ *
+ * @brief   Load the element positions.
+ *
+ * @param   array        - array being loaded
+ * @param   mountAzimuth - azimuth of the array x axis, degrees
+ * @param   numElements  - number of positions in pValues, numAntennas
+ * @param   pValues      - x, y per element, little endian int16, 0.1 mm
+ *
+ * @return  SUCCESS, INVALIDPARAMETER or bleIncorrectMode
+ */
+bStatus_t AntConfig_setGeometry(uint8_t array, int16_t mountAzimuth,
+                                uint8_t numElements, const uint8_t *pValues)
+{
+  uint8_t i;
+
+  if (array != antPendingArray)
+  {
+    return bleIncorrectMode;
+  }
+
+  if (numElements != antPending.numAntennas || numElements > AOA_EST_MAX_ELEMENTS ||
+      mountAzimuth < -180 || mountAzimuth > 180)
+  {
+    return INVALIDPARAMETER;
+  }
+
+  antPendingGeometry.numElements = numElements;
+  antPendingGeometry.mountAzimuth = mountAzimuth;
+
+  for (i = 0; i < numElements; i++, pValues += 4)
+  {
+    antPendingGeometry.elements[i].x = (int16_t)BUILD_UINT16(pValues[0], pValues[1]);
+    antPendingGeometry.elements[i].y = (int16_t)BUILD_UINT16(pValues[2], pValues[3]);
+  }
+
+  return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      AntConfig_getPending
+ *
+ * @brief   Configuration being loaded.
+ *
+ * @param   array - ANT_CONFIG_ARRAY_xxx
+ *
+ * @return  configuration, NULL if array is not being loaded
+ */
+const AntConfig_Desc *AntConfig_getPending(uint8_t array)
+{
+  return (array == antPendingArray) ? &antPending : NULL;
+}
+
+/*********************************************************************
+ * @fn      AntConfig_commit
+ *
+ * @brief   Validate the loaded configuration and make it active.
+ *
+ * @param   array   - array being loaded
+ * @param   persist - TRUE to also store it in SNV
+ *
+ * @return  SUCCESS, INVALIDPARAMETER, bleIncorrectMode or the SNV error
+ */
+bStatus_t AntConfig_commit(uint8_t array, bool persist)
+{
+  uint32_t allPatterns;
+  uint8_t status;
+
+  if (array != antPendingArray)
+  {
+    return bleIncorrectMode;
+  }
+
+  allPatterns = (antPending.numPatterns == 32) ? 0xFFFFFFFF : ((1UL << antPending.numPatterns) - 1);
+
+  if (antPendingPatterns != allPatterns ||
+      antPendingPairs != (1 << antPending.numPairs) - 1 ||
+      !AntConfig_validate(&antPending))
+  {
+    return INVALIDPARAMETER;
+  }
+
+  // Positions that leave every pair without a baseline are useless
+  if (antPendingGeometry.numElements != 0)
+  {
+    AoA_AntennaConfig config;
+    AoAEst_Geometry solver;
+
+    config.numAntennas = antPending.numAntennas;
+    config.numPairs = antPending.numPairs;
+    config.pairs = antPending.pairs;
+
+    if (!AoAEst_initGeometry(&solver, &config, antPendingGeometry.elements,
+                             antPendingGeometry.mountAzimuth))
+    {
+      return INVALIDPARAMETER;
+    }
+  }
+
+  AntConfig_apply(array, &antPending, &antPendingGeometry);
+  antSource[array] = ANT_CONFIG_SOURCE_LOADED;
+  antPendingArray = ANT_CONFIG_NO_ARRAY;
+
+  if (!persist)
+  {
+    return SUCCESS;
+  }
+
+  status = AntConfig_store(array, &antPending, &antPendingGeometry, ANT_CONFIG_NV_VERSION);
+  if (status == SUCCESS)
+  {
+    antSource[array] = ANT_CONFIG_SOURCE_NV;
+  }
+
+  return status;
+}
+
+/*********************************************************************
+ * @fn      AntConfig_restore
+ *
+ * @brief   Make the built-in configuration active again and erase the
+ *          stored one.
+ *
+ * @param   array - ANT_CONFIG_ARRAY_xxx
+ *
+ * @return  SUCCESS, INVALIDPARAMETER or the SNV error
+ */
+bStatus_t AntConfig_restore(uint8_t array)
+{
+  if (array >= ANT_CONFIG_NUM_ARRAYS)
+  {
+    return INVALIDPARAMETER;
+  }
+
+  if (array == antPendingArray)
+  {
+    antPendingArray = ANT_CONFIG_NO_ARRAY;
+  }
+
+  AntConfig_fromBuiltin(antBuiltin[array], &antNvItem.desc);
+  AntConfig_apply(array, &antNvItem.desc, NULL);
+  antSource[array] = ANT_CONFIG_SOURCE_BUILTIN;
+
+  // SNV items cannot be deleted, store erased ones
+  memset(&antNvGeometry.geometry, 0, sizeof(antNvGeometry.geometry));
+
+  return AntConfig_store(array, &antNvItem.desc, &antNvGeometry.geometry, 0);
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      AntConfig_fromBuiltin
+ *
+ * @brief   Convert a built-in configuration to its loadable form.
+ *
+ * @param   pConfig - built-in configuration, patterns in set form
+ * @param   pDesc   - filled with the configuration
+ *
+ * @return  None
+ */
+static void AntConfig_fromBuiltin(const AoA_AntennaConfig *pConfig, AntConfig_Desc *pDesc)
+{
+  uint8_t numPatterns = pConfig->pattern->numPatterns;
+  uint8_t numPairs = pConfig->numPairs;
+
+  if (numPatterns > ANT_CONFIG_MAX_PATTERNS)
+  {
+    numPatterns = ANT_CONFIG_MAX_PATTERNS;
+  }
+
+  if (numPairs > ANT_CONFIG_MAX_PAIRS)
+  {
+    numPairs = ANT_CONFIG_MAX_PAIRS;
+  }
+
+  memset(pDesc, 0, sizeof(AntConfig_Desc));
+  pDesc->numAntennas = pConfig->numAntennas;
+  pDesc->numPatterns = numPatterns;
+  pDesc->numPairs = numPairs;
+  pDesc->initialPattern = pConfig->pattern->initialPattern;
+  memcpy(pDesc->patterns, pConfig->pattern->toggles, numPatterns * sizeof(uint32_t));
+  memcpy(pDesc->pairs, pConfig->pairs, numPairs * sizeof(AoA_AntennaPair));
+}
+
+/*********************************************************************
+ * @fn      AntConfig_validate
+ *
+ * @brief   Check that a configuration can be captured and estimated.
+ *
+ * @param   pDesc - configuration
+ *
+ * @return  TRUE if valid
+ */
+static bool AntConfig_validate(const AntConfig_Desc *pDesc)
+{
+  uint8_t i;
+
+  // At least two repetitions of the antennas, the estimator tracks the
+  // carrier drift from one to the next
+  if (pDesc->numAntennas < 2 ||
+      pDesc->numPatterns > ANT_CONFIG_MAX_PATTERNS ||
+      pDesc->numPatterns < 2 * pDesc->numAntennas ||
+      pDesc->numPairs < ANT_CONFIG_MIN_PAIRS ||
+      pDesc->numPairs > ANT_CONFIG_MAX_PAIRS)
+  {
+    return FALSE;
+  }
+
+  if (pDesc->initialPattern & ~antPinMask)
+  {
+    return FALSE;
+  }
+
+  for (i = 0; i < pDesc->numPatterns; i++)
+  {
+    if (pDesc->patterns[i] & ~antPinMask)
+    {
+      return FALSE;
+    }
+  }
+
+  for (i = 0; i < pDesc->numPairs; i++)
+  {
+    const AoA_AntennaPair *pPair = &pDesc->pairs[i];
+
+    // Pairs name slots of a repetition, which may reach into the next
+    if (pPair->a == pPair->b ||
+        pPair->a >= pDesc->numPatterns ||
+        pPair->b >= pDesc->numPatterns ||
+        (pPair->sign != 1 && pPair->sign != -1))
+    {
+      return FALSE;
+    }
+
+    // Also rejects NaN
+    if (!(pPair->gain >= -ANT_CONFIG_MAX_GAIN && pPair->gain <= ANT_CONFIG_MAX_GAIN) ||
+        pPair->gain == 0.0f)
+    {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/*********************************************************************
+ * @fn      AntConfig_apply
+ *
+ * @brief   Make a configuration the active one of an array. Patterns
+ *          are turned into toggles here, once, so a capture costs the
+ *          same as with a built-in configuration.
+ *
+ * @param   array     - ANT_CONFIG_ARRAY_xxx
+ * @param   pDesc     - configuration
+ * @param   pGeometry - element positions, NULL or none if unknown
+ *
+ * @return  None
+ */
+static void AntConfig_apply(uint8_t array, const AntConfig_Desc *pDesc,
+                            const AntConfig_Geometry *pGeometry)
+{
+  AoA_AntennaConfig *pConfig = &antConfigs[array];
+  AoA_Pattern *pPattern = pConfig->pattern;
+
+  pPattern->numPatterns = pDesc->numPatterns;
+  pPattern->initialPattern = pDesc->initialPattern;
+  AOA_toggleMaker(pDesc->patterns, pDesc->initialPattern, pDesc->numPatterns, pPattern->toggles);
+
+  memcpy(antPairs[array], pDesc->pairs, pDesc->numPairs * sizeof(AoA_AntennaPair));
+  pConfig->numAntennas = pDesc->numAntennas;
+  pConfig->numPairs = pDesc->numPairs;
+
+  memset(antSignalStrength[array], 0, sizeof(antSignalStrength[array]));
+  memset(antPairAngle[array], 0, sizeof(antPairAngle[array]));
+  antResults[array].rssi = 0;
+  antResults[array].updated = false;
+
+  // The pseudo-inverse is computed here once, a capture only applies it
+  if (pGeometry == NULL || pGeometry->numElements == 0 ||
+      !AoAEst_initGeometry(&antSolvers[array], pConfig, pGeometry->elements,
+                           pGeometry->mountAzimuth))
+  {
+    memset(&antSolvers[array], 0, sizeof(antSolvers[array]));
+  }
+}
+
+/*********************************************************************
+ * @fn      AntConfig_store
+ *
+ * @brief   Write the SNV items of an array.
+ *
+ * @param   array     - ANT_CONFIG_ARRAY_xxx
+ * @param   pDesc     - configuration
+ * @param   pGeometry - element positions, numElements 0 if unknown
+ * @param   version   - ANT_CONFIG_NV_VERSION, 0 to erase
+ *
+ * @return  SUCCESS or the SNV error
+ */
+static bStatus_t AntConfig_store(uint8_t array, const AntConfig_Desc *pDesc,
+                                 const AntConfig_Geometry *pGeometry, uint8_t version)
+{
+  uint8_t status;
+
+  antNvItem.version = version;
+  if (&antNvItem.desc != pDesc)
+  {
+    antNvItem.desc = *pDesc;
+  }
+
+  antNvGeometry.version = version;
+  if (&antNvGeometry.geometry != pGeometry)
+  {
+    antNvGeometry.geometry = *pGeometry;
+  }
+
+  status = osal_snv_write(ANT_CONFIG_NV_ID(array), sizeof(antNvItem), &antNvItem);
+  if (status == SUCCESS)
+  {
+    status = osal_snv_write(ANT_CONFIG_NV_GEOMETRY_ID(array), sizeof(antNvGeometry),
+                            &antNvGeometry);
+  }
+
+  return status;
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,249 @@
+/******************************************************************************
+
+ @file       ant_config.h
+
+ @brief Runtime antenna array configuration for the AoA Receiver.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+#ifndef ANTCONFIG_H
+#define ANTCONFIG_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bcomdef.h"
+#include "aoa/AOA.h"
+#include "aoa_estimator.h"
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Antenna arrays
+#define ANT_CONFIG_ARRAY_A1                   0
+#define ANT_CONFIG_ARRAY_A2                   1
+#define ANT_CONFIG_NUM_ARRAYS                 2
+
+// Limits of a configuration
+#define ANT_CONFIG_MAX_PATTERNS               32
+#define ANT_CONFIG_MIN_PAIRS                  2     // The angle combines the first two
+#define ANT_CONFIG_MAX_PAIRS                  AOA_EST_MAX_PAIRS
+#define ANT_CONFIG_MAX_GAIN                   16.0f
+
+// SNV items of each array: the configuration, then the geometry
+#define ANT_CONFIG_NV_ID(array)               (BLE_NVID_CUST_START + (array))
+#define ANT_CONFIG_NV_GEOMETRY_ID(array)      (BLE_NVID_CUST_START + ANT_CONFIG_NUM_ARRAYS + (array))
+
+// Layout version of the SNV item, 0 marks an erased item
+#define ANT_CONFIG_NV_VERSION                 1
+
+// Where the active configuration of an array came from
+#define ANT_CONFIG_SOURCE_BUILTIN             0
+#define ANT_CONFIG_SOURCE_NV                  1
+#define ANT_CONFIG_SOURCE_LOADED              2     // Loaded, not persisted
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Configuration of one antenna array in its loadable form. Patterns are
+// the pins set in each slot, they are turned into toggles when applied.
+typedef struct
+{
+  uint8_t  numAntennas;
+  uint8_t  numPatterns;
+  uint8_t  numPairs;
+  uint32_t initialPattern;
+  uint32_t patterns[ANT_CONFIG_MAX_PATTERNS];
+  AoA_AntennaPair pairs[ANT_CONFIG_MAX_PAIRS];
+} AntConfig_Desc;
+
+// Element positions of one array, optional. Element n is the antenna
+// switched in during slot n of each repetition.
+typedef struct
+{
+  uint8_t numElements;    // numAntennas, 0 if the positions are unknown
+  int16_t mountAzimuth;   // Azimuth of the array x axis, degrees
+  AoAEst_Element elements[AOA_EST_MAX_ELEMENTS];
+} AntConfig_Geometry;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * @brief   Load the configuration of every array, from SNV when a valid
+ *          item is stored and from the built-in configuration otherwise.
+ *          The built-in patterns must still be in set form, i.e. not
+ *          passed through AOA_toggleMaker.
+ *
+ * @param   pinMask   - antenna switch pins handed to AOA_init, patterns
+ *                      may not drive other pins
+ * @param   ppBuiltin - built-in configuration of each array
+ */
+extern void AntConfig_init(uint32_t pinMask,
+                           AoA_AntennaConfig *const ppBuiltin[ANT_CONFIG_NUM_ARRAYS]);
+
+/*
+ * @brief   Active configuration of an array. The address stays the same
+ *          for the life of the application, later loads update it in
+ *          place.
+ */
+extern AoA_AntennaConfig *AntConfig_get(uint8_t array);
+
+/*
+ * @brief   Result buffers of an array, sized for ANT_CONFIG_MAX_PAIRS.
+ */
+extern AoA_AntennaResult *AntConfig_getResult(uint8_t array);
+
+/*
+ * @brief   Direction solver of an array, rank AOA_EST_GEOMETRY_NONE if
+ *          its element positions are unknown.
+ */
+extern const AoAEst_Geometry *AntConfig_getSolver(uint8_t array);
+
+/*
+ * @brief   Where the active configuration of an array came from.
+ *
+ * @return  ANT_CONFIG_SOURCE_xxx
+ */
+extern uint8_t AntConfig_getSource(uint8_t array);
+
+/*
+ * @brief   Start loading a configuration. Replaces any load in progress.
+ *
+ * @return  SUCCESS or INVALIDPARAMETER
+ */
+extern bStatus_t AntConfig_begin(uint8_t array, uint8_t numAntennas,
+                                 uint8_t numPatterns, uint8_t numPairs,
+                                 uint32_t initialPattern);
+
+/*
+ * @brief   Load consecutive slot patterns.
+ *
+ * @param   array     - array being loaded
+ * @param   first     - index of the first pattern
+ * @param   numValues - number of patterns in pValues
+ * @param   pValues   - pins set in each slot, little endian uint32
+ *
+ * @return  SUCCESS, INVALIDPARAMETER or bleIncorrectMode if the array
+ *          is not being loaded
+ */
+extern bStatus_t AntConfig_setPatterns(uint8_t array, uint8_t first,
+                                       uint8_t numValues, const uint8_t *pValues);
+
+/*
+ * @brief   Load one antenna pair.
+ *
+ * @return  SUCCESS, INVALIDPARAMETER or bleIncorrectMode if the array
+ *          is not being loaded
+ */
+extern bStatus_t AntConfig_setPair(uint8_t array, uint8_t index,
+                                   const AoA_AntennaPair *pPair);
+
+/*
+ * @brief   Load the element positions. Optional, without them the array
+ *          only reports pair angles.
+ *
+ * @param   array        - array being loaded
+ * @param   mountAzimuth - azimuth of the array x axis, degrees
+ * @param   numElements  - number of positions in pValues, numAntennas
+ * @param   pValues      - x, y per element, little endian int16, 0.1 mm
+ *
+ * @return  SUCCESS, INVALIDPARAMETER or bleIncorrectMode if the array
+ *          is not being loaded
+ */
+extern bStatus_t AntConfig_setGeometry(uint8_t array, int16_t mountAzimuth,
+                                       uint8_t numElements, const uint8_t *pValues);
+
+/*
+ * @brief   Configuration being loaded, NULL if array is not being
+ *          loaded.
+ */
+extern const AntConfig_Desc *AntConfig_getPending(uint8_t array);
+
+/*
+ * @brief   Validate the loaded configuration and make it active. The
+ *          caller must make sure no capture or estimation is using the
+ *          array.
+ *
+ * @param   array   - array being loaded
+ * @param   persist - TRUE to also store it in SNV
+ *
+ * @return  SUCCESS, INVALIDPARAMETER if incomplete or invalid,
+ *          bleIncorrectMode if the array is not being loaded, or the
+ *          SNV error
+ */
+extern bStatus_t AntConfig_commit(uint8_t array, bool persist);
+
+/*
+ * @brief   Make the built-in configuration active again and erase the
+ *          stored one. Same caller requirement as AntConfig_commit.
+ *
+ * @return  SUCCESS or the SNV error
+ */
+extern bStatus_t AntConfig_restore(uint8_t array);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ANTCONFIG_H */
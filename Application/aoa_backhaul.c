@@ -0,0 +1,413 @@
+/******************************************************************************
+
+ @file       aoa_backhaul.c
+
+ @brief Angle result backhaul over GATT notifications.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+
+#include <icall.h>
+#include "icall_ble_api.h"
+
+#include "aoa_backhaul.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// ATT opcode and handle ahead of a notification's value
+#define AOA_BACKHAUL_NOTI_HDR_LEN             3
+
+// Position of the records value in bhAttrTbl
+#define AOA_BACKHAUL_RECORDS_IDX              2
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static CONST uint8_t bhServUUID[ATT_BT_UUID_SIZE] =
+{
+  LO_UINT16(AOA_BACKHAUL_SERV_UUID), HI_UINT16(AOA_BACKHAUL_SERV_UUID)
+};
+
+static CONST uint8_t bhRecordsUUID[ATT_BT_UUID_SIZE] =
+{
+  LO_UINT16(AOA_BACKHAUL_RECORDS_UUID), HI_UINT16(AOA_BACKHAUL_RECORDS_UUID)
+};
+
+static CONST gattAttrType_t bhService = { ATT_BT_UUID_SIZE, bhServUUID };
+
+static uint8_t bhRecordsProps = GATT_PROP_NOTIFY;
+
+// Value of the records characteristic, only ever notified
+static uint8_t bhRecordsValue = 0;
+
+// Client configuration of each link, allocated with the service
+static gattCharCfg_t *bhRecordsConfig = NULL;
+
+// Entries of bhRecordsConfig, one per link the stack can hold
+static uint8_t bhNumConns = 0;
+
+static gattAttribute_t bhAttrTbl[] =
+{
+  // AoA Results service
+  {
+    { ATT_BT_UUID_SIZE, primaryServiceUUID },
+    GATT_PERMIT_READ,
+    0,
+    (uint8_t *)&bhService
+  },
+
+    // Records declaration
+    {
+      { ATT_BT_UUID_SIZE, characterUUID },
+      GATT_PERMIT_READ,
+      0,
+      &bhRecordsProps
+    },
+
+      // Records value
+      {
+        { ATT_BT_UUID_SIZE, bhRecordsUUID },
+        0,
+        0,
+        &bhRecordsValue
+      },
+
+      // Records client configuration
+      {
+        { ATT_BT_UUID_SIZE, clientCharCfgUUID },
+        GATT_PERMIT_READ | GATT_PERMIT_WRITE,
+        0,
+        (uint8_t *)&bhRecordsConfig
+      },
+};
+
+// Batched records
+static uint8_t bhBatch[AOA_BACKHAUL_MAX_RECORDS * AOA_BACKHAUL_RECORD_LEN];
+static uint8_t bhNumRecords = 0;
+
+static AoABackhaul_Stats bhStats;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static bStatus_t AoABackhaul_readAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
+                                        uint8_t *pValue, uint16_t *pLen,
+                                        uint16_t offset, uint16_t maxLen,
+                                        uint8_t method);
+static bStatus_t AoABackhaul_writeAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
+                                         uint8_t *pValue, uint16_t len,
+                                         uint16_t offset, uint8_t method);
+static bool AoABackhaul_notify(uint16_t connHandle, const uint8_t *pData, uint16_t len);
+
+/*********************************************************************
+ * PROFILE CALLBACKS
+ */
+
+static CONST gattServiceCBs_t bhCBs =
+{
+  AoABackhaul_readAttrCB,  // Read callback function pointer
+  AoABackhaul_writeAttrCB, // Write callback function pointer
+  NULL                     // Authorization callback function pointer
+};
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      AoABackhaul_addService
+ *
+ * @brief   Register the AoA Results service with the GATT server.
+ *
+ * @return  SUCCESS, bleMemAllocError or the GATT error
+ */
+bStatus_t AoABackhaul_addService(void)
+{
+  // Sized from the stack's link DB: the service is added before the
+  // central role is started, which is when linkDBNumConns gets set
+  bhNumConns = linkDB_NumConns();
+  bhRecordsConfig = (gattCharCfg_t *)ICall_malloc(sizeof(gattCharCfg_t) *
+                                                  bhNumConns);
+  if (bhRecordsConfig == NULL)
+  {
+    return bleMemAllocError;
+  }
+
+  GATTServApp_InitCharCfg(INVALID_CONNHANDLE, bhRecordsConfig);
+
+  bhNumRecords = 0;
+  memset(&bhStats, 0, sizeof(bhStats));
+
+  return GATTServApp_RegisterService(bhAttrTbl, GATT_NUM_ATTRS(bhAttrTbl),
+                                     GATT_MAX_ENCRYPT_KEY_SIZE,
+                                     (gattServiceCBs_t *)&bhCBs);
+}
+
+/*********************************************************************
+ * @fn      AoABackhaul_subscribed
+ *
+ * @brief   Whether any client has notifications enabled.
+ *
+ * @return  true if there is a subscriber
+ */
+bool AoABackhaul_subscribed(void)
+{
+  uint8_t i;
+
+  if (bhRecordsConfig == NULL)
+  {
+    return false;
+  }
+
+  for (i = 0; i < bhNumConns; i++)
+  {
+    if (bhRecordsConfig[i].connHandle != INVALID_CONNHANDLE &&
+        (bhRecordsConfig[i].value & GATT_CLIENT_CFG_NOTIFY))
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/*********************************************************************
+ * @fn      AoABackhaul_put
+ *
+ * @brief   Add an angle to the batch.
+ *
+ * @param   pAddr     - tag address
+ * @param   azimuth   - degrees
+ * @param   elevation - degrees, AOA_BACKHAUL_NO_ELEVATION if unknown
+ * @param   rssi      - dBm
+ * @param   channel   - RF channel of the capture
+ *
+ * @return  records in the batch, AOA_BACKHAUL_MAX_RECORDS when it is
+ *          full and must be flushed
+ */
+uint8_t AoABackhaul_put(const uint8_t *pAddr, int16_t azimuth,
+                        int16_t elevation, int8_t rssi, uint8_t channel)
+{
+  uint8_t *pRec;
+
+  // Full, the caller did not flush. The oldest record is the least useful.
+  if (bhNumRecords == AOA_BACKHAUL_MAX_RECORDS)
+  {
+    memmove(bhBatch, bhBatch + AOA_BACKHAUL_RECORD_LEN,
+            (AOA_BACKHAUL_MAX_RECORDS - 1) * AOA_BACKHAUL_RECORD_LEN);
+    bhNumRecords--;
+    bhStats.numDropped++;
+  }
+
+  pRec = &bhBatch[bhNumRecords * AOA_BACKHAUL_RECORD_LEN];
+
+  memcpy(pRec, pAddr, B_ADDR_LEN);
+  pRec[6] = LO_UINT16(azimuth);
+  pRec[7] = HI_UINT16(azimuth);
+  pRec[8] = LO_UINT16(elevation);
+  pRec[9] = HI_UINT16(elevation);
+  pRec[10] = (uint8_t)rssi;
+  pRec[11] = channel;
+
+  return ++bhNumRecords;
+}
+
+/*********************************************************************
+ * @fn      AoABackhaul_flush
+ *
+ * @brief   Send the batch to every subscriber and empty it.
+ *
+ * @return  None
+ */
+void AoABackhaul_flush(void)
+{
+  uint8_t i;
+
+  if (bhNumRecords == 0 || bhRecordsConfig == NULL)
+  {
+    return;
+  }
+
+  for (i = 0; i < bhNumConns; i++)
+  {
+    uint16_t connHandle = bhRecordsConfig[i].connHandle;
+    uint16_t perNoti;
+    uint8_t sent = 0;
+
+    if (connHandle == INVALID_CONNHANDLE ||
+        !(bhRecordsConfig[i].value & GATT_CLIENT_CFG_NOTIFY))
+    {
+      continue;
+    }
+
+    // Whole records only, a default 23 byte MTU still carries one
+    perNoti = (GATT_GetMTU(connHandle) - AOA_BACKHAUL_NOTI_HDR_LEN) /
+              AOA_BACKHAUL_RECORD_LEN;
+    if (perNoti == 0)
+    {
+      continue;
+    }
+
+    while (sent < bhNumRecords)
+    {
+      uint8_t num = bhNumRecords - sent;
+
+      if (num > perNoti)
+      {
+        num = (uint8_t)perNoti;
+      }
+
+      if (!AoABackhaul_notify(connHandle, &bhBatch[sent * AOA_BACKHAUL_RECORD_LEN],
+                              num * AOA_BACKHAUL_RECORD_LEN))
+      {
+        bhStats.numDropped += bhNumRecords - sent;
+        break;
+      }
+
+      bhStats.numNotifications++;
+      bhStats.numRecords += num;
+      sent += num;
+    }
+  }
+
+  bhNumRecords = 0;
+}
+
+/*********************************************************************
+ * @fn      AoABackhaul_getStats
+ *
+ * @brief   Read the statistics.
+ *
+ * @param   pStats - filled with a snapshot of the statistics
+ *
+ * @return  None
+ */
+void AoABackhaul_getStats(AoABackhaul_Stats *pStats)
+{
+  *pStats = bhStats;
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      AoABackhaul_notify
+ *
+ * @brief   Send one notification of the records value.
+ *
+ * @param   connHandle - subscriber
+ * @param   pData      - records
+ * @param   len        - number of bytes in pData
+ *
+ * @return  false if the notification could not be queued
+ */
+static bool AoABackhaul_notify(uint16_t connHandle, const uint8_t *pData, uint16_t len)
+{
+  attHandleValueNoti_t noti;
+
+  noti.pValue = GATT_bm_alloc(connHandle, ATT_HANDLE_VALUE_NOTI, len, NULL);
+  if (noti.pValue == NULL)
+  {
+    return false;
+  }
+
+  noti.handle = bhAttrTbl[AOA_BACKHAUL_RECORDS_IDX].handle;
+  noti.len = len;
+  memcpy(noti.pValue, pData, len);
+
+  if (GATT_Notification(connHandle, &noti, FALSE) != SUCCESS)
+  {
+    GATT_bm_free((gattMsg_t *)&noti, ATT_HANDLE_VALUE_NOTI);
+    return false;
+  }
+
+  return true;
+}
+
+/*********************************************************************
+ * @fn      AoABackhaul_readAttrCB
+ *
+ * @brief   Read an attribute. Only the records value reaches here, and
+ *          it is not readable.
+ *
+ * @return  ATT_ERR_ATTR_NOT_FOUND
+ */
+static bStatus_t AoABackhaul_readAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
+                                        uint8_t *pValue, uint16_t *pLen,
+                                        uint16_t offset, uint16_t maxLen,
+                                        uint8_t method)
+{
+  *pLen = 0;
+
+  return ATT_ERR_ATTR_NOT_FOUND;
+}
+
+/*********************************************************************
+ * @fn      AoABackhaul_writeAttrCB
+ *
+ * @brief   Write an attribute. Only the client configuration accepts
+ *          writes, it enables notifications only.
+ *
+ * @return  SUCCESS or the ATT error
+ */
+static bStatus_t AoABackhaul_writeAttrCB(uint16_t connHandle, gattAttribute_t *pAttr,
+                                         uint8_t *pValue, uint16_t len,
+                                         uint16_t offset, uint8_t method)
+{
+  if (pAttr->type.len == ATT_BT_UUID_SIZE &&
+      BUILD_UINT16(pAttr->type.uuid[0], pAttr->type.uuid[1]) == GATT_CLIENT_CHAR_CFG_UUID)
+  {
+    return GATTServApp_ProcessCCCWriteReq(connHandle, pAttr, pValue, len,
+                                          offset, GATT_CLIENT_CFG_NOTIFY);
+  }
+
+  return ATT_ERR_ATTR_NOT_FOUND;
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,159 @@
+/******************************************************************************
+
+ @file       aoa_backhaul.h
+
+ @brief Angle result backhaul over GATT notifications.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+#ifndef AOABACKHAUL_H
+#define AOABACKHAUL_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bcomdef.h"
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// AoA Results service and its records characteristic (notify only)
+#define AOA_BACKHAUL_SERV_UUID                0xFFC0
+#define AOA_BACKHAUL_RECORDS_UUID             0xFFC1
+
+// Record layout, little endian, records back to back in a notification:
+//
+//   ADDR[6] | AZIMUTH[2] | ELEVATION[2] | RSSI | CHANNEL
+//
+// Angles are int16 degrees, AOA_BACKHAUL_NO_ELEVATION when the array
+// does not resolve elevation.
+#define AOA_BACKHAUL_RECORD_LEN               12
+#define AOA_BACKHAUL_NO_ELEVATION             0x7FFF
+
+// Records batched before a flush is due. The default fills one
+// notification on a 251 byte data length link (ATT MTU 247).
+#ifndef AOA_BACKHAUL_MAX_RECORDS
+#define AOA_BACKHAUL_MAX_RECORDS              20
+#endif
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Statistics
+typedef struct
+{
+  uint32_t numRecords;        // Records sent, counted once per subscriber
+  uint32_t numNotifications;  // Notifications sent
+  uint32_t numDropped;        // Records lost to a full TX queue or no memory
+} AoABackhaul_Stats;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * @brief   Register the AoA Results service with the GATT server.
+ *
+ * @return  SUCCESS, bleMemAllocError or the GATT error
+ */
+extern bStatus_t AoABackhaul_addService(void);
+
+/*
+ * @brief   Whether any client has notifications enabled. Records are
+ *          only worth batching if so.
+ *
+ * @return  true if there is a subscriber
+ */
+extern bool AoABackhaul_subscribed(void);
+
+/*
+ * @brief   Add an angle to the batch.
+ *
+ * @param   pAddr     - tag address
+ * @param   azimuth   - degrees
+ * @param   elevation - degrees, AOA_BACKHAUL_NO_ELEVATION if unknown
+ * @param   rssi      - dBm
+ * @param   channel   - RF channel of the capture
+ *
+ * @return  records in the batch, AOA_BACKHAUL_MAX_RECORDS when it is
+ *          full and must be flushed
+ */
+extern uint8_t AoABackhaul_put(const uint8_t *pAddr, int16_t azimuth,
+                               int16_t elevation, int8_t rssi, uint8_t channel);
+
+/*
+ * @brief   Send the batch to every subscriber, as many records per
+ *          notification as its ATT MTU allows, and empty it.
+ */
+extern void AoABackhaul_flush(void);
+
+/*
+ * @brief   Read the statistics.
+ *
+ * @param   pStats - filled with a snapshot of the statistics
+ */
+extern void AoABackhaul_getStats(AoABackhaul_Stats *pStats);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AOABACKHAUL_H */
@@ -0,0 +1,270 @@
+/******************************************************************************
+
+ @file       aoa_bench.c
+
+ @brief Cycle-accurate timing of short code sections.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "aoa_bench.h"
+
+#if defined( AOA_BENCH_HOST )
+#include <time.h>
+#else
+#include <ti/sysbios/hal/Hwi.h>
+#include <inc/hw_types.h>
+#include <inc/hw_cpu_dwt.h>
+#include <inc/hw_cpu_scs.h>
+#endif // AOA_BENCH_HOST
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Runs of the empty section used to measure the timer overhead
+#define AOA_BENCH_CAL_RUNS                    16
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Cost of timing an empty section, removed from every measurement
+static uint32_t benchOverhead = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint32_t AoABench_now(void);
+static uint32_t AoABench_time(AoABench_Fxn fxn, void *pArg);
+static void AoABench_nop(void *pArg);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      AoABench_init
+ *
+ * @brief   Start the timer and measure its own overhead.
+ *
+ * @return  none
+ */
+void AoABench_init(void)
+{
+  uint32_t t;
+  uint8_t i;
+
+#if !defined( AOA_BENCH_HOST )
+  // The cycle counter only runs with trace enabled, which is otherwise
+  // left to the debugger
+  HWREG(CPU_SCS_BASE + CPU_SCS_O_DEMCR) |= CPU_SCS_DEMCR_TRCENA;
+  HWREG(CPU_DWT_BASE + CPU_DWT_O_CTRL) |= CPU_DWT_CTRL_CYCCNTENA;
+#endif // !AOA_BENCH_HOST
+
+  // The call through the function pointer is part of the overhead
+  benchOverhead = 0;
+  benchOverhead = AoABench_time(AoABench_nop, NULL);
+  for (i = 1; i < AOA_BENCH_CAL_RUNS; i++)
+  {
+    t = AoABench_time(AoABench_nop, NULL);
+    if (t < benchOverhead)
+    {
+      benchOverhead = t;
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      AoABench_unit
+ *
+ * @brief   Unit of the measured times.
+ *
+ * @return  AOA_BENCH_UNIT_xxx
+ */
+uint8_t AoABench_unit(void)
+{
+#if defined( AOA_BENCH_HOST )
+  return AOA_BENCH_UNIT_NS;
+#else
+  return AOA_BENCH_UNIT_CYCLES;
+#endif // AOA_BENCH_HOST
+}
+
+/*********************************************************************
+ * @fn      AoABench_run
+ *
+ * @brief   Time a code section, one iteration at a time.
+ *
+ * @param   fxn        - code section
+ * @param   pArg       - passed to fxn
+ * @param   iterations - 1 to AOA_BENCH_MAX_ITERATIONS
+ * @param   pResult    - filled with the times
+ *
+ * @return  false if iterations is out of range
+ */
+bool AoABench_run(AoABench_Fxn fxn, void *pArg, uint16_t iterations,
+                  AoABench_Result *pResult)
+{
+  uint32_t t;
+
+  if (iterations == 0 || iterations > AOA_BENCH_MAX_ITERATIONS)
+  {
+    return false;
+  }
+
+  pResult->count = 0;
+  pResult->min = UINT32_MAX;
+  pResult->max = 0;
+  pResult->total = 0;
+
+  while (pResult->count < iterations)
+  {
+    t = AoABench_time(fxn, pArg);
+
+    if (t < pResult->min)
+    {
+      pResult->min = t;
+    }
+    if (t > pResult->max)
+    {
+      pResult->max = t;
+    }
+    pResult->total += t;
+    pResult->count++;
+  }
+
+  return true;
+}
+
+/*********************************************************************
+ * @fn      AoABench_avg
+ *
+ * @brief   Average time per iteration.
+ *
+ * @param   pResult - times of a run
+ *
+ * @return  average, 0 if nothing was measured
+ */
+uint32_t AoABench_avg(const AoABench_Result *pResult)
+{
+  if (pResult->count == 0)
+  {
+    return 0;
+  }
+
+  return (uint32_t)(pResult->total / pResult->count);
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      AoABench_now
+ *
+ * @brief   Read the timer. Only differences are meaningful, they are
+ *          correct across one wrap: ~89 s of cycles at 48 MHz, ~4 s of
+ *          nanoseconds.
+ *
+ * @return  current time in AoABench_unit() units
+ */
+static uint32_t AoABench_now(void)
+{
+#if defined( AOA_BENCH_HOST )
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint32_t)ts.tv_sec * 1000000000u + (uint32_t)ts.tv_nsec;
+#else
+  return HWREG(CPU_DWT_BASE + CPU_DWT_O_CYCCNT);
+#endif // AOA_BENCH_HOST
+}
+
+/*********************************************************************
+ * @fn      AoABench_time
+ *
+ * @brief   Time one call of a code section. On target interrupts are
+ *          disabled for the call.
+ *
+ * @param   fxn  - code section
+ * @param   pArg - passed to fxn
+ *
+ * @return  time of the call less the timer overhead
+ */
+static uint32_t AoABench_time(AoABench_Fxn fxn, void *pArg)
+{
+  uint32_t start;
+  uint32_t t;
+#if !defined( AOA_BENCH_HOST )
+  UInt key = Hwi_disable();
+#endif // !AOA_BENCH_HOST
+
+  start = AoABench_now();
+  fxn(pArg);
+  t = AoABench_now() - start;
+
+#if !defined( AOA_BENCH_HOST )
+  Hwi_restore(key);
+#endif // !AOA_BENCH_HOST
+
+  return (t > benchOverhead) ? t - benchOverhead : 0;
+}
+
+/*********************************************************************
+ * @fn      AoABench_nop
+ *
+ * @brief   Empty code section, used to measure the timer overhead.
+ *
+ * @param   pArg - not used
+ *
+ * @return  none
+ */
+static void AoABench_nop(void *pArg)
+{
+  (void)pArg;
+}
+
+/*********************************************************************
+*********************************************************************/
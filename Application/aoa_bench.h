@@ -0,0 +1,150 @@
+/******************************************************************************
+
+ @file       aoa_bench.h
+
+ @brief Cycle-accurate timing of short code sections.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+#ifndef AOABENCH_H
+#define AOABENCH_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Units of the measured times. On target the Cortex-M3 DWT cycle
+// counter is used, a host build (AOA_BENCH_HOST) uses the monotonic
+// clock instead.
+#define AOA_BENCH_UNIT_CYCLES                 0
+#define AOA_BENCH_UNIT_NS                     1
+
+// Upper bound on the iterations of one run
+#ifndef AOA_BENCH_MAX_ITERATIONS
+#define AOA_BENCH_MAX_ITERATIONS              1000
+#endif
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Code section under test, called once per iteration
+typedef void (*AoABench_Fxn)(void *pArg);
+
+// Times of one run, timer overhead already removed
+typedef struct
+{
+  uint16_t count;         // Iterations measured
+  uint32_t min;
+  uint32_t max;
+  uint64_t total;
+} AoABench_Result;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * @brief   Start the timer and measure its own overhead.
+ */
+extern void AoABench_init(void);
+
+/*
+ * @brief   Unit of the measured times.
+ *
+ * @return  AOA_BENCH_UNIT_xxx
+ */
+extern uint8_t AoABench_unit(void);
+
+/*
+ * @brief   Time a code section.
+ *
+ *          Each iteration is timed on its own with interrupts disabled,
+ *          so min is the cost of the code alone and max shows how much
+ *          it varies with its input and with cache or flash wait states.
+ *          Interrupts are served between iterations.
+ *
+ * @param   fxn        - code section
+ * @param   pArg       - passed to fxn
+ * @param   iterations - 1 to AOA_BENCH_MAX_ITERATIONS
+ * @param   pResult    - filled with the times
+ *
+ * @return  false if iterations is out of range
+ */
+extern bool AoABench_run(AoABench_Fxn fxn, void *pArg, uint16_t iterations,
+                         AoABench_Result *pResult);
+
+/*
+ * @brief   Average time per iteration.
+ *
+ * @param   pResult - times of a run
+ *
+ * @return  average, 0 if nothing was measured
+ */
+extern uint32_t AoABench_avg(const AoABench_Result *pResult);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AOABENCH_H */
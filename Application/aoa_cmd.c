@@ -0,0 +1,588 @@
+/******************************************************************************
+
+ @file       aoa_cmd.c
+
+ @brief Binary command interface for the AoA Receiver over UART.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+#include <stdarg.h>
+
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Semaphore.h>
+#include <ti/sysbios/BIOS.h>
+#include <ti/drivers/UART.h>
+#include <ti/drivers/uart/UARTCC26XX.h>
+#include <ti/drivers/dpl/SystemP.h>
+
+#include "board.h"
+#include "aoa_cmd.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Reader task configuration. Runs above the estimation worker, which
+// can keep priority 1 busy indefinitely and TI-RTOS does not time-slice
+// tasks of equal priority, so a STOP command is always read. Blocks in
+// UART_read, so sharing priority 2 with the application costs nothing.
+#define AOA_CMD_TASK_PRIORITY                 2
+
+#ifndef AOA_CMD_TASK_STACK_SIZE
+#define AOA_CMD_TASK_STACK_SIZE               512
+#endif
+
+// Bytes requested per UART_read. Reads return early on an idle line.
+#define AOA_CMD_RX_CHUNK                      16
+
+#define AOA_CMD_UART_BAUD_RATE                115200
+
+// Longest Display line written to the UART, longer text is cut
+#define AOA_CMD_DISPLAY_LINE_SIZE             128
+
+// Frame parser states
+enum
+{
+  AOA_CMD_RX_SOF,
+  AOA_CMD_RX_LEN,
+  AOA_CMD_RX_CMD,
+  AOA_CMD_RX_DATA,
+  AOA_CMD_RX_FCS
+};
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Task configuration
+static Task_Struct aoaCmdTask;
+static Char aoaCmdTaskStack[AOA_CMD_TASK_STACK_SIZE];
+
+static UART_Handle aoaCmdUart = NULL;
+static Event_Handle aoaCmdEvent = NULL;
+static uint32_t aoaCmdEventId = 0;
+
+// Held while a frame or a Display line is written, so none interleave
+static Semaphore_Struct aoaCmdTxLock;
+
+// Display line being written, guarded by aoaCmdTxLock. Room for "\r\n".
+static char aoaCmdLine[AOA_CMD_DISPLAY_LINE_SIZE + 2];
+
+// Posted by AoACmd_sendRsp once the application is done with the frame
+static Semaphore_Struct aoaCmdRelease;
+
+// Frame handed to the application and the flag guarding it
+static AoACmd_Frame aoaCmdFrame;
+static volatile bool aoaCmdPending = FALSE;
+
+// Frame being parsed
+static AoACmd_Frame aoaCmdRxFrame;
+static uint8_t aoaCmdRxState = AOA_CMD_RX_SOF;
+static uint8_t aoaCmdRxIdx = 0;
+static uint8_t aoaCmdRxFcs = 0;
+
+static AoACmd_Stats aoaCmdStats;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void AoACmd_taskFxn(UArg a0, UArg a1);
+static bool AoACmd_parseByte(uint8_t b);
+static void AoACmd_sendFrame(uint8_t cmd, const uint8_t *pHdr, uint8_t hdrLen,
+                             const uint8_t *pData, uint8_t len);
+static void AoACmd_displayClear(Display_Handle handle);
+static void AoACmd_displayClearLines(Display_Handle handle, uint8_t fromLine,
+                                     uint8_t toLine);
+static void AoACmd_displayVprintf(Display_Handle handle, uint8_t line,
+                                  uint8_t column, char *fmt, va_list va);
+static void AoACmd_displayClose(Display_Handle handle);
+static int AoACmd_displayControl(Display_Handle handle, unsigned int cmd,
+                                 void *arg);
+static unsigned int AoACmd_displayGetType(void);
+
+/*********************************************************************
+ * DISPLAY CALLBACKS
+ */
+
+// Display on the command UART. Not in the board's Display_config, so it
+// is never initialized or opened through the Display driver.
+static const Display_FxnTable aoaCmdDisplayFxnTable =
+{
+  NULL,                     // Init function pointer
+  NULL,                     // Open function pointer
+  AoACmd_displayClear,      // Clear function pointer
+  AoACmd_displayClearLines, // Clear lines function pointer
+  AoACmd_displayVprintf,    // Print function pointer
+  AoACmd_displayClose,      // Close function pointer
+  AoACmd_displayControl,    // Control function pointer
+  AoACmd_displayGetType     // Get type function pointer
+};
+
+static Display_Config aoaCmdDisplay =
+{
+  &aoaCmdDisplayFxnTable,
+  NULL,
+  NULL
+};
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      AoACmd_init
+ *
+ * @brief   Open Board_UART0 and start the command reader task.
+ *
+ * @param   hEvent  - event the application task pends on
+ * @param   eventId - posted on hEvent when a frame is ready
+ *
+ * @return  none
+ */
+void AoACmd_init(Event_Handle hEvent, uint32_t eventId)
+{
+  Task_Params taskParams;
+  Semaphore_Params semParams;
+  UART_Params uartParams;
+  UART_Handle hUart;
+
+  UART_Params_init(&uartParams);
+  uartParams.readDataMode = UART_DATA_BINARY;
+  uartParams.writeDataMode = UART_DATA_BINARY;
+  uartParams.readReturnMode = UART_RETURN_FULL;
+  uartParams.readEcho = UART_ECHO_OFF;
+  uartParams.baudRate = AOA_CMD_UART_BAUD_RATE;
+
+  // Fails if something else, such as a UART Display, already has it
+  hUart = UART_open(Board_UART0, &uartParams);
+
+  if (hUart == NULL)
+  {
+    return;
+  }
+
+  // Let reads return whatever arrived once the line goes idle
+  UART_control(hUart, UARTCC26XX_CMD_RETURN_PARTIAL_ENABLE, NULL);
+
+  aoaCmdUart = hUart;
+  aoaCmdEvent = hEvent;
+  aoaCmdEventId = eventId;
+
+  Semaphore_Params_init(&semParams);
+  semParams.mode = Semaphore_Mode_BINARY;
+  Semaphore_construct(&aoaCmdRelease, 0, &semParams);
+  Semaphore_construct(&aoaCmdTxLock, 1, &semParams);
+
+  Task_Params_init(&taskParams);
+  taskParams.stack = aoaCmdTaskStack;
+  taskParams.stackSize = AOA_CMD_TASK_STACK_SIZE;
+  taskParams.priority = AOA_CMD_TASK_PRIORITY;
+
+  Task_construct(&aoaCmdTask, AoACmd_taskFxn, &taskParams, NULL);
+}
+
+/*********************************************************************
+ * @fn      AoACmd_openDisplay
+ *
+ * @brief   Get a Display that writes its text to the command UART.
+ *
+ * @return  Display handle, NULL if the command UART is not open
+ */
+Display_Handle AoACmd_openDisplay(void)
+{
+  return (aoaCmdUart != NULL) ? &aoaCmdDisplay : NULL;
+}
+
+/*********************************************************************
+ * @fn      AoACmd_getFrame
+ *
+ * @brief   Get the frame announced by the command event.
+ *
+ * @return  the pending frame, NULL if there is none
+ */
+AoACmd_Frame *AoACmd_getFrame(void)
+{
+  return aoaCmdPending ? &aoaCmdFrame : NULL;
+}
+
+/*********************************************************************
+ * @fn      AoACmd_sendRsp
+ *
+ * @brief   Send the response to the pending frame and release it.
+ *
+ * @param   status - response status
+ * @param   pData  - response data
+ * @param   len    - number of bytes in pData
+ *
+ * @return  none
+ */
+void AoACmd_sendRsp(uint8_t status, const uint8_t *pData, uint8_t len)
+{
+  if (!aoaCmdPending)
+  {
+    return;
+  }
+
+  AoACmd_sendFrame(aoaCmdFrame.cmd | AOA_CMD_RSP_FLAG, &status, 1, pData, len);
+
+  // Hand the frame buffer back to the reader
+  aoaCmdPending = FALSE;
+  Semaphore_post(Semaphore_handle(&aoaCmdRelease));
+}
+
+/*********************************************************************
+ * @fn      AoACmd_sendInd
+ *
+ * @brief   Send an indication.
+ *
+ * @param   cmd   - AOA_CMD_IND_xxx
+ * @param   pData - indication data
+ * @param   len   - number of bytes in pData
+ *
+ * @return  none
+ */
+void AoACmd_sendInd(uint8_t cmd, const uint8_t *pData, uint8_t len)
+{
+  if (aoaCmdUart != NULL)
+  {
+    AoACmd_sendFrame(cmd, NULL, 0, pData, len);
+  }
+}
+
+/*********************************************************************
+ * @fn      AoACmd_getStats
+ *
+ * @brief   Read the reader statistics.
+ *
+ * @param   pStats - filled with a snapshot of the statistics
+ *
+ * @return  none
+ */
+void AoACmd_getStats(AoACmd_Stats *pStats)
+{
+  *pStats = aoaCmdStats;
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      AoACmd_taskFxn
+ *
+ * @brief   Reader task. Parses the UART byte stream and hands complete
+ *          frames to the application one at a time.
+ *
+ * @param   a0, a1 - not used
+ *
+ * @return  none
+ */
+static void AoACmd_taskFxn(UArg a0, UArg a1)
+{
+  uint8_t rxBuf[AOA_CMD_RX_CHUNK];
+
+  for (;;)
+  {
+    int rxLen = UART_read(aoaCmdUart, rxBuf, sizeof(rxBuf));
+    int i;
+
+    for (i = 0; i < rxLen; i++)
+    {
+      if (AoACmd_parseByte(rxBuf[i]))
+      {
+        // Publish the frame and wait until the application responds.
+        // Bytes arriving meanwhile stay in the driver ring buffer.
+        aoaCmdFrame = aoaCmdRxFrame;
+        aoaCmdPending = TRUE;
+
+        Event_post(aoaCmdEvent, aoaCmdEventId);
+        Semaphore_pend(Semaphore_handle(&aoaCmdRelease), BIOS_WAIT_FOREVER);
+      }
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      AoACmd_sendFrame
+ *
+ * @brief   Build and write one frame.
+ *
+ * @param   cmd    - CMD field
+ * @param   pHdr   - bytes placed before pData (the response status)
+ * @param   hdrLen - number of bytes in pHdr
+ * @param   pData  - frame data
+ * @param   len    - number of bytes in pData, truncated to fit
+ *
+ * @return  none
+ */
+static void AoACmd_sendFrame(uint8_t cmd, const uint8_t *pHdr, uint8_t hdrLen,
+                             const uint8_t *pData, uint8_t len)
+{
+  uint8_t frame[AOA_CMD_MAX_PAYLOAD + 4];
+  uint8_t fcs;
+  uint8_t i;
+
+  if (len > AOA_CMD_MAX_PAYLOAD - hdrLen)
+  {
+    len = AOA_CMD_MAX_PAYLOAD - hdrLen;
+  }
+
+  frame[0] = AOA_CMD_SOF;
+  frame[1] = hdrLen + len;
+  frame[2] = cmd;
+
+  if (hdrLen > 0)
+  {
+    memcpy(&frame[3], pHdr, hdrLen);
+  }
+
+  if (len > 0)
+  {
+    memcpy(&frame[3 + hdrLen], pData, len);
+  }
+
+  fcs = 0;
+  for (i = 1; i < frame[1] + 3; i++)
+  {
+    fcs ^= frame[i];
+  }
+  frame[frame[1] + 3] = fcs;
+
+  Semaphore_pend(Semaphore_handle(&aoaCmdTxLock), BIOS_WAIT_FOREVER);
+  UART_write(aoaCmdUart, frame, frame[1] + 4);
+  Semaphore_post(Semaphore_handle(&aoaCmdTxLock));
+}
+
+/*********************************************************************
+ * @fn      AoACmd_displayClear
+ *
+ * @brief   Display clear. Lines are written in order, there is nothing
+ *          to clear.
+ *
+ * @param   handle - display
+ *
+ * @return  none
+ */
+static void AoACmd_displayClear(Display_Handle handle)
+{
+  (void)handle;
+}
+
+/*********************************************************************
+ * @fn      AoACmd_displayClearLines
+ *
+ * @brief   Display clear of a range of lines, see AoACmd_displayClear.
+ *
+ * @param   handle   - display
+ * @param   fromLine - first line
+ * @param   toLine   - last line
+ *
+ * @return  none
+ */
+static void AoACmd_displayClearLines(Display_Handle handle, uint8_t fromLine,
+                                     uint8_t toLine)
+{
+  (void)handle;
+  (void)fromLine;
+  (void)toLine;
+}
+
+/*********************************************************************
+ * @fn      AoACmd_displayVprintf
+ *
+ * @brief   Write one line of Display text between frames. The line and
+ *          column are not used: the text goes out as a line of its own,
+ *          so the host tool can skip it.
+ *
+ * @param   handle - display
+ * @param   line   - not used
+ * @param   column - not used
+ * @param   fmt    - printf format
+ * @param   va     - format arguments
+ *
+ * @return  none
+ */
+static void AoACmd_displayVprintf(Display_Handle handle, uint8_t line,
+                                  uint8_t column, char *fmt, va_list va)
+{
+  size_t len;
+
+  (void)handle;
+  (void)line;
+  (void)column;
+
+  Semaphore_pend(Semaphore_handle(&aoaCmdTxLock), BIOS_WAIT_FOREVER);
+
+  SystemP_vsnprintf(aoaCmdLine, AOA_CMD_DISPLAY_LINE_SIZE, fmt, va);
+
+  // Some callers end their text with "\n\r" already
+  len = strlen(aoaCmdLine);
+  while (len > 0 && (aoaCmdLine[len - 1] == '\r' || aoaCmdLine[len - 1] == '\n'))
+  {
+    len--;
+  }
+
+  aoaCmdLine[len++] = '\r';
+  aoaCmdLine[len++] = '\n';
+
+  UART_write(aoaCmdUart, aoaCmdLine, len);
+
+  Semaphore_post(Semaphore_handle(&aoaCmdTxLock));
+}
+
+/*********************************************************************
+ * @fn      AoACmd_displayClose
+ *
+ * @brief   Display close. The UART stays open for the command link.
+ *
+ * @param   handle - display
+ *
+ * @return  none
+ */
+static void AoACmd_displayClose(Display_Handle handle)
+{
+  (void)handle;
+}
+
+/*********************************************************************
+ * @fn      AoACmd_displayControl
+ *
+ * @brief   Display control. No commands are supported.
+ *
+ * @param   handle - display
+ * @param   cmd    - DISPLAY_CMD_xxx
+ * @param   arg    - command argument
+ *
+ * @return  DISPLAY_STATUS_UNDEFINEDCMD
+ */
+static int AoACmd_displayControl(Display_Handle handle, unsigned int cmd,
+                                 void *arg)
+{
+  (void)handle;
+  (void)cmd;
+  (void)arg;
+
+  return DISPLAY_STATUS_UNDEFINEDCMD;
+}
+
+/*********************************************************************
+ * @fn      AoACmd_displayGetType
+ *
+ * @brief   Display type, a UART for the application.
+ *
+ * @return  Display_Type_UART
+ */
+static unsigned int AoACmd_displayGetType(void)
+{
+  return Display_Type_UART;
+}
+
+/*********************************************************************
+ * @fn      AoACmd_parseByte
+ *
+ * @brief   Feed one byte to the frame parser.
+ *
+ * @param   b - received byte
+ *
+ * @return  TRUE when b completes a frame with a valid FCS
+ */
+static bool AoACmd_parseByte(uint8_t b)
+{
+  switch (aoaCmdRxState)
+  {
+    case AOA_CMD_RX_SOF:
+      if (b == AOA_CMD_SOF)
+      {
+        aoaCmdRxState = AOA_CMD_RX_LEN;
+      }
+      break;
+
+    case AOA_CMD_RX_LEN:
+      if (b > AOA_CMD_MAX_PAYLOAD)
+      {
+        aoaCmdStats.numOverruns++;
+        aoaCmdRxState = AOA_CMD_RX_SOF;
+      }
+      else
+      {
+        aoaCmdRxFrame.len = b;
+        aoaCmdRxFcs = b;
+        aoaCmdRxIdx = 0;
+        aoaCmdRxState = AOA_CMD_RX_CMD;
+      }
+      break;
+
+    case AOA_CMD_RX_CMD:
+      aoaCmdRxFrame.cmd = b;
+      aoaCmdRxFcs ^= b;
+      aoaCmdRxState = (aoaCmdRxFrame.len > 0) ? AOA_CMD_RX_DATA : AOA_CMD_RX_FCS;
+      break;
+
+    case AOA_CMD_RX_DATA:
+      aoaCmdRxFrame.data[aoaCmdRxIdx++] = b;
+      aoaCmdRxFcs ^= b;
+      if (aoaCmdRxIdx == aoaCmdRxFrame.len)
+      {
+        aoaCmdRxState = AOA_CMD_RX_FCS;
+      }
+      break;
+
+    case AOA_CMD_RX_FCS:
+    default:
+      aoaCmdRxState = AOA_CMD_RX_SOF;
+      if (b == aoaCmdRxFcs)
+      {
+        aoaCmdStats.numFrames++;
+        return TRUE;
+      }
+      aoaCmdStats.numFcsErrors++;
+      break;
+  }
+
+  return FALSE;
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,307 @@
+/******************************************************************************
+
+ @file       aoa_cmd.h
+
+ @brief Binary command interface for the AoA Receiver over UART.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+#ifndef AOACMD_H
+#define AOACMD_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <ti/display/Display.h>
+#include <ti/sysbios/knl/Event.h>
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Frame layout, both directions:
+//
+//   SOF | LEN | CMD | DATA[LEN] | FCS
+//
+// FCS is the XOR of LEN, CMD and DATA. A response echoes the command
+// with AOA_CMD_RSP_FLAG set and starts DATA with a status byte.
+#define AOA_CMD_SOF                           0xFE
+#define AOA_CMD_RSP_FLAG                      0x80
+
+// Largest DATA field accepted or sent
+#ifndef AOA_CMD_MAX_PAYLOAD
+#define AOA_CMD_MAX_PAYLOAD                   64
+#endif
+
+// Protocol version reported by AOA_CMD_PING
+#define AOA_CMD_VERSION                       0x01
+
+// Commands
+#define AOA_CMD_PING                          0x01  // -> version
+#define AOA_CMD_GET_STATE                     0x02  // -> state block
+#define AOA_CMD_GET_STATS                     0x03  // group -> statistics
+#define AOA_CMD_GET_DEVICES                   0x04  // [uint16 first] -> device table page
+#define AOA_CMD_IDLE_AOA_START                0x10
+#define AOA_CMD_IDLE_AOA_STOP                 0x11
+#define AOA_CMD_DISCOVER                      0x12  // [AOA_CMD_DISC_xxx bit-mask]
+#define AOA_CMD_CONNECT                       0x13  // addrType, addr[6]
+#define AOA_CMD_DISCONNECT                    0x14
+#define AOA_CMD_CONN_AOA                      0x15  // AOA_CMD_CONN_AOA_xxx
+#define AOA_CMD_DISCOVER_STOP                 0x16
+#define AOA_CMD_SET_CHANNELS                  0x20  // ch[1..AOA_MAX_CHANNELS]
+#define AOA_CMD_SET_RSSI_THRESHOLD            0x21  // int8 threshold, int8 hysteresis
+#define AOA_CMD_SET_RSSI_FILTER               0x22  // alpha (1..16)
+#define AOA_CMD_SET_OPTIONS                   0x23  // AOA_CMD_OPT_xxx bit-mask
+#define AOA_CMD_FILTER_ADD                    0x24  // addr[6]
+#define AOA_CMD_FILTER_CLEAR                  0x25
+#define AOA_CMD_SET_IQ_GATE                   0x26  // uint16 amplitude, coherence %
+#define AOA_CMD_SET_SLOT_MAP                  0x27  // skip, keep (samples per slot)
+#define AOA_CMD_ANT_BEGIN                     0x28  // array, numAntennas, numPatterns, numPairs, uint32 initialPattern
+#define AOA_CMD_ANT_PATTERNS                  0x29  // array, first, uint32 pins[1..15]
+#define AOA_CMD_ANT_PAIR                      0x2A  // array, index, a, b, int8 sign, int8 offset, float gain
+#define AOA_CMD_ANT_COMMIT                    0x2B  // array, AOA_CMD_ANT_xxx bit-mask
+#define AOA_CMD_ANT_RESTORE                   0x2C  // array
+#define AOA_CMD_ANT_GEOMETRY                  0x2D  // array, int16 mountAzimuth, int16 x, y[numAntennas] (0.1 mm)
+#define AOA_CMD_SET_DUTY                      0x2E  // maxRate, minRate, ratePerTag, uint16 tagWindow (ms)
+#define AOA_CMD_SET_TRIGGER                   0x2F  // uint16 connHandle (0xFFFF all), int8 threshold, int8 hysteresis,
+                                                    // alpha, uint16 minOn, minOff, requestGap (ms)
+#define AOA_CMD_SET_CONN_CTRL                 0x30  // uint16 connHandle (0xFFFF all), activeRate, stillRate,
+                                                    // uint16 idleInterval, motionAngle, uint16 motionHold, updateGap (ms)
+#define AOA_CMD_SET_SENDER                    0x31  // burst, uint16 period (1.25 ms, 0 = connection interval)
+#define AOA_CMD_SET_BACKHAUL                  0x32  // uint16 flush (ms), AOA_HUB_LINK only
+
+// Test injection, only in receivers built with AOA_INJECT
+#define AOA_CMD_INJECT_ADV                    0x33  // addrType, addr[6], int8 rssi, advData[0..31]
+#define AOA_CMD_INJECT_CONN_EVT               0x34  // uint16 connHandle, status, int8 lastRssi
+#define AOA_CMD_INJECT_IQ_BEGIN               0x35  // array, channel, int8 rssi, shift, slotLen,
+                                                    // uint16 numSamples, addr[6]
+#define AOA_CMD_INJECT_IQ_DATA                0x36  // uint16 first, int8 i, q[1..AOA_CMD_INJECT_IQ_MAX]
+#define AOA_CMD_INJECT_IQ_COMMIT              0x37
+
+// Packed I/Q samples carried by one AOA_CMD_INJECT_IQ_DATA
+#define AOA_CMD_INJECT_IQ_MAX                 ((AOA_CMD_MAX_PAYLOAD - 2) / 2)
+
+// Benchmarks, only in receivers built with AOA_BENCH
+#define AOA_CMD_BENCH                         0x38  // AOA_CMD_BENCH_xxx, uint16 iterations
+                                                    // -> unit, uint16 count, uint32 min, avg, max
+
+// AOA_CMD_GET_DEVICES response: uint16 count, uint16 first, then one
+// entry per device: addrType, addr[6], int8 rssi, flags, uint16 age (ms)
+#define AOA_CMD_DEVICE_ENTRY_LEN              11
+
+// Indications, sent unsolicited without a status byte
+#define AOA_CMD_IND_DEVICE                    0x40  // addrType, addr[6], int8 rssi
+#define AOA_CMD_IND_ANGLE                     0x41  // addr[6], int16 angle, int16 current, int16 elevation,
+                                                    // int16 currentElevation, int8 rssi, channel, antenna,
+                                                    // uint16 estimate (us)
+#define AOA_CMD_IND_IQ_BEGIN                  0x42  // Capture header, as AOA_CMD_INJECT_IQ_BEGIN
+#define AOA_CMD_IND_IQ_DATA                   0x43  // Capture samples, as AOA_CMD_INJECT_IQ_DATA
+
+// AOA_CMD_IND_ANGLE elevation when the array resolves none
+#define AOA_CMD_NO_ELEVATION                  0x7FFF
+
+// AOA_CMD_DISCOVER options
+#define AOA_CMD_DISC_CONTINUOUS               0x01  // Restart rounds until stopped
+#define AOA_CMD_DISC_AUTO_CONNECT             0x02  // Connect to new AoA senders
+
+// AOA_CMD_CONN_AOA modes
+#define AOA_CMD_CONN_AOA_OFF                  0x00
+#define AOA_CMD_CONN_AOA_MANUAL               0x01
+#define AOA_CMD_CONN_AOA_AUTO                 0x02
+
+// AOA_CMD_SET_OPTIONS bits
+#define AOA_CMD_OPT_PIPELINED                 0x01
+#define AOA_CMD_OPT_COALESCE                  0x02
+#define AOA_CMD_OPT_FAST_DISC                 0x04
+#define AOA_CMD_OPT_ANGLE_IND                 0x08  // Send AOA_CMD_IND_ANGLE per angle
+#define AOA_CMD_OPT_IQ_IND                    0x10  // Send every capture before estimation
+#define AOA_CMD_OPT_FUSION                    0x20  // One angle per tag and channel cycle
+
+// AOA_CMD_BENCH code sections
+#define AOA_CMD_BENCH_PAIR_ANGLES             0x00  // Pair angles of one capture
+#define AOA_CMD_BENCH_ESTIMATE                0x01  // Angle from both arrays' pair angles
+#define AOA_CMD_BENCH_FIND_SVC                0x02  // Service UUID search in advertising data
+#define AOA_CMD_BENCH_ADD_DEVICE              0x03  // Device table refresh of a known device
+#define AOA_CMD_BENCH_QUEUE                   0x04  // App message through the pooled queue
+#define AOA_CMD_BENCH_UTIL_QUEUE              0x05  // Util_enqueueMsg + Util_dequeueMsg
+#define AOA_CMD_BENCH_IQ_COPY                 0x06  // Capture copy out of the driver buffer
+
+// AOA_CMD_ANT_COMMIT options
+#define AOA_CMD_ANT_PERSIST                   0x01  // Also store in SNV
+
+// AOA_CMD_GET_STATS groups. Group AOA_CMD_STATS_POOL + n reads message
+// pool size class n.
+#define AOA_CMD_STATS_COUNTERS                0x00
+#define AOA_CMD_STATS_TRIGGER                 0x01  // uint32 requests, held
+#define AOA_CMD_STATS_CONN_CTRL               0x02  // uint32 requests, failures, uint16 interval
+#define AOA_CMD_STATS_LINK                    0x03  // uint32 ms to handles, ms to first angle (last link)
+#define AOA_CMD_STATS_BACKHAUL                0x04  // uint32 records, notifications, dropped (AOA_HUB_LINK)
+#define AOA_CMD_STATS_POOL                    0x10
+
+// Counters returned by AOA_CMD_STATS_COUNTERS, in this order, as
+// little endian uint32
+#define AOA_CMD_STAT_AOA_REPORTS              0
+#define AOA_CMD_STAT_AOA_FAILURES             1
+#define AOA_CMD_STAT_ANGLES                   2
+#define AOA_CMD_STAT_WORKER_DROPS             3
+#define AOA_CMD_STAT_CONN_EVT_COALESCED       4
+#define AOA_CMD_STAT_CMD_FRAMES               5
+#define AOA_CMD_STAT_CMD_FCS_ERRORS           6
+#define AOA_CMD_STAT_CMD_OVERRUNS             7
+#define AOA_CMD_STAT_AOA_FILTERED             8
+#define AOA_CMD_STAT_IQ_LOW_AMPLITUDE         9
+#define AOA_CMD_STAT_IQ_LOW_COHERENCE         10
+#define AOA_CMD_STAT_RADIO_ON_MS              11
+#define AOA_CMD_STAT_DUTY_ROUNDS              12
+#define AOA_CMD_STAT_DUTY_WAITS               13
+#define AOA_CMD_NUM_STATS                     14
+
+// Response status codes. Handlers report bStatus_t values (SUCCESS,
+// INVALIDPARAMETER, bleIncorrectMode, ...); the command plane adds
+// these for frames it cannot dispatch.
+#define AOA_CMD_STATUS_UNKNOWN_CMD            0xE0
+#define AOA_CMD_STATUS_BAD_LENGTH             0xE1
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Received command frame
+typedef struct
+{
+  uint8_t cmd;                          // Command identifier
+  uint8_t len;                          // Number of bytes in data
+  uint8_t data[AOA_CMD_MAX_PAYLOAD];    // Command parameters
+} AoACmd_Frame;
+
+// Reader statistics
+typedef struct
+{
+  uint32_t numFrames;     // Frames with a valid FCS
+  uint32_t numFcsErrors;  // Frames dropped on FCS mismatch
+  uint32_t numOverruns;   // Frames dropped for LEN > AOA_CMD_MAX_PAYLOAD
+} AoACmd_Stats;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * @brief   Open Board_UART0 and start the command reader task.
+ *
+ *          The command link needs the UART to itself. Do not open a
+ *          UART Display next to it: use AoACmd_openDisplay instead, or
+ *          build with the LCD Display or none.
+ *
+ * @param   hEvent  - event the application task pends on
+ * @param   eventId - posted on hEvent when a frame is ready
+ */
+extern void AoACmd_init(Event_Handle hEvent, uint32_t eventId);
+
+/*
+ * @brief   Get a Display that writes its text to the command UART, one
+ *          line at a time between frames. Call after AoACmd_init.
+ *          Line and column are ignored, the text is not positioned.
+ *
+ * @return  Display handle, NULL if the command UART is not open
+ */
+extern Display_Handle AoACmd_openDisplay(void);
+
+/*
+ * @brief   Get the frame announced by eventId.
+ *
+ * @return  the pending frame, NULL if there is none
+ */
+extern AoACmd_Frame *AoACmd_getFrame(void);
+
+/*
+ * @brief   Send the response to the pending frame and release it so
+ *          the reader can deliver the next one. The frame is written
+ *          whole, never inside a Display line.
+ *
+ * @param   status - response status
+ * @param   pData  - response data, may be NULL if len is 0
+ * @param   len    - number of bytes in pData (truncated to
+ *                   AOA_CMD_MAX_PAYLOAD - 1)
+ */
+extern void AoACmd_sendRsp(uint8_t status, const uint8_t *pData, uint8_t len);
+
+/*
+ * @brief   Send an indication, written whole like AoACmd_sendRsp.
+ *
+ * @param   cmd   - AOA_CMD_IND_xxx
+ * @param   pData - indication data, may be NULL if len is 0
+ * @param   len   - number of bytes in pData (truncated to
+ *                  AOA_CMD_MAX_PAYLOAD)
+ */
+extern void AoACmd_sendInd(uint8_t cmd, const uint8_t *pData, uint8_t len);
+
+/*
+ * @brief   Read the reader statistics.
+ *
+ * @param   pStats - filled with a snapshot of the statistics
+ */
+extern void AoACmd_getStats(AoACmd_Stats *pStats);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AOACMD_H */
@@ -0,0 +1,487 @@
+/******************************************************************************
+
+ @file       aoa_conn_ctrl.c
+
+ @brief Connection interval control from the wanted AoA angle rate.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+
+#include "aoa_conn_ctrl.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// An update takes effect at an instant at least 6 connection events
+// ahead. A request without an answer after this many events of the old
+// interval is given up.
+#define AOA_CONN_CTRL_PENDING_EVENTS          16
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Controller state of one peer
+typedef struct
+{
+  AoAConnCtrl_Cfg cfg;
+  uint16_t interval;      // In use, 1.25 ms units, 0 if unknown
+  bool     pending;       // An update was requested and not answered
+  bool     requested;     // lastRequest is valid
+  bool     hasAngle;      // lastAngle is valid
+  bool     moved;         // lastMotion is valid
+  int16_t  lastAngle;     // Angle at the last movement
+  uint32_t lastRequest;
+  uint32_t lastMotion;
+} AoAConnCtrl_Peer;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint32_t ctrlTicksPerMs = 1;
+static AoAConnCtrl_Cfg ctrlDefaultCfg;
+static AoAConnCtrl_Peer ctrlPeers[AOA_CONN_CTRL_MAX_PEERS];
+static AoAConnCtrl_Stats ctrlStats;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static bool AoAConnCtrl_validCfg(const AoAConnCtrl_Cfg *pCfg);
+static uint16_t AoAConnCtrl_rateInterval(uint8_t rate);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      AoAConnCtrl_init
+ *
+ * @brief   Initialize the controller.
+ *
+ * @param   pCfg       - policy of every peer
+ * @param   ticksPerMs - ticks per millisecond
+ *
+ * @return  None
+ */
+void AoAConnCtrl_init(const AoAConnCtrl_Cfg *pCfg, uint32_t ticksPerMs)
+{
+  uint8_t i;
+
+  ctrlTicksPerMs = (ticksPerMs != 0) ? ticksPerMs : 1;
+  ctrlDefaultCfg = *pCfg;
+
+  memset(ctrlPeers, 0, sizeof(ctrlPeers));
+  memset(&ctrlStats, 0, sizeof(ctrlStats));
+
+  for (i = 0; i < AOA_CONN_CTRL_MAX_PEERS; i++)
+  {
+    ctrlPeers[i].cfg = *pCfg;
+  }
+}
+
+/*********************************************************************
+ * @fn      AoAConnCtrl_setCfg
+ *
+ * @brief   Set the policy of a peer.
+ *
+ * @param   connHandle - peer or AOA_CONN_CTRL_ALL_PEERS
+ * @param   pCfg       - policy
+ *
+ * @return  SUCCESS or INVALIDPARAMETER
+ */
+bStatus_t AoAConnCtrl_setCfg(uint16_t connHandle, const AoAConnCtrl_Cfg *pCfg)
+{
+  uint8_t i;
+
+  if (!AoAConnCtrl_validCfg(pCfg))
+  {
+    return INVALIDPARAMETER;
+  }
+
+  if (connHandle == AOA_CONN_CTRL_ALL_PEERS)
+  {
+    ctrlDefaultCfg = *pCfg;
+
+    for (i = 0; i < AOA_CONN_CTRL_MAX_PEERS; i++)
+    {
+      ctrlPeers[i].cfg = *pCfg;
+    }
+  }
+  else if (connHandle < AOA_CONN_CTRL_MAX_PEERS)
+  {
+    ctrlPeers[connHandle].cfg = *pCfg;
+  }
+  else
+  {
+    return INVALIDPARAMETER;
+  }
+
+  return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      AoAConnCtrl_open
+ *
+ * @brief   A peer connected.
+ *
+ * @param   connHandle   - peer
+ * @param   connInterval - interval of the new link, 1.25 ms units
+ * @param   now          - current time
+ *
+ * @return  None
+ */
+void AoAConnCtrl_open(uint16_t connHandle, uint16_t connInterval, uint32_t now)
+{
+  AoAConnCtrl_Peer *pPeer;
+
+  if (connHandle >= AOA_CONN_CTRL_MAX_PEERS)
+  {
+    return;
+  }
+
+  pPeer = &ctrlPeers[connHandle];
+
+  memset(pPeer, 0, sizeof(*pPeer));
+  pPeer->cfg = ctrlDefaultCfg;
+  pPeer->interval = connInterval;
+
+  // Leave the peripheral its own parameter request first
+  pPeer->requested = true;
+  pPeer->lastRequest = now;
+}
+
+/*********************************************************************
+ * @fn      AoAConnCtrl_updated
+ *
+ * @brief   An update of a peer's link completed.
+ *
+ * @param   connHandle   - peer
+ * @param   status       - SUCCESS or the reason it failed
+ * @param   connInterval - interval in use now, 1.25 ms units
+ *
+ * @return  None
+ */
+void AoAConnCtrl_updated(uint16_t connHandle, uint8_t status, uint16_t connInterval)
+{
+  AoAConnCtrl_Peer *pPeer;
+
+  if (connHandle >= AOA_CONN_CTRL_MAX_PEERS)
+  {
+    return;
+  }
+
+  pPeer = &ctrlPeers[connHandle];
+
+  // Also completes updates the peripheral asked for
+  if (status == SUCCESS)
+  {
+    pPeer->interval = connInterval;
+  }
+  else if (pPeer->pending)
+  {
+    ctrlStats.numFailures++;
+  }
+
+  pPeer->pending = false;
+}
+
+/*********************************************************************
+ * @fn      AoAConnCtrl_angle
+ *
+ * @brief   An angle of a peer was estimated.
+ *
+ * @param   connHandle - peer
+ * @param   angle      - degrees
+ * @param   now        - current time
+ *
+ * @return  None
+ */
+void AoAConnCtrl_angle(uint16_t connHandle, int16_t angle, uint32_t now)
+{
+  AoAConnCtrl_Peer *pPeer;
+  int16_t delta;
+
+  if (connHandle >= AOA_CONN_CTRL_MAX_PEERS)
+  {
+    return;
+  }
+
+  pPeer = &ctrlPeers[connHandle];
+
+  if (!pPeer->hasAngle)
+  {
+    pPeer->lastAngle = angle;
+    pPeer->hasAngle = true;
+    return;
+  }
+
+  // The reference only moves with the tag, so a slow drift adds up
+  delta = angle - pPeer->lastAngle;
+  if (delta > 180)
+  {
+    delta -= 360;
+  }
+  else if (delta < -180)
+  {
+    delta += 360;
+  }
+
+  if (delta < 0)
+  {
+    delta = -delta;
+  }
+
+  if (delta >= pPeer->cfg.motionAngle)
+  {
+    pPeer->lastAngle = angle;
+    pPeer->moved = true;
+    pPeer->lastMotion = now;
+  }
+}
+
+/*********************************************************************
+ * @fn      AoAConnCtrl_target
+ *
+ * @brief   Interval the policy wants for a peer now.
+ *
+ * @param   connHandle   - peer
+ * @param   senderActive - the sender was asked to transmit
+ * @param   now          - current time
+ *
+ * @return  interval, 1.25 ms units, 0 if the controller is disabled
+ */
+uint16_t AoAConnCtrl_target(uint16_t connHandle, bool senderActive, uint32_t now)
+{
+  AoAConnCtrl_Peer *pPeer;
+
+  if (connHandle >= AOA_CONN_CTRL_MAX_PEERS)
+  {
+    return 0;
+  }
+
+  pPeer = &ctrlPeers[connHandle];
+
+  if (pPeer->cfg.activeRate == 0)
+  {
+    return 0;
+  }
+
+  if (!senderActive)
+  {
+    return pPeer->cfg.idleInterval;
+  }
+
+  if (pPeer->moved &&
+      now - pPeer->lastMotion < (uint32_t)pPeer->cfg.motionHold * ctrlTicksPerMs)
+  {
+    return AoAConnCtrl_rateInterval(pPeer->cfg.activeRate);
+  }
+
+  return AoAConnCtrl_rateInterval(pPeer->cfg.stillRate);
+}
+
+/*********************************************************************
+ * @fn      AoAConnCtrl_poll
+ *
+ * @brief   Check whether the link of a peer should be updated.
+ *
+ * @param   connHandle   - peer
+ * @param   senderActive - the sender was asked to transmit
+ * @param   now          - current time
+ * @param   pInterval    - filled with the interval to request
+ *
+ * @return  true if an update should be requested now
+ */
+bool AoAConnCtrl_poll(uint16_t connHandle, bool senderActive, uint32_t now,
+                      uint16_t *pInterval)
+{
+  AoAConnCtrl_Peer *pPeer;
+  uint16_t target = AoAConnCtrl_target(connHandle, senderActive, now);
+  uint32_t wait;
+
+  if (target == 0)
+  {
+    return false;
+  }
+
+  pPeer = &ctrlPeers[connHandle];
+
+  // Wait for the previous request, give it up if it is not answered
+  wait = (uint32_t)pPeer->cfg.minUpdateGap * ctrlTicksPerMs;
+  if (pPeer->pending)
+  {
+    wait += ((uint32_t)pPeer->interval * AOA_CONN_CTRL_PENDING_EVENTS * 5 / 4) * ctrlTicksPerMs;
+  }
+
+  if (pPeer->requested && now - pPeer->lastRequest < wait)
+  {
+    return false;
+  }
+
+  if (pPeer->pending)
+  {
+    pPeer->pending = false;
+    ctrlStats.numFailures++;
+  }
+
+  // Close enough, an update costs air time and a few events of latency
+  if (pPeer->interval != 0)
+  {
+    uint16_t diff = (target > pPeer->interval) ? target - pPeer->interval :
+                                                 pPeer->interval - target;
+
+    if (diff * 4 <= pPeer->interval)
+    {
+      return false;
+    }
+  }
+
+  pPeer->pending = true;
+  pPeer->requested = true;
+  pPeer->lastRequest = now;
+  ctrlStats.numRequests++;
+
+  *pInterval = target;
+
+  return true;
+}
+
+/*********************************************************************
+ * @fn      AoAConnCtrl_requestFailed
+ *
+ * @brief   The stack refused to start a requested update.
+ *
+ * @param   connHandle - peer
+ *
+ * @return  None
+ */
+void AoAConnCtrl_requestFailed(uint16_t connHandle)
+{
+  if (connHandle < AOA_CONN_CTRL_MAX_PEERS && ctrlPeers[connHandle].pending)
+  {
+    ctrlPeers[connHandle].pending = false;
+    ctrlStats.numFailures++;
+  }
+}
+
+/*********************************************************************
+ * @fn      AoAConnCtrl_getInterval
+ *
+ * @brief   Interval of a peer's link.
+ *
+ * @param   connHandle - peer
+ *
+ * @return  interval, 1.25 ms units, 0 if unknown
+ */
+uint16_t AoAConnCtrl_getInterval(uint16_t connHandle)
+{
+  return (connHandle < AOA_CONN_CTRL_MAX_PEERS) ? ctrlPeers[connHandle].interval : 0;
+}
+
+/*********************************************************************
+ * @fn      AoAConnCtrl_getStats
+ *
+ * @brief   Read the statistics.
+ *
+ * @param   pStats - filled with a snapshot of the statistics
+ *
+ * @return  None
+ */
+void AoAConnCtrl_getStats(AoAConnCtrl_Stats *pStats)
+{
+  *pStats = ctrlStats;
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      AoAConnCtrl_validCfg
+ *
+ * @brief   Check a policy.
+ *
+ * @param   pCfg - policy
+ *
+ * @return  true if usable
+ */
+static bool AoAConnCtrl_validCfg(const AoAConnCtrl_Cfg *pCfg)
+{
+  if (pCfg->activeRate == 0)
+  {
+    return true;
+  }
+
+  return pCfg->stillRate != 0 && pCfg->stillRate <= pCfg->activeRate &&
+         pCfg->idleInterval >= AOA_CONN_CTRL_MIN_INTERVAL &&
+         pCfg->idleInterval <= AOA_CONN_CTRL_MAX_INTERVAL;
+}
+
+/*********************************************************************
+ * @fn      AoAConnCtrl_rateInterval
+ *
+ * @brief   Longest interval that still gives an angle rate.
+ *
+ * @param   rate - angles per second, not 0
+ *
+ * @return  interval, 1.25 ms units
+ */
+static uint16_t AoAConnCtrl_rateInterval(uint8_t rate)
+{
+  // 800 intervals of 1.25 ms per second
+  uint16_t interval = 800 / (AOA_CONN_CTRL_EVENTS_PER_ANGLE * rate);
+
+  if (interval < AOA_CONN_CTRL_MIN_INTERVAL)
+  {
+    interval = AOA_CONN_CTRL_MIN_INTERVAL;
+  }
+
+  return interval;
+}
+
+/*********************************************************************
+*********************************************************************/
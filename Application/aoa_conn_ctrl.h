@@ -0,0 +1,228 @@
+/******************************************************************************
+
+ @file       aoa_conn_ctrl.h
+
+ @brief Connection interval control from the wanted AoA angle rate.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+#ifndef AOACONNCTRL_H
+#define AOACONNCTRL_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bcomdef.h"
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Peers tracked, indexed by connection handle
+#ifndef AOA_CONN_CTRL_MAX_PEERS
+#if defined(MAX_NUM_BLE_CONNS)
+#define AOA_CONN_CTRL_MAX_PEERS               MAX_NUM_BLE_CONNS
+#else
+#define AOA_CONN_CTRL_MAX_PEERS               1
+#endif
+#endif
+
+// AoAConnCtrl_setCfg handle addressing the default and every peer
+#define AOA_CONN_CTRL_ALL_PEERS               0xFFFF
+
+// Connection interval limits of the specification, 1.25 ms units
+#define AOA_CONN_CTRL_MIN_INTERVAL            6
+#define AOA_CONN_CTRL_MAX_INTERVAL            3200
+
+// Connection events per angle, one capture on each antenna array
+#define AOA_CONN_CTRL_EVENTS_PER_ANGLE        2
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Controller policy. While the sender is on, the interval gives
+// activeRate angles per second if the tag moved by motionAngle within
+// motionHold, stillRate otherwise. While it is off (the tag is out of
+// range or AoA is stopped) the link backs off to idleInterval.
+typedef struct
+{
+  uint8_t  activeRate;    // Angles per second, 0 disables the controller
+  uint8_t  stillRate;     // Angles per second, 1..activeRate
+  uint16_t idleInterval;  // 1.25 ms units
+  uint8_t  motionAngle;   // Degrees
+  uint16_t motionHold;    // ms
+  uint16_t minUpdateGap;  // ms between two update requests
+} AoAConnCtrl_Cfg;
+
+// Statistics, all peers
+typedef struct
+{
+  uint32_t numRequests;   // Updates requested
+  uint32_t numFailures;   // Requests the stack did not start or complete
+} AoAConnCtrl_Stats;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * @brief   Initialize the controller. All times are in the caller's
+ *          tick unit.
+ *
+ * @param   pCfg       - policy of every peer
+ * @param   ticksPerMs - ticks per millisecond
+ */
+extern void AoAConnCtrl_init(const AoAConnCtrl_Cfg *pCfg, uint32_t ticksPerMs);
+
+/*
+ * @brief   Set the policy of a peer.
+ *
+ * @param   connHandle - peer, AOA_CONN_CTRL_ALL_PEERS for all peers and
+ *                       those connecting later
+ * @param   pCfg       - policy
+ *
+ * @return  SUCCESS or INVALIDPARAMETER
+ */
+extern bStatus_t AoAConnCtrl_setCfg(uint16_t connHandle, const AoAConnCtrl_Cfg *pCfg);
+
+/*
+ * @brief   A peer connected.
+ *
+ * @param   connHandle   - peer
+ * @param   connInterval - interval of the new link, 1.25 ms units
+ * @param   now          - current time
+ */
+extern void AoAConnCtrl_open(uint16_t connHandle, uint16_t connInterval, uint32_t now);
+
+/*
+ * @brief   An update of a peer's link completed.
+ *
+ * @param   connHandle   - peer
+ * @param   status       - SUCCESS or the reason it failed
+ * @param   connInterval - interval in use now, 1.25 ms units
+ */
+extern void AoAConnCtrl_updated(uint16_t connHandle, uint8_t status,
+                                uint16_t connInterval);
+
+/*
+ * @brief   An angle of a peer was estimated.
+ *
+ * @param   connHandle - peer
+ * @param   angle      - degrees
+ * @param   now        - current time
+ */
+extern void AoAConnCtrl_angle(uint16_t connHandle, int16_t angle, uint32_t now);
+
+/*
+ * @brief   Interval the policy wants for a peer now.
+ *
+ * @param   connHandle   - peer
+ * @param   senderActive - the sender was asked to transmit
+ * @param   now          - current time
+ *
+ * @return  interval, 1.25 ms units, 0 if the controller is disabled
+ */
+extern uint16_t AoAConnCtrl_target(uint16_t connHandle, bool senderActive, uint32_t now);
+
+/*
+ * @brief   Check whether the link of a peer should be updated. The
+ *          interval in use is kept while it is within a quarter of the
+ *          target, and requests are spaced by minUpdateGap.
+ *
+ * @param   connHandle   - peer
+ * @param   senderActive - the sender was asked to transmit
+ * @param   now          - current time
+ * @param   pInterval    - filled with the interval to request
+ *
+ * @return  true if an update should be requested now, it is counted as
+ *          requested
+ */
+extern bool AoAConnCtrl_poll(uint16_t connHandle, bool senderActive, uint32_t now,
+                             uint16_t *pInterval);
+
+/*
+ * @brief   The stack refused to start a requested update.
+ *
+ * @param   connHandle - peer
+ */
+extern void AoAConnCtrl_requestFailed(uint16_t connHandle);
+
+/*
+ * @brief   Interval of a peer's link.
+ *
+ * @param   connHandle - peer
+ *
+ * @return  interval, 1.25 ms units, 0 if unknown
+ */
+extern uint16_t AoAConnCtrl_getInterval(uint16_t connHandle);
+
+/*
+ * @brief   Read the statistics.
+ *
+ * @param   pStats - filled with a snapshot of the statistics
+ */
+extern void AoAConnCtrl_getStats(AoAConnCtrl_Stats *pStats);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AOACONNCTRL_H */
@@ -0,0 +1,352 @@
+/******************************************************************************
+
+ @file       aoa_duty.c
+
+ @brief Capture scheduling for duty-cycled AoA scanning.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+
+#include "aoa_duty.h"
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Recently captured tag
+typedef struct
+{
+  uint8_t  addr[B_ADDR_LEN];
+  bool     used;
+  uint32_t lastSeen;
+} AoADuty_Tag;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint32_t dutyTicksPerMs = 1;
+static AoADuty_Cfg dutyCfg;
+static AoADuty_Stats dutyStats;
+
+static AoADuty_Tag dutyTags[AOA_DUTY_MAX_TAGS];
+
+// Start of the previous round, valid if dutyRoundStarted
+static uint32_t dutyLastRound;
+static bool dutyRoundStarted;
+
+// Armed capture, and radio time below one ms not yet counted
+static uint32_t dutyRadioOnAt;
+static bool dutyRadioOn;
+static uint32_t dutyRadioTicks;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint8_t AoADuty_countTags(uint32_t now);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      AoADuty_init
+ *
+ * @brief   Initialize the scheduler.
+ *
+ * @param   ticksPerMs - ticks per millisecond
+ *
+ * @return  None
+ */
+void AoADuty_init(uint32_t ticksPerMs)
+{
+  dutyTicksPerMs = (ticksPerMs != 0) ? ticksPerMs : 1;
+
+  memset(&dutyCfg, 0, sizeof(dutyCfg));
+  memset(&dutyStats, 0, sizeof(dutyStats));
+  dutyRadioOn = false;
+  dutyRadioTicks = 0;
+
+  AoADuty_reset();
+}
+
+/*********************************************************************
+ * @fn      AoADuty_setCfg
+ *
+ * @brief   Set the schedule.
+ *
+ * @param   pCfg - schedule
+ *
+ * @return  SUCCESS or INVALIDPARAMETER
+ */
+bStatus_t AoADuty_setCfg(const AoADuty_Cfg *pCfg)
+{
+  // A rate of 0 without tags would never see one again
+  if (pCfg->maxRate != 0 &&
+      (pCfg->minRate == 0 || pCfg->minRate > pCfg->maxRate || pCfg->tagWindow == 0))
+  {
+    return INVALIDPARAMETER;
+  }
+
+  dutyCfg = *pCfg;
+
+  return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      AoADuty_getCfg
+ *
+ * @brief   Read the schedule.
+ *
+ * @param   pCfg - filled with the schedule
+ *
+ * @return  None
+ */
+void AoADuty_getCfg(AoADuty_Cfg *pCfg)
+{
+  *pCfg = dutyCfg;
+}
+
+/*********************************************************************
+ * @fn      AoADuty_reset
+ *
+ * @brief   Forget the previous round and the recent tags.
+ *
+ * @return  None
+ */
+void AoADuty_reset(void)
+{
+  memset(dutyTags, 0, sizeof(dutyTags));
+  dutyRoundStarted = false;
+  dutyStats.numTags = 0;
+}
+
+/*********************************************************************
+ * @fn      AoADuty_nextRound
+ *
+ * @brief   Ask to start a round.
+ *
+ * @param   now - current time
+ *
+ * @return  0 if the round starts now, otherwise ms to stand by first
+ */
+uint32_t AoADuty_nextRound(uint32_t now)
+{
+  uint32_t rate;
+  uint32_t period;
+  uint32_t elapsed;
+
+  dutyStats.numTags = AoADuty_countTags(now);
+
+  if (dutyCfg.maxRate == 0)
+  {
+    dutyStats.rate = 0;
+    dutyStats.numRounds++;
+    return 0;
+  }
+
+  rate = dutyCfg.minRate + (uint32_t)dutyCfg.ratePerTag * dutyStats.numTags;
+  if (rate > dutyCfg.maxRate)
+  {
+    rate = dutyCfg.maxRate;
+  }
+  dutyStats.rate = (uint8_t)rate;
+
+  period = (1000 * dutyTicksPerMs) / rate;
+  elapsed = now - dutyLastRound;
+
+  if (dutyRoundStarted && elapsed < period)
+  {
+    dutyStats.numWaits++;
+
+    // Round up so the caller never wakes up early
+    return (period - elapsed + dutyTicksPerMs - 1) / dutyTicksPerMs;
+  }
+
+  dutyLastRound = now;
+  dutyRoundStarted = true;
+  dutyStats.numRounds++;
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      AoADuty_radioOn
+ *
+ * @brief   A capture was armed.
+ *
+ * @param   now - current time
+ *
+ * @return  None
+ */
+void AoADuty_radioOn(uint32_t now)
+{
+  dutyRadioOnAt = now;
+  dutyRadioOn = true;
+}
+
+/*********************************************************************
+ * @fn      AoADuty_radioOff
+ *
+ * @brief   The armed capture ended.
+ *
+ * @param   now - current time
+ *
+ * @return  None
+ */
+void AoADuty_radioOff(uint32_t now)
+{
+  if (!dutyRadioOn)
+  {
+    return;
+  }
+
+  dutyRadioOn = false;
+  dutyRadioTicks += now - dutyRadioOnAt;
+
+  dutyStats.radioOnMs += dutyRadioTicks / dutyTicksPerMs;
+  dutyRadioTicks %= dutyTicksPerMs;
+}
+
+/*********************************************************************
+ * @fn      AoADuty_tagSeen
+ *
+ * @brief   A tag was captured.
+ *
+ * @param   pAddr - tag address
+ * @param   now   - current time
+ *
+ * @return  None
+ */
+void AoADuty_tagSeen(const uint8_t *pAddr, uint32_t now)
+{
+  AoADuty_Tag *pTag = NULL;
+  uint8_t i;
+
+  for (i = 0; i < AOA_DUTY_MAX_TAGS; i++)
+  {
+    if (dutyTags[i].used && memcmp(dutyTags[i].addr, pAddr, B_ADDR_LEN) == 0)
+    {
+      dutyTags[i].lastSeen = now;
+      return;
+    }
+  }
+
+  // Take a free entry, or the one seen longest ago
+  for (i = 0; i < AOA_DUTY_MAX_TAGS; i++)
+  {
+    if (!dutyTags[i].used)
+    {
+      pTag = &dutyTags[i];
+      break;
+    }
+
+    if (pTag == NULL || now - dutyTags[i].lastSeen > now - pTag->lastSeen)
+    {
+      pTag = &dutyTags[i];
+    }
+  }
+
+  memcpy(pTag->addr, pAddr, B_ADDR_LEN);
+  pTag->used = true;
+  pTag->lastSeen = now;
+}
+
+/*********************************************************************
+ * @fn      AoADuty_getStats
+ *
+ * @brief   Read the statistics.
+ *
+ * @param   pStats - filled with a snapshot of the statistics
+ *
+ * @return  None
+ */
+void AoADuty_getStats(AoADuty_Stats *pStats)
+{
+  *pStats = dutyStats;
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      AoADuty_countTags
+ *
+ * @brief   Count the tags seen within the tag window, forgetting older
+ *          ones.
+ *
+ * @param   now - current time
+ *
+ * @return  number of recent tags
+ */
+static uint8_t AoADuty_countTags(uint32_t now)
+{
+  uint32_t window = (uint32_t)dutyCfg.tagWindow * dutyTicksPerMs;
+  uint8_t count = 0;
+  uint8_t i;
+
+  for (i = 0; i < AOA_DUTY_MAX_TAGS; i++)
+  {
+    if (!dutyTags[i].used)
+    {
+      continue;
+    }
+
+    if (now - dutyTags[i].lastSeen > window)
+    {
+      dutyTags[i].used = false;
+    }
+    else
+    {
+      count++;
+    }
+  }
+
+  return count;
+}
+
+/*********************************************************************
+*********************************************************************/
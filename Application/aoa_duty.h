@@ -0,0 +1,186 @@
+/******************************************************************************
+
+ @file       aoa_duty.h
+
+ @brief Capture scheduling for duty-cycled AoA scanning.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+#ifndef AOADUTY_H
+#define AOADUTY_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bcomdef.h"
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Distinct tags tracked to adapt the rate
+#ifndef AOA_DUTY_MAX_TAGS
+#define AOA_DUTY_MAX_TAGS                     8
+#endif
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Schedule. A round is one capture on each antenna array. The rate
+// follows the tags seen within tagWindow: minRate with none, plus
+// ratePerTag for each, up to maxRate.
+typedef struct
+{
+  uint8_t  maxRate;       // Rounds per second, 0 to scan continuously
+  uint8_t  minRate;       // Rounds per second without recent tags, >= 1
+  uint8_t  ratePerTag;    // Rounds per second added per recent tag
+  uint16_t tagWindow;     // How long a tag counts as recent, ms
+} AoADuty_Cfg;
+
+// Statistics
+typedef struct
+{
+  uint32_t radioOnMs;     // Time captures were armed
+  uint32_t numRounds;     // Rounds started
+  uint32_t numWaits;      // Rounds delayed to stay within the rate
+  uint8_t  rate;          // Current rounds per second, 0 if continuous
+  uint8_t  numTags;       // Tags seen within tagWindow
+} AoADuty_Stats;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * @brief   Initialize the scheduler, continuous until configured. All
+ *          times are in the caller's tick unit.
+ *
+ * @param   ticksPerMs - ticks per millisecond
+ */
+extern void AoADuty_init(uint32_t ticksPerMs);
+
+/*
+ * @brief   Set the schedule, effective from the next round.
+ *
+ * @param   pCfg - schedule
+ *
+ * @return  SUCCESS or INVALIDPARAMETER
+ */
+extern bStatus_t AoADuty_setCfg(const AoADuty_Cfg *pCfg);
+
+/*
+ * @brief   Read the schedule.
+ *
+ * @param   pCfg - filled with the schedule
+ */
+extern void AoADuty_getCfg(AoADuty_Cfg *pCfg);
+
+/*
+ * @brief   Forget the previous round and the recent tags, call when
+ *          scanning starts.
+ */
+extern void AoADuty_reset(void);
+
+/*
+ * @brief   Ask to start a round. Rounds are spread evenly at the
+ *          current rate, a late round starts at once but is not made
+ *          up for with a burst.
+ *
+ * @param   now - current time
+ *
+ * @return  0 if the round starts now, otherwise ms to stand by first
+ */
+extern uint32_t AoADuty_nextRound(uint32_t now);
+
+/*
+ * @brief   A capture was armed.
+ *
+ * @param   now - current time
+ */
+extern void AoADuty_radioOn(uint32_t now);
+
+/*
+ * @brief   The armed capture ended. Ignored if none was armed.
+ *
+ * @param   now - current time
+ */
+extern void AoADuty_radioOff(uint32_t now);
+
+/*
+ * @brief   A tag was captured.
+ *
+ * @param   pAddr - tag address
+ * @param   now   - current time
+ */
+extern void AoADuty_tagSeen(const uint8_t *pAddr, uint32_t now);
+
+/*
+ * @brief   Read the statistics.
+ *
+ * @param   pStats - filled with a snapshot of the statistics
+ */
+extern void AoADuty_getStats(AoADuty_Stats *pStats);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AOADUTY_H */
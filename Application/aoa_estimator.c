@@ -0,0 +1,536 @@
+/******************************************************************************
+
+ @file       aoa_estimator.c
+
+ @brief Pair angle estimation on packed I/Q captures.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+#include <math.h>
+
+#include "aoa_estimator.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Phase units per full circle returned by AoAEst_atan2
+#define AOA_EST_ATAN_CIRCLE                   256
+
+// Speed of light, 0.1 mm * MHz
+#define AOA_EST_LIGHT_SPEED                   2997924.58f
+
+// Smallest det / trace^2 of the baseline Gram matrix still solved as a
+// planar array. Flatter layouts are solved along their main axis.
+#define AOA_EST_PLANAR_MIN                    0.01f
+
+#define AOA_EST_RAD_TO_DEG                    57.29578f
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static int16_t AoAEst_phase(const AoAIQ_Sample *pZ1, const AoAIQ_Sample *pZ2);
+static int32_t AoAEst_repAdvance(const AoA_AntennaConfig *pConfig,
+                                 const AoAIQ_Sample *pSamples,
+                                 uint16_t numSamples, uint8_t slotLen,
+                                 uint8_t slotPeriod);
+static int16_t AoAEst_atan2(int32_t y, int32_t x);
+static int16_t AoAEst_wrap(int32_t angle);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      AoAEst_getPairAngles
+ *
+ * @brief   Estimate the pair angles of one packed capture.
+ *
+ * @param   channel    - RF channel the capture was taken on
+ * @param   rssi       - RSSI of the captured packet
+ * @param   pConfig    - antenna array the capture was taken with
+ * @param   pResult    - filled with the pair angles, updated is set
+ * @param   pSamples   - packed capture
+ * @param   numSamples - number of samples in pSamples
+ * @param   slotLen    - samples per antenna slot in pSamples
+ * @param   slotPeriod - raw samples per antenna slot in the capture
+ * @param   shift      - block exponent returned by AoAIQ_pack
+ *
+ * @return  None
+ */
+void AoAEst_getPairAngles(uint8_t channel, int8_t rssi,
+                          const AoA_AntennaConfig *pConfig,
+                          AoA_AntennaResult *pResult,
+                          const AoAIQ_Sample *pSamples,
+                          uint16_t numSamples, uint8_t slotLen,
+                          uint8_t slotPeriod, uint8_t shift)
+{
+  int32_t  sum[AOA_EST_MAX_PAIRS] = {0};
+  uint32_t amplitude[AOA_EST_MAX_PAIRS] = {0};
+  uint16_t count[AOA_EST_MAX_PAIRS] = {0};
+  uint8_t  numAntennas = pConfig->numAntennas;
+  uint8_t  numPairs = pConfig->numPairs;
+  uint16_t numReps = pConfig->pattern->numPatterns / numAntennas;
+  uint16_t stride = numAntennas * slotLen;
+  int32_t  expected;
+  uint16_t rep;
+  uint8_t  p;
+
+  if (numPairs > AOA_EST_MAX_PAIRS)
+  {
+    numPairs = AOA_EST_MAX_PAIRS;
+  }
+
+  // Carrier advance over one repetition from the sample rate phase, to
+  // unwrap the repetition to repetition phase below
+  expected = AoAEst_repAdvance(pConfig, pSamples, numSamples, slotLen, slotPeriod);
+
+  for (rep = 1; rep < numReps; rep++)
+  {
+    uint16_t cur = rep * stride;
+
+    for (p = 0; p < numPairs; p++)
+    {
+      const AoA_AntennaPair *pPair = &pConfig->pairs[p];
+      uint16_t a = cur + pPair->a * slotLen;
+      uint16_t b = cur + pPair->b * slotLen;
+      int16_t  distance = (int16_t)pPair->b - (int16_t)pPair->a;
+      uint16_t i;
+
+      // Compare the two slots sample by sample, stopping at the end of
+      // the capture
+      for (i = 0; i < slotLen && a + i < numSamples && b + i < numSamples; i++)
+      {
+        const AoAIQ_Sample *pA = &pSamples[a + i];
+
+        // Phase the carrier advanced on antenna a over one repetition,
+        // the whole turns taken from the expected advance
+        int32_t advance = expected + AoAEst_wrap(AoAEst_phase(pA, pA - stride) - expected);
+
+        // Phase of antenna b relative to a, minus the advance over the
+        // slots separating them
+        sum[p] += AoAEst_wrap(AoAEst_phase(&pSamples[b + i], pA) -
+                              (distance * advance) / numAntennas);
+        amplitude[p] += (uint32_t)((pA->i < 0) ? -pA->i : pA->i) +
+                        (uint32_t)((pA->q < 0) ? -pA->q : pA->q);
+        count[p]++;
+      }
+    }
+  }
+
+  for (p = 0; p < numPairs; p++)
+  {
+    const AoA_AntennaPair *pPair = &pConfig->pairs[p];
+    int32_t angle = (count[p] != 0) ? (sum[p] / count[p]) : 0;
+
+    pResult->pairAngle[p] = (int16_t)((float)(angle * pPair->sign + pPair->offset) * pPair->gain);
+    pResult->signalStrength[p] = (count[p] != 0) ? ((amplitude[p] / count[p]) << shift) : 0;
+  }
+
+  pResult->rssi = rssi;
+  pResult->ch = channel;
+  pResult->updated = true;
+}
+
+/*********************************************************************
+ * @fn      AoAEst_initGeometry
+ *
+ * @brief   Precompute the direction solver of an array.
+ *
+ * @param   pGeometry    - solver to fill
+ * @param   pConfig      - antenna array, numAntennas elements
+ * @param   pElements    - element positions
+ * @param   mountAzimuth - azimuth of the array x axis, degrees
+ *
+ * @return  FALSE if the pair baselines span no direction
+ */
+bool AoAEst_initGeometry(AoAEst_Geometry *pGeometry,
+                         const AoA_AntennaConfig *pConfig,
+                         const AoAEst_Element *pElements,
+                         int16_t mountAzimuth)
+{
+  float baseline[AOA_EST_MAX_PAIRS][2];
+  float g00 = 0.0f;
+  float g01 = 0.0f;
+  float g11 = 0.0f;
+  float det;
+  float trace;
+  uint8_t numElements = pConfig->numAntennas;
+  uint8_t numPairs = pConfig->numPairs;
+  uint8_t p;
+
+  memset(pGeometry, 0, sizeof(AoAEst_Geometry));
+
+  if (numElements == 0 || numElements > AOA_EST_MAX_ELEMENTS)
+  {
+    return false;
+  }
+
+  if (numPairs > AOA_EST_MAX_PAIRS)
+  {
+    numPairs = AOA_EST_MAX_PAIRS;
+  }
+
+  // Baselines and their Gram matrix B'B
+  for (p = 0; p < numPairs; p++)
+  {
+    const AoAEst_Element *pA = &pElements[pConfig->pairs[p].a % numElements];
+    const AoAEst_Element *pB = &pElements[pConfig->pairs[p].b % numElements];
+
+    baseline[p][0] = (float)(pB->x - pA->x);
+    baseline[p][1] = (float)(pB->y - pA->y);
+
+    g00 += baseline[p][0] * baseline[p][0];
+    g01 += baseline[p][0] * baseline[p][1];
+    g11 += baseline[p][1] * baseline[p][1];
+  }
+
+  det = g00 * g11 - g01 * g01;
+  trace = g00 + g11;
+
+  if (trace <= 0.0f)
+  {
+    return false;
+  }
+
+  if (det > AOA_EST_PLANAR_MIN * trace * trace)
+  {
+    // (B'B)^-1 B'
+    for (p = 0; p < numPairs; p++)
+    {
+      pGeometry->pinv[0][p] = (g11 * baseline[p][0] - g01 * baseline[p][1]) / det;
+      pGeometry->pinv[1][p] = (g00 * baseline[p][1] - g01 * baseline[p][0]) / det;
+    }
+
+    pGeometry->rank = AOA_EST_GEOMETRY_PLANAR;
+  }
+  else
+  {
+    // Project the baselines on the main axis of B'B
+    float axis = 0.5f * atan2f(2.0f * g01, g00 - g11);
+    float ax = cosf(axis);
+    float ay = sinf(axis);
+    float sum = 0.0f;
+
+    for (p = 0; p < numPairs; p++)
+    {
+      float d = baseline[p][0] * ax + baseline[p][1] * ay;
+
+      pGeometry->pinv[0][p] = d;
+      sum += d * d;
+    }
+
+    for (p = 0; p < numPairs; p++)
+    {
+      pGeometry->pinv[0][p] /= sum;
+    }
+
+    pGeometry->rank = AOA_EST_GEOMETRY_LINEAR;
+  }
+
+  pGeometry->numPairs = numPairs;
+  pGeometry->mountAzimuth = mountAzimuth;
+
+  return true;
+}
+
+/*********************************************************************
+ * @fn      AoAEst_getDirection
+ *
+ * @brief   Direction of arrival from the pair angles of an array with a
+ *          known geometry.
+ *
+ * @param   pGeometry - solver from AoAEst_initGeometry
+ * @param   pResult   - pair angles and channel of the capture
+ * @param   pDir      - filled with the direction
+ *
+ * @return  FALSE if the array has no geometry
+ */
+bool AoAEst_getDirection(const AoAEst_Geometry *pGeometry,
+                         const AoA_AntennaResult *pResult,
+                         AoAEst_Direction *pDir)
+{
+  // Phase in degrees to path difference in 0.1 mm
+  float scale = AOA_EST_LIGHT_SPEED / AoAEst_channelMhz(pResult->ch) / 360.0f;
+  float ux = 0.0f;
+  float uy = 0.0f;
+  float azimuth;
+  uint8_t p;
+
+  if (pGeometry->rank == AOA_EST_GEOMETRY_NONE)
+  {
+    return false;
+  }
+
+  for (p = 0; p < pGeometry->numPairs; p++)
+  {
+    float phase = (float)AoAEst_wrap(pResult->pairAngle[p]);
+
+    ux += pGeometry->pinv[0][p] * phase;
+    uy += pGeometry->pinv[1][p] * phase;
+  }
+
+  ux *= scale;
+  uy *= scale;
+
+  if (pGeometry->rank == AOA_EST_GEOMETRY_PLANAR)
+  {
+    // (ux, uy) is the direction projected on the array plane, noise can
+    // push it past the unit circle
+    float r = sqrtf(ux * ux + uy * uy);
+
+    if (r > 1.0f)
+    {
+      r = 1.0f;
+    }
+
+    azimuth = atan2f(uy, ux) * AOA_EST_RAD_TO_DEG;
+    pDir->elevation = (int16_t)(acosf(r) * AOA_EST_RAD_TO_DEG + 0.5f);
+    pDir->hasElevation = true;
+  }
+  else
+  {
+    // Cone around the axis, reported as the angle from broadside
+    if (ux > 1.0f)
+    {
+      ux = 1.0f;
+    }
+    else if (ux < -1.0f)
+    {
+      ux = -1.0f;
+    }
+
+    azimuth = asinf(ux) * AOA_EST_RAD_TO_DEG;
+    pDir->elevation = 0;
+    pDir->hasElevation = false;
+  }
+
+  // Rounded to nearest
+  azimuth += (azimuth < 0.0f) ? -0.5f : 0.5f;
+  pDir->azimuth = AoAEst_wrap((int32_t)azimuth + pGeometry->mountAzimuth);
+
+  return true;
+}
+
+/*********************************************************************
+ * @fn      AoAEst_channelMhz
+ *
+ * @brief   Carrier frequency of a BLE RF channel.
+ *
+ * @param   channel - channel index, 0-36 data, 37-39 advertising
+ *
+ * @return  frequency, MHz
+ */
+uint16_t AoAEst_channelMhz(uint8_t channel)
+{
+  switch (channel)
+  {
+    case 37:
+      return 2402;
+
+    case 38:
+      return 2426;
+
+    case 39:
+      return 2480;
+
+    default:
+      // Data channels skip the slot of channel 38
+      return (channel < 11) ? (2404 + 2 * channel) : (2406 + 2 * channel);
+  }
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      AoAEst_phase
+ *
+ * @brief   Phase of z1 * conj(z2), in degrees.
+ *
+ * @param   pZ1 - first sample
+ * @param   pZ2 - second sample
+ *
+ * @return  phase, -180 to 180 degrees
+ */
+static int16_t AoAEst_phase(const AoAIQ_Sample *pZ1, const AoAIQ_Sample *pZ2)
+{
+  // int8 components, the products need no pre-scaling
+  int32_t re = (int32_t)pZ1->i * pZ2->i + (int32_t)pZ1->q * pZ2->q;
+  int32_t im = (int32_t)pZ1->q * pZ2->i - (int32_t)pZ1->i * pZ2->q;
+
+  return (int16_t)((AoAEst_atan2(im, re) * 360) / AOA_EST_ATAN_CIRCLE);
+}
+
+/*********************************************************************
+ * @fn      AoAEst_repAdvance
+ *
+ * @brief   Phase the carrier advances over one repetition of the
+ *          pattern, unwrapped. The kept samples of a slot are
+ *          consecutive raw samples of one antenna, so the phase from
+ *          each to the next is the carrier advance per sample. Over a
+ *          whole repetition that advance turns more than 180 degrees
+ *          once the tag is some 40 kHz off, which the repetition to
+ *          repetition phase alone cannot tell apart.
+ *
+ * @param   pConfig    - antenna array the capture was taken with
+ * @param   pSamples   - packed capture
+ * @param   numSamples - number of samples in pSamples
+ * @param   slotLen    - samples per antenna slot in pSamples
+ * @param   slotPeriod - raw samples per antenna slot in the capture
+ *
+ * @return  advance, degrees. 0 if slots hold a single sample.
+ */
+static int32_t AoAEst_repAdvance(const AoA_AntennaConfig *pConfig,
+                                 const AoAIQ_Sample *pSamples,
+                                 uint16_t numSamples, uint8_t slotLen,
+                                 uint8_t slotPeriod)
+{
+  int32_t re = 0;
+  int32_t im = 0;
+  float perSample;
+  uint16_t n;
+
+  if (slotLen < 2)
+  {
+    return 0;
+  }
+
+  // Sum of z[n] * conj(z[n - 1]) within each slot. At most 2 * 128^2 a
+  // term, so a capture of up to 65535 samples fits in 32 bits.
+  for (n = 1; n < numSamples; n++)
+  {
+    const AoAIQ_Sample *pCur = &pSamples[n];
+    const AoAIQ_Sample *pPrev = pCur - 1;
+
+    if (n % slotLen == 0)
+    {
+      continue;
+    }
+
+    re += (int32_t)pCur->i * pPrev->i + (int32_t)pCur->q * pPrev->q;
+    im += (int32_t)pCur->q * pPrev->i - (int32_t)pCur->i * pPrev->q;
+  }
+
+  if (re == 0 && im == 0)
+  {
+    return 0;
+  }
+
+  perSample = atan2f((float)im, (float)re) * AOA_EST_RAD_TO_DEG;
+  perSample *= (float)pConfig->numAntennas * slotPeriod;
+
+  return (int32_t)(perSample + ((perSample < 0.0f) ? -0.5f : 0.5f));
+}
+
+/*********************************************************************
+ * @fn      AoAEst_atan2
+ *
+ * @brief   Four quadrant arctangent, linear within each octant. Exact
+ *          at multiples of 45 degrees, up to 4 degrees off in between.
+ *
+ * @param   y - imaginary part
+ * @param   x - real part
+ *
+ * @return  angle, AOA_EST_ATAN_CIRCLE units per full circle
+ */
+static int16_t AoAEst_atan2(int32_t y, int32_t x)
+{
+  int32_t ax = (x < 0) ? -x : x;
+  int32_t ay = (y < 0) ? -y : y;
+  int32_t angle;
+
+  if (ax == 0 && ay == 0)
+  {
+    return 0;
+  }
+
+  // First octant angle, rounded; 32 units is 45 degrees
+  if (ay < ax)
+  {
+    angle = (ay * 32 + ax / 2) / ax;
+  }
+  else
+  {
+    angle = 64 - (ax * 32 + ay / 2) / ay;
+  }
+
+  // Unfold to the quadrant of (x, y)
+  if (x < 0)
+  {
+    angle = 128 - angle;
+  }
+
+  return (int16_t)((y < 0) ? -angle : angle);
+}
+
+/*********************************************************************
+ * @fn      AoAEst_wrap
+ *
+ * @brief   Wrap an angle to -180..180 degrees.
+ *
+ * @param   angle - degrees
+ *
+ * @return  wrapped angle
+ */
+static int16_t AoAEst_wrap(int32_t angle)
+{
+  angle %= 360;
+
+  if (angle > 180)
+  {
+    angle -= 360;
+  }
+  else if (angle <= -180)
+  {
+    angle += 360;
+  }
+
+  return (int16_t)angle;
+}
+
+/*********************************************************************
+*********************************************************************/
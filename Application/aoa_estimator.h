@@ -0,0 +1,208 @@
+/******************************************************************************
+
+ @file       aoa_estimator.h
+
+ @brief Pair angle estimation on packed I/Q captures.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+#ifndef AOAESTIMATOR_H
+#define AOAESTIMATOR_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "aoa/AOA.h"
+#include "aoa_iq.h"
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Antenna pairs estimated per array, further pairs are left untouched
+#define AOA_EST_MAX_PAIRS                     6
+
+// Antenna elements of an array with a known geometry
+#define AOA_EST_MAX_ELEMENTS                  8
+
+// AoAEst_Geometry ranks
+#define AOA_EST_GEOMETRY_NONE                 0     // Positions unknown
+#define AOA_EST_GEOMETRY_LINEAR               1     // Azimuth only
+#define AOA_EST_GEOMETRY_PLANAR               2     // Azimuth and elevation
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Position of an antenna element in the array plane, 0.1 mm units
+typedef struct
+{
+  int16_t x;
+  int16_t y;
+} AoAEst_Element;
+
+// Direction solver of one antenna array, precomputed from the element
+// positions so a capture only costs two multiply-adds per pair
+typedef struct
+{
+  uint8_t rank;                             // AOA_EST_GEOMETRY_xxx
+  uint8_t numPairs;
+  int16_t mountAzimuth;                     // Array x axis, degrees
+  float   pinv[2][AOA_EST_MAX_PAIRS];       // Pseudo-inverse of the pair baselines
+} AoAEst_Geometry;
+
+// Direction of arrival
+typedef struct
+{
+  int16_t azimuth;        // Degrees from the receiver reference
+  int16_t elevation;      // Degrees above the array plane, 90 on its normal
+  bool    hasElevation;   // FALSE for linear arrays
+} AoAEst_Direction;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * @brief   Estimate the pair angles of one packed capture.
+ *
+ *          For every sample of a repetition the phase between the slots
+ *          of the two antennas of a pair, corrected by the phase the
+ *          carrier advanced between the slots, averaged over the capture
+ *          and mapped through the pair sign, offset and gain. The
+ *          advance is measured from one repetition to the next and its
+ *          whole turns are taken from the phase between neighbouring
+ *          samples of a slot, so carrier offsets up to the +-150 kHz BLE
+ *          allows are corrected. Works on the int8 samples directly, the
+ *          block exponent only scales the signal strength. Slots may be
+ *          trimmed, but the kept samples of a slot must be consecutive
+ *          and the same in every slot.
+ *
+ * @param   channel    - RF channel the capture was taken on
+ * @param   rssi       - RSSI of the captured packet
+ * @param   pConfig    - antenna array the capture was taken with
+ * @param   pResult    - filled with the pair angles, updated is set
+ * @param   pSamples   - packed capture
+ * @param   numSamples - number of samples in pSamples
+ * @param   slotLen    - samples per antenna slot in pSamples
+ * @param   slotPeriod - raw samples per antenna slot in the capture,
+ *                       AoAIQ_SlotMap.slotSamples
+ * @param   shift      - block exponent returned by AoAIQ_pack
+ */
+extern void AoAEst_getPairAngles(uint8_t channel, int8_t rssi,
+                                 const AoA_AntennaConfig *pConfig,
+                                 AoA_AntennaResult *pResult,
+                                 const AoAIQ_Sample *pSamples,
+                                 uint16_t numSamples, uint8_t slotLen,
+                                 uint8_t slotPeriod, uint8_t shift);
+
+/*
+ * @brief   Precompute the direction solver of an array.
+ *
+ *          Element n is the antenna switched in during slot n of the
+ *          first repetition, a pair slot s uses element s % numAntennas.
+ *          The pair baselines form a matrix B, one row per pair, and the
+ *          solver stores its least squares pseudo-inverse. If all
+ *          elements lie on a line only the component along it is
+ *          solved, pairs of the same element add nothing.
+ *
+ * @param   pGeometry    - solver to fill
+ * @param   pConfig      - antenna array, numAntennas elements
+ * @param   pElements    - element positions
+ * @param   mountAzimuth - azimuth of the array x axis, degrees
+ *
+ * @return  FALSE if the pair baselines span no direction
+ */
+extern bool AoAEst_initGeometry(AoAEst_Geometry *pGeometry,
+                                const AoA_AntennaConfig *pConfig,
+                                const AoAEst_Element *pElements,
+                                int16_t mountAzimuth);
+
+/*
+ * @brief   Direction of arrival from the pair angles of an array with a
+ *          known geometry.
+ *
+ *          The pair angles are taken as the calibrated phase of
+ *          element b relative to a in degrees, i.e. pair gain 1.
+ *
+ * @param   pGeometry - solver from AoAEst_initGeometry
+ * @param   pResult   - pair angles and channel of the capture
+ * @param   pDir      - filled with the direction
+ *
+ * @return  FALSE if the array has no geometry
+ */
+extern bool AoAEst_getDirection(const AoAEst_Geometry *pGeometry,
+                                const AoA_AntennaResult *pResult,
+                                AoAEst_Direction *pDir);
+
+/*
+ * @brief   Carrier frequency of a BLE RF channel.
+ *
+ * @param   channel - channel index, 0-36 data, 37-39 advertising
+ *
+ * @return  frequency, MHz
+ */
+extern uint16_t AoAEst_channelMhz(uint8_t channel);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AOAESTIMATOR_H */
@@ -0,0 +1,310 @@
+/******************************************************************************
+
+ @file       aoa_fusion.c
+
+ @brief Per-tag fusion of the angles measured on the channels of one
+        channel cycle.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+
+#include "aoa_fusion.h"
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Angles of the current cycle of one tag
+typedef struct
+{
+  uint8_t  addr[B_ADDR_LEN];
+  bool     inUse;
+  uint8_t  numAngles;
+  uint32_t lastSeen;      // fusionStamp of the last angle
+  AoAFusion_Angle angles[AOA_FUSION_MAX_CHANNELS];
+} fusionTag_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static fusionTag_t fusionTags[AOA_FUSION_MAX_TAGS];
+
+// Angles per cycle
+static uint8_t fusionCycle = 1;
+
+// Incremented per angle, orders the tags by when they were last seen
+static uint32_t fusionStamp = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static fusionTag_t *AoAFusion_findTag(const uint8_t *pAddr);
+static void AoAFusion_fuse(const fusionTag_t *pTag, AoAFusion_Result *pResult);
+static int16_t AoAFusion_wrap(int32_t angle);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      AoAFusion_init
+ *
+ * @brief   Set the cycle length and forget all tags.
+ *
+ * @param   numChannels - channels per cycle, 1 to AOA_FUSION_MAX_CHANNELS
+ *
+ * @return  false if numChannels is out of range
+ */
+bool AoAFusion_init(uint8_t numChannels)
+{
+  if (numChannels == 0 || numChannels > AOA_FUSION_MAX_CHANNELS)
+  {
+    return false;
+  }
+
+  fusionCycle = numChannels;
+  AoAFusion_reset();
+
+  return true;
+}
+
+/*********************************************************************
+ * @fn      AoAFusion_reset
+ *
+ * @brief   Forget the angles of all tags.
+ *
+ * @return  None
+ */
+void AoAFusion_reset(void)
+{
+  memset(fusionTags, 0, sizeof(fusionTags));
+  fusionStamp = 0;
+}
+
+/*********************************************************************
+ * @fn      AoAFusion_add
+ *
+ * @brief   Add the angle of a tag and fuse its cycle once complete.
+ *
+ * @param   pAddr   - tag address, B_ADDR_LEN bytes
+ * @param   pAngle  - angle of one capture pair
+ * @param   pResult - filled when a cycle ended
+ *
+ * @return  true if pResult holds a fused angle
+ */
+bool AoAFusion_add(const uint8_t *pAddr, const AoAFusion_Angle *pAngle,
+                   AoAFusion_Result *pResult)
+{
+  fusionTag_t *pTag = AoAFusion_findTag(pAddr);
+  bool fused = false;
+  uint8_t i;
+
+  // A repeated channel means the rest of the cycle was lost, fuse what
+  // was measured and start the next cycle with this angle
+  for (i = 0; i < pTag->numAngles; i++)
+  {
+    if (pTag->angles[i].channel == pAngle->channel)
+    {
+      AoAFusion_fuse(pTag, pResult);
+      pTag->numAngles = 0;
+      fused = true;
+      break;
+    }
+  }
+
+  pTag->angles[pTag->numAngles++] = *pAngle;
+  pTag->lastSeen = ++fusionStamp;
+
+  if (!fused && pTag->numAngles >= fusionCycle)
+  {
+    AoAFusion_fuse(pTag, pResult);
+    pTag->numAngles = 0;
+    fused = true;
+  }
+
+  return fused;
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      AoAFusion_findTag
+ *
+ * @brief   Entry of a tag, taking over a free or the least recently
+ *          seen entry for a new tag.
+ *
+ * @param   pAddr - tag address
+ *
+ * @return  entry of the tag
+ */
+static fusionTag_t *AoAFusion_findTag(const uint8_t *pAddr)
+{
+  fusionTag_t *pOldest = &fusionTags[0];
+  uint8_t i;
+
+  for (i = 0; i < AOA_FUSION_MAX_TAGS; i++)
+  {
+    fusionTag_t *pTag = &fusionTags[i];
+
+    if (pTag->inUse && memcmp(pTag->addr, pAddr, B_ADDR_LEN) == 0)
+    {
+      return pTag;
+    }
+
+    // Free entries count as never seen
+    if (!pTag->inUse)
+    {
+      if (pOldest->inUse)
+      {
+        pOldest = pTag;
+      }
+    }
+    else if (pOldest->inUse && pTag->lastSeen < pOldest->lastSeen)
+    {
+      pOldest = pTag;
+    }
+  }
+
+  memcpy(pOldest->addr, pAddr, B_ADDR_LEN);
+  pOldest->inUse = true;
+  pOldest->numAngles = 0;
+
+  return pOldest;
+}
+
+/*********************************************************************
+ * @fn      AoAFusion_fuse
+ *
+ * @brief   Weighted mean of the angles of a tag's cycle.
+ *
+ *          The azimuths are averaged as offsets from the strongest
+ *          angle, so a cycle straddling +-180 degrees does not average
+ *          to the opposite direction.
+ *
+ * @param   pTag    - tag with at least one angle
+ * @param   pResult - filled with the fused angle
+ *
+ * @return  None
+ */
+static void AoAFusion_fuse(const fusionTag_t *pTag, AoAFusion_Result *pResult)
+{
+  const AoAFusion_Angle *pStrongest = &pTag->angles[0];
+  float azimuthSum = 0.0f;
+  float azimuthWeight = 0.0f;
+  float elevationSum = 0.0f;
+  float elevationWeight = 0.0f;
+  uint8_t i;
+
+  for (i = 1; i < pTag->numAngles; i++)
+  {
+    if (pTag->angles[i].amplitude > pStrongest->amplitude)
+    {
+      pStrongest = &pTag->angles[i];
+    }
+  }
+
+  for (i = 0; i < pTag->numAngles; i++)
+  {
+    const AoAFusion_Angle *pAngle = &pTag->angles[i];
+
+    // Never zero, so a cycle of silent captures is a plain mean
+    float weight = ((float)pAngle->amplitude + 1.0f) * ((float)pAngle->amplitude + 1.0f);
+
+    azimuthSum += weight * AoAFusion_wrap(pAngle->azimuth - pStrongest->azimuth);
+    azimuthWeight += weight;
+
+    if (pAngle->hasElevation)
+    {
+      elevationSum += weight * pAngle->elevation;
+      elevationWeight += weight;
+    }
+  }
+
+  azimuthSum /= azimuthWeight;
+  azimuthSum += (azimuthSum < 0.0f) ? -0.5f : 0.5f;
+
+  if (elevationWeight > 0.0f)
+  {
+    elevationSum /= elevationWeight;
+    elevationSum += (elevationSum < 0.0f) ? -0.5f : 0.5f;
+  }
+
+  pResult->angle = *pStrongest;
+  pResult->angle.azimuth = AoAFusion_wrap(pStrongest->azimuth + (int32_t)azimuthSum);
+  pResult->angle.hasElevation = (elevationWeight > 0.0f);
+  pResult->angle.elevation = pResult->angle.hasElevation ? (int16_t)elevationSum : 0;
+  pResult->numFused = pTag->numAngles;
+}
+
+/*********************************************************************
+ * @fn      AoAFusion_wrap
+ *
+ * @brief   Wrap an angle to -180..180 degrees.
+ *
+ * @param   angle - degrees
+ *
+ * @return  wrapped angle
+ */
+static int16_t AoAFusion_wrap(int32_t angle)
+{
+  angle %= 360;
+
+  if (angle > 180)
+  {
+    angle -= 360;
+  }
+  else if (angle <= -180)
+  {
+    angle += 360;
+  }
+
+  return (int16_t)angle;
+}
+
+/*********************************************************************
+*********************************************************************/
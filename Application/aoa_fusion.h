@@ -0,0 +1,155 @@
+/******************************************************************************
+
+ @file       aoa_fusion.h
+
+ @brief Per-tag fusion of the angles measured on the channels of one
+        channel cycle.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+#ifndef AOAFUSION_H
+#define AOAFUSION_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bcomdef.h"
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Tags fused at the same time, the least recently seen is replaced
+#ifndef AOA_FUSION_MAX_TAGS
+#define AOA_FUSION_MAX_TAGS                   8
+#endif
+
+// Angles per cycle, at most one per channel
+#ifndef AOA_FUSION_MAX_CHANNELS
+#define AOA_FUSION_MAX_CHANNELS               8
+#endif
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Angle of one capture pair
+typedef struct
+{
+  int16_t  azimuth;       // Degrees
+  int16_t  elevation;     // Degrees, valid if hasElevation
+  bool     hasElevation;
+  uint8_t  channel;       // RF channel of the captures
+  uint8_t  antenna;       // Antenna array that measured it
+  int8_t   rssi;
+  uint16_t amplitude;     // Signal strength, raw sample units
+} AoAFusion_Angle;
+
+// Fused angle of one cycle. channel, antenna and rssi are those of the
+// strongest angle.
+typedef struct
+{
+  AoAFusion_Angle angle;
+  uint8_t numFused;       // Angles combined, 1 to the cycle length
+} AoAFusion_Result;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * @brief   Set the cycle length and forget all tags.
+ *
+ * @param   numChannels - channels per cycle, 1 to AOA_FUSION_MAX_CHANNELS
+ *
+ * @return  false if numChannels is out of range
+ */
+extern bool AoAFusion_init(uint8_t numChannels);
+
+/*
+ * @brief   Forget the angles of all tags, e.g. when AoA stops.
+ */
+extern void AoAFusion_reset(void);
+
+/*
+ * @brief   Add the angle of a tag and fuse its cycle once complete.
+ *
+ *          A cycle ends after numChannels angles on distinct channels,
+ *          or early when the tag repeats a channel because a capture of
+ *          the cycle was lost. The fused azimuth is the weighted
+ *          circular mean of the cycle, elevation the weighted mean of
+ *          the angles that have one. Each angle is weighted by its
+ *          amplitude squared, i.e. by its SNR over a constant noise
+ *          floor, so a channel in a fade barely counts.
+ *
+ * @param   pAddr   - tag address, B_ADDR_LEN bytes
+ * @param   pAngle  - angle of one capture pair
+ * @param   pResult - filled when a cycle ended
+ *
+ * @return  true if pResult holds a fused angle
+ */
+extern bool AoAFusion_add(const uint8_t *pAddr, const AoAFusion_Angle *pAngle,
+                          AoAFusion_Result *pResult);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AOAFUSION_H */
@@ -0,0 +1,306 @@
+/******************************************************************************
+
+ @file       aoa_gatt_cache.c
+
+ @brief GATT handle cache of bonded AoA senders.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+
+#include <icall.h>
+#include "icall_ble_api.h"
+
+#include "aoa_gatt_cache.h"
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Handles of one peer, keyed by its identity address
+typedef struct
+{
+  uint8_t used;
+  uint8_t addrType;           // Identity address type
+  uint8_t addr[B_ADDR_LEN];   // Identity address
+  AoAGattCache_Handles handles;
+} AoAGattCache_Entry;
+
+// SNV item, most recently used entry first. Must stay below the 255
+// byte item limit.
+typedef struct
+{
+  uint8_t version;            // AOA_GATT_CACHE_NV_VERSION, 0 if erased
+  AoAGattCache_Entry entries[AOA_GATT_CACHE_SIZE];
+} AoAGattCache_NvItem;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static AoAGattCache_NvItem gattCache;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static bool AoAGattCache_identity(const uint8_t *pAddr, uint8_t addrType,
+                                  uint8_t *pIdType, uint8_t *pIdAddr);
+static int8_t AoAGattCache_lookup(uint8_t idType, const uint8_t *pIdAddr);
+static void AoAGattCache_toFront(uint8_t idx);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      AoAGattCache_init
+ *
+ * @brief   Load the cache from SNV.
+ *
+ * @return  None
+ */
+void AoAGattCache_init(void)
+{
+  if (osal_snv_read(AOA_GATT_CACHE_NV_ID, sizeof(gattCache), &gattCache) != SUCCESS ||
+      gattCache.version != AOA_GATT_CACHE_NV_VERSION)
+  {
+    memset(&gattCache, 0, sizeof(gattCache));
+    gattCache.version = AOA_GATT_CACHE_NV_VERSION;
+  }
+}
+
+/*********************************************************************
+ * @fn      AoAGattCache_find
+ *
+ * @brief   Look up the handles of a peer.
+ *
+ * @param   pAddr    - peer address, as seen on the link
+ * @param   addrType - peer address type
+ * @param   pHandles - filled with the handles
+ *
+ * @return  false if the peer is not bonded or not cached
+ */
+bool AoAGattCache_find(const uint8_t *pAddr, uint8_t addrType,
+                       AoAGattCache_Handles *pHandles)
+{
+  uint8_t idAddr[B_ADDR_LEN];
+  uint8_t idType;
+  int8_t idx;
+
+  if (!AoAGattCache_identity(pAddr, addrType, &idType, idAddr))
+  {
+    return false;
+  }
+
+  idx = AoAGattCache_lookup(idType, idAddr);
+  if (idx < 0)
+  {
+    return false;
+  }
+
+  *pHandles = gattCache.entries[idx].handles;
+
+  // Recency only matters for eviction, not worth an SNV write here
+  AoAGattCache_toFront((uint8_t)idx);
+
+  return true;
+}
+
+/*********************************************************************
+ * @fn      AoAGattCache_store
+ *
+ * @brief   Remember the handles of a bonded peer.
+ *
+ * @param   pAddr    - peer address, as seen on the link
+ * @param   addrType - peer address type
+ * @param   pHandles - handles found by discovery
+ *
+ * @return  SUCCESS, bleIncorrectMode if the peer is not bonded, or the
+ *          SNV error
+ */
+bStatus_t AoAGattCache_store(const uint8_t *pAddr, uint8_t addrType,
+                             const AoAGattCache_Handles *pHandles)
+{
+  AoAGattCache_Entry *pEntry;
+  uint8_t idAddr[B_ADDR_LEN];
+  uint8_t idType;
+  int8_t idx;
+
+  if (!AoAGattCache_identity(pAddr, addrType, &idType, idAddr))
+  {
+    return bleIncorrectMode;
+  }
+
+  idx = AoAGattCache_lookup(idType, idAddr);
+  if (idx >= 0)
+  {
+    if (memcmp(&gattCache.entries[idx].handles, pHandles, sizeof(*pHandles)) == 0)
+    {
+      AoAGattCache_toFront((uint8_t)idx);
+      return SUCCESS;
+    }
+  }
+  else
+  {
+    // Reuse the least recently used entry
+    idx = AOA_GATT_CACHE_SIZE - 1;
+  }
+
+  AoAGattCache_toFront((uint8_t)idx);
+
+  pEntry = &gattCache.entries[0];
+  pEntry->used = TRUE;
+  pEntry->addrType = idType;
+  memcpy(pEntry->addr, idAddr, B_ADDR_LEN);
+  pEntry->handles = *pHandles;
+
+  return osal_snv_write(AOA_GATT_CACHE_NV_ID, sizeof(gattCache), &gattCache);
+}
+
+/*********************************************************************
+ * @fn      AoAGattCache_remove
+ *
+ * @brief   Forget the handles of a peer.
+ *
+ * @param   pAddr    - peer address, as seen on the link
+ * @param   addrType - peer address type
+ *
+ * @return  None
+ */
+void AoAGattCache_remove(const uint8_t *pAddr, uint8_t addrType)
+{
+  uint8_t idAddr[B_ADDR_LEN];
+  uint8_t idType;
+  int8_t idx;
+
+  if (!AoAGattCache_identity(pAddr, addrType, &idType, idAddr))
+  {
+    return;
+  }
+
+  idx = AoAGattCache_lookup(idType, idAddr);
+  if (idx >= 0)
+  {
+    // Close the gap, the free entry ends up last
+    memmove(&gattCache.entries[idx], &gattCache.entries[idx + 1],
+            (AOA_GATT_CACHE_SIZE - 1 - idx) * sizeof(AoAGattCache_Entry));
+    memset(&gattCache.entries[AOA_GATT_CACHE_SIZE - 1], 0, sizeof(AoAGattCache_Entry));
+
+    VOID osal_snv_write(AOA_GATT_CACHE_NV_ID, sizeof(gattCache), &gattCache);
+  }
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      AoAGattCache_identity
+ *
+ * @brief   Get the identity address of a bonded peer.
+ *
+ * @param   pAddr    - peer address, as seen on the link
+ * @param   addrType - peer address type
+ * @param   pIdType  - filled with the identity address type
+ * @param   pIdAddr  - filled with the identity address
+ *
+ * @return  false if the peer is not bonded
+ */
+static bool AoAGattCache_identity(const uint8_t *pAddr, uint8_t addrType,
+                                  uint8_t *pIdType, uint8_t *pIdAddr)
+{
+  uint8_t bondIdx;
+
+  return GAPBondMgr_FindAddr((uint8_t *)pAddr, addrType, &bondIdx,
+                             pIdType, pIdAddr) == SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      AoAGattCache_lookup
+ *
+ * @brief   Find the entry of an identity address.
+ *
+ * @param   idType  - identity address type
+ * @param   pIdAddr - identity address
+ *
+ * @return  entry index, -1 if not cached
+ */
+static int8_t AoAGattCache_lookup(uint8_t idType, const uint8_t *pIdAddr)
+{
+  uint8_t i;
+
+  for (i = 0; i < AOA_GATT_CACHE_SIZE; i++)
+  {
+    AoAGattCache_Entry *pEntry = &gattCache.entries[i];
+
+    if (pEntry->used && pEntry->addrType == idType &&
+        memcmp(pEntry->addr, pIdAddr, B_ADDR_LEN) == 0)
+    {
+      return (int8_t)i;
+    }
+  }
+
+  return -1;
+}
+
+/*********************************************************************
+ * @fn      AoAGattCache_toFront
+ *
+ * @brief   Move an entry to the front, shifting the more recent ones
+ *          back by one.
+ *
+ * @param   idx - entry index
+ *
+ * @return  None
+ */
+static void AoAGattCache_toFront(uint8_t idx)
+{
+  AoAGattCache_Entry entry = gattCache.entries[idx];
+
+  memmove(&gattCache.entries[1], &gattCache.entries[0],
+          idx * sizeof(AoAGattCache_Entry));
+  gattCache.entries[0] = entry;
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,151 @@
+/******************************************************************************
+
+ @file       aoa_gatt_cache.h
+
+ @brief GATT handle cache of bonded AoA senders.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+#ifndef AOAGATTCACHE_H
+#define AOAGATTCACHE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bcomdef.h"
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Bonded senders whose handles are kept, the least recently used
+// entry makes room for a new one
+#ifndef AOA_GATT_CACHE_SIZE
+#define AOA_GATT_CACHE_SIZE                   8
+#endif
+
+// SNV item of the cache, after the ant_config items
+#define AOA_GATT_CACHE_NV_ID                  (BLE_NVID_CUST_START + 4)
+
+// Layout version of the SNV item, 0 marks an erased item
+#define AOA_GATT_CACHE_NV_VERSION             1
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Handles found by service discovery
+typedef struct
+{
+  uint16_t svcStartHdl;   // AoA service
+  uint16_t svcEndHdl;
+  uint16_t charHdl;       // Start/stop characteristic
+  uint16_t ctrlHdl;       // Control characteristic, 0 on a legacy sender
+} AoAGattCache_Handles;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * @brief   Load the cache from SNV.
+ */
+extern void AoAGattCache_init(void);
+
+/*
+ * @brief   Look up the handles of a peer. Resolvable private addresses
+ *          are matched through the bond of the peer.
+ *
+ * @param   pAddr    - peer address, as seen on the link
+ * @param   addrType - peer address type
+ * @param   pHandles - filled with the handles
+ *
+ * @return  false if the peer is not bonded or not cached
+ */
+extern bool AoAGattCache_find(const uint8_t *pAddr, uint8_t addrType,
+                              AoAGattCache_Handles *pHandles);
+
+/*
+ * @brief   Remember the handles of a bonded peer. SNV is only written
+ *          when the entry changes.
+ *
+ * @param   pAddr    - peer address, as seen on the link
+ * @param   addrType - peer address type
+ * @param   pHandles - handles found by discovery
+ *
+ * @return  SUCCESS, bleIncorrectMode if the peer is not bonded, or the
+ *          SNV error
+ */
+extern bStatus_t AoAGattCache_store(const uint8_t *pAddr, uint8_t addrType,
+                                    const AoAGattCache_Handles *pHandles);
+
+/*
+ * @brief   Forget the handles of a peer, e.g. after they stopped
+ *          working.
+ *
+ * @param   pAddr    - peer address, as seen on the link
+ * @param   addrType - peer address type
+ */
+extern void AoAGattCache_remove(const uint8_t *pAddr, uint8_t addrType);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AOAGATTCACHE_H */
@@ -0,0 +1,331 @@
+/******************************************************************************
+
+ @file       aoa_iq.c
+
+ @brief I/Q capture quality checks for the AoA Receiver.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "aoa_iq.h"
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static int8_t AoAIQ_packComponent(int16_t value, uint8_t shift);
+static uint32_t AoAIQ_isqrt(uint32_t x);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      AoAIQ_slotMapInit
+ *
+ * @brief   Build the slot map of a capture.
+ *
+ * @param   pMap        - map to fill
+ * @param   numPatterns - AoA_Pattern.numPatterns of the capture
+ * @param   numSamples  - raw samples in the capture
+ * @param   skip        - samples to drop after each switch
+ * @param   keep        - samples to keep per slot
+ *
+ * @return  false if skip + keep does not fit in a slot
+ */
+bool AoAIQ_slotMapInit(AoAIQ_SlotMap *pMap, uint8_t numPatterns,
+                       uint16_t numSamples, uint8_t skip, uint8_t keep)
+{
+  uint16_t slotSamples;
+
+  if (numPatterns == 0 || keep == 0)
+  {
+    return false;
+  }
+
+  slotSamples = numSamples / numPatterns;
+
+  if (slotSamples > UINT8_MAX || skip + keep > slotSamples)
+  {
+    return false;
+  }
+
+  pMap->numSlots = numPatterns;
+  pMap->slotSamples = (uint8_t)slotSamples;
+  pMap->skip = skip;
+  pMap->keep = keep;
+
+  return true;
+}
+
+/*********************************************************************
+ * @fn      AoAIQ_pack
+ *
+ * @brief   Pack the kept samples of a raw capture into block floating
+ *          point.
+ *
+ * @param   pSrc - raw capture
+ * @param   pMap - samples to keep
+ * @param   pDst - packed capture, numSlots * keep entries
+ *
+ * @return  shift to apply to the packed components to get raw units
+ */
+uint8_t AoAIQ_pack(const AoA_IQSample *pSrc, const AoAIQ_SlotMap *pMap,
+                   AoAIQ_Sample *pDst)
+{
+  const AoA_IQSample *pSlot;
+  uint32_t peak = 0;
+  uint8_t shift = 0;
+  uint8_t slot;
+  uint8_t n;
+
+  // OR of the magnitudes has the same top bit as the largest one
+  pSlot = pSrc + pMap->skip;
+  for (slot = 0; slot < pMap->numSlots; slot++)
+  {
+    for (n = 0; n < pMap->keep; n++)
+    {
+      int32_t i = pSlot[n].i;
+      int32_t q = pSlot[n].q;
+
+      peak |= (uint32_t)((i < 0) ? -i : i) | (uint32_t)((q < 0) ? -q : q);
+    }
+    pSlot += pMap->slotSamples;
+  }
+
+  while ((peak >> shift) > INT8_MAX)
+  {
+    shift++;
+  }
+
+  pSlot = pSrc + pMap->skip;
+  for (slot = 0; slot < pMap->numSlots; slot++)
+  {
+    for (n = 0; n < pMap->keep; n++)
+    {
+      pDst->i = AoAIQ_packComponent(pSlot[n].i, shift);
+      pDst->q = AoAIQ_packComponent(pSlot[n].q, shift);
+      pDst++;
+    }
+    pSlot += pMap->slotSamples;
+  }
+
+  return shift;
+}
+
+/*********************************************************************
+ * @fn      AoAIQ_gate
+ *
+ * @brief   Check whether a capture is worth estimating.
+ *
+ * @param   pSamples   - packed capture
+ * @param   numSamples - number of samples in pSamples
+ * @param   slotLen    - samples per antenna slot in pSamples
+ * @param   shift      - block exponent returned by AoAIQ_pack
+ * @param   pCfg       - thresholds
+ * @param   pQuality   - filled with the measured quality, may be NULL
+ *
+ * @return  AOA_IQ_GATE_PASS or the first check that failed
+ */
+uint8_t AoAIQ_gate(const AoAIQ_Sample *pSamples, uint16_t numSamples,
+                   uint8_t slotLen, uint8_t shift, const AoAIQ_GateCfg *pCfg,
+                   AoAIQ_Quality *pQuality)
+{
+  // A sample contributes at most 2 * 128^2, so 65535 of them still fit
+  int32_t energy = 0;
+  uint32_t pairEnergy = 0;
+  int32_t crossRe = 0;
+  int32_t crossIm = 0;
+  uint32_t amplitude;
+  uint8_t coherence;
+  uint16_t n;
+
+  if (numSamples < 2 || slotLen == 0)
+  {
+    return AOA_IQ_GATE_LOW_AMPLITUDE;
+  }
+
+  energy = (int32_t)pSamples[0].i * pSamples[0].i +
+           (int32_t)pSamples[0].q * pSamples[0].q;
+
+  for (n = 1; n < numSamples; n++)
+  {
+    int32_t i0 = pSamples[n - 1].i;
+    int32_t q0 = pSamples[n - 1].q;
+    int32_t i1 = pSamples[n].i;
+    int32_t q1 = pSamples[n].q;
+    int32_t e1 = i1 * i1 + q1 * q1;
+
+    energy += e1;
+
+    // The first sample of a slot is on another antenna
+    if (n % slotLen == 0)
+    {
+      continue;
+    }
+
+    // z[n] * conj(z[n-1]), against the energy of both samples
+    crossRe += i1 * i0 + q1 * q0;
+    crossIm += q1 * i0 - i1 * q0;
+    pairEnergy += (uint32_t)(e1 + i0 * i0 + q0 * q0);
+  }
+
+  // Back to raw sample units
+  amplitude = AoAIQ_isqrt((uint32_t)energy / numSamples) << shift;
+  if (amplitude > UINT16_MAX)
+  {
+    amplitude = UINT16_MAX;
+  }
+
+  if (energy == 0)
+  {
+    coherence = 0;
+  }
+  else if (pairEnergy == 0)
+  {
+    // One sample per slot, nothing to compare: not a reason to drop it
+    coherence = 100;
+  }
+  else
+  {
+    // Ratio of squares in float, the accumulators do not fit 32 bits
+    // once squared. Done once per capture. pairEnergy counts each
+    // product's samples twice, so the cross sum is doubled to match.
+    float cross = 4.0f * ((float)crossRe * (float)crossRe + (float)crossIm * (float)crossIm);
+    float power = (float)pairEnergy * (float)pairEnergy;
+
+    coherence = (uint8_t)AoAIQ_isqrt((uint32_t)((cross / power) * 10000.0f));
+    if (coherence > 100)
+    {
+      coherence = 100;
+    }
+  }
+
+  if (pQuality != NULL)
+  {
+    pQuality->amplitude = (uint16_t)amplitude;
+    pQuality->coherence = coherence;
+  }
+
+  if (amplitude < pCfg->minAmplitude)
+  {
+    return AOA_IQ_GATE_LOW_AMPLITUDE;
+  }
+
+  if (coherence < pCfg->minCoherence)
+  {
+    return AOA_IQ_GATE_LOW_COHERENCE;
+  }
+
+  return AOA_IQ_GATE_PASS;
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      AoAIQ_packComponent
+ *
+ * @brief   Scale one raw component down, rounded to nearest.
+ *
+ * @param   value - raw component
+ * @param   shift - block exponent
+ *
+ * @return  packed component
+ */
+static int8_t AoAIQ_packComponent(int16_t value, uint8_t shift)
+{
+  int32_t packed = value;
+
+  if (shift != 0)
+  {
+    packed = (packed + (1L << (shift - 1))) >> shift;
+  }
+
+  // Rounding can carry the peak one step past the int8 range
+  if (packed > INT8_MAX)
+  {
+    packed = INT8_MAX;
+  }
+
+  return (int8_t)packed;
+}
+
+/*********************************************************************
+ * @fn      AoAIQ_isqrt
+ *
+ * @brief   Integer square root, rounded down.
+ *
+ * @param   x - value
+ *
+ * @return  floor(sqrt(x))
+ */
+static uint32_t AoAIQ_isqrt(uint32_t x)
+{
+  uint32_t root = 0;
+  uint32_t bit = 1UL << 30;
+
+  while (bit > x)
+  {
+    bit >>= 2;
+  }
+
+  while (bit != 0)
+  {
+    if (x >= root + bit)
+    {
+      x -= root + bit;
+      root = (root >> 1) + bit;
+    }
+    else
+    {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+
+  return root;
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,192 @@
+/******************************************************************************
+
+ @file       aoa_iq.h
+
+ @brief I/Q capture quality checks for the AoA Receiver.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+#ifndef AOAIQ_H
+#define AOAIQ_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "aoa/AOA.h"
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// AoAIQ_gate results
+#define AOA_IQ_GATE_PASS                      0
+#define AOA_IQ_GATE_LOW_AMPLITUDE             1  // Signal close to the noise floor
+#define AOA_IQ_GATE_LOW_COHERENCE             2  // Phase too noisy, e.g. a collision
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Compact I/Q sample, one byte per component. A capture is stored in
+// block floating point: every component is the raw value shifted right
+// by one per-capture exponent, chosen so the largest component fits.
+typedef struct
+{
+  int8_t i;
+  int8_t q;
+} AoAIQ_Sample;
+
+// Which raw samples of a capture are kept. The capture is numSlots
+// antenna slots of slotSamples each, the first samples after every
+// switch are still settling and the tail of a slot adds little.
+typedef struct
+{
+  uint8_t numSlots;       // Antenna slots in the capture
+  uint8_t slotSamples;    // Raw samples per slot
+  uint8_t skip;           // Samples dropped after each switch
+  uint8_t keep;           // Samples kept per slot
+} AoAIQ_SlotMap;
+
+// Gate thresholds. A zero threshold disables that check.
+typedef struct
+{
+  uint16_t minAmplitude;  // Minimum RMS amplitude, raw sample units
+  uint8_t  minCoherence;  // Minimum phase coherence, percent
+} AoAIQ_GateCfg;
+
+// Quality of a capture
+typedef struct
+{
+  uint16_t amplitude;     // RMS amplitude, raw sample units
+  uint8_t  coherence;     // Phase coherence, percent
+} AoAIQ_Quality;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * @brief   Build the slot map of a capture.
+ *
+ *          Each antenna pattern entry is one slot, so the raw samples
+ *          per slot follow from the capture length and numPatterns.
+ *
+ * @param   pMap        - map to fill
+ * @param   numPatterns - AoA_Pattern.numPatterns of the capture
+ * @param   numSamples  - raw samples in the capture
+ * @param   skip        - samples to drop after each switch
+ * @param   keep        - samples to keep per slot
+ *
+ * @return  false if skip + keep does not fit in a slot
+ */
+extern bool AoAIQ_slotMapInit(AoAIQ_SlotMap *pMap, uint8_t numPatterns,
+                              uint16_t numSamples, uint8_t skip, uint8_t keep);
+
+/*
+ * @brief   Pack the kept samples of a raw capture into block floating
+ *          point.
+ *
+ *          Only the samples selected by the slot map are read, they are
+ *          stored back to back, keep per slot. The shift is the smallest
+ *          that fits the largest component into int8, each component is
+ *          rounded to nearest. Half the size of the raw samples, the
+ *          quantization noise stays ~40 dB below the strongest sample.
+ *
+ * @param   pSrc - raw capture
+ * @param   pMap - samples to keep
+ * @param   pDst - packed capture, numSlots * keep entries
+ *
+ * @return  shift to apply to the packed components to get raw units
+ */
+extern uint8_t AoAIQ_pack(const AoA_IQSample *pSrc, const AoAIQ_SlotMap *pMap,
+                          AoAIQ_Sample *pDst);
+
+/*
+ * @brief   Check whether a capture is worth estimating.
+ *
+ *          Amplitude is the RMS of the samples. Coherence measures how
+ *          steadily the phase advances from one sample to the next:
+ *          |sum(z[n] * conj(z[n-1]))| over the mean energy of the
+ *          compared samples. Only samples of the same slot are compared,
+ *          the first sample of a slot follows an antenna switch and the
+ *          skipped samples, so its phase step says nothing about the
+ *          signal. A clean tone is close to 100 percent whatever the
+ *          slot map, noise and colliding packets pull it down. One pass,
+ *          no divisions per sample.
+ *
+ * @param   pSamples   - packed capture
+ * @param   numSamples - number of samples in pSamples
+ * @param   slotLen    - samples per antenna slot in pSamples. With one
+ *                       sample per slot coherence is not measured, 100.
+ * @param   shift      - block exponent returned by AoAIQ_pack
+ * @param   pCfg       - thresholds
+ * @param   pQuality   - filled with the measured quality, may be NULL
+ *
+ * @return  AOA_IQ_GATE_PASS or the first check that failed
+ */
+extern uint8_t AoAIQ_gate(const AoAIQ_Sample *pSamples, uint16_t numSamples,
+                          uint8_t slotLen, uint8_t shift, const AoAIQ_GateCfg *pCfg,
+                          AoAIQ_Quality *pQuality);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AOAIQ_H */
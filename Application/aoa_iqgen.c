@@ -0,0 +1,365 @@
+/******************************************************************************
+
+ @file       aoa_iqgen.c
+
+ @brief Synthetic I/Q captures for a given direction, noise, carrier
+        offset and multipath.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+#include <math.h>
+
+#include "aoa_iqgen.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#define AOA_IQGEN_TWO_PI                      6.2831853f
+#define AOA_IQGEN_DEG_TO_RAD                  0.01745329f
+
+// Speed of light, 0.1 mm * MHz
+#define AOA_IQGEN_LIGHT_SPEED                 2997924.58f
+
+// Noise generator state used in place of a zero seed, which xorshift
+// never leaves
+#define AOA_IQGEN_SEED                        0x2545F491
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint32_t AoAIQGen_random(uint32_t *pSeed);
+static float AoAIQGen_gaussian(uint32_t *pSeed);
+static int16_t AoAIQGen_saturate(float value);
+static bool AoAIQGen_slotElements(const AoA_AntennaConfig *pConfig,
+                                  uint8_t *pSlotElement);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      AoAIQGen_sceneInit
+ *
+ * @brief   Set up a clean single path scene: default amplitude, no
+ *          noise, carrier offset or settling.
+ *
+ * @param   pScene    - scene to fill
+ * @param   channel   - RF channel
+ * @param   azimuth   - direction of the tag, degrees
+ * @param   elevation - degrees above the array plane
+ *
+ * @return  None
+ */
+void AoAIQGen_sceneInit(AoAIQGen_Scene *pScene, uint8_t channel,
+                        int16_t azimuth, int16_t elevation)
+{
+  memset(pScene, 0, sizeof(AoAIQGen_Scene));
+
+  pScene->channel = channel;
+  pScene->amplitude = AOA_IQGEN_DEFAULT_AMPLITUDE;
+  pScene->snrDb = AOA_IQGEN_NO_NOISE;
+  pScene->numPaths = 1;
+  pScene->paths[0].azimuth = azimuth;
+  pScene->paths[0].elevation = elevation;
+}
+
+/*********************************************************************
+ * @fn      AoAIQGen_capture
+ *
+ * @brief   Generate the raw capture of one packet.
+ *
+ * @param   pConfig      - antenna array
+ * @param   pElements    - element positions, NULL for a line along x
+ * @param   mountAzimuth - azimuth of the array x axis, degrees
+ * @param   pScene       - conditions of the capture
+ * @param   pSeed        - noise generator state, updated
+ * @param   pSamples     - filled with the capture
+ * @param   numSamples   - samples to generate
+ *
+ * @return  false if the array or scene is out of range
+ */
+bool AoAIQGen_capture(const AoA_AntennaConfig *pConfig,
+                      const AoAEst_Element *pElements,
+                      int16_t mountAzimuth,
+                      const AoAIQGen_Scene *pScene, uint32_t *pSeed,
+                      AoA_IQSample *pSamples, uint16_t numSamples)
+{
+  // Response of each element to the scene, relative to a 0 dB path
+  float respI[AOA_EST_MAX_ELEMENTS];
+  float respQ[AOA_EST_MAX_ELEMENTS];
+  // Element switched in during each slot
+  uint8_t slotElement[UINT8_MAX];
+  float amplitude = (float)pScene->amplitude;
+  float sigma = 0.0f;
+  float wavenumber;
+  float step;
+  float start;
+  uint8_t numAntennas = pConfig->numAntennas;
+  uint8_t numPatterns = pConfig->pattern->numPatterns;
+  uint16_t slotLen;
+  uint16_t n;
+  uint8_t e;
+  uint8_t p;
+
+  if (numAntennas == 0 || numAntennas > AOA_EST_MAX_ELEMENTS ||
+      pScene->numPaths == 0 || pScene->numPaths > AOA_IQGEN_MAX_PATHS ||
+      numPatterns == 0 || numSamples < numPatterns ||
+      !AoAIQGen_slotElements(pConfig, slotElement))
+  {
+    return false;
+  }
+
+  // Radians of carrier phase per 0.1 mm of path
+  wavenumber = AOA_IQGEN_TWO_PI * AoAEst_channelMhz(pScene->channel) / AOA_IQGEN_LIGHT_SPEED;
+
+  for (e = 0; e < numAntennas; e++)
+  {
+    float x = (pElements != NULL) ? (float)pElements[e].x : (float)(e * AOA_IQGEN_ULA_SPACING);
+    float y = (pElements != NULL) ? (float)pElements[e].y : 0.0f;
+
+    respI[e] = 0.0f;
+    respQ[e] = 0.0f;
+
+    for (p = 0; p < pScene->numPaths; p++)
+    {
+      const AoAIQGen_Path *pPath = &pScene->paths[p];
+      float azimuth = (float)(pPath->azimuth - mountAzimuth) * AOA_IQGEN_DEG_TO_RAD;
+      float elevation = (float)pPath->elevation * AOA_IQGEN_DEG_TO_RAD;
+      float gain = powf(10.0f, (float)pPath->gainDb / 20.0f);
+
+      // Path direction projected on the array plane
+      float ux = cosf(elevation) * cosf(azimuth);
+      float uy = cosf(elevation) * sinf(azimuth);
+      float phase = (float)pPath->phase * AOA_IQGEN_DEG_TO_RAD +
+                    wavenumber * (x * ux + y * uy);
+
+      respI[e] += gain * cosf(phase);
+      respQ[e] += gain * sinf(phase);
+    }
+  }
+
+  if (pScene->snrDb != AOA_IQGEN_NO_NOISE)
+  {
+    // Split evenly between I and Q
+    sigma = amplitude / sqrtf(2.0f * powf(10.0f, (float)pScene->snrDb / 10.0f));
+  }
+
+  step = AOA_IQGEN_TWO_PI * (float)(AOA_IQGEN_TONE_KHZ + pScene->cfoKhz) / AOA_IQGEN_SAMPLE_KHZ;
+  start = AOA_IQGEN_TWO_PI * (float)(AoAIQGen_random(pSeed) >> 8) / 16777216.0f;
+  slotLen = numSamples / numPatterns;
+
+  for (n = 0; n < numSamples; n++)
+  {
+    uint16_t slot = n / slotLen;
+    uint16_t offset;
+    float hI;
+    float hQ;
+    float phase;
+    float c;
+    float s;
+
+    // Left over samples stay on the last slot
+    if (slot >= numPatterns)
+    {
+      slot = numPatterns - 1;
+    }
+
+    offset = n - slot * slotLen;
+    e = slotElement[slot];
+    hI = respI[e];
+    hQ = respQ[e];
+
+    // The switch blends linearly from the previous antenna
+    if (slot > 0 && offset < pScene->settleSamples)
+    {
+      uint8_t prev = slotElement[slot - 1];
+      float w = (float)(offset + 1) / (float)(pScene->settleSamples + 1);
+
+      hI = respI[prev] + w * (hI - respI[prev]);
+      hQ = respQ[prev] + w * (hQ - respQ[prev]);
+    }
+
+    phase = start + step * (float)n;
+    c = amplitude * cosf(phase);
+    s = amplitude * sinf(phase);
+
+    if (sigma > 0.0f)
+    {
+      pSamples[n].i = AoAIQGen_saturate(hI * c - hQ * s + sigma * AoAIQGen_gaussian(pSeed));
+      pSamples[n].q = AoAIQGen_saturate(hI * s + hQ * c + sigma * AoAIQGen_gaussian(pSeed));
+    }
+    else
+    {
+      pSamples[n].i = AoAIQGen_saturate(hI * c - hQ * s);
+      pSamples[n].q = AoAIQGen_saturate(hI * s + hQ * c);
+    }
+  }
+
+  return true;
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      AoAIQGen_random
+ *
+ * @brief   Next value of a xorshift32 generator.
+ *
+ * @param   pSeed - generator state, updated
+ *
+ * @return  32 random bits
+ */
+static uint32_t AoAIQGen_random(uint32_t *pSeed)
+{
+  uint32_t x = (*pSeed != 0) ? *pSeed : AOA_IQGEN_SEED;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *pSeed = x;
+
+  return x;
+}
+
+/*********************************************************************
+ * @fn      AoAIQGen_gaussian
+ *
+ * @brief   Standard normal value, Box-Muller.
+ *
+ * @param   pSeed - generator state, updated
+ *
+ * @return  random value, mean 0, deviation 1
+ */
+static float AoAIQGen_gaussian(uint32_t *pSeed)
+{
+  // u1 in (0, 1] so the log stays finite
+  float u1 = (float)((AoAIQGen_random(pSeed) >> 8) + 1) / 16777216.0f;
+  float u2 = (float)(AoAIQGen_random(pSeed) >> 8) / 16777216.0f;
+
+  return sqrtf(-2.0f * logf(u1)) * cosf(AOA_IQGEN_TWO_PI * u2);
+}
+
+/*********************************************************************
+ * @fn      AoAIQGen_saturate
+ *
+ * @brief   Round a sample component to nearest and clamp it to int16.
+ *
+ * @param   value - component, raw sample units
+ *
+ * @return  component
+ */
+static int16_t AoAIQGen_saturate(float value)
+{
+  value += (value < 0.0f) ? -0.5f : 0.5f;
+
+  if (value > 32767.0f)
+  {
+    return 32767;
+  }
+  else if (value < -32768.0f)
+  {
+    return -32768;
+  }
+
+  return (int16_t)value;
+}
+
+/*********************************************************************
+ * @fn      AoAIQGen_slotElements
+ *
+ * @brief   Follow the antenna pins through the pattern toggles and give
+ *          each slot the element AoAEst_initGeometry numbers it with:
+ *          element n is the one switched in during slot n of the first
+ *          repetition, later slots on the same pins reuse its number.
+ *
+ * @param   pConfig      - antenna array
+ * @param   pSlotElement - filled with the element of each slot
+ *
+ * @return  false if a slot switches pins the first repetition never
+ *          visits
+ */
+static bool AoAIQGen_slotElements(const AoA_AntennaConfig *pConfig,
+                                  uint8_t *pSlotElement)
+{
+  uint32_t pins[UINT8_MAX];
+  uint32_t current = pConfig->pattern->initialPattern;
+  uint8_t numPatterns = pConfig->pattern->numPatterns;
+  uint8_t numElements = pConfig->numAntennas;
+  uint8_t slot;
+  uint8_t e;
+
+  if (numElements > numPatterns)
+  {
+    numElements = numPatterns;
+  }
+
+  for (slot = 0; slot < numPatterns; slot++)
+  {
+    current ^= pConfig->pattern->toggles[slot];
+    pins[slot] = current;
+
+    // Numbered by the first slot on these pins, at the latest this one
+    e = 0;
+    while (e < numElements && pins[e] != current)
+    {
+      e++;
+    }
+
+    if (e == numElements)
+    {
+      return false;
+    }
+
+    pSlotElement[slot] = e;
+  }
+
+  return true;
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,180 @@
+/******************************************************************************
+
+ @file       aoa_iqgen.h
+
+ @brief Synthetic I/Q captures for a given direction, noise, carrier
+        offset and multipath.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+#ifndef AOAIQGEN_H
+#define AOAIQGEN_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "aoa/AOA.h"
+#include "aoa_estimator.h"
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Propagation paths of a scene, the first is the direct path
+#define AOA_IQGEN_MAX_PATHS                   4
+
+// Receiver sample rate and the tone the constant part of the packet
+// gives at zero carrier offset
+#define AOA_IQGEN_SAMPLE_KHZ                  4000
+#define AOA_IQGEN_TONE_KHZ                    250
+
+// AoAIQGen_Scene.snrDb value that adds no noise
+#define AOA_IQGEN_NO_NOISE                    127
+
+// Element spacing used when no positions are given: half a wavelength
+// at 2440 MHz, 0.1 mm
+#define AOA_IQGEN_ULA_SPACING                 614
+
+// Amplitude set by AoAIQGen_sceneInit, raw sample units
+#define AOA_IQGEN_DEFAULT_AMPLITUDE           1000
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// One propagation path. The paths are narrowband: a reflection only
+// changes the direction, strength and carrier phase of the signal.
+typedef struct
+{
+  int16_t azimuth;        // Degrees from the receiver reference
+  int16_t elevation;      // Degrees above the array plane
+  int8_t  gainDb;         // Relative to the amplitude of the scene
+  int16_t phase;          // Carrier phase relative to the direct path, degrees
+} AoAIQGen_Path;
+
+// Conditions of one capture
+typedef struct
+{
+  uint8_t  channel;       // RF channel, 0-39
+  uint16_t amplitude;     // Amplitude of a 0 dB path, raw sample units
+  int8_t   snrDb;         // Per sample, to a 0 dB path, or AOA_IQGEN_NO_NOISE
+  int16_t  cfoKhz;        // Carrier frequency offset of the tag
+  uint8_t  settleSamples; // Samples after a switch blending the two antennas
+  uint8_t  numPaths;      // 1 to AOA_IQGEN_MAX_PATHS
+  AoAIQGen_Path paths[AOA_IQGEN_MAX_PATHS];
+} AoAIQGen_Scene;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * @brief   Set up a clean single path scene: default amplitude, no
+ *          noise, carrier offset or settling.
+ *
+ * @param   pScene    - scene to fill
+ * @param   channel   - RF channel
+ * @param   azimuth   - direction of the tag, degrees
+ * @param   elevation - degrees above the array plane
+ */
+extern void AoAIQGen_sceneInit(AoAIQGen_Scene *pScene, uint8_t channel,
+                               int16_t azimuth, int16_t elevation);
+
+/*
+ * @brief   Generate the raw capture of one packet.
+ *
+ *          Laid out as the receiver captures it: numSamples samples
+ *          split evenly into pattern->numPatterns antenna slots, each
+ *          on the element its pattern pins select. Elements are numbered
+ *          as in AoAEst_initGeometry, by their slot in the first
+ *          repetition, so patterns repeating out of step are followed.
+ *          The tone advances by AOA_IQGEN_TONE_KHZ plus the carrier
+ *          offset, its start phase is drawn from the seed. Each element
+ *          sees the sum of the paths with the phase 360 * r.u / lambda,
+ *          r its position and u the path direction. Noise is white
+ *          Gaussian, components are rounded and saturated to int16.
+ *
+ *          The pair sign, offset and gain of the config are not
+ *          modelled, the capture is what a calibrated array would give.
+ *          Linear arrays resolve the angle from broadside, so compare
+ *          AoAEst_getDirection with the cone angle, not the azimuth.
+ *
+ * @param   pConfig      - antenna array
+ * @param   pElements    - element positions, NULL for a line along x
+ *                         spaced AOA_IQGEN_ULA_SPACING apart
+ * @param   mountAzimuth - azimuth of the array x axis, degrees
+ * @param   pScene       - conditions of the capture
+ * @param   pSeed        - noise generator state, updated
+ * @param   pSamples     - filled with the capture
+ * @param   numSamples   - samples to generate
+ *
+ * @return  false if the array or scene is out of range
+ */
+extern bool AoAIQGen_capture(const AoA_AntennaConfig *pConfig,
+                             const AoAEst_Element *pElements,
+                             int16_t mountAzimuth,
+                             const AoAIQGen_Scene *pScene, uint32_t *pSeed,
+                             AoA_IQSample *pSamples, uint16_t numSamples);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AOAIQGEN_H */
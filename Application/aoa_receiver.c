@@ -50,10 +50,13 @@
  */
 #include <string.h>
 
+#include <ti/sysbios/BIOS.h>
 #include <ti/sysbios/knl/Task.h>
 #include <ti/sysbios/knl/Clock.h>
 #include <ti/sysbios/knl/Event.h>
 #include <ti/sysbios/knl/Queue.h>
+#include <ti/sysbios/knl/Semaphore.h>
+#include <ti/sysbios/hal/Hwi.h>
 #include <ti/display/Display.h>
 
 // For AoA
@@ -84,6 +87,19 @@
 
 // AOA headers
 #include "aoa_receiver.h"
+#include "msg_pool.h"
+#include "aoa_cmd.h"
+#include "dev_table.h"
+#include "aoa_iq.h"
+#include "aoa_estimator.h"
+#include "ant_config.h"
+#include "aoa_duty.h"
+#include "aoa_trigger.h"
+#include "aoa_conn_ctrl.h"
+#include "aoa_gatt_cache.h"
+#include "aoa_backhaul.h"
+#include "aoa_bench.h"
+#include "aoa_fusion.h"
 #include "aoa/AOA.h"
 #include "aoa/RFQueue.h"
 #include "ant_array1_config_boostxl_rev1v1.h"
@@ -105,6 +121,7 @@
 #define AOA_PASSCODE_NEEDED_EVT               0x0008
 #define AOA_REPORT_EVT                        0x0010
 #define AOA_CONN_EVT                          0x0020
+#define AOA_ANGLE_EVT                         0x0040
 
 // AoA Receiver Task Events
 #define AOA_ICALL_EVT                         ICALL_MSG_EVENT_ID // Event_Id_31
@@ -114,13 +131,44 @@
 // AoA Receiver connected event end event
 #define AOA_HCI_CONN_EVT_END_EVT              Event_Id_01
 
+// A coalesced connection event report is waiting in its slot
+#define AOA_CONN_EVT_SLOT_EVT                 Event_Id_02
+
+// The estimation worker has finished with an I/Q report
+#define AOA_ESTIMATE_DONE_EVT                 Event_Id_03
+
+// A command frame arrived on the UART command interface
+#define AOA_CMD_EVT                           Event_Id_04
+
+// Duty-cycled idle AoA scanning is due for its next round
+#define AOA_DUTY_EVT                          Event_Id_05
+
+// Angles batched for the backhaul subscribers are due
+#define AOA_BACKHAUL_EVT                      Event_Id_06
+
 #define AOA_ALL_EVENTS                        (AOA_ICALL_EVT           | \
                                                AOA_QUEUE_EVT           | \
                                                AOA_START_DISCOVERY_EVT | \
-                                               AOA_HCI_CONN_EVT_END_EVT)
+                                               AOA_HCI_CONN_EVT_END_EVT | \
+                                               AOA_CONN_EVT_SLOT_EVT   | \
+                                               AOA_ESTIMATE_DONE_EVT   | \
+                                               AOA_CMD_EVT             | \
+                                               AOA_DUTY_EVT            | \
+                                               AOA_BACKHAUL_EVT)
+
+// Maximum number of scan responses kept by the stack. The stack holds a
+// record per device until the round ends and ends the round once the list
+// is full, so this bounds both. More than the device table takes is of no
+// use.
+#if DEV_TABLE_SIZE < 255
+#define DEFAULT_MAX_SCAN_RES                  DEV_TABLE_SIZE
+#else
+#define DEFAULT_MAX_SCAN_RES                  255
+#endif
 
-// Maximum number of scan responses
-#define DEFAULT_MAX_SCAN_RES                  8
+// Devices not seen for this long (ms) are dropped from the device table
+// when a discovery round starts
+#define DEFAULT_DEV_TABLE_MAX_AGE             60000
 
 // Scan duration in ms
 #define DEFAULT_SCAN_DURATION                 4000
@@ -146,9 +194,12 @@
 // TRUE to use white list when creating link
 #define DEFAULT_LINK_WHITE_LIST               FALSE
 
-// After the connection is formed, the central will accept connection parameter
-// update requests from the peripheral
-#define DEFAULT_ENABLE_UPDATE_REQUEST         GAPCENTRALROLE_PARAM_UPDATE_REQ_AUTO_ACCEPT
+// After the connection is formed, connection parameter update requests
+// from the peripheral are answered by the application. While the
+// connection controller is off they are accepted as asked, as with
+// GAPCENTRALROLE_PARAM_UPDATE_REQ_AUTO_ACCEPT, otherwise the link gets
+// the interval the controller wants.
+#define DEFAULT_ENABLE_UPDATE_REQUEST         GAPCENTRALROLE_PARAM_UPDATE_REQ_SEND_TO_APP
 
 // Minimum connection interval (units of 1.25ms) if automatic parameter update
 // request is enabled
@@ -165,6 +216,27 @@
 // request is enabled
 #define DEFAULT_UPDATE_CONN_TIMEOUT           600
 
+// Connection interval controller. Connected AoA captures once per
+// connection event, so the interval sets the angle rate. An active rate
+// of 0 leaves the interval to the peripheral, so the controller is off
+// until AOA_CMD_SET_CONN_CTRL sets a rate. The other values match the
+// defaults of the conn-ctrl command of aoa_cmd.py.
+#define DEFAULT_CONN_CTRL_ACTIVE_RATE         0     // Angles per second, tag moving
+#define DEFAULT_CONN_CTRL_STILL_RATE          2     // Angles per second, tag still
+#define DEFAULT_CONN_CTRL_IDLE_INTERVAL       DEFAULT_UPDATE_MAX_CONN_INTERVAL
+#define DEFAULT_CONN_CTRL_MOTION_ANGLE        5     // degrees
+#define DEFAULT_CONN_CTRL_MOTION_HOLD         3000  // ms
+#define DEFAULT_CONN_CTRL_UPDATE_GAP          2000  // ms
+
+// Traffic requested from senders with the control characteristic. The
+// receiver captures one packet per connection event, so by default it
+// asks for a single packet every connection interval.
+#define DEFAULT_AOA_SENDER_BURST              1
+#define DEFAULT_AOA_SENDER_PERIOD             0     // 1.25 ms units, 0 = connection interval
+
+// Largest supervision timeout, units of 10ms
+#define AOA_MAX_CONN_TIMEOUT                  3200
+
 // Default GAP pairing mode
 #define DEFAULT_PAIRING_MODE                  GAPBOND_PAIRING_MODE_WAIT_FOR_REQ
 
@@ -180,19 +252,141 @@
 // Default service discovery timer delay in ms
 #define DEFAULT_SVC_DISCOVERY_DELAY           1000
 
+// TRUE to find the sender's handles as soon as the link is up, with one
+// characteristic discovery over the whole handle range, instead of the
+// MTU, service and characteristic steps after the delay above. At the
+// default 23-byte MTU a read by type response holds three 16-bit UUID
+// declarations, so a sender with a large GATT database can need more
+// round trips over the whole range than the step by step path does.
+#define DEFAULT_FAST_DISCOVERY                FALSE
+
 // TRUE to filter discovery results on desired service UUID
 #define DEFAULT_DEV_DISC_BY_SVC_UUID          TRUE
 
+// TRUE to start the next discovery round as soon as one ends, reporting
+// new AoA senders as their advertisements arrive
+#define DEFAULT_CONT_DISCOVERY                FALSE
+
+// TRUE to connect to a new AoA sender found by discovery, and start
+// connected AoA once its AoA characteristic is found. Targets are
+// limited by the address filter list when it is not empty.
+#define DEFAULT_DISC_AUTO_CONNECT             FALSE
+
 // Length of bd addr as a string
 #define B_ADDR_STR_LEN                        15
 
-// AOA RSSI Threshold
+// TRUE to re-arm idle AoA scanning on the second report buffer before
+// the previous capture is estimated, so capture and estimation overlap
+#define DEFAULT_AOA_PIPELINED                 FALSE
+
+// TRUE to send every angle, or every capture, over the command
+// interface. Captures take ~10 frames each and slow AoA down, they are
+// meant for recording test data.
+#define DEFAULT_AOA_ANGLE_IND                 FALSE
+#define DEFAULT_AOA_IQ_IND                    FALSE
+
+// TRUE to fuse the angles of a tag over each channel cycle and output
+// one angle per cycle instead of one per capture pair
+#define DEFAULT_AOA_FUSION                    FALSE
+
+// I/Q quality gate applied before estimation. Captures below either
+// threshold are dropped, 0 disables a check.
+#define DEFAULT_AOA_IQ_MIN_AMPLITUDE          32    // RMS, raw sample units
+#define DEFAULT_AOA_IQ_MIN_COHERENCE          70    // percent
+
+// Samples kept of each antenna slot (16 samples, 4 us at 4 MHz). The
+// first microsecond after a switch is still settling.
+#define DEFAULT_AOA_SLOT_SKIP                 4
+#define DEFAULT_AOA_SLOT_KEEP                 8
+
+// Idle AoA scanning rate, in rounds (one capture per antenna array) per
+// second. Between rounds the radio is off and the device can stand by.
+// A maximum of 0 scans continuously.
+#ifndef DEFAULT_AOA_DUTY_MAX_RATE
+#define DEFAULT_AOA_DUTY_MAX_RATE             0
+#endif
+#define DEFAULT_AOA_DUTY_MIN_RATE             1     // No tag seen recently
+#define DEFAULT_AOA_DUTY_RATE_PER_TAG         2
+#define DEFAULT_AOA_DUTY_TAG_WINDOW           5000  // ms
+
+// Hub link: build with AOA_HUB_LINK and the receiver also advertises the
+// AoA Results service, so a hub can connect and subscribe to the angles
+// while tags are scanned and connected. The stack library must be built
+// with the peripheral role (HOST_CONFIG with PERIPHERAL_CFG) and
+// MAX_NUM_BLE_CONNS of 2 or more. The hub link shares the radio with the
+// AoA captures.
+#if defined( AOA_HUB_LINK )
+#if defined( AOA_STREAM )
+#error "AOA_HUB_LINK notifies angles, AOA_STREAM receivers do not estimate any"
+#endif
+
+// Advertising interval (units of 625us), slow so the captures keep the
+// radio
+#define DEFAULT_HUB_ADV_INTERVAL              800
+
+// Longest time (ms) an angle waits in the backhaul batch before it is
+// notified to the subscribers. A full batch goes out at once.
+#define DEFAULT_AOA_BACKHAUL_FLUSH            100
+#endif // AOA_HUB_LINK
+
+// TRUE to keep only the latest undelivered connection event report of
+// each connection instead of queueing every report
+#define DEFAULT_CONN_EVT_COALESCE             FALSE
+
+// Number of connection event report slots, one per connection handle
+#if defined(MAX_NUM_BLE_CONNS)
+#define AOA_CONN_EVT_SLOTS                    MAX_NUM_BLE_CONNS
+#else
+#define AOA_CONN_EVT_SLOTS                    1
+#endif
+
+// AOA RSSI Threshold (defaults, can be changed over the command interface)
 #define AOA_RSSI_THRESHOLD                    -50
 #define AOA_RSSI_THRESHOLD_HYSTERESIS         -5
 
+// Auto AoA dwell times and spacing of requests to the sender (ms). A
+// tag hovering around the threshold no longer toggles the sender on
+// every connection event.
+#define DEFAULT_AOA_TRIGGER_MIN_ON_TIME       2000
+#define DEFAULT_AOA_TRIGGER_MIN_OFF_TIME      1000
+#define DEFAULT_AOA_TRIGGER_REQUEST_GAP       500
+
+// Maximum number of RF channels in the AoA channel list
+#define AOA_MAX_CHANNELS                      8
+
+// Highest BLE RF channel index
+#define AOA_MAX_RF_CHANNEL                    39
+
+// Number of advertiser addresses idle AoA scanning can be limited to
+#ifndef AOA_FILTER_LIST_SIZE
+#define AOA_FILTER_LIST_SIZE                  8
+#endif
+
+// AOA_REPORT_EVT status of a capture dropped by the address filter
+#define AOA_REPORT_FILTERED                   0xF0
+
+// Build with AOA_INJECT to accept the AOA_CMD_INJECT_xxx commands, which
+// feed advertising reports, connection events and I/Q captures into the
+// same paths the stack and the AoA driver use. Scripted scenarios then
+// run the real state machine without tags on the air. Test builds only.
+
 // AOA Profile UUIDS
 #define AOAPROFILE_SERVICE_UUID               0xFFB0
 #define AOAPROFILE_AOA_START_UUID             0xFFB1
+#define AOAPROFILE_AOA_CONTROL_UUID           0xFFB2
+
+// Sender control message, written without response to the
+// AOAPROFILE_AOA_CONTROL_UUID characteristic:
+//
+//   OP | PACKET_ID | CHAN_MAP[5] | PERIOD[2] | BURST
+//
+// CHAN_MAP bit n (byte n / 8, bit n % 8) enables RF channel n. PERIOD
+// is the little endian time between bursts in 1.25 ms units, BURST the
+// number of AoA packets sent back to back. A sender without the
+// characteristic only understands the 1-byte start/stop write.
+#define AOA_SENDER_CTRL_STOP                  0x00
+#define AOA_SENDER_CTRL_START                 0x01
+#define AOA_SENDER_CTRL_LEN                   10
 
 // RSSI check
 #define AOA_IS_VALID_RSSI(rssi)              ((rssi) != -LL_RF_RSSI_UNDEFINED && \
@@ -223,16 +417,64 @@
 #endif // Display_DISABLE_ALL
 
 // Task configuration
-#define AOA_TASK_PRIORITY                     1
+#define AOA_TASK_PRIORITY                     2
 
 #ifndef AOA_TASK_STACK_SIZE
 #define AOA_TASK_STACK_SIZE                   1120
 #endif
 
+// Estimation worker task configuration. Runs below the application
+// task so GAP/GATT, key and connection event processing preempt it.
+#define AOA_WORKER_TASK_PRIORITY              1
+
+#ifndef AOA_WORKER_TASK_STACK_SIZE
+#define AOA_WORKER_TASK_STACK_SIZE            768
+#endif
+
 #define AOA_PIN(x)                            (1 << (x&0xff))
 
+// Antenna switch pins driven by the AoA driver. Loaded antenna patterns
+// may only use these.
+#define AOA_ANTENNA_PINS                      (1 << IOID_27 | 1 << IOID_28 | 1 << IOID_29 | 1 << IOID_30)
+
 #define NUM_AOA_SAMPLES                       512
 
+// Longest antenna pattern, one slot per entry
+#define AOA_MAX_PATTERNS                      32
+
+// Most samples an estimating build keeps per slot, sizes the report
+// buffers
+#ifndef AOA_MAX_SLOT_KEEP
+#define AOA_MAX_SLOT_KEEP                     DEFAULT_AOA_SLOT_KEEP
+#endif
+
+#define AOA_REPORT_SAMPLES                    (AOA_MAX_PATTERNS * AOA_MAX_SLOT_KEEP)
+
+// Number of I/Q report buffers. Two let a new capture be copied out
+// while the worker is still estimating the previous one. Estimating
+// builds keep captures packed to half size, so twice as many fit in the
+// same RAM.
+#ifndef AOA_NUM_REPORT_BUFS
+#if defined( AOA_STREAM )
+#define AOA_NUM_REPORT_BUFS                   2
+#else
+#define AOA_NUM_REPORT_BUFS                   4
+#endif
+#endif
+
+// Depth of the estimation worker queue, one entry per report buffer
+#define AOA_WORKER_QUEUE_DEPTH                AOA_NUM_REPORT_BUFS
+
+// Message pool blocks per size class. Small blocks carry the queue
+// envelopes, angle results and one byte payloads (pairing state,
+// passcode), medium blocks carry connection event reports and large
+// blocks carry I/Q reports.
+#define AOA_POOL_SMALL_BLOCKS                 16
+#define AOA_POOL_MEDIUM_BLOCKS                4
+#define AOA_POOL_LARGE_BLOCKS                 AOA_NUM_REPORT_BUFS
+
+#define AOA_MAX(a, b)                         (((a) > (b)) ? (a) : (b))
+
 // Set the register cause to the registration bit-mask
 #define CONNECTION_EVENT_REGISTER_BIT_SET(RegisterCause) (connectionEventRegisterCauseBitMap |= RegisterCause)
 // Remove the register cause from the registration bit-mask
@@ -259,7 +501,10 @@ enum
   BLE_DISC_STATE_IDLE,                // Idle
   BLE_DISC_STATE_MTU,                 // Exchange ATT MTU size
   BLE_DISC_STATE_SVC,                 // Service discovery
-  BLE_DISC_STATE_CHAR                 // Characteristic discovery
+  BLE_DISC_STATE_CHAR,                // Characteristic discovery
+  BLE_DISC_STATE_CTRL,                // Control characteristic discovery
+  BLE_DISC_STATE_ALL_CHARS,           // Fast discovery, all characteristics
+  BLE_DISC_STATE_MTU_LATE             // Fast discovery, MTU after the handles
 };
 
 // Key states for connections
@@ -277,14 +522,18 @@ typedef enum {
 // App event passed from profiles.
 typedef struct
 {
-  appEvtHdr_t hdr; // event header
-  uint8_t *pData;  // event data
+  Queue_Elem _elem; // queue element
+  appEvtHdr_t hdr;  // event header
+  uint8_t *pData;   // event data
 } sbcEvt_t;
 
 #if !defined( AOA_STREAM )
 typedef struct {
     int16_t angle;
     int16_t currentangle;
+    int16_t elevation;        // Valid if hasElevation
+    int16_t currentElevation; // Valid if hasElevation
+    bool    hasElevation;     // Array geometry resolves elevation
     int8_t  rssi;
     int16_t signalStrength;
     uint8_t channel;
@@ -294,6 +543,7 @@ typedef struct {
 typedef struct AoA_movingAverage
 {
     int16_t array[6];
+    int16_t elevation[6];
     uint8_t idx;
     uint8_t currentAntennaArray;
     int16_t currentAoA;
@@ -313,10 +563,32 @@ typedef struct {
   uint8_t channel;
   AoA_AntennaConfig *antConfig;
   AoA_AntennaResult *antResult;  
+#if defined( AOA_STREAM )
   AoA_IQSample samples[NUM_AOA_SAMPLES];
+#else
+  int8_t rssi;
+  uint8_t iqShift;                        // Block exponent of samples[]
+  uint8_t slotLen;                        // Samples kept per antenna slot
+  uint8_t slotPeriod;                     // Raw samples per antenna slot
+  uint16_t numSamples;
+  AoAIQ_Sample samples[AOA_REPORT_SAMPLES];
+#endif // AOA_STREAM
   uint8_t advAddr[6];
 } aoaReport_t;
 
+#if !defined( AOA_STREAM )
+// Angle result passed from the estimation worker to the application
+typedef struct {
+  uint8_t advAddr[B_ADDR_LEN];
+  AoA_Sample sample;
+  uint16_t estimateUs;        // Worker time spent on the capture pair
+} aoaAngleRpt_t;
+
+#define AOA_POOL_SMALL_SIZE                   AOA_MAX(sizeof(sbcEvt_t), sizeof(aoaAngleRpt_t))
+#else
+#define AOA_POOL_SMALL_SIZE                   sizeof(sbcEvt_t)
+#endif // !AOA_STREAM
+
 // RSSI alpha filter structure
 typedef struct
 {
@@ -324,6 +596,13 @@ typedef struct
   uint8_t alpha;
 } rssiAlphaFilter_t;
 
+// Latest undelivered connection event report of one connection
+typedef struct
+{
+  Gap_ConnEventRpt_t report;  // Most recent report
+  bool pending;               // TRUE until the app task consumes it
+} connEvtSlot_t;
+
 typedef enum
 {
   NOT_REGISTERED     = 0x0,
@@ -332,6 +611,19 @@ typedef enum
   FOR_ATT_RSP        = 0x4,
 } connectionEventRegisterCause_u;
 
+#if defined( AOA_BENCH )
+// Inputs of the AOA_CMD_BENCH code sections
+typedef struct
+{
+  aoaReport_t *pReport;       // Synthetic capture
+  AoA_IQSample *pRaw;         // Driver capture buffer
+#if !defined( AOA_STREAM )
+  AoAIQ_SlotMap slotMap;      // Samples kept in pReport
+#endif // !AOA_STREAM
+  uint8_t *pMsg;              // Message passed through Util_enqueueMsg
+} aoaBench_t;
+#endif // AOA_BENCH
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -360,6 +652,15 @@ static ICall_SyncHandle syncEvent;
 // Clock object used to signal timeout
 static Clock_Struct startDiscClock;
 
+// Wakes duty-cycled idle AoA scanning for its next round
+static Clock_Struct aoaDutyClock;
+
+#if defined( AOA_HUB_LINK )
+// Flushes the backhaul batch, started by its first angle
+static Clock_Struct aoaBackhaulClock;
+static uint16_t aoaBackhaulFlush = DEFAULT_AOA_BACKHAUL_FLUSH;
+#endif // AOA_HUB_LINK
+
 // Queue object used for app messages
 static Queue_Struct appMsg;
 static Queue_Handle appMsgQueue;
@@ -368,15 +669,39 @@ static Queue_Handle appMsgQueue;
 Task_Struct sbcTask;
 Char sbcTaskStack[AOA_TASK_STACK_SIZE];
 
+#if !defined( AOA_STREAM )
+// Estimation worker task configuration
+Task_Struct aoaWorkerTask;
+Char aoaWorkerTaskStack[AOA_WORKER_TASK_STACK_SIZE];
+
+// Estimation worker queue. Bounded ring of reports waiting for the
+// worker, counted by aoaWorkerSem.
+static Semaphore_Struct aoaWorkerSem;
+static aoaReport_t *aoaWorkerQueue[AOA_WORKER_QUEUE_DEPTH];
+static uint8_t aoaWorkerQueueHead = 0;
+static uint8_t aoaWorkerQueueCount = 0;
+
+// Number of reports dropped because the worker queue was full
+static uint32_t aoaWorkerDropCnt = 0;
+#endif // !AOA_STREAM
+
 // GAP GATT Attributes
 static const uint8_t attDeviceName[GAP_DEVICE_NAME_LEN] = "AoA Receiver";
 
-// Number of scan results and scan result index
-static uint8_t scanRes = 0;
-static int8_t scanIdx = -1;
+// Device table index selected in the key menu
+static int16_t scanIdx = -1;
+
+// Continuous discovery and auto-connect
+static bool contDiscovery = DEFAULT_CONT_DISCOVERY;
+static bool discAutoConnect = DEFAULT_DISC_AUTO_CONNECT;
+
+// Sender to connect to once the running discovery round is cancelled
+static bool discConnectPending = FALSE;
+static uint8_t discConnectAddr[B_ADDR_LEN];
+static uint8_t discConnectAddrType;
 
-// Scan result list
-static gapDevRec_t devList[DEFAULT_MAX_SCAN_RES];
+// TRUE if the current link was made by auto-connect
+static bool discAutoAoa = FALSE;
 
 // Scanning state
 static bool scanningStarted = FALSE;
@@ -393,6 +718,26 @@ static bool aoaSenderActive = FALSE;
 // Connection handle of current connection
 static uint16_t connHandle = GAP_CONNHANDLE_INIT;
 
+#if defined( AOA_HUB_LINK )
+// Connection handle of the hub, kept apart from the tag link
+static uint16_t hubConnHandle = GAP_CONNHANDLE_INIT;
+
+// Hub advertising: flags and the AoA Results service
+static uint8_t hubAdvData[] =
+{
+  0x02, GAP_ADTYPE_FLAGS, GAP_ADTYPE_FLAGS_GENERAL | GAP_ADTYPE_FLAGS_BREDR_NOT_SUPPORTED,
+  0x03, GAP_ADTYPE_16BIT_COMPLETE,
+  LO_UINT16(AOA_BACKHAUL_SERV_UUID), HI_UINT16(AOA_BACKHAUL_SERV_UUID)
+};
+
+// Hub scan response: the device name
+static uint8_t hubScanRspData[] =
+{
+  0x0D, GAP_ADTYPE_LOCAL_NAME_COMPLETE,
+  'A', 'o', 'A', ' ', 'R', 'e', 'c', 'e', 'i', 'v', 'e', 'r'
+};
+#endif // AOA_HUB_LINK
+
 // Application state
 static uint8_t state = BLE_STATE_IDLE;
 
@@ -406,6 +751,30 @@ static uint16_t svcEndHdl = 0;
 // Discovered characteristic handle
 static uint16_t charHdl = 0;
 
+// Discovered sender control characteristic handle, 0 for a legacy sender
+static uint16_t ctrlHdl = 0;
+
+// Address of the connected peer, to look up and store cached handles
+static uint8_t peerAddr[B_ADDR_LEN];
+static uint8_t peerAddrType;
+
+// Handles came from the cache and no write has confirmed them yet
+static bool gattCacheHit = FALSE;
+
+// Fast discovery, see DEFAULT_FAST_DISCOVERY
+static bool fastDiscovery = DEFAULT_FAST_DISCOVERY;
+
+// Last link: when it came up, and the ms until the sender's handles were
+// known and until the first angle. 0 while not reached.
+static uint32_t linkUpTime = 0;
+static uint32_t linkDiscMs = 0;
+static uint32_t linkFirstAngleMs = 0;
+
+// AoA packets the sender sends per burst, and the time between bursts
+// in 1.25 ms units (0 follows the connection interval)
+static uint8_t senderBurst = DEFAULT_AOA_SENDER_BURST;
+static uint16_t senderPeriod = DEFAULT_AOA_SENDER_PERIOD;
+
 // Value to write
 static uint8_t charVal = 0;
 
@@ -421,28 +790,122 @@ static keyPressConnOpt_t keyPressConnOpt = DISCONNECT;
 // Declare and initialize channel table
 static uint8_t channelIdx = 0;
 
-static uint8_t channels[] = {37, 38, 39};
+static uint8_t channels[AOA_MAX_CHANNELS] = {37, 38, 39};
+static uint8_t numChannels = 3;
+
+// Number of I/Q report buffers currently allocated, at most
+// AOA_NUM_REPORT_BUFS
+static volatile uint8_t aoaReportsAllocated = 0;
+
+// Active antenna configurations, owned by ant_config. Set once at init,
+// loading a new configuration updates them in place.
+static AoA_AntennaConfig *AoAReceiver_antA1Config = NULL;
+static AoA_AntennaConfig *AoAReceiver_antA2Config = NULL;
+
+static AoA_AntennaResult *AoAReceiver_antA1Result = NULL;
+static AoA_AntennaResult *AoAReceiver_antA2Result = NULL;
+
+// Antenna array the armed capture uses. Chosen when the capture is
+// armed so it does not depend on how far estimation has progressed.
+static AoA_AntennaConfig *aoaArmedConfig = NULL;
+static AoA_AntennaResult *aoaArmedResult = NULL;
+
+// TRUE if the next capture uses antenna array A2
+static bool aoaCaptureA2 = FALSE;
+
+#if !defined( AOA_STREAM )
+// Pipelined idle AoA scanning
+static bool aoaPipelined = DEFAULT_AOA_PIPELINED;
+
+// Angles and captures sent over the command interface
+static bool aoaAngleInd = DEFAULT_AOA_ANGLE_IND;
+static bool aoaIqInd = DEFAULT_AOA_IQ_IND;
+
+// Angles fused over the channel cycle, see AoAReceiver_fuseAngle
+static bool aoaFusion = DEFAULT_AOA_FUSION;
+
+// Worker ticks spent on the captures of the current pair
+static uint32_t aoaEstimateTicks = 0;
+
+// I/Q quality gate and the number of captures it dropped
+static AoAIQ_GateCfg aoaIqGateCfg =
+{
+  DEFAULT_AOA_IQ_MIN_AMPLITUDE,
+  DEFAULT_AOA_IQ_MIN_COHERENCE
+};
+static uint32_t aoaIqLowAmplitudeCnt = 0;
+static uint32_t aoaIqLowCoherenceCnt = 0;
+
+// Samples copied out of each antenna slot
+static uint8_t aoaSlotSkip = DEFAULT_AOA_SLOT_SKIP;
+static uint8_t aoaSlotKeep = DEFAULT_AOA_SLOT_KEEP;
+
+// Moving average of the estimated angles
+static AoA_movingAverage AoA_ma;
+#endif // !AOA_STREAM
 
-// AoA buffer allocation flag to avoid more than one big buffer
-// being allocated at the same time.
-static volatile bool aoaAllocated = false;
+#if defined( AOA_BENCH )
+// Private queue of the AOA_CMD_BENCH_xxx_QUEUE sections
+static Queue_Struct benchMsg;
+static Queue_Handle benchMsgQueue;
 
-static AoA_AntennaConfig *AoAReceiver_antA1Config = &BOOSTXL_AoA_Config_ArrayA1;
-static AoA_AntennaConfig *AoAReceiver_antA2Config = &BOOSTXL_AoA_Config_ArrayA2;
+// Advertising data of a typical sender: flags, name, then the service
+// UUID list, so the search walks every AD structure
+static uint8_t benchAdvData[] =
+{
+  0x02, GAP_ADTYPE_FLAGS, 0x06,
+  0x08, GAP_ADTYPE_LOCAL_NAME_COMPLETE, 'A', 'o', 'A', ' ', 'T', 'a', 'g',
+  0x05, GAP_ADTYPE_16BIT_COMPLETE, 0x0A, 0x18,
+  LO_UINT16(AOAPROFILE_SERVICE_UUID), HI_UINT16(AOAPROFILE_SERVICE_UUID)
+};
 
-static AoA_AntennaResult *AoAReceiver_antA1Result = &BOOSTXL_AoA_Result_ArrayA1;
-static AoA_AntennaResult *AoAReceiver_antA2Result = &BOOSTXL_AoA_Result_ArrayA2;
+// Device refreshed by AOA_CMD_BENCH_ADD_DEVICE. Not an AoA sender, so
+// it is never connected and ages out like any other advertiser.
+static uint8_t benchAddr[B_ADDR_LEN] = { 0x01, 0x00, 0x00, 0xBE, 0xBE, 0xC0 };
+#endif // AOA_BENCH
 
 // Auto AoA enable (enabled by RSSI threshold)
 bool autoAoaEnabled = FALSE;
 
-// RSSI Alpha filter
+// RSSI Alpha filter. Auto AoA filters the RSSI of each peer in the
+// trigger engine.
 rssiAlphaFilter_t aoaReceiverRssi;
 
+// Advertiser address filter for idle AoA scanning. Captures from other
+// advertisers are dropped in the RF callback. Empty accepts everyone.
+static uint8_t aoaFilterList[AOA_FILTER_LIST_SIZE][B_ADDR_LEN];
+static volatile uint8_t aoaFilterCount = 0;
+
+// AoA report and angle counters, reported over the command interface
+static uint32_t aoaReportCnt = 0;
+static uint32_t aoaFilteredCnt = 0;
+static uint32_t aoaReportFailCnt = 0;
+static uint32_t aoaAngleCnt = 0;
+
 
 // Bitmap to mark clients that are registered to connection events
 uint32_t connectionEventRegisterCauseBitMap = NOT_REGISTERED;
 
+// Connection event report coalescing
+static bool connEvtCoalesce = DEFAULT_CONN_EVT_COALESCE;
+static connEvtSlot_t connEvtSlots[AOA_CONN_EVT_SLOTS];
+
+// Number of reports overwritten before the app task consumed them
+static uint32_t connEvtCoalescedCnt = 0;
+
+// Message pool storage, one array per size class
+static uint32_t aoaPoolSmall[MSG_POOL_STORAGE_WORDS(AOA_POOL_SMALL_SIZE, AOA_POOL_SMALL_BLOCKS)];
+static uint32_t aoaPoolMedium[MSG_POOL_STORAGE_WORDS(sizeof(Gap_ConnEventRpt_t), AOA_POOL_MEDIUM_BLOCKS)];
+static uint32_t aoaPoolLarge[MSG_POOL_STORAGE_WORDS(sizeof(aoaReport_t), AOA_POOL_LARGE_BLOCKS)];
+
+// Message pool size classes, in increasing block size
+static const MsgPool_ClassCfg aoaPoolCfg[] =
+{
+  { AOA_POOL_SMALL_SIZE,        AOA_POOL_SMALL_BLOCKS,  aoaPoolSmall  },
+  { sizeof(Gap_ConnEventRpt_t), AOA_POOL_MEDIUM_BLOCKS, aoaPoolMedium },
+  { sizeof(aoaReport_t),        AOA_POOL_LARGE_BLOCKS,  aoaPoolLarge  },
+};
+
 /*********************************************************************
  * LOCAL FUNCTIONS
  */
@@ -455,9 +918,24 @@ static void AoAReceiver_processStackMsg(ICall_Hdr *pMsg);
 static void AoAReceiver_processAppMsg(sbcEvt_t *pMsg);
 static void AoAReceiver_processRoleEvent(gapCentralRoleEvent_t *pEvent);
 static void AoAReceiver_processGATTDiscEvent(gattMsgEvent_t *pMsg);
+static void AoAReceiver_discComplete(void);
+static uint32_t AoAReceiver_elapsedMs(uint32_t since);
 static void AoAReceiver_startDiscovery(void);
+static bStatus_t AoAReceiver_idleAoaStart(void);
+static bStatus_t AoAReceiver_idleAoaStop(void);
+static bStatus_t AoAReceiver_discoverDevices(void);
+static bStatus_t AoAReceiver_connect(uint8_t *pAddr, uint8_t addrType);
+static bStatus_t AoAReceiver_connAoaScan(bool enable);
+static bStatus_t AoAReceiver_autoAoa(bool enable);
+static bStatus_t AoAReceiver_disconnect(void);
+static uint8_t *AoAReceiver_putUint32(uint8_t *pBuf, uint32_t val);
+static void AoAReceiver_processCmd(void);
 static bool AoAReceiver_findSvcUuid(uint16_t uuid, uint8_t *pData, uint8_t dataLen);
-static void AoAReceiver_addDeviceInfo(uint8_t *pAddr, uint8_t addrType);
+static bool AoAReceiver_addDeviceInfo(uint8_t *pAddr, uint8_t addrType,
+                                      int8_t rssi, uint8_t flags);
+static void AoAReceiver_newAoaDevice(uint8_t *pAddr, uint8_t addrType, int8_t rssi);
+static void AoAReceiver_restartDiscovery(void);
+static bStatus_t AoAReceiver_stopDiscovery(void);
 static void AoAReceiver_processPairState(uint8_t state, uint8_t status);
 static void AoAReceiver_processPasscode(uint16_t connectionHandle, uint8_t uiOutputs);
 
@@ -472,23 +950,73 @@ static void AoAReceiver_keyChangeHandler(uint8 keys);
 static uint8_t AoAReceiver_enqueueMsg(uint16_t event, uint8_t status, uint8_t *pData);
 
 static void AoAReceiver_connEvtCB(Gap_ConnEventRpt_t *pReport);
+static void AoAReceiver_connEvtPost(const Gap_ConnEventRpt_t *pReport);
 static void AoAReceiver_processConnEvt(Gap_ConnEventRpt_t *pReport);
+static void AoAReceiver_processConnEvtSlots(void);
 static void AoAReceiver_processCmdCompleteEvt(hciEvt_CmdComplete_t *pMsg);
 
 static void AoAReceiver_aoaStart(void);
+static void AoAReceiver_aoaRetry(void);
+static void AoAReceiver_aoaSchedule(void);
+static void AoAReceiver_connCtrlPoll(uint16_t handle);
+static void AoAReceiver_replyParamUpdate(gapUpdateLinkParamReq_t *pReq);
+static uint16_t AoAReceiver_connTimeout(uint16_t interval, uint16_t latency);
+static void AoAReceiver_aoaDutyHandler(UArg a0);
+#if defined( AOA_HUB_LINK )
+static void AoAReceiver_backhaulHandler(UArg a0);
+static void AoAReceiver_backhaulPut(uint8_t *pAddr, AoA_Sample *pSample);
+#endif // AOA_HUB_LINK
+static bool AoAReceiver_filterMatch(const uint8_t *pAddr);
+static bStatus_t AoAReceiver_filterAdd(const uint8_t *pAddr);
+static void AoAReceiver_filterClear(void);
 static void AoAReceiver_aoaEnableSender(bool enable);
+static bStatus_t AoAReceiver_senderControl(uint8_t op, bool confirm);
+static void AoAReceiver_senderUpdate(void);
 static void AoAReceiver_processAoAEvt(aoaReport_t *aoaReport, uint8_t aoaReportState);
 static void AoAReceiver_AoACompleteCallback(uint8_t event);
+static void AoAReceiver_freeReport(aoaReport_t *aoaReport);
 
 static bStatus_t AoAReceiver_RegistertToAllConnectionEvent (connectionEventRegisterCause_u connectionEventRegisterCause);
 static bStatus_t AoAReceiver_UnRegistertToAllConnectionEvent (connectionEventRegisterCause_u connectionEventRegisterCause);
-static void AoAReceiver_calculateRSSI(int lastRssi);
 
 #if !defined(AOA_STREAM)
+static void AoAReceiver_calculateRSSI(int lastRssi);
 static void AoAReceiver_displayEstimatedAngle(uint8_t *aoaAdvAddr, AoA_Sample AoA);
+static void AoAReceiver_sendAngle(const aoaAngleRpt_t *pAngle);
+static bool AoAReceiver_fuseAngle(aoaAngleRpt_t *pAngle);
+static uint8_t AoAReceiver_fusionCycle(void);
+static void AoAReceiver_sendIq(const aoaReport_t *aoaReport);
 static AoA_Sample AoAReceiver_estimateAngle(const AoA_AntennaResult *AoAReceiver_antA1Result, const AoA_AntennaResult *AoAReceiver_antA2Result);
+static int16_t AoAReceiver_wrapAngle(int32_t angle);
+static void AoAReceiver_workerFxn(UArg a0, UArg a1);
+static bool AoAReceiver_workerPost(aoaReport_t *aoaReport);
+static aoaReport_t *AoAReceiver_workerGet(void);
+static void AoAReceiver_estimateReport(aoaReport_t *aoaReport);
+static bStatus_t AoAReceiver_setSlotMap(uint8_t skip, uint8_t keep);
+static bool AoAReceiver_slotMapFits(uint8_t numPatterns, uint8_t skip, uint8_t keep);
 #endif // !AOA_STREAM
-
+static bool AoAReceiver_antConfigBusy(void);
+#if defined( AOA_INJECT )
+static bStatus_t AoAReceiver_injectAdv(const AoACmd_Frame *pFrame);
+static bStatus_t AoAReceiver_injectConnEvt(const AoACmd_Frame *pFrame);
+#if !defined( AOA_STREAM )
+static bStatus_t AoAReceiver_injectIq(const AoACmd_Frame *pFrame);
+#endif // !AOA_STREAM
+#endif // AOA_INJECT
+#if defined( AOA_BENCH )
+static bStatus_t AoAReceiver_bench(const AoACmd_Frame *pFrame, uint8_t *pRsp,
+                                   uint8_t *pRspLen);
+static bool AoAReceiver_benchCapture(aoaBench_t *pBench, uint8_t array);
+static void AoAReceiver_benchPairAngles(void *pArg);
+#if !defined( AOA_STREAM )
+static void AoAReceiver_benchEstimate(void *pArg);
+#endif // !AOA_STREAM
+static void AoAReceiver_benchFindSvc(void *pArg);
+static void AoAReceiver_benchAddDevice(void *pArg);
+static void AoAReceiver_benchQueue(void *pArg);
+static void AoAReceiver_benchUtilQueue(void *pArg);
+static void AoAReceiver_benchIqCopy(void *pArg);
+#endif // AOA_BENCH
 
 /*********************************************************************
  * EXTERN FUNCTIONS
@@ -591,6 +1119,25 @@ void AoAReceiver_createTask(void)
   taskParams.priority = AOA_TASK_PRIORITY;
 
   Task_construct(&sbcTask, AoAReceiver_taskFxn, &taskParams, NULL);
+
+#if !defined( AOA_STREAM )
+  {
+    Semaphore_Params semParams;
+
+    // The worker pends on this until a report is queued
+    Semaphore_Params_init(&semParams);
+    semParams.mode = Semaphore_Mode_COUNTING;
+    Semaphore_construct(&aoaWorkerSem, 0, &semParams);
+  }
+
+  // Configure the estimation worker task
+  Task_Params_init(&taskParams);
+  taskParams.stack = aoaWorkerTaskStack;
+  taskParams.stackSize = AOA_WORKER_TASK_STACK_SIZE;
+  taskParams.priority = AOA_WORKER_TASK_PRIORITY;
+
+  Task_construct(&aoaWorkerTask, AoAReceiver_workerFxn, &taskParams, NULL);
+#endif // !AOA_STREAM
 }
 
 /*********************************************************************
@@ -615,16 +1162,57 @@ static void AoAReceiver_init(void)
   // so that the application can send and receive messages.
   ICall_registerApp(&selfEntity, &syncEvent);
 
+  // Set up the message pool before any callback can allocate from it
+  MsgPool_init(aoaPoolCfg, sizeof(aoaPoolCfg) / sizeof(aoaPoolCfg[0]));
+
+  DevTable_clear();
+
   // Create an RTOS queue for message from profile to be sent to app.
   appMsgQueue = Util_constructQueue(&appMsg);
 
+#if defined( AOA_BENCH )
+  // Code section timing
+  benchMsgQueue = Util_constructQueue(&benchMsg);
+  AoABench_init();
+#endif // AOA_BENCH
+
+#if !defined( AOA_STREAM )
+  // One fused angle per pass over the channel list
+  AoAFusion_init(AoAReceiver_fusionCycle());
+#endif // !AOA_STREAM
+
   // Setup discovery delay as a one-shot timer
   Util_constructClock(&startDiscClock, AoAReceiver_startDiscHandler,
                       DEFAULT_SVC_DISCOVERY_DELAY, 0, false, 0);
 
+  // Idle AoA scanning schedule, the clock is started per round
+  {
+    AoADuty_Cfg dutyCfg;
+
+    dutyCfg.maxRate = DEFAULT_AOA_DUTY_MAX_RATE;
+    dutyCfg.minRate = DEFAULT_AOA_DUTY_MIN_RATE;
+    dutyCfg.ratePerTag = DEFAULT_AOA_DUTY_RATE_PER_TAG;
+    dutyCfg.tagWindow = DEFAULT_AOA_DUTY_TAG_WINDOW;
+
+    AoADuty_init(1000 / Clock_tickPeriod);
+    AoADuty_setCfg(&dutyCfg);
+  }
+  Util_constructClock(&aoaDutyClock, AoAReceiver_aoaDutyHandler, 0, 0, false, 0);
+#if defined( AOA_HUB_LINK )
+  Util_constructClock(&aoaBackhaulClock, AoAReceiver_backhaulHandler, 0, 0, false, 0);
+#endif // AOA_HUB_LINK
+
   Board_initKeys(AoAReceiver_keyChangeHandler);
 
+  // The command link owns Board_UART0. A UART Display would open the
+  // same UART, so its text goes out through the command link instead.
+  AoACmd_init(syncEvent, AOA_CMD_EVT);
+
+#if (AOA_DISPLAY_TYPE == Display_Type_UART)
+  dispHandle = AoACmd_openDisplay();
+#else
   dispHandle = Display_open(AOA_DISPLAY_TYPE, NULL);
+#endif // AOA_DISPLAY_TYPE == Display_Type_UART
 
   // Setup the Central GAPRole Profile. For more information see the GAP section
   // in the User's Guide:
@@ -632,9 +1220,31 @@ static void AoAReceiver_init(void)
   {
     uint8_t scanRes = DEFAULT_MAX_SCAN_RES;
 
+    uint8_t paramUpdateReply = DEFAULT_ENABLE_UPDATE_REQUEST;
+
     GAPCentralRole_SetParameter(GAPCENTRALROLE_MAX_SCAN_RES, sizeof(uint8_t),
                                 &scanRes);
+    GAPCentralRole_SetParameter(GAPCENTRALROLE_LINK_PARAM_UPDATE_REQ_REPLY,
+                                sizeof(uint8_t), &paramUpdateReply);
+  }
+
+#if defined( AOA_HUB_LINK )
+  // Advertise the results service to the hub, as a peripheral next to
+  // the central role
+  {
+    uint8_t advEnabled = TRUE;
+
+    GAPCentralRole_SetParameter(GAPCENTRALROLE_ADVERT_DATA, sizeof(hubAdvData),
+                                hubAdvData);
+    GAPCentralRole_SetParameter(GAPCENTRALROLE_SCAN_RSP_DATA,
+                                sizeof(hubScanRspData), hubScanRspData);
+    GAPCentralRole_SetParameter(GAPCENTRALROLE_ADVERT_ENABLED, sizeof(uint8_t),
+                                &advEnabled);
+
+    GAP_SetParamValue(TGAP_GEN_DISC_ADV_INT_MIN, DEFAULT_HUB_ADV_INTERVAL);
+    GAP_SetParamValue(TGAP_GEN_DISC_ADV_INT_MAX, DEFAULT_HUB_ADV_INTERVAL);
   }
+#endif // AOA_HUB_LINK
 
   // Set GAP Parameters to set the discovery duration
   // For more information, see the GAP section of the User's Guide:
@@ -673,6 +1283,9 @@ static void AoAReceiver_init(void)
   // Initialize GATT attributes
   GGS_AddService(GATT_ALL_SERVICES);         // GAP
   GATTServApp_AddService(GATT_ALL_SERVICES); // GATT attributes
+#if defined( AOA_HUB_LINK )
+  AoABackhaul_addService();                  // Angle results
+#endif // AOA_HUB_LINK
 
   // Start the Device
   VOID GAPCentralRole_StartDevice(&AoAReceiver_roleCB);
@@ -692,7 +1305,13 @@ static void AoAReceiver_init(void)
     //This API is documented in hci.h
     //See the LE Data Length Extension section in the BLE-Stack User's Guide for information on using this command:
     //http://software-dl.ti.com/lprf/sdg-latest/html/cc2640/index.html
+#if defined( AOA_HUB_LINK )
+    //Long PDUs let one backhaul notification carry a whole batch of angles.
+    //Sender links carry short PDUs only and keep the default.
+    HCI_LE_WriteSuggestedDefaultDataLenCmd(APP_SUGGESTED_PDU_SIZE, APP_SUGGESTED_TX_TIME);
+#else
     //HCI_LE_WriteSuggestedDefaultDataLenCmd(APP_SUGGESTED_PDU_SIZE, APP_SUGGESTED_TX_TIME);
+#endif // AOA_HUB_LINK
   }
 
   Display_print0(dispHandle, 0, 0, "AoA Receiver");
@@ -700,13 +1319,31 @@ static void AoAReceiver_init(void)
   aoaHandle = AOA_init( AOA_ROLE_RECEIVER,
                         AOD_PACKET_ID,
                         AOA_PACKET_ID,
-                        (1 << IOID_27 | 1 << IOID_28 | 1 << IOID_29 | 1 << IOID_30),
+                        AOA_ANTENNA_PINS,
                         Board_GPTIMER0A,
                         &AoAReceiver_AoACompleteCallback);
   
-  // Initialize antenna toggling patterns
-  BOOSTXL_AoA_AntennaPattern_A1_init();
-  BOOSTXL_AoA_AntennaPattern_A2_init();
+  // Load the antenna configurations, stored ones override the built-in
+  // patterns. Toggle patterns are made from them when they are loaded.
+  {
+    AoA_AntennaConfig *const builtin[ANT_CONFIG_NUM_ARRAYS] =
+    {
+      &BOOSTXL_AoA_Config_ArrayA1,
+      &BOOSTXL_AoA_Config_ArrayA2
+    };
+
+    AntConfig_init(AOA_ANTENNA_PINS, builtin);
+  }
+
+  // Handles of bonded senders seen on earlier links
+  AoAGattCache_init();
+
+  AoAReceiver_antA1Config = AntConfig_get(ANT_CONFIG_ARRAY_A1);
+  AoAReceiver_antA2Config = AntConfig_get(ANT_CONFIG_ARRAY_A2);
+  AoAReceiver_antA1Result = AntConfig_getResult(ANT_CONFIG_ARRAY_A1);
+  AoAReceiver_antA2Result = AntConfig_getResult(ANT_CONFIG_ARRAY_A2);
+  aoaArmedConfig = AoAReceiver_antA1Config;
+  aoaArmedResult = AoAReceiver_antA1Result;
   
   // Configure the AoA scan timing
   aoaHandle->scanInterval = GAP_GetParamValue(TGAP_GEN_DISC_SCAN_INT);
@@ -714,6 +1351,34 @@ static void AoAReceiver_init(void)
 
   aoaReceiverRssi.alpha = AOA_ALPHA_FILTER_VALUE;
   aoaReceiverRssi.currentRssi = AOA_ALPHA_FILTER_INITIAL_RSSI;
+
+  // Auto AoA policy, the same for every peer until changed
+  {
+    AoATrigger_Cfg trigCfg;
+
+    trigCfg.threshold = AOA_RSSI_THRESHOLD;
+    trigCfg.hysteresis = AOA_RSSI_THRESHOLD_HYSTERESIS;
+    trigCfg.alpha = AOA_ALPHA_FILTER_VALUE;
+    trigCfg.minOnTime = DEFAULT_AOA_TRIGGER_MIN_ON_TIME;
+    trigCfg.minOffTime = DEFAULT_AOA_TRIGGER_MIN_OFF_TIME;
+    trigCfg.minRequestGap = DEFAULT_AOA_TRIGGER_REQUEST_GAP;
+
+    AoATrigger_init(&trigCfg, 1000 / Clock_tickPeriod);
+  }
+
+  // Connection interval policy, the same for every peer until changed
+  {
+    AoAConnCtrl_Cfg ctrlCfg;
+
+    ctrlCfg.activeRate = DEFAULT_CONN_CTRL_ACTIVE_RATE;
+    ctrlCfg.stillRate = DEFAULT_CONN_CTRL_STILL_RATE;
+    ctrlCfg.idleInterval = DEFAULT_CONN_CTRL_IDLE_INTERVAL;
+    ctrlCfg.motionAngle = DEFAULT_CONN_CTRL_MOTION_ANGLE;
+    ctrlCfg.motionHold = DEFAULT_CONN_CTRL_MOTION_HOLD;
+    ctrlCfg.minUpdateGap = DEFAULT_CONN_CTRL_UPDATE_GAP;
+
+    AoAConnCtrl_init(&ctrlCfg, 1000 / Clock_tickPeriod);
+  }
 }
 
 /*********************************************************************
@@ -769,15 +1434,13 @@ static void AoAReceiver_taskFxn(UArg a0, UArg a1)
       {
         while (!Queue_empty(appMsgQueue))
         {
-          sbcEvt_t *pMsg = (sbcEvt_t *)Util_dequeueMsg(appMsgQueue);
-          if (pMsg)
-          {
-            // Process message
-            AoAReceiver_processAppMsg(pMsg);
+          sbcEvt_t *pMsg = (sbcEvt_t *)Queue_get(appMsgQueue);
 
-            // Free the space from the message
-            ICall_free(pMsg);
-          }
+          // Process message
+          AoAReceiver_processAppMsg(pMsg);
+
+          // Return the envelope to the pool
+          MsgPool_free(pMsg);
         }
       }
 
@@ -785,6 +1448,45 @@ static void AoAReceiver_taskFxn(UArg a0, UArg a1)
       {
         AoAReceiver_startDiscovery();
       }
+
+      if (events & AOA_CONN_EVT_SLOT_EVT)
+      {
+        AoAReceiver_processConnEvtSlots();
+      }
+
+      if (events & AOA_CMD_EVT)
+      {
+        AoAReceiver_processCmd();
+      }
+
+#if !defined( AOA_STREAM )
+      // The worker is done with a capture, keep idle AoA scanning going.
+      // A pipelined scan was already re-armed when the report arrived.
+      if (events & AOA_ESTIMATE_DONE_EVT)
+      {
+        if (!aoaPipelined && state == BLE_STATE_IDLE_AOA_SCANNING && aoaIdleScanStarted)
+        {
+          AoAReceiver_aoaSchedule();
+        }
+      }
+#endif // !AOA_STREAM
+
+      // The stand-by between two duty-cycled rounds is over
+      if (events & AOA_DUTY_EVT)
+      {
+        if (state == BLE_STATE_IDLE_AOA_SCANNING && aoaIdleScanStarted)
+        {
+          AoAReceiver_aoaSchedule();
+        }
+      }
+
+#if defined( AOA_HUB_LINK )
+      // The oldest batched angle has waited long enough
+      if (events & AOA_BACKHAUL_EVT)
+      {
+        AoABackhaul_flush();
+      }
+#endif // AOA_HUB_LINK
     }
   }
 }
@@ -863,30 +1565,84 @@ static void AoAReceiver_processAppMsg(sbcEvt_t *pMsg)
     case AOA_PAIRING_STATE_EVT:
       {
         AoAReceiver_processPairState(pMsg->hdr.state, *pMsg->pData);
-        ICall_free(pMsg->pData);
+        MsgPool_free(pMsg->pData);
       }
       break;
 
     case AOA_PASSCODE_NEEDED_EVT:
       {
         AoAReceiver_processPasscode(connHandle, *pMsg->pData);
-        ICall_free(pMsg->pData);
+        MsgPool_free(pMsg->pData);
       }
       break;
 
     case AOA_CONN_EVT:
       {
         AoAReceiver_processConnEvt((Gap_ConnEventRpt_t *)(pMsg->pData));
-        ICall_free(pMsg->pData);
+        MsgPool_free(pMsg->pData);
       }
       break;
 
     case AOA_REPORT_EVT:
       {
+        uint32_t now = Clock_getTicks();
+
+        AoADuty_radioOff(now);
+
+        if (pMsg->hdr.state == SUCCESS)
+        {
+          aoaReportCnt++;
+          AoADuty_tagSeen(((aoaReport_t *)pMsg->pData)->advAddr, now);
+        }
+        else if (pMsg->hdr.state != AOA_REPORT_FILTERED)
+        {
+          aoaReportFailCnt++;
+        }
+
         // The data for this event will be freed in this function
         AoAReceiver_processAoAEvt((aoaReport_t *)(pMsg->pData), pMsg->hdr.state);
       }
       break;
+
+#if !defined( AOA_STREAM )
+    case AOA_ANGLE_EVT:
+      {
+        aoaAngleRpt_t *pAngle = (aoaAngleRpt_t *)pMsg->pData;
+
+        aoaAngleCnt++;
+
+        // Connected, the angle tells the interval controller whether
+        // the tag moves. The angle of this pair alone, the moving
+        // average would delay and damp the motion.
+        if (state == BLE_STATE_CONNECTED_AOA_SCANNING)
+        {
+          AoAConnCtrl_angle(connHandle, pAngle->sample.currentangle, Clock_getTicks());
+
+          if (linkFirstAngleMs == 0)
+          {
+            linkFirstAngleMs = AoAReceiver_elapsedMs(linkUpTime);
+          }
+        }
+
+        // Print AoA results via UART, and notify them to a hub. Fused,
+        // only the last angle of each channel cycle is output; the
+        // interval controller above still takes each pair, but only
+        // while connected AoA scanning.
+        if (!aoaFusion || AoAReceiver_fuseAngle(pAngle))
+        {
+          AoAReceiver_displayEstimatedAngle(pAngle->advAddr, pAngle->sample);
+#if defined( AOA_HUB_LINK )
+          AoAReceiver_backhaulPut(pAngle->advAddr, &pAngle->sample);
+#endif // AOA_HUB_LINK
+          if (aoaAngleInd)
+          {
+            AoAReceiver_sendAngle(pAngle);
+          }
+        }
+        MsgPool_free(pAngle);
+      }
+      break;
+#endif // !AOA_STREAM
     
     default:
       break;
@@ -923,15 +1679,22 @@ static void AoAReceiver_processRoleEvent(gapCentralRoleEvent_t *pEvent)
 
     case GAP_DEVICE_INFO_EVENT:
       {
-        // If filtering device discovery results based on service UUID
-        if (DEFAULT_DEV_DISC_BY_SVC_UUID == TRUE)
+        bool aoaSvc = AoAReceiver_findSvcUuid(AOAPROFILE_SERVICE_UUID,
+                                              pEvent->deviceInfo.pEvtData,
+                                              pEvent->deviceInfo.dataLen);
+
+        // If filtering device discovery results based on service UUID,
+        // only AoA senders are kept
+        if (aoaSvc || DEFAULT_DEV_DISC_BY_SVC_UUID == FALSE)
         {
-          if (AoAReceiver_findSvcUuid(AOAPROFILE_SERVICE_UUID,
-                                      pEvent->deviceInfo.pEvtData,
-                                      pEvent->deviceInfo.dataLen))
+          if (AoAReceiver_addDeviceInfo(pEvent->deviceInfo.addr,
+                                        pEvent->deviceInfo.addrType,
+                                        pEvent->deviceInfo.rssi,
+                                        aoaSvc ? DEV_TABLE_FLAG_AOA : 0))
           {
-            AoAReceiver_addDeviceInfo(pEvent->deviceInfo.addr,
-                                      pEvent->deviceInfo.addrType);
+            AoAReceiver_newAoaDevice(pEvent->deviceInfo.addr,
+                                     pEvent->deviceInfo.addrType,
+                                     pEvent->deviceInfo.rssi);
           }
         }
       }
@@ -942,17 +1705,27 @@ static void AoAReceiver_processRoleEvent(gapCentralRoleEvent_t *pEvent)
         // discovery complete
         scanningStarted = FALSE;
 
-        // if not filtering device discovery results based on service UUID
-        if (DEFAULT_DEV_DISC_BY_SVC_UUID == FALSE)
+        // Auto-connect cancelled the round to make this connection
+        if (discConnectPending)
+        {
+          discConnectPending = FALSE;
+
+          if (AoAReceiver_connect(discConnectAddr, discConnectAddrType) == SUCCESS)
+          {
+            discAutoAoa = TRUE;
+            break;
+          }
+        }
+
+        if (contDiscovery && state == BLE_STATE_IDLE)
         {
-          // Copy results
-          scanRes = pEvent->discCmpl.numDevs;
-          memcpy(devList, pEvent->discCmpl.pDevList, (sizeof(gapDevRec_t) * scanRes));
+          AoAReceiver_restartDiscovery();
+          break;
         }
 
-        Display_print1(dispHandle, 2, 0, "Devices Found %d", scanRes);
+        Display_print1(dispHandle, 2, 0, "Devices Found %d", DevTable_count());
 
-        if (scanRes > 0)
+        if (DevTable_count() > 0)
         {
           Display_print0(dispHandle, 3, 0, "<- To Select");
         }
@@ -967,6 +1740,20 @@ static void AoAReceiver_processRoleEvent(gapCentralRoleEvent_t *pEvent)
 
     case GAP_LINK_ESTABLISHED_EVENT:
       {
+#if defined( AOA_HUB_LINK )
+        // The hub connected to the advertising. It only subscribes to
+        // the results service, the tag link is left alone.
+        if (pEvent->gap.hdr.status == SUCCESS &&
+            pEvent->linkCmpl.connRole == GAP_PROFILE_PERIPHERAL)
+        {
+          hubConnHandle = pEvent->linkCmpl.connectionHandle;
+
+          Display_print1(dispHandle, 7, 0, "Hub: %s",
+                         Util_convertBdAddr2Str(pEvent->linkCmpl.devAddr));
+          break;
+        }
+#endif // AOA_HUB_LINK
+
         if (pEvent->gap.hdr.status == SUCCESS)
         {
           hciActiveConnInfo_t *pConnInfo;
@@ -976,10 +1763,39 @@ static void AoAReceiver_processRoleEvent(gapCentralRoleEvent_t *pEvent)
           connHandle = pEvent->linkCmpl.connectionHandle;
           GATTProcedureInProgress = TRUE;
 
-          // If service discovery not performed initiate service discovery
+          AoATrigger_open(connHandle, Clock_getTicks());
+          AoAConnCtrl_open(connHandle, pEvent->linkCmpl.connInterval, Clock_getTicks());
+
+          memcpy(peerAddr, pEvent->linkCmpl.devAddr, B_ADDR_LEN);
+          peerAddrType = pEvent->linkCmpl.devAddrType;
+
+          linkUpTime = Clock_getTicks();
+          linkDiscMs = linkFirstAngleMs = 0;
+
+          // If service discovery not performed initiate service discovery,
+          // unless a bonded sender's handles are known from an earlier link
           if (charHdl == 0)
           {
-            Util_startClock(&startDiscClock);
+            AoAGattCache_Handles handles;
+
+            if (AoAGattCache_find(peerAddr, peerAddrType, &handles))
+            {
+              svcStartHdl = handles.svcStartHdl;
+              svcEndHdl = handles.svcEndHdl;
+              charHdl = handles.charHdl;
+              ctrlHdl = handles.ctrlHdl;
+              gattCacheHit = TRUE;
+
+              AoAReceiver_discComplete();
+            }
+            else if (fastDiscovery)
+            {
+              AoAReceiver_startDiscovery();
+            }
+            else
+            {
+              Util_startClock(&startDiscClock);
+            }
           }
 
           Display_print0(dispHandle, 2, 0, "Connected");
@@ -990,8 +1806,8 @@ static void AoAReceiver_processRoleEvent(gapCentralRoleEvent_t *pEvent)
 
           if (pConnInfo != NULL)
           {
-            // Get the connection info of a single connection
-            HCI_EXT_GetActiveConnInfoCmd(0, pConnInfo);
+            // Get the connection info of the tag link
+            HCI_EXT_GetActiveConnInfoCmd(connHandle, pConnInfo);
             Display_print1(dispHandle, 10, 0, "AccessAddress: 0x%x", pConnInfo->accessAddr);
             Display_print1(dispHandle, 11, 0, "Connection Interval: %d", pConnInfo->connInterval);
             Display_print3(dispHandle, 12, 0, "HopVal: %d, nxtCh: %d, mSCA: %d",
@@ -1017,25 +1833,53 @@ static void AoAReceiver_processRoleEvent(gapCentralRoleEvent_t *pEvent)
           state = BLE_STATE_IDLE;
           connHandle = GAP_CONNHANDLE_INIT;
           discState = BLE_DISC_STATE_IDLE;
+          discAutoAoa = FALSE;
 
           Display_print0(dispHandle, 2, 0, "Connect Failed");
           Display_print1(dispHandle, 3, 0, "Reason: %d", pEvent->gap.hdr.status);
+
+          if (contDiscovery)
+          {
+            AoAReceiver_restartDiscovery();
+          }
         }
       }
       break;
 
     case GAP_LINK_TERMINATED_EVENT:
       {
+#if defined( AOA_HUB_LINK )
+        // The central role advertises again for the next hub
+        if (pEvent->linkTerminate.connectionHandle == hubConnHandle)
+        {
+          hubConnHandle = GAP_CONNHANDLE_INIT;
+
+          Display_print1(dispHandle, 7, 0, "Hub lost: %d", pEvent->linkTerminate.reason);
+          break;
+        }
+#endif // AOA_HUB_LINK
+
         state = BLE_STATE_IDLE;
         connHandle = GAP_CONNHANDLE_INIT;
         discState = BLE_DISC_STATE_IDLE;
-        charHdl = 0;
+        charHdl = ctrlHdl = 0;
+        gattCacheHit = FALSE;
         GATTProcedureInProgress = FALSE;
         keyPressConnOpt = DISCONNECT;
         scanIdx = -1;
+        discAutoAoa = FALSE;
 
-        // Un-subscribe the event
+        // Un-subscribe the event. The requests go with it, or the next
+        // link would start the sender with no capture armed.
         AoAReceiver_UnRegistertToAllConnectionEvent(FOR_AOA_SCAN);
+        aoaConnectedScanRequest = FALSE;
+        autoAoaEnabled = FALSE;
+
+        // Drop any report of the closed link still waiting in its slot
+        if (pEvent->linkTerminate.connectionHandle < AOA_CONN_EVT_SLOTS)
+        {
+          connEvtSlots[pEvent->linkTerminate.connectionHandle].pending = FALSE;
+        }
 
         // We are disconnected, mark that sender is not active anymore
         // (As far as the receiver is concerned)
@@ -1051,15 +1895,44 @@ static void AoAReceiver_processRoleEvent(gapCentralRoleEvent_t *pEvent)
 
         // Prompt user to begin scanning.
         Display_print0(dispHandle, 5, 0, "Discover ->");
+
+        if (contDiscovery)
+        {
+          AoAReceiver_restartDiscovery();
+        }
       }
       break;
 
     case GAP_LINK_PARAM_UPDATE_EVENT:
       {
+#if defined( AOA_HUB_LINK )
+        // The hub runs its own link
+        if (pEvent->linkUpdate.connectionHandle == hubConnHandle)
+        {
+          break;
+        }
+#endif // AOA_HUB_LINK
+
+        AoAConnCtrl_updated(pEvent->linkUpdate.connectionHandle,
+                            pEvent->linkUpdate.status,
+                            pEvent->linkUpdate.connInterval);
+
+        // A sender following the connection interval needs the new one
+        if (pEvent->linkUpdate.status == SUCCESS && senderPeriod == 0)
+        {
+          AoAReceiver_senderUpdate();
+        }
+
         Display_print1(dispHandle, 2, 0, "Param Update: %d", pEvent->linkUpdate.status);
       }
       break;
 
+    case GAP_UPDATE_LINK_PARAM_REQ_EVENT:
+      {
+        AoAReceiver_replyParamUpdate(&pEvent->linkUpdateReply.req);
+      }
+      break;
+
     default:
       break;
   }
@@ -1107,11 +1980,15 @@ static void AoAReceiver_handleKeys(uint8_t shift, uint8_t keys)
       // If not currently scanning
       if (!scanningStarted)
       {
+        DevTable_Entry *pDev;
+
         // Increment index of current result.
         scanIdx++;
+        pDev = DevTable_get(scanIdx);
 
-        // If there are no scanned devices
-        if (scanIdx >= scanRes)
+        // If there are no more scanned devices. Aging can compact the
+        // table between key presses, so this is checked on every press.
+        if (pDev == NULL)
         {
           // Prompt the user to begin scanning again.
           scanIdx = -1;
@@ -1133,7 +2010,8 @@ static void AoAReceiver_handleKeys(uint8_t shift, uint8_t keys)
         {
           // Display the indexed scanned device.
           Display_print1(dispHandle, 2, 0, "Device %d", (scanIdx + 1));
-          Display_print0(dispHandle, 3, 0, Util_convertBdAddr2Str(devList[scanIdx].addr));
+          Display_print0(dispHandle, 3, 0, Util_convertBdAddr2Str(pDev->addr));
+          Display_print1(dispHandle, 4, 0, "RSSI %d", pDev->rssi);
           Display_print0(dispHandle, 5, 0, "Connect ->");
           Display_print0(dispHandle, 6, 0, "<- Next Option");
         }
@@ -1186,52 +2064,33 @@ static void AoAReceiver_handleKeys(uint8_t shift, uint8_t keys)
       {
         if (aoaIdleScanStarted)
         {
-          state = BLE_STATE_IDLE_AOA_SCANNING;
-
-          Display_print0(dispHandle, 2, 0, "AoA Scan Started");
-          Display_print0(dispHandle, 3, 0, "");
-          Display_print0(dispHandle, 4, 0, "");
-          Display_print0(dispHandle, 5, 0, "Toggle AoA Scan ->");
-          Display_print0(dispHandle, 6, 0, "");
-          
-          AoAReceiver_aoaStart();
+          AoAReceiver_idleAoaStart();
         }
         else if (!scanningStarted)
         {
-          scanningStarted = TRUE;
-          scanRes = 0;
-
-          Display_print0(dispHandle, 2, 0, "Discovering...");
-          Display_print0(dispHandle, 3, 0, "");
-          Display_print0(dispHandle, 4, 0, "");
-          Display_print0(dispHandle, 5, 0, "");
-          Display_print0(dispHandle, 6, 0, "");
-
-          GAPCentralRole_StartDiscovery(DEFAULT_DISCOVERY_MODE,
-                                        DEFAULT_DISCOVERY_ACTIVE_SCAN,
-                                        DEFAULT_DISCOVERY_WHITE_LIST);
+          AoAReceiver_discoverDevices();
         }
       }
       // Connect if there is a scan result
       else
       {
-        // connect to current device in scan result
-        uint8_t *peerAddr = devList[scanIdx].addr;
-        uint8_t addrType = devList[scanIdx].addrType;
-
-        state = BLE_STATE_CONNECTING;
-
-        GAPCentralRole_EstablishLink(DEFAULT_LINK_HIGH_DUTY_CYCLE,
-                                     DEFAULT_LINK_WHITE_LIST,
-                                     addrType, peerAddr);
-
-        Display_print0(dispHandle, 2, 0, "Connecting");
-        Display_print0(dispHandle, 3, 0, Util_convertBdAddr2Str(peerAddr));
-        Display_clearLine(dispHandle, 4);
+        DevTable_Entry *pDev = DevTable_get(scanIdx);
 
-        // Forget the scan results.
-        scanRes = 0;
-        scanIdx = -1;
+        // connect to current device in scan result
+        if (pDev != NULL)
+        {
+          AoAReceiver_connect(pDev->addr, pDev->addrType);
+        }
+        // Aged out of the table since it was shown, start over
+        else
+        {
+          scanIdx = -1;
+          aoaIdleScanStarted = FALSE;
+          Display_print0(dispHandle, 2, 0, "");
+          Display_print0(dispHandle, 3, 0, "");
+          Display_print0(dispHandle, 5, 0, "Discover ->");
+          Display_print0(dispHandle, 6, 0, "<- Next Option");
+        }
       }
     }
     else if (state == BLE_STATE_CONNECTED || state == BLE_STATE_CONNECTED_AOA_SCANNING)
@@ -1239,111 +2098,15 @@ static void AoAReceiver_handleKeys(uint8_t shift, uint8_t keys)
       switch (keyPressConnOpt)
       {
         case AOA_SCAN:
-          {
-            if (!aoaConnectedScanRequest)
-            {
-              state = BLE_STATE_CONNECTED_AOA_SCANNING;
-              aoaConnectedScanRequest = TRUE;
-
-              // Subscribe the callback
-              // Start connected AoA Scan in this callback event
-              AoAReceiver_RegistertToAllConnectionEvent(FOR_AOA_SCAN);
-
-              // If AOA sender is not active, request AOA
-              if (!aoaSenderActive)
-              {
-                AoAReceiver_aoaEnableSender(TRUE);
-              }
-              
-              Display_print0(dispHandle, 2, 0, "AoA Scan Started");
-              Display_print0(dispHandle, 3, 0, "");
-              Display_print0(dispHandle, 4, 0, "");
-              Display_print0(dispHandle, 5, 0, "Toggle AoA Scan ->");
-            }
-            else
-            {
-              state = BLE_STATE_CONNECTED;
-              aoaConnectedScanRequest = FALSE;
-
-              // Un-subscribe the callback event
-              AoAReceiver_UnRegistertToAllConnectionEvent(FOR_AOA_SCAN);
-              
-              // If AOA sender is active, request AOA termination
-              if (aoaSenderActive)
-              {
-                AoAReceiver_aoaEnableSender(FALSE);
-              }
-
-              Display_print0(dispHandle, 2, 0, "AoA Scan Cancelled");
-              Display_print0(dispHandle, 3, 0, "");
-              Display_print0(dispHandle, 4, 0, "");
-              Display_print0(dispHandle, 5, 0, "Toggle AoA Scan ->");
-
-              AoAReceiver_antA1Result->updated = false;
-              AoAReceiver_antA2Result->updated = false;
-
-              // Reset channl index
-              channelIdx = 0;
-            }
-          }
+          AoAReceiver_connAoaScan(!aoaConnectedScanRequest);
           break;
 
         case AUTO_AOA:
-          {
-            if (!autoAoaEnabled)
-            {
-              state = BLE_STATE_CONNECTED_AOA_SCANNING;
-              autoAoaEnabled = TRUE;
-              aoaConnectedScanRequest = TRUE;
-              
-              // Subscribe the callback event
-              AoAReceiver_RegistertToAllConnectionEvent(FOR_AOA_SCAN);
-
-              Display_print0(dispHandle, 1, 0, "");
-              Display_print0(dispHandle, 2, 0, "");
-              Display_print0(dispHandle, 3, 0, "");
-              Display_print0(dispHandle, 4, 0, "Auto AoA Enabled");
-              Display_print0(dispHandle, 5, 0, "Toggle Auto AoA ->");
-            }
-            else
-            {
-              state = BLE_STATE_CONNECTED;
-              autoAoaEnabled = FALSE;
-              aoaConnectedScanRequest = FALSE;
-              
-              // Un-subscribe the callback event
-              AoAReceiver_UnRegistertToAllConnectionEvent(FOR_AOA_SCAN);
-
-              Display_print0(dispHandle, 1, 0, "");
-              Display_print0(dispHandle, 2, 0, "");
-              Display_print0(dispHandle, 3, 0, "");
-              Display_print0(dispHandle, 4, 0, "Auto AoA Disabled");
-              Display_print0(dispHandle, 5, 0, "Toggle Auto AoA ->");
-            }
-          }
+          AoAReceiver_autoAoa(!autoAoaEnabled);
           break;
 
         case DISCONNECT:
-          {
-            state = BLE_STATE_IDLE;
-
-            // Un-subscribe AOA connection events (we are disconnecting)
-            AoAReceiver_UnRegistertToAllConnectionEvent(FOR_AOA_SCAN);
-
-            if (aoaSenderActive)
-            {
-              AoAReceiver_aoaEnableSender(FALSE);
-            }
-
-            GAPCentralRole_TerminateLink(connHandle);
-
-            Display_print0(dispHandle, 2, 0, "Disconnecting");
-            Display_print0(dispHandle, 3, 0, "");
-            Display_print0(dispHandle, 4, 0, "");
-            Display_print0(dispHandle, 5, 0, "");
-
-            keyPressConnOpt = AOA_SCAN;
-          }
+          AoAReceiver_disconnect();
           break;
 
         default:
@@ -1352,20 +2115,7 @@ static void AoAReceiver_handleKeys(uint8_t shift, uint8_t keys)
     }
     else if (state == BLE_STATE_IDLE_AOA_SCANNING)
     {
-      state = BLE_STATE_IDLE;
-      aoaIdleScanStarted = TRUE;
-
-      AoAReceiver_antA1Result->updated = false;
-      AoAReceiver_antA2Result->updated = false;
-
-      // Reset channel index
-      channelIdx = 0;
-
-      Display_print0(dispHandle, 2, 0, "AoA Scan Stopped");
-      Display_print0(dispHandle, 3, 0, "");
-      Display_print0(dispHandle, 4, 0, "");
-      Display_print0(dispHandle, 5, 0, "Toggle AoA Scan ->");
-      Display_print0(dispHandle, 6, 0, "");
+      AoAReceiver_idleAoaStop();
     }
 
     return;
@@ -1373,254 +2123,2079 @@ static void AoAReceiver_handleKeys(uint8_t shift, uint8_t keys)
 }
 
 /*********************************************************************
- * @fn      AoAReceiver_processGATTMsg
+ * @fn      AoAReceiver_idleAoaStart
  *
- * @brief   Process GATT messages and events.
+ * @brief   Start AoA scanning while not connected.
  *
- * @return  none
+ * @return  SUCCESS, or bleIncorrectMode if not idle
  */
-static void AoAReceiver_processGATTMsg(gattMsgEvent_t *pMsg)
+static bStatus_t AoAReceiver_idleAoaStart(void)
 {
-  if (state == BLE_STATE_CONNECTED || state == BLE_STATE_CONNECTED_AOA_SCANNING)
+  if (state != BLE_STATE_IDLE || scanningStarted)
   {
-    // See if GATT server was unable to transmit an ATT response
-    if (pMsg->hdr.status == blePending)
-    {
-      // No HCI buffer was available. App can try to retransmit the response
-      // on the next connection event. Drop it for now.
-      Display_print1(dispHandle, 4, 0, "ATT Rsp dropped %d", pMsg->method);
-    }
-    else if ((pMsg->method == ATT_READ_RSP)   ||
-             ((pMsg->method == ATT_ERROR_RSP) &&
-              (pMsg->msg.errorRsp.reqOpcode == ATT_READ_REQ)))
-    {
-      if (pMsg->method == ATT_ERROR_RSP)
-      {
-        Display_print1(dispHandle, 4, 0, "Read Error %d", pMsg->msg.errorRsp.errCode);
-      }
-      else
-      {
-        // After a successful read, display the read value
-        Display_print1(dispHandle, 4, 0, "Read rsp: %d", pMsg->msg.readRsp.pValue[0]);
-      }
+    return bleIncorrectMode;
+  }
 
-      GATTProcedureInProgress = FALSE;
-    }
-    else if ((pMsg->method == ATT_WRITE_RSP)  ||
-             ((pMsg->method == ATT_ERROR_RSP) &&
-              (pMsg->msg.errorRsp.reqOpcode == ATT_WRITE_REQ)))
-    {
-      if (pMsg->method == ATT_ERROR_RSP)
-      {
-        Display_print1(dispHandle, 4, 0, "Write Error %d", pMsg->msg.errorRsp.errCode);
-      }
-      else
-      {
-        // After a successful write, display the value that was written
-        Display_print1(dispHandle, 4, 0, "Write sent: %d", charVal);
-      }
+  state = BLE_STATE_IDLE_AOA_SCANNING;
+  aoaIdleScanStarted = TRUE;
 
-      GATTProcedureInProgress = FALSE;
-    }
-    else if (pMsg->method == ATT_FLOW_CTRL_VIOLATED_EVENT)
-    {
-      // ATT request-response or indication-confirmation flow control is
-      // violated. All subsequent ATT requests or indications will be dropped.
-      // The app is informed in case it wants to drop the connection.
+  Display_print0(dispHandle, 2, 0, "AoA Scan Started");
+  Display_print0(dispHandle, 3, 0, "");
+  Display_print0(dispHandle, 4, 0, "");
+  Display_print0(dispHandle, 5, 0, "Toggle AoA Scan ->");
+  Display_print0(dispHandle, 6, 0, "");
 
-      // Display the opcode of the message that caused the violation.
-      Display_print1(dispHandle, 4, 0, "FC Violated: %d", pMsg->msg.flowCtrlEvt.opcode);
-    }
-    else if (pMsg->method == ATT_MTU_UPDATED_EVENT)
-    {
-      // MTU size updated
-      Display_print1(dispHandle, 4, 0, "MTU Size: %d", pMsg->msg.mtuEvt.MTU);
-    }
-    else if (discState != BLE_DISC_STATE_IDLE)
-    {
-      AoAReceiver_processGATTDiscEvent(pMsg);
-    }
-  } // else - in case a GATT message came after a connection has dropped, ignore it.
+  AoADuty_reset();
+  AoAReceiver_aoaSchedule();
 
-  // Needed only for ATT Protocol messages
-  GATT_bm_free(&pMsg->msg, pMsg->method);
+  return SUCCESS;
 }
 
-
 /*********************************************************************
- * @fn      AoAReceiver_processPairState
+ * @fn      AoAReceiver_idleAoaStop
  *
- * @brief   Process the new paring state.
+ * @brief   Stop AoA scanning while not connected.
  *
- * @return  none
+ * @return  SUCCESS, or bleIncorrectMode if not scanning
  */
-static void AoAReceiver_processPairState(uint8_t state, uint8_t status)
+static bStatus_t AoAReceiver_idleAoaStop(void)
 {
-  if (state == GAPBOND_PAIRING_STATE_STARTED)
-  {
-    Display_print0(dispHandle, 2, 0, "Pairing started");
-  }
-  else if (state == GAPBOND_PAIRING_STATE_COMPLETE)
+  if (state != BLE_STATE_IDLE_AOA_SCANNING)
   {
-    if (status == SUCCESS)
-    {
-      Display_print0(dispHandle, 2, 0, "Pairing success");
-    }
-    else
-    {
-      Display_print1(dispHandle, 2, 0, "Pairing fail: %d", status);
-    }
-  }
-  else if (state == GAPBOND_PAIRING_STATE_BONDED)
-  {
-    if (status == SUCCESS)
-    {
-      Display_print0(dispHandle, 2, 0, "Bonding success");
-    }
-  }
-  else if (state == GAPBOND_PAIRING_STATE_BOND_SAVED)
-  {
-    if (status == SUCCESS)
-    {
-      Display_print0(dispHandle, 2, 0, "Bond save success");
-    }
-    else
-    {
-      Display_print1(dispHandle, 2, 0, "Bond save failed: %d", status);
-    }
+    return bleIncorrectMode;
   }
+
+  state = BLE_STATE_IDLE;
+  aoaIdleScanStarted = TRUE;
+
+  // Do not wake up for a round that will not be run
+  Util_stopClock(&aoaDutyClock);
+
+  AoAReceiver_antA1Result->updated = false;
+  AoAReceiver_antA2Result->updated = false;
+
+  // Reset channel index and restart from array A1
+  channelIdx = 0;
+  aoaCaptureA2 = FALSE;
+#if !defined( AOA_STREAM )
+  AoAFusion_reset();
+#endif // !AOA_STREAM
+
+  Display_print0(dispHandle, 2, 0, "AoA Scan Stopped");
+  Display_print0(dispHandle, 3, 0, "");
+  Display_print0(dispHandle, 4, 0, "");
+  Display_print0(dispHandle, 5, 0, "Toggle AoA Scan ->");
+  Display_print0(dispHandle, 6, 0, "");
+
+  return SUCCESS;
 }
 
 /*********************************************************************
- * @fn      AoAReceiver_processPasscode
+ * @fn      AoAReceiver_discoverDevices
  *
- * @brief   Process the Passcode request.
+ * @brief   Start a device discovery round.
  *
- * @return  none
+ * @return  SUCCESS, or bleIncorrectMode if not idle or already scanning
  */
-static void AoAReceiver_processPasscode(uint16_t connectionHandle,
-                                          uint8_t uiOutputs)
+static bStatus_t AoAReceiver_discoverDevices(void)
 {
-  // This app uses a default passcode. A real-life scenario would handle all
-  // pairing scenarios and likely generate this randomly.
-  uint32_t passcode = B_APP_DEFAULT_PASSCODE;
-
-  // Display passcode to user
-  if (uiOutputs != 0)
+  if (state != BLE_STATE_IDLE || scanningStarted)
   {
-    Display_print1(dispHandle, 4, 0, "Passcode: %d", passcode);
+    return bleIncorrectMode;
   }
 
-  // Send passcode response
-  GAPBondMgr_PasscodeRsp(connectionHandle, SUCCESS, passcode);
+  scanningStarted = TRUE;
+  scanIdx = -1;
+
+  // Keep what was seen recently, a new round refreshes it
+  DevTable_age(Clock_getTicks(),
+               DEFAULT_DEV_TABLE_MAX_AGE * (1000 / Clock_tickPeriod));
+
+  Display_print0(dispHandle, 2, 0, "Discovering...");
+  Display_print0(dispHandle, 3, 0, "");
+  Display_print0(dispHandle, 4, 0, "");
+  Display_print0(dispHandle, 5, 0, "");
+  Display_print0(dispHandle, 6, 0, "");
+
+  GAPCentralRole_StartDiscovery(DEFAULT_DISCOVERY_MODE,
+                                DEFAULT_DISCOVERY_ACTIVE_SCAN,
+                                DEFAULT_DISCOVERY_WHITE_LIST);
+
+  return SUCCESS;
 }
 
 /*********************************************************************
- * @fn      AoAReceiver_startDiscovery
+ * @fn      AoAReceiver_connect
  *
- * @brief   Start service discovery.
+ * @brief   Establish a link to a peer.
  *
- * @return  none
+ * @param   pAddr    - peer address
+ * @param   addrType - peer address type
+ *
+ * @return  SUCCESS, or bleIncorrectMode if not idle
  */
-static void AoAReceiver_startDiscovery(void)
+static bStatus_t AoAReceiver_connect(uint8_t *pAddr, uint8_t addrType)
 {
-  attExchangeMTUReq_t req;
+  uint8_t linkAddr[B_ADDR_LEN];
 
-  // Initialize cached handles
-  svcStartHdl = svcEndHdl = charHdl = 0;
+  if (state != BLE_STATE_IDLE || scanningStarted)
+  {
+    return bleIncorrectMode;
+  }
 
-  discState = BLE_DISC_STATE_MTU;
+  // The address may live in the device table, which discovery reorders
+  memcpy(linkAddr, pAddr, B_ADDR_LEN);
 
-  // Discover GATT Server's Rx MTU size
-  req.clientRxMTU = maxPduSize - L2CAP_HDR_SIZE;
+  state = BLE_STATE_CONNECTING;
 
-  // ATT MTU size should be set to the minimum of the Client Rx MTU
-  // and Server Rx MTU values
-  VOID GATT_ExchangeMTU(connHandle, &req, selfEntity);
+  GAPCentralRole_EstablishLink(DEFAULT_LINK_HIGH_DUTY_CYCLE,
+                               DEFAULT_LINK_WHITE_LIST,
+                               addrType, linkAddr);
+
+  Display_print0(dispHandle, 2, 0, "Connecting");
+  Display_print0(dispHandle, 3, 0, Util_convertBdAddr2Str(linkAddr));
+  Display_clearLine(dispHandle, 4);
+
+  scanIdx = -1;
+
+  return SUCCESS;
 }
 
 /*********************************************************************
- * @fn      AoAReceiver_processGATTDiscEvent
+ * @fn      AoAReceiver_connAoaScan
  *
- * @brief   Process GATT discovery event
+ * @brief   Start or stop AoA scanning on the current connection.
  *
- * @return  none
+ * @param   enable - TRUE to start, FALSE to stop
+ *
+ * @return  SUCCESS, or bleIncorrectMode if not connected
  */
-static void AoAReceiver_processGATTDiscEvent(gattMsgEvent_t *pMsg)
+static bStatus_t AoAReceiver_connAoaScan(bool enable)
 {
-  if (discState == BLE_DISC_STATE_MTU)
+  if (state != BLE_STATE_CONNECTED && state != BLE_STATE_CONNECTED_AOA_SCANNING)
   {
-    // MTU size response received, discover aoa service
-    if (pMsg->method == ATT_EXCHANGE_MTU_RSP)
-    {
-      uint8_t uuid[ATT_BT_UUID_SIZE] = { LO_UINT16(AOAPROFILE_SERVICE_UUID),
-                                         HI_UINT16(AOAPROFILE_SERVICE_UUID) };
+    return bleIncorrectMode;
+  }
 
-      // Just in case we're using the default MTU size (23 octets)
-      Display_print1(dispHandle, 4, 0, "MTU Size: %d", ATT_MTU_SIZE);
+  if (enable && !aoaConnectedScanRequest)
+  {
+    state = BLE_STATE_CONNECTED_AOA_SCANNING;
+    aoaConnectedScanRequest = TRUE;
 
-      discState = BLE_DISC_STATE_SVC;
+    // Subscribe the callback
+    // Start connected AoA Scan in this callback event
+    AoAReceiver_RegistertToAllConnectionEvent(FOR_AOA_SCAN);
 
-      // Discovery aoa service
-      VOID GATT_DiscPrimaryServiceByUUID(connHandle, uuid, ATT_BT_UUID_SIZE,
-                                         selfEntity);
+    // If AOA sender is not active, request AOA
+    if (!aoaSenderActive)
+    {
+      AoAReceiver_aoaEnableSender(TRUE);
     }
+
+    Display_print0(dispHandle, 2, 0, "AoA Scan Started");
+    Display_print0(dispHandle, 3, 0, "");
+    Display_print0(dispHandle, 4, 0, "");
+    Display_print0(dispHandle, 5, 0, "Toggle AoA Scan ->");
   }
-  else if (discState == BLE_DISC_STATE_SVC)
+  else if (!enable && aoaConnectedScanRequest)
   {
-    // Service found, store handles
-    if (pMsg->method == ATT_FIND_BY_TYPE_VALUE_RSP &&
-        pMsg->msg.findByTypeValueRsp.numInfo > 0)
+    state = BLE_STATE_CONNECTED;
+    aoaConnectedScanRequest = FALSE;
+
+    // Un-subscribe the callback event
+    AoAReceiver_UnRegistertToAllConnectionEvent(FOR_AOA_SCAN);
+
+    // If AOA sender is active, request AOA termination
+    if (aoaSenderActive)
     {
-      svcStartHdl = ATT_ATTR_HANDLE(pMsg->msg.findByTypeValueRsp.pHandlesInfo, 0);
-      svcEndHdl = ATT_GRP_END_HANDLE(pMsg->msg.findByTypeValueRsp.pHandlesInfo, 0);
+      AoAReceiver_aoaEnableSender(FALSE);
     }
 
-    // If procedure complete
-    if (((pMsg->method == ATT_FIND_BY_TYPE_VALUE_RSP) &&
-         (pMsg->hdr.status == bleProcedureComplete))  ||
-        (pMsg->method == ATT_ERROR_RSP))
-    {
-      if (svcStartHdl != 0)
-      {
-        attReadByTypeReq_t req;
+    // No more connection events are reported, back off now
+    AoAReceiver_connCtrlPoll(connHandle);
 
-        // Discover characteristic
-        discState = BLE_DISC_STATE_CHAR;
+    Display_print0(dispHandle, 2, 0, "AoA Scan Cancelled");
+    Display_print0(dispHandle, 3, 0, "");
+    Display_print0(dispHandle, 4, 0, "");
+    Display_print0(dispHandle, 5, 0, "Toggle AoA Scan ->");
 
-        req.startHandle = svcStartHdl;
-        req.endHandle = svcEndHdl;
-        req.type.len = ATT_BT_UUID_SIZE;
-        req.type.uuid[0] = LO_UINT16(AOAPROFILE_AOA_START_UUID);
-        req.type.uuid[1] = HI_UINT16(AOAPROFILE_AOA_START_UUID);
+    AoAReceiver_antA1Result->updated = false;
+    AoAReceiver_antA2Result->updated = false;
 
-        VOID GATT_DiscCharsByUUID(connHandle, &req, selfEntity);
-      }
-    }
+    // Reset channl index and restart from array A1
+    channelIdx = 0;
+    aoaCaptureA2 = FALSE;
+#if !defined( AOA_STREAM )
+    AoAFusion_reset();
+#endif // !AOA_STREAM
   }
-  else if (discState == BLE_DISC_STATE_CHAR)
-  {
-    // Characteristic found, store handle
-    if ((pMsg->method == ATT_READ_BY_TYPE_RSP) &&
-        (pMsg->msg.readByTypeRsp.numPairs > 0))
-    {
-      charHdl = BUILD_UINT16(pMsg->msg.readByTypeRsp.pDataList[3],
-                             pMsg->msg.readByTypeRsp.pDataList[4]);
 
-      // This is done to cover the case where we were disconnected
-      // In this case, if the user requested some form of AoA, we will automatically register
-      if (autoAoaEnabled || aoaConnectedScanRequest)
+  return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      AoAReceiver_autoAoa
+ *
+ * @brief   Enable or disable RSSI triggered AoA on the current
+ *          connection.
+ *
+ * @param   enable - TRUE to enable, FALSE to disable
+ *
+ * @return  SUCCESS, or bleIncorrectMode if not connected
+ */
+static bStatus_t AoAReceiver_autoAoa(bool enable)
+{
+  if (state != BLE_STATE_CONNECTED && state != BLE_STATE_CONNECTED_AOA_SCANNING)
+  {
+    return bleIncorrectMode;
+  }
+
+  if (enable && !autoAoaEnabled)
+  {
+    state = BLE_STATE_CONNECTED_AOA_SCANNING;
+    autoAoaEnabled = TRUE;
+    aoaConnectedScanRequest = TRUE;
+
+    // Subscribe the callback event
+    AoAReceiver_RegistertToAllConnectionEvent(FOR_AOA_SCAN);
+
+    Display_print0(dispHandle, 1, 0, "");
+    Display_print0(dispHandle, 2, 0, "");
+    Display_print0(dispHandle, 3, 0, "");
+    Display_print0(dispHandle, 4, 0, "Auto AoA Enabled");
+    Display_print0(dispHandle, 5, 0, "Toggle Auto AoA ->");
+  }
+  else if (!enable && autoAoaEnabled)
+  {
+    state = BLE_STATE_CONNECTED;
+    autoAoaEnabled = FALSE;
+    aoaConnectedScanRequest = FALSE;
+
+    // Un-subscribe the callback event
+    AoAReceiver_UnRegistertToAllConnectionEvent(FOR_AOA_SCAN);
+
+    AoAReceiver_connCtrlPoll(connHandle);
+
+    Display_print0(dispHandle, 1, 0, "");
+    Display_print0(dispHandle, 2, 0, "");
+    Display_print0(dispHandle, 3, 0, "");
+    Display_print0(dispHandle, 4, 0, "Auto AoA Disabled");
+    Display_print0(dispHandle, 5, 0, "Toggle Auto AoA ->");
+  }
+
+  return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      AoAReceiver_disconnect
+ *
+ * @brief   Stop connected AoA and terminate the current link.
+ *
+ * @return  SUCCESS, or bleIncorrectMode if not connected
+ */
+static bStatus_t AoAReceiver_disconnect(void)
+{
+  if (state != BLE_STATE_CONNECTED && state != BLE_STATE_CONNECTED_AOA_SCANNING)
+  {
+    return bleIncorrectMode;
+  }
+
+  state = BLE_STATE_IDLE;
+
+  // Un-subscribe AOA connection events (we are disconnecting)
+  AoAReceiver_UnRegistertToAllConnectionEvent(FOR_AOA_SCAN);
+
+  if (aoaSenderActive)
+  {
+    AoAReceiver_aoaEnableSender(FALSE);
+  }
+
+  GAPCentralRole_TerminateLink(connHandle);
+
+  Display_print0(dispHandle, 2, 0, "Disconnecting");
+  Display_print0(dispHandle, 3, 0, "");
+  Display_print0(dispHandle, 4, 0, "");
+  Display_print0(dispHandle, 5, 0, "");
+
+  keyPressConnOpt = AOA_SCAN;
+
+  return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      AoAReceiver_putUint32
+ *
+ * @brief   Write a 32-bit value little endian.
+ *
+ * @param   pBuf - destination, 4 bytes
+ * @param   val  - value to write
+ *
+ * @return  pointer past the written value
+ */
+static uint8_t *AoAReceiver_putUint32(uint8_t *pBuf, uint32_t val)
+{
+  *pBuf++ = BREAK_UINT32(val, 0);
+  *pBuf++ = BREAK_UINT32(val, 1);
+  *pBuf++ = BREAK_UINT32(val, 2);
+  *pBuf++ = BREAK_UINT32(val, 3);
+
+  return pBuf;
+}
+
+/*********************************************************************
+ * @fn      AoAReceiver_processCmd
+ *
+ * @brief   Execute the pending command frame from the UART command
+ *          interface and send its response.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void AoAReceiver_processCmd(void)
+{
+  AoACmd_Frame *pFrame = AoACmd_getFrame();
+  uint8_t rsp[AOA_CMD_MAX_PAYLOAD - 1];
+  uint8_t rspLen = 0;
+  uint8_t status = SUCCESS;
+
+  if (pFrame == NULL)
+  {
+    return;
+  }
+
+  switch (pFrame->cmd)
+  {
+    case AOA_CMD_PING:
+      rsp[rspLen++] = AOA_CMD_VERSION;
+      break;
+
+    case AOA_CMD_GET_STATE:
+      {
+        AoADuty_Stats dutyStats;
+        AoATrigger_Cfg trigCfg;
+        int8_t rssi = (int8_t)aoaReceiverRssi.currentRssi;
+        uint8_t flags = 0;
+
+        // Connected, the RSSI auto AoA acts on
+        AoATrigger_getCfg(AOA_TRIGGER_ALL_PEERS, &trigCfg);
+        if (state == BLE_STATE_CONNECTED || state == BLE_STATE_CONNECTED_AOA_SCANNING)
+        {
+          AoATrigger_getRssi(connHandle, &rssi);
+        }
+
+        flags |= aoaIdleScanStarted ? 0x01 : 0;
+        flags |= aoaConnectedScanRequest ? 0x02 : 0;
+        flags |= autoAoaEnabled ? 0x04 : 0;
+        flags |= aoaSenderActive ? 0x08 : 0;
+        flags |= scanningStarted ? 0x10 : 0;
+        flags |= contDiscovery ? 0x20 : 0;
+        flags |= discAutoConnect ? 0x40 : 0;
+
+        rsp[rspLen++] = state;
+        rsp[rspLen++] = flags;
+        rsp[rspLen++] = LO_UINT16(connHandle);
+        rsp[rspLen++] = HI_UINT16(connHandle);
+        rsp[rspLen++] = (uint8_t)trigCfg.threshold;
+        rsp[rspLen++] = (uint8_t)trigCfg.hysteresis;
+        rsp[rspLen++] = aoaReceiverRssi.alpha;
+        rsp[rspLen++] = (uint8_t)rssi;
+        rsp[rspLen++] = numChannels;
+        memcpy(&rsp[rspLen], channels, numChannels);
+        rspLen += numChannels;
+        rsp[rspLen++] = AntConfig_getSource(ANT_CONFIG_ARRAY_A1);
+        rsp[rspLen++] = AntConfig_getSource(ANT_CONFIG_ARRAY_A2);
+
+        AoADuty_getStats(&dutyStats);
+        rsp[rspLen++] = dutyStats.rate;
+        rsp[rspLen++] = dutyStats.numTags;
+      }
+      break;
+
+    case AOA_CMD_GET_STATS:
+      if (pFrame->len != 1)
+      {
+        status = AOA_CMD_STATUS_BAD_LENGTH;
+      }
+      else if (pFrame->data[0] == AOA_CMD_STATS_COUNTERS)
+      {
+        uint32_t counters[AOA_CMD_NUM_STATS];
+        AoACmd_Stats cmdStats;
+        AoADuty_Stats dutyStats;
+        uint8_t *pRsp = rsp;
+        uint8_t i;
+
+        AoACmd_getStats(&cmdStats);
+        AoADuty_getStats(&dutyStats);
+
+        counters[AOA_CMD_STAT_AOA_REPORTS] = aoaReportCnt;
+        counters[AOA_CMD_STAT_AOA_FAILURES] = aoaReportFailCnt;
+        counters[AOA_CMD_STAT_ANGLES] = aoaAngleCnt;
+#if !defined( AOA_STREAM )
+        counters[AOA_CMD_STAT_WORKER_DROPS] = aoaWorkerDropCnt;
+        counters[AOA_CMD_STAT_IQ_LOW_AMPLITUDE] = aoaIqLowAmplitudeCnt;
+        counters[AOA_CMD_STAT_IQ_LOW_COHERENCE] = aoaIqLowCoherenceCnt;
+#else
+        counters[AOA_CMD_STAT_WORKER_DROPS] = 0;
+        counters[AOA_CMD_STAT_IQ_LOW_AMPLITUDE] = 0;
+        counters[AOA_CMD_STAT_IQ_LOW_COHERENCE] = 0;
+#endif // !AOA_STREAM
+        counters[AOA_CMD_STAT_CONN_EVT_COALESCED] = connEvtCoalescedCnt;
+        counters[AOA_CMD_STAT_CMD_FRAMES] = cmdStats.numFrames;
+        counters[AOA_CMD_STAT_CMD_FCS_ERRORS] = cmdStats.numFcsErrors;
+        counters[AOA_CMD_STAT_CMD_OVERRUNS] = cmdStats.numOverruns;
+        counters[AOA_CMD_STAT_AOA_FILTERED] = aoaFilteredCnt;
+        counters[AOA_CMD_STAT_RADIO_ON_MS] = dutyStats.radioOnMs;
+        counters[AOA_CMD_STAT_DUTY_ROUNDS] = dutyStats.numRounds;
+        counters[AOA_CMD_STAT_DUTY_WAITS] = dutyStats.numWaits;
+
+        for (i = 0; i < AOA_CMD_NUM_STATS; i++)
+        {
+          pRsp = AoAReceiver_putUint32(pRsp, counters[i]);
+        }
+        rspLen = pRsp - rsp;
+      }
+      else if (pFrame->data[0] == AOA_CMD_STATS_TRIGGER)
+      {
+        AoATrigger_Stats trigStats;
+        uint8_t *pRsp = rsp;
+
+        AoATrigger_getStats(&trigStats);
+        pRsp = AoAReceiver_putUint32(pRsp, trigStats.numRequests);
+        pRsp = AoAReceiver_putUint32(pRsp, trigStats.numHeld);
+        rspLen = pRsp - rsp;
+      }
+#if defined( AOA_HUB_LINK )
+      else if (pFrame->data[0] == AOA_CMD_STATS_BACKHAUL)
+      {
+        AoABackhaul_Stats bhStats;
+        uint8_t *pRsp = rsp;
+
+        AoABackhaul_getStats(&bhStats);
+        pRsp = AoAReceiver_putUint32(pRsp, bhStats.numRecords);
+        pRsp = AoAReceiver_putUint32(pRsp, bhStats.numNotifications);
+        pRsp = AoAReceiver_putUint32(pRsp, bhStats.numDropped);
+        rspLen = pRsp - rsp;
+      }
+#endif // AOA_HUB_LINK
+      else if (pFrame->data[0] == AOA_CMD_STATS_LINK)
+      {
+        uint8_t *pRsp = rsp;
+
+        pRsp = AoAReceiver_putUint32(pRsp, linkDiscMs);
+        pRsp = AoAReceiver_putUint32(pRsp, linkFirstAngleMs);
+        rspLen = pRsp - rsp;
+      }
+      else if (pFrame->data[0] == AOA_CMD_STATS_CONN_CTRL)
+      {
+        AoAConnCtrl_Stats ctrlStats;
+        uint16_t interval = AoAConnCtrl_getInterval(connHandle);
+        uint8_t *pRsp = rsp;
+
+        AoAConnCtrl_getStats(&ctrlStats);
+        pRsp = AoAReceiver_putUint32(pRsp, ctrlStats.numRequests);
+        pRsp = AoAReceiver_putUint32(pRsp, ctrlStats.numFailures);
+        *pRsp++ = LO_UINT16(interval);
+        *pRsp++ = HI_UINT16(interval);
+        rspLen = pRsp - rsp;
+      }
+      else
+      {
+        MsgPool_Stats poolStats;
+
+        if (pFrame->data[0] >= AOA_CMD_STATS_POOL &&
+            MsgPool_getStats(pFrame->data[0] - AOA_CMD_STATS_POOL, &poolStats))
+        {
+          uint8_t *pRsp = rsp;
+
+          *pRsp++ = LO_UINT16(poolStats.blockSize);
+          *pRsp++ = HI_UINT16(poolStats.blockSize);
+          *pRsp++ = poolStats.numBlocks;
+          *pRsp++ = poolStats.inUse;
+          *pRsp++ = poolStats.maxInUse;
+          pRsp = AoAReceiver_putUint32(pRsp, poolStats.numAllocs);
+          pRsp = AoAReceiver_putUint32(pRsp, poolStats.numFails);
+          rspLen = pRsp - rsp;
+        }
+        else
+        {
+          status = INVALIDPARAMETER;
+        }
+      }
+      break;
+
+    case AOA_CMD_GET_DEVICES:
+      {
+        uint16_t count = DevTable_count();
+        uint16_t idx = 0;
+        uint32_t now = Clock_getTicks();
+        uint8_t *pRsp = rsp + 4;
+        DevTable_Entry *pDev;
+
+        if (pFrame->len == 2)
+        {
+          idx = BUILD_UINT16(pFrame->data[0], pFrame->data[1]);
+        }
+        else if (pFrame->len != 0)
+        {
+          status = AOA_CMD_STATUS_BAD_LENGTH;
+          break;
+        }
+
+        rsp[0] = LO_UINT16(count);
+        rsp[1] = HI_UINT16(count);
+        rsp[2] = LO_UINT16(idx);
+        rsp[3] = HI_UINT16(idx);
+
+        // As many entries as fit, the host pages through with idx
+        while ((pRsp + AOA_CMD_DEVICE_ENTRY_LEN <= rsp + sizeof(rsp)) &&
+               (pDev = DevTable_get(idx++)) != NULL)
+        {
+          uint32_t ageMs = (now - pDev->lastSeen) / (1000 / Clock_tickPeriod);
+
+          if (ageMs > 0xFFFF)
+          {
+            ageMs = 0xFFFF;
+          }
+
+          *pRsp++ = pDev->addrType;
+          memcpy(pRsp, pDev->addr, B_ADDR_LEN);
+          pRsp += B_ADDR_LEN;
+          *pRsp++ = (uint8_t)pDev->rssi;
+          *pRsp++ = pDev->flags;
+          *pRsp++ = LO_UINT16(ageMs);
+          *pRsp++ = HI_UINT16(ageMs);
+        }
+
+        rspLen = pRsp - rsp;
+      }
+      break;
+
+    case AOA_CMD_IDLE_AOA_START:
+      status = AoAReceiver_idleAoaStart();
+      break;
+
+    case AOA_CMD_IDLE_AOA_STOP:
+      status = AoAReceiver_idleAoaStop();
+      break;
+
+    case AOA_CMD_DISCOVER:
+      if (pFrame->len > 1)
+      {
+        status = AOA_CMD_STATUS_BAD_LENGTH;
+      }
+      else if ((status = AoAReceiver_discoverDevices()) == SUCCESS)
+      {
+        uint8_t opts = (pFrame->len == 1) ? pFrame->data[0] : 0;
+
+        contDiscovery = (opts & AOA_CMD_DISC_CONTINUOUS) ? TRUE : FALSE;
+        discAutoConnect = (opts & AOA_CMD_DISC_AUTO_CONNECT) ? TRUE : FALSE;
+      }
+      break;
+
+    case AOA_CMD_DISCOVER_STOP:
+      status = AoAReceiver_stopDiscovery();
+      break;
+
+    case AOA_CMD_CONNECT:
+      if (pFrame->len != 1 + B_ADDR_LEN)
+      {
+        status = AOA_CMD_STATUS_BAD_LENGTH;
+      }
+      else
+      {
+        status = AoAReceiver_connect(&pFrame->data[1], pFrame->data[0]);
+      }
+      break;
+
+    case AOA_CMD_DISCONNECT:
+      status = AoAReceiver_disconnect();
+      break;
+
+    case AOA_CMD_CONN_AOA:
+      if (pFrame->len != 1)
+      {
+        status = AOA_CMD_STATUS_BAD_LENGTH;
+      }
+      else if (pFrame->data[0] == AOA_CMD_CONN_AOA_OFF)
+      {
+        status = autoAoaEnabled ? AoAReceiver_autoAoa(FALSE) :
+                                  AoAReceiver_connAoaScan(FALSE);
+      }
+      else if (pFrame->data[0] == AOA_CMD_CONN_AOA_MANUAL)
+      {
+        // Leave auto AoA first, it shares the scan request
+        if (autoAoaEnabled)
+        {
+          AoAReceiver_autoAoa(FALSE);
+        }
+        status = AoAReceiver_connAoaScan(TRUE);
+      }
+      else if (pFrame->data[0] == AOA_CMD_CONN_AOA_AUTO)
+      {
+        if (aoaConnectedScanRequest && !autoAoaEnabled)
+        {
+          AoAReceiver_connAoaScan(FALSE);
+        }
+        status = AoAReceiver_autoAoa(TRUE);
+      }
+      else
+      {
+        status = INVALIDPARAMETER;
+      }
+      break;
+
+    case AOA_CMD_SET_CHANNELS:
+      {
+        uint8_t i;
+
+        if (pFrame->len == 0 || pFrame->len > AOA_MAX_CHANNELS)
+        {
+          status = AOA_CMD_STATUS_BAD_LENGTH;
+          break;
+        }
+
+        for (i = 0; i < pFrame->len; i++)
+        {
+          if (pFrame->data[i] > AOA_MAX_RF_CHANNEL)
+          {
+            status = INVALIDPARAMETER;
+          }
+        }
+
+        if (status == SUCCESS)
+        {
+          memcpy(channels, pFrame->data, pFrame->len);
+          numChannels = pFrame->len;
+#if !defined( AOA_STREAM )
+          AoAFusion_init(AoAReceiver_fusionCycle());
+#endif // !AOA_STREAM
+
+          // Keep the index of a running capture inside the new list
+          channelIdx = 0;
+
+          AoAReceiver_senderUpdate();
+        }
+      }
+      break;
+
+    case AOA_CMD_SET_RSSI_THRESHOLD:
+      if (pFrame->len != 2)
+      {
+        status = AOA_CMD_STATUS_BAD_LENGTH;
+      }
+      else
+      {
+        AoATrigger_Cfg trigCfg;
+
+        // Applies to every peer, AOA_CMD_SET_TRIGGER sets one
+        AoATrigger_getCfg(AOA_TRIGGER_ALL_PEERS, &trigCfg);
+        trigCfg.threshold = (int8_t)pFrame->data[0];
+        trigCfg.hysteresis = (int8_t)pFrame->data[1];
+
+        status = AoATrigger_setCfg(AOA_TRIGGER_ALL_PEERS, &trigCfg);
+      }
+      break;
+
+    case AOA_CMD_SET_RSSI_FILTER:
+      if (pFrame->len != 1)
+      {
+        status = AOA_CMD_STATUS_BAD_LENGTH;
+      }
+      else if (pFrame->data[0] == 0 || pFrame->data[0] > AOA_ALPHA_FILTER_MAX_VALUE)
+      {
+        status = INVALIDPARAMETER;
+      }
+      else
+      {
+        AoATrigger_Cfg trigCfg;
+
+        aoaReceiverRssi.alpha = pFrame->data[0];
+
+        AoATrigger_getCfg(AOA_TRIGGER_ALL_PEERS, &trigCfg);
+        trigCfg.alpha = pFrame->data[0];
+        status = AoATrigger_setCfg(AOA_TRIGGER_ALL_PEERS, &trigCfg);
+      }
+      break;
+
+    case AOA_CMD_SET_CONN_CTRL:
+      if (pFrame->len != 11)
+      {
+        status = AOA_CMD_STATUS_BAD_LENGTH;
+      }
+      else
+      {
+        AoAConnCtrl_Cfg ctrlCfg;
+
+        ctrlCfg.activeRate = pFrame->data[2];
+        ctrlCfg.stillRate = pFrame->data[3];
+        ctrlCfg.idleInterval = BUILD_UINT16(pFrame->data[4], pFrame->data[5]);
+        ctrlCfg.motionAngle = pFrame->data[6];
+        ctrlCfg.motionHold = BUILD_UINT16(pFrame->data[7], pFrame->data[8]);
+        ctrlCfg.minUpdateGap = BUILD_UINT16(pFrame->data[9], pFrame->data[10]);
+
+        status = AoAConnCtrl_setCfg(BUILD_UINT16(pFrame->data[0], pFrame->data[1]),
+                                    &ctrlCfg);
+      }
+      break;
+
+#if defined( AOA_HUB_LINK )
+    case AOA_CMD_SET_BACKHAUL:
+      if (pFrame->len != 2)
+      {
+        status = AOA_CMD_STATUS_BAD_LENGTH;
+      }
+      else if (BUILD_UINT16(pFrame->data[0], pFrame->data[1]) == 0)
+      {
+        status = INVALIDPARAMETER;
+      }
+      else
+      {
+        aoaBackhaulFlush = BUILD_UINT16(pFrame->data[0], pFrame->data[1]);
+      }
+      break;
+#endif // AOA_HUB_LINK
+
+    case AOA_CMD_SET_SENDER:
+      if (pFrame->len != 3)
+      {
+        status = AOA_CMD_STATUS_BAD_LENGTH;
+      }
+      else if (pFrame->data[0] == 0)
+      {
+        status = INVALIDPARAMETER;
+      }
+      else
+      {
+        senderBurst = pFrame->data[0];
+        senderPeriod = BUILD_UINT16(pFrame->data[1], pFrame->data[2]);
+
+        AoAReceiver_senderUpdate();
+      }
+      break;
+
+    case AOA_CMD_SET_TRIGGER:
+      if (pFrame->len != 11)
+      {
+        status = AOA_CMD_STATUS_BAD_LENGTH;
+      }
+      else
+      {
+        AoATrigger_Cfg trigCfg;
+
+        trigCfg.threshold = (int8_t)pFrame->data[2];
+        trigCfg.hysteresis = (int8_t)pFrame->data[3];
+        trigCfg.alpha = pFrame->data[4];
+        trigCfg.minOnTime = BUILD_UINT16(pFrame->data[5], pFrame->data[6]);
+        trigCfg.minOffTime = BUILD_UINT16(pFrame->data[7], pFrame->data[8]);
+        trigCfg.minRequestGap = BUILD_UINT16(pFrame->data[9], pFrame->data[10]);
+
+        status = AoATrigger_setCfg(BUILD_UINT16(pFrame->data[0], pFrame->data[1]),
+                                   &trigCfg);
+      }
+      break;
+
+    case AOA_CMD_SET_OPTIONS:
+      if (pFrame->len != 1)
+      {
+        status = AOA_CMD_STATUS_BAD_LENGTH;
+      }
+      else
+      {
+#if !defined( AOA_STREAM )
+        bool pipelined = (pFrame->data[0] & AOA_CMD_OPT_PIPELINED) ? TRUE : FALSE;
+
+        // The two modes re-arm at different points, switching while
+        // idle AoA is running would lose or double a capture
+        if (pipelined != aoaPipelined && state == BLE_STATE_IDLE_AOA_SCANNING)
+        {
+          status = bleIncorrectMode;
+          break;
+        }
+        aoaPipelined = pipelined;
+        aoaAngleInd = (pFrame->data[0] & AOA_CMD_OPT_ANGLE_IND) ? TRUE : FALSE;
+        aoaIqInd = (pFrame->data[0] & AOA_CMD_OPT_IQ_IND) ? TRUE : FALSE;
+        aoaFusion = (pFrame->data[0] & AOA_CMD_OPT_FUSION) ? TRUE : FALSE;
+        AoAFusion_reset();
+#endif // !AOA_STREAM
+        connEvtCoalesce = (pFrame->data[0] & AOA_CMD_OPT_COALESCE) ? TRUE : FALSE;
+        fastDiscovery = (pFrame->data[0] & AOA_CMD_OPT_FAST_DISC) ? TRUE : FALSE;
+      }
+      break;
+
+    case AOA_CMD_FILTER_ADD:
+      if (pFrame->len != B_ADDR_LEN)
+      {
+        status = AOA_CMD_STATUS_BAD_LENGTH;
+      }
+      else
+      {
+        status = AoAReceiver_filterAdd(pFrame->data);
+      }
+      break;
+
+    case AOA_CMD_FILTER_CLEAR:
+      AoAReceiver_filterClear();
+      break;
+
+    case AOA_CMD_SET_IQ_GATE:
+      if (pFrame->len != 3)
+      {
+        status = AOA_CMD_STATUS_BAD_LENGTH;
+      }
+      else if (pFrame->data[2] > 100)
+      {
+        status = INVALIDPARAMETER;
+      }
+      else
+      {
+#if !defined( AOA_STREAM )
+        aoaIqGateCfg.minAmplitude = BUILD_UINT16(pFrame->data[0], pFrame->data[1]);
+        aoaIqGateCfg.minCoherence = pFrame->data[2];
+#else
+        // Streaming forwards every capture unfiltered
+        status = bleIncorrectMode;
+#endif // !AOA_STREAM
+      }
+      break;
+
+    case AOA_CMD_SET_SLOT_MAP:
+      if (pFrame->len != 2)
+      {
+        status = AOA_CMD_STATUS_BAD_LENGTH;
+      }
+      else
+      {
+#if !defined( AOA_STREAM )
+        status = AoAReceiver_setSlotMap(pFrame->data[0], pFrame->data[1]);
+#else
+        // Streaming forwards whole captures
+        status = bleIncorrectMode;
+#endif // !AOA_STREAM
+      }
+      break;
+
+    case AOA_CMD_ANT_BEGIN:
+      if (pFrame->len != 8)
+      {
+        status = AOA_CMD_STATUS_BAD_LENGTH;
+      }
+      else
+      {
+        status = AntConfig_begin(pFrame->data[0], pFrame->data[1],
+                                 pFrame->data[2], pFrame->data[3],
+                                 BUILD_UINT32(pFrame->data[4], pFrame->data[5],
+                                              pFrame->data[6], pFrame->data[7]));
+      }
+      break;
+
+    case AOA_CMD_ANT_PATTERNS:
+      if (pFrame->len < 6 || (pFrame->len - 2) % 4 != 0)
+      {
+        status = AOA_CMD_STATUS_BAD_LENGTH;
+      }
+      else
+      {
+        status = AntConfig_setPatterns(pFrame->data[0], pFrame->data[1],
+                                       (pFrame->len - 2) / 4, &pFrame->data[2]);
+      }
+      break;
+
+    case AOA_CMD_ANT_PAIR:
+      if (pFrame->len != 10)
+      {
+        status = AOA_CMD_STATUS_BAD_LENGTH;
+      }
+      else
+      {
+        AoA_AntennaPair pair;
+        uint32_t gain = BUILD_UINT32(pFrame->data[6], pFrame->data[7],
+                                     pFrame->data[8], pFrame->data[9]);
+
+        memset(&pair, 0, sizeof(pair));
+        pair.a = pFrame->data[2];
+        pair.b = pFrame->data[3];
+        pair.sign = (int8_t)pFrame->data[4];
+        pair.offset = (int8_t)pFrame->data[5];
+        memcpy(&pair.gain, &gain, sizeof(pair.gain));
+
+        status = AntConfig_setPair(pFrame->data[0], pFrame->data[1], &pair);
+      }
+      break;
+
+    case AOA_CMD_SET_DUTY:
+      if (pFrame->len != 5)
+      {
+        status = AOA_CMD_STATUS_BAD_LENGTH;
+      }
+      else
+      {
+        AoADuty_Cfg dutyCfg;
+
+        dutyCfg.maxRate = pFrame->data[0];
+        dutyCfg.minRate = pFrame->data[1];
+        dutyCfg.ratePerTag = pFrame->data[2];
+        dutyCfg.tagWindow = BUILD_UINT16(pFrame->data[3], pFrame->data[4]);
+
+        // A round already waiting keeps its wake-up time
+        status = AoADuty_setCfg(&dutyCfg);
+      }
+      break;
+
+    case AOA_CMD_ANT_GEOMETRY:
+      if (pFrame->len < 3 || (pFrame->len - 3) % 4 != 0)
+      {
+        status = AOA_CMD_STATUS_BAD_LENGTH;
+      }
+      else
+      {
+        status = AntConfig_setGeometry(pFrame->data[0],
+                                       (int16_t)BUILD_UINT16(pFrame->data[1], pFrame->data[2]),
+                                       (pFrame->len - 3) / 4, &pFrame->data[3]);
+      }
+      break;
+
+    case AOA_CMD_ANT_COMMIT:
+      if (pFrame->len != 2)
+      {
+        status = AOA_CMD_STATUS_BAD_LENGTH;
+      }
+      else if (AoAReceiver_antConfigBusy())
+      {
+        status = bleIncorrectMode;
+      }
+      else
+      {
+        const AntConfig_Desc *pPending = AntConfig_getPending(pFrame->data[0]);
+
+        if (pPending == NULL)
+        {
+          status = bleIncorrectMode;
+        }
+#if !defined( AOA_STREAM )
+        else if (!AoAReceiver_slotMapFits(pPending->numPatterns, aoaSlotSkip, aoaSlotKeep))
+        {
+          status = INVALIDPARAMETER;
+        }
+#endif // !AOA_STREAM
+        else
+        {
+          status = AntConfig_commit(pFrame->data[0],
+                                    (pFrame->data[1] & AOA_CMD_ANT_PERSIST) != 0);
+        }
+      }
+      break;
+
+    case AOA_CMD_ANT_RESTORE:
+      if (pFrame->len != 1)
+      {
+        status = AOA_CMD_STATUS_BAD_LENGTH;
+      }
+      else if (AoAReceiver_antConfigBusy())
+      {
+        status = bleIncorrectMode;
+      }
+      else
+      {
+        status = AntConfig_restore(pFrame->data[0]);
+      }
+      break;
+
+#if defined( AOA_INJECT )
+    case AOA_CMD_INJECT_ADV:
+      status = AoAReceiver_injectAdv(pFrame);
+      break;
+
+    case AOA_CMD_INJECT_CONN_EVT:
+      status = AoAReceiver_injectConnEvt(pFrame);
+      break;
+
+#if !defined( AOA_STREAM )
+    case AOA_CMD_INJECT_IQ_BEGIN:
+    case AOA_CMD_INJECT_IQ_DATA:
+    case AOA_CMD_INJECT_IQ_COMMIT:
+      status = AoAReceiver_injectIq(pFrame);
+      break;
+#endif // !AOA_STREAM
+#endif // AOA_INJECT
+
+#if defined( AOA_BENCH )
+    case AOA_CMD_BENCH:
+      status = AoAReceiver_bench(pFrame, rsp, &rspLen);
+      break;
+#endif // AOA_BENCH
+
+    default:
+      status = AOA_CMD_STATUS_UNKNOWN_CMD;
+      break;
+  }
+
+  AoACmd_sendRsp(status, rsp, rspLen);
+}
+
+#if defined( AOA_INJECT )
+/*********************************************************************
+ * @fn      AoAReceiver_injectAdv
+ *
+ * @brief   Handle AOA_CMD_INJECT_ADV as if discovery had received the
+ *          advertisement. Only while a discovery round runs, like the
+ *          stack.
+ *
+ * @param   pFrame - addrType, addr[6], int8 rssi, advertising data
+ *
+ * @return  SUCCESS, bleIncorrectMode or AOA_CMD_STATUS_BAD_LENGTH
+ */
+static bStatus_t AoAReceiver_injectAdv(const AoACmd_Frame *pFrame)
+{
+  gapCentralRoleEvent_t event;
+  uint8_t advData[B_MAX_ADV_LEN];
+
+  if (pFrame->len < 8 || pFrame->len - 8 > B_MAX_ADV_LEN)
+  {
+    return AOA_CMD_STATUS_BAD_LENGTH;
+  }
+
+  if (!scanningStarted)
+  {
+    return bleIncorrectMode;
+  }
+
+  memcpy(advData, &pFrame->data[8], pFrame->len - 8);
+
+  event.deviceInfo.hdr.event = GAP_MSG_EVENT;
+  event.deviceInfo.hdr.status = SUCCESS;
+  event.deviceInfo.opcode = GAP_DEVICE_INFO_EVENT;
+  event.deviceInfo.eventType = GAP_ADRPT_ADV_IND;
+  event.deviceInfo.addrType = pFrame->data[0];
+  memcpy(event.deviceInfo.addr, &pFrame->data[1], B_ADDR_LEN);
+  event.deviceInfo.rssi = (int8_t)pFrame->data[7];
+  event.deviceInfo.dataLen = pFrame->len - 8;
+  event.deviceInfo.pEvtData = advData;
+
+  AoAReceiver_processRoleEvent(&event);
+
+  return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      AoAReceiver_injectConnEvt
+ *
+ * @brief   Handle AOA_CMD_INJECT_CONN_EVT the way the connection event
+ *          callback hands reports over, coalescing included. Reports
+ *          only arrive while registered, like the stack's.
+ *
+ * @param   pFrame - uint16 handle, status, int8 lastRssi
+ *
+ * @return  SUCCESS, bleIncorrectMode or AOA_CMD_STATUS_BAD_LENGTH
+ */
+static bStatus_t AoAReceiver_injectConnEvt(const AoACmd_Frame *pFrame)
+{
+  Gap_ConnEventRpt_t report;
+
+  if (pFrame->len != 4)
+  {
+    return AOA_CMD_STATUS_BAD_LENGTH;
+  }
+
+  if (!CONNECTION_EVENT_IS_REGISTERED)
+  {
+    return bleIncorrectMode;
+  }
+
+  memset(&report, 0, sizeof(report));
+  report.handle = BUILD_UINT16(pFrame->data[0], pFrame->data[1]);
+  report.status = pFrame->data[2];
+  report.lastRssi = (int8_t)pFrame->data[3];
+
+  AoAReceiver_connEvtPost(&report);
+
+  return SUCCESS;
+}
+
+#if !defined( AOA_STREAM )
+// Capture being uploaded by AOA_CMD_INJECT_IQ_xxx
+static aoaReport_t *injectReport = NULL;
+
+/*********************************************************************
+ * @fn      AoAReceiver_injectIq
+ *
+ * @brief   Handle the AOA_CMD_INJECT_IQ_xxx commands. A capture is
+ *          uploaded in packed form, as the completion callback would
+ *          have stored it, and queued as an AOA_REPORT_EVT. AoA
+ *          scanning must be running for the report to be estimated.
+ *
+ *          BEGIN:  array, channel, int8 rssi, shift, slotLen,
+ *                  uint16 numSamples, addr[6]
+ *          DATA:   uint16 first, int8 i, q[1..AOA_CMD_INJECT_IQ_MAX]
+ *          COMMIT: no data
+ *
+ * @param   pFrame - command
+ *
+ * @return  SUCCESS, INVALIDPARAMETER, bleIncorrectMode,
+ *          bleNoResources or AOA_CMD_STATUS_BAD_LENGTH
+ */
+static bStatus_t AoAReceiver_injectIq(const AoACmd_Frame *pFrame)
+{
+  if (pFrame->cmd == AOA_CMD_INJECT_IQ_BEGIN)
+  {
+    uint16_t numSamples;
+
+    if (pFrame->len != 13)
+    {
+      return AOA_CMD_STATUS_BAD_LENGTH;
+    }
+
+    numSamples = BUILD_UINT16(pFrame->data[5], pFrame->data[6]);
+    if (pFrame->data[0] >= ANT_CONFIG_NUM_ARRAYS ||
+        pFrame->data[4] == 0 || numSamples > AOA_REPORT_SAMPLES ||
+        numSamples % pFrame->data[4] != 0)
+    {
+      return INVALIDPARAMETER;
+    }
+
+    // A new upload replaces an uncommitted one
+    if (injectReport == NULL)
+    {
+      if (aoaReportsAllocated >= AOA_NUM_REPORT_BUFS ||
+          (injectReport = MsgPool_alloc(sizeof(aoaReport_t))) == NULL)
+      {
+        return bleNoResources;
+      }
+      aoaReportsAllocated++;
+    }
+
+    injectReport->packetId = AOA_PACKETID_DEFAULT;
+    injectReport->channel = pFrame->data[1];
+    if (pFrame->data[0] == ANT_CONFIG_ARRAY_A1)
+    {
+      injectReport->antConfig = AoAReceiver_antA1Config;
+      injectReport->antResult = AoAReceiver_antA1Result;
+    }
+    else
+    {
+      injectReport->antConfig = AoAReceiver_antA2Config;
+      injectReport->antResult = AoAReceiver_antA2Result;
+    }
+    injectReport->rssi = (int8_t)pFrame->data[2];
+    injectReport->iqShift = pFrame->data[3];
+    injectReport->slotLen = pFrame->data[4];
+    // Recorded by a receiver like this one, from a NUM_AOA_SAMPLES capture
+    injectReport->slotPeriod = NUM_AOA_SAMPLES / injectReport->antConfig->pattern->numPatterns;
+    injectReport->numSamples = numSamples;
+    memset(injectReport->samples, 0, sizeof(injectReport->samples));
+    memcpy(injectReport->advAddr, &pFrame->data[7], B_ADDR_LEN);
+
+    return SUCCESS;
+  }
+
+  if (injectReport == NULL)
+  {
+    return bleIncorrectMode;
+  }
+
+  if (pFrame->cmd == AOA_CMD_INJECT_IQ_DATA)
+  {
+    uint16_t first;
+    uint8_t num;
+
+    if (pFrame->len < 4 || (pFrame->len - 2) % 2 != 0)
+    {
+      return AOA_CMD_STATUS_BAD_LENGTH;
+    }
+
+    first = BUILD_UINT16(pFrame->data[0], pFrame->data[1]);
+    num = (pFrame->len - 2) / 2;
+    if (first + num > injectReport->numSamples)
+    {
+      return INVALIDPARAMETER;
+    }
+
+    memcpy(&injectReport->samples[first], &pFrame->data[2], num * sizeof(AoAIQ_Sample));
+
+    return SUCCESS;
+  }
+
+  // Commit
+  if (pFrame->len != 0)
+  {
+    return AOA_CMD_STATUS_BAD_LENGTH;
+  }
+
+  if (AoAReceiver_enqueueMsg(AOA_REPORT_EVT, SUCCESS, (uint8_t *)injectReport) == FALSE)
+  {
+    AoAReceiver_freeReport(injectReport);
+    injectReport = NULL;
+    return bleNoResources;
+  }
+
+  injectReport = NULL;
+
+  return SUCCESS;
+}
+#endif // !AOA_STREAM
+#endif // AOA_INJECT
+
+#if defined( AOA_BENCH )
+/*********************************************************************
+ * @fn      AoAReceiver_bench
+ *
+ * @brief   Handle AOA_CMD_BENCH: time one code section of the capture
+ *          and discovery paths on synthetic input. Only while idle, not
+ *          discovering and with no report being estimated: the sections
+ *          run with interrupts disabled and share the antenna results,
+ *          the moving average and the device table with the application.
+ *
+ * @param   pFrame  - section, uint16 iterations
+ * @param   pRsp    - filled with unit, uint16 count, uint32 min, avg, max
+ * @param   pRspLen - filled with the response length
+ *
+ * @return  SUCCESS, INVALIDPARAMETER, bleIncorrectMode, bleNoResources
+ *          or AOA_CMD_STATUS_BAD_LENGTH
+ */
+static bStatus_t AoAReceiver_bench(const AoACmd_Frame *pFrame, uint8_t *pRsp,
+                                   uint8_t *pRspLen)
+{
+  aoaBench_t bench;
+  AoABench_Fxn fxn;
+  AoABench_Result result;
+  uint16_t iterations;
+  uint8_t packetId;
+  bool ok = TRUE;
+
+  if (pFrame->len != 3)
+  {
+    return AOA_CMD_STATUS_BAD_LENGTH;
+  }
+
+  iterations = BUILD_UINT16(pFrame->data[1], pFrame->data[2]);
+  if (iterations == 0 || iterations > AOA_BENCH_MAX_ITERATIONS)
+  {
+    return INVALIDPARAMETER;
+  }
+
+  switch (pFrame->data[0])
+  {
+    case AOA_CMD_BENCH_PAIR_ANGLES:
+      fxn = AoAReceiver_benchPairAngles;
+      break;
+
+#if !defined( AOA_STREAM )
+    case AOA_CMD_BENCH_ESTIMATE:
+      fxn = AoAReceiver_benchEstimate;
+      break;
+#endif // !AOA_STREAM
+
+    case AOA_CMD_BENCH_FIND_SVC:
+      fxn = AoAReceiver_benchFindSvc;
+      break;
+
+    case AOA_CMD_BENCH_ADD_DEVICE:
+      fxn = AoAReceiver_benchAddDevice;
+      break;
+
+    case AOA_CMD_BENCH_QUEUE:
+      fxn = AoAReceiver_benchQueue;
+      break;
+
+    case AOA_CMD_BENCH_UTIL_QUEUE:
+      fxn = AoAReceiver_benchUtilQueue;
+      break;
+
+    case AOA_CMD_BENCH_IQ_COPY:
+      fxn = AoAReceiver_benchIqCopy;
+      break;
+
+    default:
+      return INVALIDPARAMETER;
+  }
+
+  if (state != BLE_STATE_IDLE || scanningStarted ||
+      AoAReceiver_antConfigBusy())
+  {
+    return bleIncorrectMode;
+  }
+
+  // The copy reads whatever the driver captured last, its timing does
+  // not depend on the content
+  AOA_getRxIQ(&packetId, &bench.pRaw);
+  if (pFrame->data[0] == AOA_CMD_BENCH_IQ_COPY && bench.pRaw == NULL)
+  {
+    return bleIncorrectMode;
+  }
+
+  bench.pMsg = NULL;
+  if ((bench.pReport = MsgPool_alloc(sizeof(aoaReport_t))) == NULL)
+  {
+    return bleNoResources;
+  }
+
+  switch (pFrame->data[0])
+  {
+    case AOA_CMD_BENCH_PAIR_ANGLES:
+    case AOA_CMD_BENCH_IQ_COPY:
+      ok = AoAReceiver_benchCapture(&bench, ANT_CONFIG_ARRAY_A1);
+      break;
+
+#if !defined( AOA_STREAM )
+    case AOA_CMD_BENCH_ESTIMATE:
+      // Both arrays need pair angles
+      if ((ok = AoAReceiver_benchCapture(&bench, ANT_CONFIG_ARRAY_A2)))
+      {
+        AoAReceiver_benchPairAngles(&bench);
+      }
+      if (ok && (ok = AoAReceiver_benchCapture(&bench, ANT_CONFIG_ARRAY_A1)))
+      {
+        AoAReceiver_benchPairAngles(&bench);
+      }
+      break;
+#endif // !AOA_STREAM
+
+    case AOA_CMD_BENCH_ADD_DEVICE:
+      // Time the refresh of a known device, the common case
+      AoAReceiver_benchAddDevice(&bench);
+      break;
+
+    case AOA_CMD_BENCH_UTIL_QUEUE:
+      ok = ((bench.pMsg = ICall_malloc(sizeof(sbcEvt_t))) != NULL);
+      break;
+
+    default:
+      break;
+  }
+
+  if (ok)
+  {
+#if !defined( AOA_STREAM )
+    AoA_movingAverage savedMa = AoA_ma;
+
+    AoABench_run(fxn, &bench, iterations, &result);
+
+    // Captures after the run must not be averaged with its angles
+    AoA_ma = savedMa;
+#else
+    AoABench_run(fxn, &bench, iterations, &result);
+#endif // !AOA_STREAM
+
+    // Nor be paired with its pair angles
+    AoAReceiver_antA1Result->updated = false;
+    AoAReceiver_antA2Result->updated = false;
+
+    // Dropped if Util_enqueueMsg ran out of memory
+    ok = (pFrame->data[0] != AOA_CMD_BENCH_UTIL_QUEUE || bench.pMsg != NULL);
+  }
+
+  if (bench.pMsg != NULL)
+  {
+    ICall_free(bench.pMsg);
+  }
+  MsgPool_free(bench.pReport);
+
+  if (!ok)
+  {
+    return bleNoResources;
+  }
+
+  pRsp[0] = AoABench_unit();
+  pRsp[1] = LO_UINT16(result.count);
+  pRsp[2] = HI_UINT16(result.count);
+  pRsp = AoAReceiver_putUint32(&pRsp[3], result.min);
+  pRsp = AoAReceiver_putUint32(pRsp, AoABench_avg(&result));
+  AoAReceiver_putUint32(pRsp, result.max);
+  *pRspLen = 15;
+
+  return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      AoAReceiver_benchCapture
+ *
+ * @brief   Fill the bench report with a synthetic capture of one array:
+ *          a clean tone advancing 90 degrees per sample, each antenna
+ *          slot a further 90 degrees ahead so the pairs see a phase
+ *          difference. Uses the current slot map.
+ *
+ * @param   pBench - bench inputs, pReport is filled
+ * @param   array  - ANT_CONFIG_ARRAY_xxx
+ *
+ * @return  FALSE if the slot map does not fit the array
+ */
+static bool AoAReceiver_benchCapture(aoaBench_t *pBench, uint8_t array)
+{
+  static const int8_t tone[4][2] = { { 96, 0 }, { 0, 96 }, { -96, 0 }, { 0, -96 } };
+  aoaReport_t *pReport = pBench->pReport;
+  uint16_t numSamples;
+  uint8_t slotLen;
+  uint16_t n;
+
+  pReport->packetId = AOA_PACKETID_DEFAULT;
+  pReport->channel = 37;
+  pReport->antConfig = AntConfig_get(array);
+  pReport->antResult = AntConfig_getResult(array);
+  memcpy(pReport->advAddr, benchAddr, B_ADDR_LEN);
+
+#if defined( AOA_STREAM )
+  numSamples = NUM_AOA_SAMPLES;
+  slotLen = NUM_AOA_SAMPLES / pReport->antConfig->pattern->numPatterns;
+#else
+  if (!AoAIQ_slotMapInit(&pBench->slotMap, pReport->antConfig->pattern->numPatterns,
+                         NUM_AOA_SAMPLES, aoaSlotSkip, aoaSlotKeep) ||
+      pBench->slotMap.numSlots * pBench->slotMap.keep > AOA_REPORT_SAMPLES)
+  {
+    return FALSE;
+  }
+
+  numSamples = pBench->slotMap.numSlots * pBench->slotMap.keep;
+  slotLen = pBench->slotMap.keep;
+  pReport->rssi = -50;
+  pReport->iqShift = 0;
+  pReport->slotLen = slotLen;
+  pReport->slotPeriod = pBench->slotMap.slotSamples;
+  pReport->numSamples = numSamples;
+#endif // AOA_STREAM
+
+  for (n = 0; n < numSamples; n++)
+  {
+    uint8_t phase = (n + n / slotLen) & 3;
+
+    pReport->samples[n].i = tone[phase][0];
+    pReport->samples[n].q = tone[phase][1];
+  }
+
+  return TRUE;
+}
+
+/*********************************************************************
+ * @fn      AoAReceiver_benchPairAngles
+ *
+ * @brief   Bench section: pair angles of the bench capture, as done per
+ *          report by the estimation worker.
+ *
+ * @param   pArg - aoaBench_t
+ *
+ * @return  none
+ */
+static void AoAReceiver_benchPairAngles(void *pArg)
+{
+  aoaReport_t *pReport = ((aoaBench_t *)pArg)->pReport;
+
+#if defined( AOA_STREAM )
+  AOA_getPairAngles(pReport->channel, pReport->antConfig, pReport->antResult,
+                    pReport->samples);
+#else
+  AoAEst_getPairAngles(pReport->channel,
+                       pReport->rssi,
+                       pReport->antConfig,
+                       pReport->antResult,
+                       pReport->samples,
+                       pReport->numSamples,
+                       pReport->slotLen,
+                       pReport->slotPeriod,
+                       pReport->iqShift);
+#endif // AOA_STREAM
+}
+
+#if !defined( AOA_STREAM )
+/*********************************************************************
+ * @fn      AoAReceiver_benchEstimate
+ *
+ * @brief   Bench section: angle from the pair angles of both arrays.
+ *
+ * @param   pArg - not used
+ *
+ * @return  none
+ */
+static void AoAReceiver_benchEstimate(void *pArg)
+{
+  (void)pArg;
+
+  AoAReceiver_estimateAngle(AoAReceiver_antA1Result, AoAReceiver_antA2Result);
+}
+#endif // !AOA_STREAM
+
+/*********************************************************************
+ * @fn      AoAReceiver_benchFindSvc
+ *
+ * @brief   Bench section: AoA service search in the advertising data of
+ *          a sender, as done per advertisement during discovery.
+ *
+ * @param   pArg - not used
+ *
+ * @return  none
+ */
+static void AoAReceiver_benchFindSvc(void *pArg)
+{
+  (void)pArg;
+
+  AoAReceiver_findSvcUuid(AOAPROFILE_SERVICE_UUID, benchAdvData, sizeof(benchAdvData));
+}
+
+/*********************************************************************
+ * @fn      AoAReceiver_benchAddDevice
+ *
+ * @brief   Bench section: device table update of one advertiser.
+ *
+ * @param   pArg - not used
+ *
+ * @return  none
+ */
+static void AoAReceiver_benchAddDevice(void *pArg)
+{
+  (void)pArg;
+
+  AoAReceiver_addDeviceInfo(benchAddr, ADDRTYPE_RANDOM, -50, 0);
+}
+
+/*********************************************************************
+ * @fn      AoAReceiver_benchQueue
+ *
+ * @brief   Bench section: one message through the application queue the
+ *          way AoAReceiver_enqueueMsg and the task loop pass it, the
+ *          pooled envelope being the queue node. No event is posted.
+ *
+ * @param   pArg - not used
+ *
+ * @return  none
+ */
+static void AoAReceiver_benchQueue(void *pArg)
+{
+  sbcEvt_t *pMsg = MsgPool_alloc(sizeof(sbcEvt_t));
+
+  (void)pArg;
+
+  if (pMsg != NULL)
+  {
+    pMsg->hdr.event = AOA_REPORT_EVT;
+    pMsg->hdr.state = SUCCESS;
+    pMsg->pData = NULL;
+    Queue_put(benchMsgQueue, &pMsg->_elem);
+
+    MsgPool_free(Queue_get(benchMsgQueue));
+  }
+}
+
+/*********************************************************************
+ * @fn      AoAReceiver_benchUtilQueue
+ *
+ * @brief   Bench section: one message through Util_enqueueMsg and
+ *          Util_dequeueMsg, which allocate a queue node from the heap
+ *          per message. No event is posted.
+ *
+ * @param   pArg - aoaBench_t, pMsg is cleared if it was dropped
+ *
+ * @return  none
+ */
+static void AoAReceiver_benchUtilQueue(void *pArg)
+{
+  aoaBench_t *pBench = pArg;
+
+  // Util_enqueueMsg frees the message when it fails
+  if (pBench->pMsg == NULL ||
+      !Util_enqueueMsg(benchMsgQueue, NULL, pBench->pMsg))
+  {
+    pBench->pMsg = NULL;
+    return;
+  }
+
+  Util_dequeueMsg(benchMsgQueue);
+}
+
+/*********************************************************************
+ * @fn      AoAReceiver_benchIqCopy
+ *
+ * @brief   Bench section: copy of a capture out of the driver buffer,
+ *          as done in the RF callback for every capture.
+ *
+ * @param   pArg - aoaBench_t
+ *
+ * @return  none
+ */
+static void AoAReceiver_benchIqCopy(void *pArg)
+{
+  aoaBench_t *pBench = pArg;
+
+#if defined( AOA_STREAM )
+  memcpy(pBench->pReport->samples, pBench->pRaw, NUM_AOA_SAMPLES * sizeof(AoA_IQSample));
+#else
+  pBench->pReport->iqShift = AoAIQ_pack(pBench->pRaw, &pBench->slotMap,
+                                        pBench->pReport->samples);
+#endif // AOA_STREAM
+}
+#endif // AOA_BENCH
+
+/*********************************************************************
+ * @fn      AoAReceiver_processGATTMsg
+ *
+ * @brief   Process GATT messages and events.
+ *
+ * @return  none
+ */
+static void AoAReceiver_processGATTMsg(gattMsgEvent_t *pMsg)
+{
+  // Only the tag link has client procedures, a hub's messages are its
+  // server's business
+  if ((state == BLE_STATE_CONNECTED || state == BLE_STATE_CONNECTED_AOA_SCANNING) &&
+      pMsg->connHandle == connHandle)
+  {
+    // See if GATT server was unable to transmit an ATT response
+    if (pMsg->hdr.status == blePending)
+    {
+      // No HCI buffer was available. App can try to retransmit the response
+      // on the next connection event. Drop it for now.
+      Display_print1(dispHandle, 4, 0, "ATT Rsp dropped %d", pMsg->method);
+    }
+    else if ((pMsg->method == ATT_READ_RSP)   ||
+             ((pMsg->method == ATT_ERROR_RSP) &&
+              (pMsg->msg.errorRsp.reqOpcode == ATT_READ_REQ)))
+    {
+      if (pMsg->method == ATT_ERROR_RSP)
+      {
+        Display_print1(dispHandle, 4, 0, "Read Error %d", pMsg->msg.errorRsp.errCode);
+      }
+      else
+      {
+        // After a successful read, display the read value
+        Display_print1(dispHandle, 4, 0, "Read rsp: %d", pMsg->msg.readRsp.pValue[0]);
+      }
+
+      GATTProcedureInProgress = FALSE;
+    }
+    else if ((pMsg->method == ATT_WRITE_RSP)  ||
+             ((pMsg->method == ATT_ERROR_RSP) &&
+              (pMsg->msg.errorRsp.reqOpcode == ATT_WRITE_REQ)))
+    {
+      GATTProcedureInProgress = FALSE;
+
+      if (pMsg->method == ATT_ERROR_RSP)
+      {
+        Display_print1(dispHandle, 4, 0, "Write Error %d", pMsg->msg.errorRsp.errCode);
+
+        // The sender changed since its handles were cached, find them
+        // again. Other errors, e.g. insufficient encryption on a bonded
+        // reconnect before it is restored, say nothing about the handles.
+        if (gattCacheHit &&
+            (pMsg->msg.errorRsp.errCode == ATT_ERR_INVALID_HANDLE ||
+             pMsg->msg.errorRsp.errCode == ATT_ERR_ATTR_NOT_FOUND))
+        {
+          AoAGattCache_remove(peerAddr, peerAddrType);
+          gattCacheHit = FALSE;
+          aoaSenderActive = FALSE;
+          AoATrigger_senderChanged(connHandle, Clock_getTicks());
+
+          GATTProcedureInProgress = TRUE;
+          AoAReceiver_startDiscovery();
+        }
+      }
+      else
+      {
+        // After a successful write, display the value that was written
+        Display_print1(dispHandle, 4, 0, "Write sent: %d", charVal);
+
+        gattCacheHit = FALSE;
+      }
+    }
+    else if (pMsg->method == ATT_FLOW_CTRL_VIOLATED_EVENT)
+    {
+      // ATT request-response or indication-confirmation flow control is
+      // violated. All subsequent ATT requests or indications will be dropped.
+      // The app is informed in case it wants to drop the connection.
+
+      // Display the opcode of the message that caused the violation.
+      Display_print1(dispHandle, 4, 0, "FC Violated: %d", pMsg->msg.flowCtrlEvt.opcode);
+    }
+    else if (pMsg->method == ATT_MTU_UPDATED_EVENT)
+    {
+      // MTU size updated
+      Display_print1(dispHandle, 4, 0, "MTU Size: %d", pMsg->msg.mtuEvt.MTU);
+    }
+    else if (discState != BLE_DISC_STATE_IDLE)
+    {
+      AoAReceiver_processGATTDiscEvent(pMsg);
+    }
+  } // else - in case a GATT message came after a connection has dropped, ignore it.
+
+  // Needed only for ATT Protocol messages
+  GATT_bm_free(&pMsg->msg, pMsg->method);
+}
+
+
+/*********************************************************************
+ * @fn      AoAReceiver_processPairState
+ *
+ * @brief   Process the new paring state.
+ *
+ * @return  none
+ */
+static void AoAReceiver_processPairState(uint8_t state, uint8_t status)
+{
+  if (state == GAPBOND_PAIRING_STATE_STARTED)
+  {
+    Display_print0(dispHandle, 2, 0, "Pairing started");
+  }
+  else if (state == GAPBOND_PAIRING_STATE_COMPLETE)
+  {
+    if (status == SUCCESS)
+    {
+      Display_print0(dispHandle, 2, 0, "Pairing success");
+    }
+    else
+    {
+      Display_print1(dispHandle, 2, 0, "Pairing fail: %d", status);
+    }
+  }
+  else if (state == GAPBOND_PAIRING_STATE_BONDED)
+  {
+    if (status == SUCCESS)
+    {
+      Display_print0(dispHandle, 2, 0, "Bonding success");
+    }
+  }
+  else if (state == GAPBOND_PAIRING_STATE_BOND_SAVED)
+  {
+    if (status == SUCCESS)
+    {
+      Display_print0(dispHandle, 2, 0, "Bond save success");
+
+      // Discovery finished before the sender was bonded
+      if (charHdl != 0 && discState == BLE_DISC_STATE_IDLE)
+      {
+        AoAGattCache_Handles handles;
+
+        handles.svcStartHdl = svcStartHdl;
+        handles.svcEndHdl = svcEndHdl;
+        handles.charHdl = charHdl;
+        handles.ctrlHdl = ctrlHdl;
+        VOID AoAGattCache_store(peerAddr, peerAddrType, &handles);
+      }
+    }
+    else
+    {
+      Display_print1(dispHandle, 2, 0, "Bond save failed: %d", status);
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      AoAReceiver_processPasscode
+ *
+ * @brief   Process the Passcode request.
+ *
+ * @return  none
+ */
+static void AoAReceiver_processPasscode(uint16_t connectionHandle,
+                                          uint8_t uiOutputs)
+{
+  // This app uses a default passcode. A real-life scenario would handle all
+  // pairing scenarios and likely generate this randomly.
+  uint32_t passcode = B_APP_DEFAULT_PASSCODE;
+
+  // Display passcode to user
+  if (uiOutputs != 0)
+  {
+    Display_print1(dispHandle, 4, 0, "Passcode: %d", passcode);
+  }
+
+  // Send passcode response
+  GAPBondMgr_PasscodeRsp(connectionHandle, SUCCESS, passcode);
+}
+
+/*********************************************************************
+ * @fn      AoAReceiver_startDiscovery
+ *
+ * @brief   Start service discovery.
+ *
+ * @return  none
+ */
+static void AoAReceiver_startDiscovery(void)
+{
+  attExchangeMTUReq_t req;
+
+  // Initialize cached handles
+  svcStartHdl = svcEndHdl = charHdl = ctrlHdl = 0;
+
+  // Both characteristics in one procedure, one request per three
+  // declarations at the default MTU. ATT allows one request at a time,
+  // the MTU exchange follows once AoA can start.
+  if (fastDiscovery)
+  {
+    discState = BLE_DISC_STATE_ALL_CHARS;
+
+    VOID GATT_DiscAllChars(connHandle, GATT_MIN_HANDLE, GATT_MAX_HANDLE, selfEntity);
+    return;
+  }
+
+  discState = BLE_DISC_STATE_MTU;
+
+  // Discover GATT Server's Rx MTU size
+  req.clientRxMTU = maxPduSize - L2CAP_HDR_SIZE;
+
+  // ATT MTU size should be set to the minimum of the Client Rx MTU
+  // and Server Rx MTU values
+  VOID GATT_ExchangeMTU(connHandle, &req, selfEntity);
+}
+
+/*********************************************************************
+ * @fn      AoAReceiver_processGATTDiscEvent
+ *
+ * @brief   Process GATT discovery event
+ *
+ * @return  none
+ */
+static void AoAReceiver_processGATTDiscEvent(gattMsgEvent_t *pMsg)
+{
+  if (discState == BLE_DISC_STATE_MTU)
+  {
+    // MTU size response received, discover aoa service
+    if (pMsg->method == ATT_EXCHANGE_MTU_RSP)
+    {
+      uint8_t uuid[ATT_BT_UUID_SIZE] = { LO_UINT16(AOAPROFILE_SERVICE_UUID),
+                                         HI_UINT16(AOAPROFILE_SERVICE_UUID) };
+
+      // Just in case we're using the default MTU size (23 octets)
+      Display_print1(dispHandle, 4, 0, "MTU Size: %d", ATT_MTU_SIZE);
+
+      discState = BLE_DISC_STATE_SVC;
+
+      // Discovery aoa service
+      VOID GATT_DiscPrimaryServiceByUUID(connHandle, uuid, ATT_BT_UUID_SIZE,
+                                         selfEntity);
+    }
+  }
+  else if (discState == BLE_DISC_STATE_SVC)
+  {
+    // Service found, store handles
+    if (pMsg->method == ATT_FIND_BY_TYPE_VALUE_RSP &&
+        pMsg->msg.findByTypeValueRsp.numInfo > 0)
+    {
+      svcStartHdl = ATT_ATTR_HANDLE(pMsg->msg.findByTypeValueRsp.pHandlesInfo, 0);
+      svcEndHdl = ATT_GRP_END_HANDLE(pMsg->msg.findByTypeValueRsp.pHandlesInfo, 0);
+    }
+
+    // If procedure complete
+    if (((pMsg->method == ATT_FIND_BY_TYPE_VALUE_RSP) &&
+         (pMsg->hdr.status == bleProcedureComplete))  ||
+        (pMsg->method == ATT_ERROR_RSP))
+    {
+      if (svcStartHdl != 0)
+      {
+        attReadByTypeReq_t req;
+
+        // Discover characteristic
+        discState = BLE_DISC_STATE_CHAR;
+
+        req.startHandle = svcStartHdl;
+        req.endHandle = svcEndHdl;
+        req.type.len = ATT_BT_UUID_SIZE;
+        req.type.uuid[0] = LO_UINT16(AOAPROFILE_AOA_START_UUID);
+        req.type.uuid[1] = HI_UINT16(AOAPROFILE_AOA_START_UUID);
+
+        VOID GATT_DiscCharsByUUID(connHandle, &req, selfEntity);
+      }
+    }
+  }
+  else if (discState == BLE_DISC_STATE_CHAR)
+  {
+    // Characteristic found, store handle
+    if ((pMsg->method == ATT_READ_BY_TYPE_RSP) &&
+        (pMsg->msg.readByTypeRsp.numPairs > 0))
+    {
+      charHdl = BUILD_UINT16(pMsg->msg.readByTypeRsp.pDataList[3],
+                             pMsg->msg.readByTypeRsp.pDataList[4]);
+    }
+
+    // If procedure complete
+    if (((pMsg->method == ATT_READ_BY_TYPE_RSP) &&
+         (pMsg->hdr.status == bleProcedureComplete))  ||
+        (pMsg->method == ATT_ERROR_RSP))
+    {
+      if (charHdl != 0)
+      {
+        attReadByTypeReq_t req;
+
+        // Discover the control characteristic, legacy senders lack it
+        discState = BLE_DISC_STATE_CTRL;
+
+        req.startHandle = svcStartHdl;
+        req.endHandle = svcEndHdl;
+        req.type.len = ATT_BT_UUID_SIZE;
+        req.type.uuid[0] = LO_UINT16(AOAPROFILE_AOA_CONTROL_UUID);
+        req.type.uuid[1] = HI_UINT16(AOAPROFILE_AOA_CONTROL_UUID);
+
+        VOID GATT_DiscCharsByUUID(connHandle, &req, selfEntity);
+      }
+      else
+      {
+        discState = BLE_DISC_STATE_IDLE;
+      }
+    }
+  }
+  else if (discState == BLE_DISC_STATE_CTRL)
+  {
+    // Control characteristic found, store handle
+    if ((pMsg->method == ATT_READ_BY_TYPE_RSP) &&
+        (pMsg->msg.readByTypeRsp.numPairs > 0))
+    {
+      ctrlHdl = BUILD_UINT16(pMsg->msg.readByTypeRsp.pDataList[3],
+                             pMsg->msg.readByTypeRsp.pDataList[4]);
+    }
+
+    // If procedure complete. Not found ends in an error response.
+    if (((pMsg->method == ATT_READ_BY_TYPE_RSP) &&
+         (pMsg->hdr.status == bleProcedureComplete))  ||
+        (pMsg->method == ATT_ERROR_RSP))
+    {
+      AoAGattCache_Handles handles;
+
+      discState = BLE_DISC_STATE_IDLE;
+
+      // Kept for the next link if the sender is bonded, otherwise once
+      // the bond is saved
+      handles.svcStartHdl = svcStartHdl;
+      handles.svcEndHdl = svcEndHdl;
+      handles.charHdl = charHdl;
+      handles.ctrlHdl = ctrlHdl;
+      VOID AoAGattCache_store(peerAddr, peerAddrType, &handles);
+
+      AoAReceiver_discComplete();
+    }
+  }
+  else if (discState == BLE_DISC_STATE_ALL_CHARS)
+  {
+    // Entries are handle, properties, value handle and UUID. Only 16-bit
+    // UUIDs are of interest.
+    if ((pMsg->method == ATT_READ_BY_TYPE_RSP) &&
+        (pMsg->msg.readByTypeRsp.numPairs > 0) &&
+        (pMsg->msg.readByTypeRsp.len == 5 + ATT_BT_UUID_SIZE))
+    {
+      uint8_t *pEntry = pMsg->msg.readByTypeRsp.pDataList;
+      uint16_t i;
+
+      for (i = 0; i < pMsg->msg.readByTypeRsp.numPairs; i++, pEntry += 5 + ATT_BT_UUID_SIZE)
       {
-        AoAReceiver_RegistertToAllConnectionEvent(FOR_AOA_SCAN);
+        uint16_t uuid = BUILD_UINT16(pEntry[5], pEntry[6]);
+
+        if (uuid == AOAPROFILE_AOA_START_UUID)
+        {
+          charHdl = BUILD_UINT16(pEntry[3], pEntry[4]);
+        }
+        else if (uuid == AOAPROFILE_AOA_CONTROL_UUID)
+        {
+          ctrlHdl = BUILD_UINT16(pEntry[3], pEntry[4]);
+        }
       }
+    }
+
+    // If procedure complete
+    if (((pMsg->method == ATT_READ_BY_TYPE_RSP) &&
+         (pMsg->hdr.status == bleProcedureComplete))  ||
+        (pMsg->method == ATT_ERROR_RSP))
+    {
+      discState = BLE_DISC_STATE_IDLE;
+
+      if (charHdl != 0)
+      {
+        AoAGattCache_Handles handles;
+
+        // The service range is not needed without the step by step
+        // discovery, it stays 0 in the cache
+        handles.svcStartHdl = svcStartHdl;
+        handles.svcEndHdl = svcEndHdl;
+        handles.charHdl = charHdl;
+        handles.ctrlHdl = ctrlHdl;
+        VOID AoAGattCache_store(peerAddr, peerAddrType, &handles);
 
+        AoAReceiver_discComplete();
+      }
+    }
+  }
+  else if (discState == BLE_DISC_STATE_MTU_LATE)
+  {
+    if ((pMsg->method == ATT_EXCHANGE_MTU_RSP) ||
+        ((pMsg->method == ATT_ERROR_RSP) &&
+         (pMsg->msg.errorRsp.reqOpcode == ATT_EXCHANGE_MTU_REQ)))
+    {
+      discState = BLE_DISC_STATE_IDLE;
       GATTProcedureInProgress = FALSE;
+
+      // A legacy start write waits for the exchange
+      if (aoaConnectedScanRequest && !autoAoaEnabled && !aoaSenderActive)
+      {
+        AoAReceiver_aoaEnableSender(TRUE);
+      }
     }
+  }
+}
+
+/*********************************************************************
+ * @fn      AoAReceiver_discComplete
+ *
+ * @brief   The sender's handles are known, by discovery or from the
+ *          cache. Resume the AoA the user asked for.
+ *
+ * @return  none
+ */
+static void AoAReceiver_discComplete(void)
+{
+  Display_print2(dispHandle, 4, 0, "Sender control: %s%s",
+                 (ctrlHdl != 0) ? "extended" : "legacy",
+                 gattCacheHit ? ", cached" : "");
+
+  // This is done to cover the case where we were disconnected
+  // In this case, if the user requested some form of AoA, we will automatically register
+  if (autoAoaEnabled || aoaConnectedScanRequest)
+  {
+    AoAReceiver_RegistertToAllConnectionEvent(FOR_AOA_SCAN);
+  }
+
+  GATTProcedureInProgress = FALSE;
+
+  linkDiscMs = AoAReceiver_elapsedMs(linkUpTime);
 
-    discState = BLE_DISC_STATE_IDLE;
+  // A sender picked by auto-connect goes straight to connected AoA
+  if (discAutoAoa)
+  {
+    AoAReceiver_connAoaScan(TRUE);
+  }
+  // Rediscovered after stale cached handles, ask again
+  else if (aoaConnectedScanRequest && !autoAoaEnabled && !aoaSenderActive)
+  {
+    AoAReceiver_aoaEnableSender(TRUE);
+  }
+
+  // Fast discovery skipped the MTU exchange. Worth it only when the link
+  // can carry more than the default MTU, and only when no write request
+  // is outstanding.
+  if (fastDiscovery && !GATTProcedureInProgress &&
+      maxPduSize - L2CAP_HDR_SIZE > ATT_MTU_SIZE)
+  {
+    attExchangeMTUReq_t req;
+
+    req.clientRxMTU = maxPduSize - L2CAP_HDR_SIZE;
+
+    if (GATT_ExchangeMTU(connHandle, &req, selfEntity) == SUCCESS)
+    {
+      discState = BLE_DISC_STATE_MTU_LATE;
+      GATTProcedureInProgress = TRUE;
+    }
   }
 }
 
+/*********************************************************************
+ * @fn      AoAReceiver_elapsedMs
+ *
+ * @brief   Milliseconds since a Clock tick count, at least 1 so that 0
+ *          can mean not reached.
+ *
+ * @param   since - Clock_getTicks() value
+ *
+ * @return  elapsed ms
+ */
+static uint32_t AoAReceiver_elapsedMs(uint32_t since)
+{
+  uint32_t ms = (Clock_getTicks() - since) / (1000 / Clock_tickPeriod);
+
+  return (ms != 0) ? ms : 1;
+}
+
 /*********************************************************************
  * @fn      AoAReceiver_findSvcUuid
  *
@@ -1688,33 +4263,105 @@ static bool AoAReceiver_findSvcUuid(uint16_t uuid, uint8_t *pData, uint8_t dataL
 /*********************************************************************
  * @fn      AoAReceiver_addDeviceInfo
  *
- * @brief   Add a device to the device discovery result list
+ * @brief   Add a device to the device table or refresh its entry
+ *
+ * @param   pAddr    - device address
+ * @param   addrType - device address type
+ * @param   rssi     - RSSI of the advertisement
+ * @param   flags    - DEV_TABLE_FLAG_xxx seen in the advertisement
+ *
+ * @return  TRUE if this is the first time the device is seen as an
+ *          AoA sender
+ */
+static bool AoAReceiver_addDeviceInfo(uint8_t *pAddr, uint8_t addrType,
+                                      int8_t rssi, uint8_t flags)
+{
+  DevTable_Entry *pDev = DevTable_find(pAddr);
+  bool knownAoa = (pDev != NULL) && (pDev->flags & DEV_TABLE_FLAG_AOA);
+
+  // A full table keeps the devices it has until they age out
+  pDev = DevTable_update(pAddr, addrType, rssi, flags, Clock_getTicks());
+
+  return (pDev != NULL) && !knownAoa && (pDev->flags & DEV_TABLE_FLAG_AOA);
+}
+
+/*********************************************************************
+ * @fn      AoAReceiver_newAoaDevice
+ *
+ * @brief   Report an AoA sender as soon as discovery sees it, and
+ *          connect to it if auto-connect is enabled
+ *
+ * @param   pAddr    - device address
+ * @param   addrType - device address type
+ * @param   rssi     - RSSI of the advertisement
  *
  * @return  none
  */
-static void AoAReceiver_addDeviceInfo(uint8_t *pAddr, uint8_t addrType)
+static void AoAReceiver_newAoaDevice(uint8_t *pAddr, uint8_t addrType, int8_t rssi)
 {
-  uint8_t i;
+  uint8_t ind[2 + B_ADDR_LEN];
+
+  ind[0] = addrType;
+  memcpy(&ind[1], pAddr, B_ADDR_LEN);
+  ind[1 + B_ADDR_LEN] = (uint8_t)rssi;
+  AoACmd_sendInd(AOA_CMD_IND_DEVICE, ind, sizeof(ind));
 
-  // If result count not at max
-  if (scanRes < DEFAULT_MAX_SCAN_RES)
+  Display_print1(dispHandle, 2, 0, "Devices Found %d", DevTable_count());
+
+  if (discAutoConnect && !discConnectPending && state == BLE_STATE_IDLE &&
+      AoAReceiver_filterMatch(pAddr))
   {
-    // Check if device is already in scan results
-    for (i = 0; i < scanRes; i++)
-    {
-      if (memcmp(pAddr, devList[i].addr , B_ADDR_LEN) == 0)
-      {
-        return;
-      }
-    }
+    // Links cannot be made while scanning, connect once the round ends
+    memcpy(discConnectAddr, pAddr, B_ADDR_LEN);
+    discConnectAddrType = addrType;
+    discConnectPending = TRUE;
+
+    GAPCentralRole_CancelDiscovery();
+  }
+}
+
+/*********************************************************************
+ * @fn      AoAReceiver_restartDiscovery
+ *
+ * @brief   Start the next round of continuous discovery
+ *
+ * @return  none
+ */
+static void AoAReceiver_restartDiscovery(void)
+{
+  if (state != BLE_STATE_IDLE || scanningStarted)
+  {
+    return;
+  }
+
+  scanningStarted = TRUE;
 
-    // Add addr to scan result list
-    memcpy(devList[scanRes].addr, pAddr, B_ADDR_LEN);
-    devList[scanRes].addrType = addrType;
+  DevTable_age(Clock_getTicks(),
+               DEFAULT_DEV_TABLE_MAX_AGE * (1000 / Clock_tickPeriod));
+
+  GAPCentralRole_StartDiscovery(DEFAULT_DISCOVERY_MODE,
+                                DEFAULT_DISCOVERY_ACTIVE_SCAN,
+                                DEFAULT_DISCOVERY_WHITE_LIST);
+}
+
+/*********************************************************************
+ * @fn      AoAReceiver_stopDiscovery
+ *
+ * @brief   Stop continuous discovery and cancel the running round
+ *
+ * @return  SUCCESS
+ */
+static bStatus_t AoAReceiver_stopDiscovery(void)
+{
+  contDiscovery = FALSE;
+  discConnectPending = FALSE;
 
-    // Increment scan result count
-    scanRes++;
+  if (scanningStarted)
+  {
+    GAPCentralRole_CancelDiscovery();
   }
+
+  return SUCCESS;
 }
 
 /*********************************************************************
@@ -1751,12 +4398,15 @@ static void AoAReceiver_pairStateCB(uint16_t connHandle, uint8_t state, uint8_t
   uint8_t *pData;
 
   // Allocate space for the event data.
-  if ((pData = ICall_malloc(sizeof(uint8_t))))
+  if ((pData = MsgPool_alloc(sizeof(uint8_t))))
   {
     *pData = status;
 
     // Queue the event.
-    AoAReceiver_enqueueMsg(AOA_PAIRING_STATE_EVT, state, pData);
+    if (AoAReceiver_enqueueMsg(AOA_PAIRING_STATE_EVT, state, pData) == FALSE)
+    {
+      MsgPool_free(pData);
+    }
   }
 }
 
@@ -1773,12 +4423,15 @@ static void AoAReceiver_passcodeCB(uint8_t *deviceAddr, uint16_t connHandle,
   uint8_t *pData;
 
   // Allocate space for the passcode event.
-  if ((pData = ICall_malloc(sizeof(uint8_t))))
+  if ((pData = MsgPool_alloc(sizeof(uint8_t))))
   {
     *pData = uiOutputs;
 
     // Enqueue the event.
-    AoAReceiver_enqueueMsg(AOA_PASSCODE_NEEDED_EVT, 0, pData);
+    if (AoAReceiver_enqueueMsg(AOA_PASSCODE_NEEDED_EVT, 0, pData) == FALSE)
+    {
+      MsgPool_free(pData);
+    }
   }
 }
 
@@ -1797,32 +4450,117 @@ static void AoAReceiver_startDiscHandler(UArg a0)
 }
 
 /*********************************************************************
- * @fn      AoAReceiver_keyChangeHandler
- *
- * @brief   Key event handler function
+ * @fn      AoAReceiver_keyChangeHandler
+ *
+ * @brief   Key event handler function
+ *
+ * @param   a0 - ignored
+ *
+ * @return  none
+ */
+static void AoAReceiver_keyChangeHandler(uint8 keys)
+{
+  AoAReceiver_enqueueMsg(AOA_KEY_CHANGE_EVT, keys, NULL);
+}
+
+/*********************************************************************
+ * @fn      AoAReceiver_connEvtCB
+ *
+ * @brief   Connection event callback.
+ *
+ * @param pReport pointer to connection event report
+ */
+static void AoAReceiver_connEvtCB(Gap_ConnEventRpt_t *pReport)
+{
+  AoAReceiver_connEvtPost(pReport);
+
+  ICall_free(pReport);
+}
+
+/*********************************************************************
+ * @fn      AoAReceiver_connEvtPost
+ *
+ * @brief   Hand a connection event report to the app task. The report
+ *          is copied, the caller keeps it.
+ *
+ * @param pReport pointer to connection event report
+ */
+static void AoAReceiver_connEvtPost(const Gap_ConnEventRpt_t *pReport)
+{
+  Gap_ConnEventRpt_t *pCopy;
+
+#if defined( AOA_HUB_LINK )
+  // Reports come for every link, the hub's have nothing to time
+  if (pReport->handle == hubConnHandle)
+  {
+    return;
+  }
+#endif // AOA_HUB_LINK
+
+  // Only the latest report matters to the app task. Overwrite whatever
+  // it has not consumed yet.
+  if (connEvtCoalesce && pReport->handle < AOA_CONN_EVT_SLOTS)
+  {
+    connEvtSlot_t *pSlot = &connEvtSlots[pReport->handle];
+    UInt key = Hwi_disable();
+
+    if (pSlot->pending)
+    {
+      connEvtCoalescedCnt++;
+    }
+
+    pSlot->report = *pReport;
+    pSlot->pending = TRUE;
+
+    Hwi_restore(key);
+
+    Event_post(syncEvent, AOA_CONN_EVT_SLOT_EVT);
+  }
+  // Move the report into the pool so the stack's buffer is released
+  // right away
+  else if ((pCopy = MsgPool_alloc(sizeof(Gap_ConnEventRpt_t))) != NULL)
+  {
+    *pCopy = *pReport;
+
+    // Enqueue the event for processing in the app context.
+    if (AoAReceiver_enqueueMsg(AOA_CONN_EVT, 0, (uint8_t *)pCopy) == FALSE)
+    {
+      MsgPool_free(pCopy);
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      AoAReceiver_processConnEvtSlots
  *
- * @param   a0 - ignored
+ * @brief   Process the latest connection event report of every
+ *          connection that has one pending.
  *
  * @return  none
  */
-static void AoAReceiver_keyChangeHandler(uint8 keys)
+static void AoAReceiver_processConnEvtSlots(void)
 {
-  AoAReceiver_enqueueMsg(AOA_KEY_CHANGE_EVT, keys, NULL);
-}
+  uint8_t i;
 
-/*********************************************************************
- * @fn      AoAReceiver_connEvtCB
- *
- * @brief   Connection event callback.
- *
- * @param pReport pointer to connection event report
- */
-static void AoAReceiver_connEvtCB(Gap_ConnEventRpt_t *pReport)
-{
-  // Enqueue the event for processing in the app context.
-  if(AoAReceiver_enqueueMsg(AOA_CONN_EVT, 0, (uint8_t *)pReport) == FALSE)
+  for (i = 0; i < AOA_CONN_EVT_SLOTS; i++)
   {
-    ICall_free(pReport);
+    Gap_ConnEventRpt_t report;
+    bool pending;
+    UInt key = Hwi_disable();
+
+    pending = connEvtSlots[i].pending;
+    if (pending)
+    {
+      report = connEvtSlots[i].report;
+      connEvtSlots[i].pending = FALSE;
+    }
+
+    Hwi_restore(key);
+
+    if (pending)
+    {
+      AoAReceiver_processConnEvt(&report);
+    }
   }
 }
 
@@ -1841,22 +4579,37 @@ static void AoAReceiver_processConnEvt(Gap_ConnEventRpt_t *pReport)
     // This will ensure that AOA receiver and sender are synchronized
     if (pReport->status == GAP_CONN_EVT_STAT_SUCCESS)
     {
+      AoAReceiver_connCtrlPoll(pReport->handle);
+
       if (autoAoaEnabled && aoaConnectedScanRequest)
       {
-        AoAReceiver_calculateRSSI(pReport->lastRssi);
+        uint8_t action = aoaSenderActive ? AOA_TRIGGER_CAPTURE : AOA_TRIGGER_NONE;
+
         // Request AoA from sender if the application requested auto-AoA
-        // and user has not requested a manual scan (key press)
-        if (aoaReceiverRssi.currentRssi >= AOA_RSSI_THRESHOLD && aoaSenderActive)
+        // and user has not requested a manual scan (key press). The
+        // engine decides, with the peer's own filter and timers.
+        if (AOA_IS_VALID_RSSI(pReport->lastRssi))
         {
-          AoAReceiver_aoaStart();
+          action = AoATrigger_update(pReport->handle, pReport->lastRssi,
+                                     aoaSenderActive, Clock_getTicks());
         }
-        else if (aoaReceiverRssi.currentRssi >= AOA_RSSI_THRESHOLD && !aoaSenderActive)
-        {
-          AoAReceiver_aoaEnableSender(TRUE);
-        }
-        else if (aoaReceiverRssi.currentRssi < (AOA_RSSI_THRESHOLD + AOA_RSSI_THRESHOLD_HYSTERESIS) && aoaSenderActive)
+
+        switch (action)
         {
-          AoAReceiver_aoaEnableSender(FALSE);
+          case AOA_TRIGGER_CAPTURE:
+            AoAReceiver_aoaStart();
+            break;
+
+          case AOA_TRIGGER_ENABLE:
+            AoAReceiver_aoaEnableSender(TRUE);
+            break;
+
+          case AOA_TRIGGER_DISABLE:
+            AoAReceiver_aoaEnableSender(FALSE);
+            break;
+
+          default:
+            break;
         }
       }
       else if (aoaConnectedScanRequest) // Key press
@@ -1881,7 +4634,7 @@ static void AoAReceiver_processConnEvt(Gap_ConnEventRpt_t *pReport)
 static uint8_t AoAReceiver_enqueueMsg(uint16_t event, uint8_t state,
                                         uint8_t *pData)
 {
-  sbcEvt_t *pMsg = ICall_malloc(sizeof(sbcEvt_t));
+  sbcEvt_t *pMsg = MsgPool_alloc(sizeof(sbcEvt_t));
 
   // Create dynamic pointer to message.
   if (pMsg)
@@ -1890,8 +4643,13 @@ static uint8_t AoAReceiver_enqueueMsg(uint16_t event, uint8_t state,
     pMsg->hdr.state = state;
     pMsg->pData = pData;
 
-    // Enqueue the message.
-    return Util_enqueueMsg(appMsgQueue, syncEvent, (uint8_t *)pMsg);
+    // Enqueue the message. The envelope doubles as the queue node.
+    Queue_put(appMsgQueue, &pMsg->_elem);
+
+    // Wake up the application thread event handler.
+    Event_post(syncEvent, AOA_QUEUE_EVT);
+
+    return TRUE;
   }
 
   return FALSE;
@@ -1911,13 +4669,180 @@ static void AoAReceiver_displayEstimatedAngle(uint8_t *aoaAdvAddr, AoA_Sample Ao
 {
   AoAReceiver_calculateRSSI(AoA.rssi);
 
-//  Display_print0(dispHandle, 8, 0, "%s:{fuccc}");
-  Display_print5(dispHandle, 8, 0, "%s: {\"aoa\": %d, \"rssi\": %d, \"antenna\": %d, \"channel\": %d}\n\r",
-                 Util_convertBdAddr2Str(aoaAdvAddr),
-                 AoA.angle,
-                 AoA.rssi,
-                 AoA.antenna,
-                 AoA.channel);
+  if (AoA.hasElevation)
+  {
+    Display_printf(dispHandle, 8, 0, "%s: {\"aoa\": %d, \"elevation\": %d, \"rssi\": %d, \"antenna\": %d, \"channel\": %d}\n\r",
+                   Util_convertBdAddr2Str(aoaAdvAddr),
+                   AoA.angle,
+                   AoA.elevation,
+                   AoA.rssi,
+                   AoA.antenna,
+                   AoA.channel);
+  }
+  else
+  {
+    Display_print5(dispHandle, 8, 0, "%s: {\"aoa\": %d, \"rssi\": %d, \"antenna\": %d, \"channel\": %d}\n\r",
+                   Util_convertBdAddr2Str(aoaAdvAddr),
+                   AoA.angle,
+                   AoA.rssi,
+                   AoA.antenna,
+                   AoA.channel);
+  }
+}
+
+/*********************************************************************
+* @fn      AoAReceiver_sendAngle
+*
+* @brief   Send an angle as AOA_CMD_IND_ANGLE. Besides the moving
+*          average it carries the angle of this capture pair alone,
+*          which is what test data is checked against.
+*
+* @param   pAngle - angle from the estimation worker
+*
+* @return  none
+*/
+static void AoAReceiver_sendAngle(const aoaAngleRpt_t *pAngle)
+{
+  const AoA_Sample *pSample = &pAngle->sample;
+  int16_t elevation = AOA_CMD_NO_ELEVATION;
+  int16_t currentElevation = AOA_CMD_NO_ELEVATION;
+  uint8_t ind[B_ADDR_LEN + 13];
+  uint8_t *p = &ind[B_ADDR_LEN];
+
+  if (pSample->hasElevation)
+  {
+    elevation = pSample->elevation;
+    currentElevation = pSample->currentElevation;
+  }
+
+  memcpy(ind, pAngle->advAddr, B_ADDR_LEN);
+  *p++ = LO_UINT16(pSample->angle);
+  *p++ = HI_UINT16(pSample->angle);
+  *p++ = LO_UINT16(pSample->currentangle);
+  *p++ = HI_UINT16(pSample->currentangle);
+  *p++ = LO_UINT16(elevation);
+  *p++ = HI_UINT16(elevation);
+  *p++ = LO_UINT16(currentElevation);
+  *p++ = HI_UINT16(currentElevation);
+  *p++ = (uint8_t)pSample->rssi;
+  *p++ = pSample->channel;
+  *p++ = pSample->antenna;
+  *p++ = LO_UINT16(pAngle->estimateUs);
+  *p++ = HI_UINT16(pAngle->estimateUs);
+
+  AoACmd_sendInd(AOA_CMD_IND_ANGLE, ind, sizeof(ind));
+}
+
+/*********************************************************************
+* @fn      AoAReceiver_fuseAngle
+*
+* @brief   Add the angle of a capture pair to its tag's channel cycle.
+*          At the end of the cycle the sample is rewritten: angle and
+*          elevation become the fused ones, taking the place of the
+*          moving average, and rssi, channel, antenna and signal
+*          strength those of the strongest pair. currentangle keeps the
+*          angle of the last pair.
+*
+* @param   pAngle - angle from the estimation worker, updated
+*
+* @return  TRUE if the cycle ended and pAngle holds the fused angle
+*/
+static bool AoAReceiver_fuseAngle(aoaAngleRpt_t *pAngle)
+{
+  AoA_Sample *pSample = &pAngle->sample;
+  AoAFusion_Angle angle;
+  AoAFusion_Result fused;
+
+  angle.azimuth = pSample->currentangle;
+  angle.elevation = pSample->currentElevation;
+  angle.hasElevation = pSample->hasElevation;
+  angle.channel = pSample->channel;
+  angle.antenna = pSample->antenna;
+  angle.rssi = pSample->rssi;
+  angle.amplitude = (pSample->signalStrength > 0) ? pSample->signalStrength : 0;
+
+  if (!AoAFusion_add(pAngle->advAddr, &angle, &fused))
+  {
+    return FALSE;
+  }
+
+  pSample->angle = fused.angle.azimuth;
+  pSample->elevation = fused.angle.elevation;
+  pSample->hasElevation = fused.angle.hasElevation;
+  pSample->channel = fused.angle.channel;
+  pSample->antenna = fused.angle.antenna;
+  pSample->rssi = fused.angle.rssi;
+  pSample->signalStrength = fused.angle.amplitude;
+
+  return TRUE;
+}
+
+/*********************************************************************
+* @fn      AoAReceiver_fusionCycle
+*
+* @brief   Angles per fusion cycle: the distinct channels of the list,
+*          which the pairs visit in turn. A channel listed twice would
+*          otherwise end every cycle early on the repeat.
+*
+* @return  channels per cycle
+*/
+static uint8_t AoAReceiver_fusionCycle(void)
+{
+  uint8_t numDistinct = 0;
+  uint8_t i;
+
+  for (i = 0; i < numChannels; i++)
+  {
+    if (memchr(channels, channels[i], i) == NULL)
+    {
+      numDistinct++;
+    }
+  }
+
+  return numDistinct;
+}
+
+/*********************************************************************
+* @fn      AoAReceiver_sendIq
+*
+* @brief   Send a capture as AOA_CMD_IND_IQ_BEGIN and AOA_CMD_IND_IQ_DATA,
+*          laid out like the AOA_CMD_INJECT_IQ_xxx commands so a recorded
+*          capture can be injected back unchanged.
+*
+* @param   aoaReport - packed capture
+*
+* @return  none
+*/
+static void AoAReceiver_sendIq(const aoaReport_t *aoaReport)
+{
+  uint8_t ind[2 + AOA_CMD_INJECT_IQ_MAX * sizeof(AoAIQ_Sample)];
+  uint16_t first;
+  uint16_t num;
+
+  ind[0] = (aoaReport->antConfig == AoAReceiver_antA2Config) ? ANT_CONFIG_ARRAY_A2
+                                                             : ANT_CONFIG_ARRAY_A1;
+  ind[1] = aoaReport->channel;
+  ind[2] = (uint8_t)aoaReport->rssi;
+  ind[3] = aoaReport->iqShift;
+  ind[4] = aoaReport->slotLen;
+  ind[5] = LO_UINT16(aoaReport->numSamples);
+  ind[6] = HI_UINT16(aoaReport->numSamples);
+  memcpy(&ind[7], aoaReport->advAddr, B_ADDR_LEN);
+  AoACmd_sendInd(AOA_CMD_IND_IQ_BEGIN, ind, 7 + B_ADDR_LEN);
+
+  for (first = 0; first < aoaReport->numSamples; first += num)
+  {
+    num = aoaReport->numSamples - first;
+    if (num > AOA_CMD_INJECT_IQ_MAX)
+    {
+      num = AOA_CMD_INJECT_IQ_MAX;
+    }
+
+    ind[0] = LO_UINT16(first);
+    ind[1] = HI_UINT16(first);
+    memcpy(&ind[2], &aoaReport->samples[first], num * sizeof(AoAIQ_Sample));
+    AoACmd_sendInd(AOA_CMD_IND_IQ_DATA, ind, 2 + num * sizeof(AoAIQ_Sample));
+  }
 }
 
 /*********************************************************************
@@ -1933,8 +4858,8 @@ static AoA_Sample AoAReceiver_estimateAngle(const AoA_AntennaResult *AoAReceiver
                                             const AoA_AntennaResult *AoAReceiver_antA2Result)
 {
   AoA_Sample AoA;
+  AoAEst_Direction dir;
 
-  static AoA_movingAverage AoA_ma;
   uint8_t AoA_ma_size = sizeof(AoA_ma.array) / sizeof(AoA_ma.array[0]);
 
   // Compensate for different carrier frequencies (RF channels)
@@ -1967,18 +4892,29 @@ static AoA_Sample AoAReceiver_estimateAngle(const AoA_AntennaResult *AoAReceiver
           break;
   }
 
-  // Calculate AoA for each antenna array
-  const int16_t AoA_A1 = ((AoAReceiver_antA1Result->pairAngle[0] + AoAReceiver_antA1Result->pairAngle[1]) / 2) + 45 + AoA_A1_freqComp;
-  const int16_t AoA_A2 = ((AoAReceiver_antA2Result->pairAngle[0] + AoAReceiver_antA2Result->pairAngle[1]) / 2) - 45 - AoA_A2_freqComp;
+  // Calculate AoA for each antenna array. The pair angles are -180..180
+  // each, the offsets can take their sum out of that range.
+  int16_t AoA_A1 = AoAReceiver_wrapAngle(((AoAReceiver_antA1Result->pairAngle[0] + AoAReceiver_antA1Result->pairAngle[1]) / 2) + 45 + AoA_A1_freqComp);
+  int16_t AoA_A2 = AoAReceiver_wrapAngle(((AoAReceiver_antA2Result->pairAngle[0] + AoAReceiver_antA2Result->pairAngle[1]) / 2) - 45 - AoA_A2_freqComp);
   // Calculate average signal strength
   const int16_t signalStrength_A1 = (AoAReceiver_antA1Result->signalStrength[0] + AoAReceiver_antA1Result->signalStrength[1]) / 2;
 //  const int16_t signalStrength_A2 = (AoAReceiver_antA1Result->signalStrength[0] + AoAReceiver_antA1Result->signalStrength[1]) / 2;
   const int16_t signalStrength_A2 = (AoAReceiver_antA2Result->signalStrength[0] + AoAReceiver_antA2Result->signalStrength[1]) / 2;
 
 
+  dir.hasElevation = false;
+
   // Signal strength is higher on A1 vs A2
   if (AoAReceiver_antA1Result->rssi > AoAReceiver_antA2Result->rssi)
   {
+      // Arrays with known element positions are solved geometrically,
+      // the channel is part of the solution
+      if (AoAEst_getDirection(AntConfig_getSolver(ANT_CONFIG_ARRAY_A1),
+                              AoAReceiver_antA1Result, &dir))
+      {
+          AoA_A1 = dir.azimuth;
+      }
+
       // Use AoA from Antenna Array A1
       AoA_ma.array[AoA_ma.idx] = AoA_A1;
       AoA_ma.currentAoA = AoA_A1;
@@ -1991,6 +4927,12 @@ static AoA_Sample AoAReceiver_estimateAngle(const AoA_AntennaResult *AoAReceiver
   // Signal strength is higher on A2 vs A1
   else
   {
+      if (AoAEst_getDirection(AntConfig_getSolver(ANT_CONFIG_ARRAY_A2),
+                              AoAReceiver_antA2Result, &dir))
+      {
+          AoA_A2 = dir.azimuth;
+      }
+
       // Use AoA from Antenna Array A2
       AoA_ma.array[AoA_ma.idx] = AoA_A2;
       AoA_ma.currentAoA = AoA_A2;
@@ -2003,14 +4945,30 @@ static AoA_Sample AoAReceiver_estimateAngle(const AoA_AntennaResult *AoAReceiver
 
   // Add new AoA to moving average
   AoA_ma.array[AoA_ma.idx] = AoA_ma.currentAoA;
+  AoA_ma.elevation[AoA_ma.idx] = dir.hasElevation ? dir.elevation : 0;
 
-  // Calculate new moving average
+  // Calculate new moving average, of the offsets from the current angle
+  // so that angles either side of 180 average to 180, not 0
   AoA_ma.AoAsum = 0;
   for(uint8_t i = 0; i < AoA_ma_size; i++)
   {
-      AoA_ma.AoAsum += AoA_ma.array[i];
+      AoA_ma.AoAsum += AoAReceiver_wrapAngle(AoA_ma.array[i] - AoA_ma.currentAoA);
+  }
+  AoA_ma.AoA = AoAReceiver_wrapAngle(AoA_ma.currentAoA + AoA_ma.AoAsum / AoA_ma_size);
+
+  AoA.hasElevation = dir.hasElevation;
+  AoA.currentElevation = dir.hasElevation ? dir.elevation : 0;
+  AoA.elevation = 0;
+  if (dir.hasElevation)
+  {
+      int32_t elevationSum = 0;
+
+      for(uint8_t i = 0; i < AoA_ma_size; i++)
+      {
+          elevationSum += AoA_ma.elevation[i];
+      }
+      AoA.elevation = elevationSum / AoA_ma_size;
   }
-  AoA_ma.AoA = AoA_ma.AoAsum / AoA_ma_size;
 
   // Update moving average index
   if(AoA_ma.idx >= (AoA_ma_size - 1))
@@ -2031,6 +4989,31 @@ static AoA_Sample AoAReceiver_estimateAngle(const AoA_AntennaResult *AoAReceiver
 
   return AoA;
 }
+
+/*********************************************************************
+ * @fn      AoAReceiver_wrapAngle
+ *
+ * @brief   Wrap an angle to -180..180 degrees.
+ *
+ * @param   angle - degrees
+ *
+ * @return  wrapped angle
+ */
+static int16_t AoAReceiver_wrapAngle(int32_t angle)
+{
+  angle %= 360;
+
+  if (angle > 180)
+  {
+    angle -= 360;
+  }
+  else if (angle <= -180)
+  {
+    angle += 360;
+  }
+
+  return (int16_t)angle;
+}
 #endif // !AOA_STREAM
 
 /*********************************************************************
@@ -2049,36 +5032,63 @@ static void AoAReceiver_AoACompleteCallback(uint8_t event)
     uint8_t packetId;
     AoA_IQSample *samples;
     aoaReport_t *aoaReport;
+#if !defined( AOA_STREAM )
+    AoAIQ_SlotMap slotMap;
+
+    // Only the stable part of each antenna slot is copied. The map was
+    // validated when it was set, this only guards the report size.
+    if (!AoAIQ_slotMapInit(&slotMap, aoaArmedConfig->pattern->numPatterns,
+                           NUM_AOA_SAMPLES, aoaSlotSkip, aoaSlotKeep) ||
+        slotMap.numSlots * slotMap.keep > AOA_REPORT_SAMPLES)
+    {
+      AoAReceiver_enqueueMsg(AOA_REPORT_EVT, FAILURE, NULL);
+      return;
+    }
+#endif // !AOA_STREAM
 
     AOA_getRxIQ(&packetId, &samples);
 
     if (samples != NULL)
     {
+      uint8_t *pAdvAddr = ((uint8_t *) &RFQueue_getDataEntry()->data) + 2;
+
+      // Drop captures from advertisers we are not tracking before the
+      // samples are copied or a report buffer is taken
+      if (state == BLE_STATE_IDLE_AOA_SCANNING && !AoAReceiver_filterMatch(pAdvAddr))
+      {
+        AoAReceiver_enqueueMsg(AOA_REPORT_EVT, AOA_REPORT_FILTERED, NULL);
+        return;
+      }
+
       // Allocate space for the event data.
-      if (aoaAllocated == false)
+      if (aoaReportsAllocated < AOA_NUM_REPORT_BUFS)
       {
-        if (aoaReport = ICall_malloc(sizeof(aoaReport_t)))
+        if (aoaReport = MsgPool_alloc(sizeof(aoaReport_t)))
         {
-          aoaAllocated = true;
+          aoaReportsAllocated++;
           aoaReport->packetId = packetId;
           aoaReport->channel = RF_cmdBleScanner.channel;
         
-          if (!AoAReceiver_antA1Result->updated)
-          {
-            aoaReport->antConfig = AoAReceiver_antA1Config;
-            aoaReport->antResult = AoAReceiver_antA1Result;
-          }
-          else if (!AoAReceiver_antA2Result->updated)
-          {
-            aoaReport->antConfig = AoAReceiver_antA2Config;
-            aoaReport->antResult = AoAReceiver_antA2Result;
-          }
+          aoaReport->antConfig = aoaArmedConfig;
+          aoaReport->antResult = aoaArmedResult;
         
+#if defined( AOA_STREAM )
           memcpy(aoaReport->samples, samples, NUM_AOA_SAMPLES * sizeof(AoA_IQSample));
-          memcpy(aoaReport->advAddr, ((uint8_t *) &RFQueue_getDataEntry()->data) + 2, 6);
+#else
+          // The driver's result RSSI is only filled in by AOA_getPairAngles
+          aoaReport->rssi = ((rfc_bleScannerOutput_t *)RF_cmdBleScanner.pOutput)->lastRssi;
+          aoaReport->slotLen = slotMap.keep;
+          aoaReport->slotPeriod = slotMap.slotSamples;
+          aoaReport->numSamples = slotMap.numSlots * slotMap.keep;
+          aoaReport->iqShift = AoAIQ_pack(samples, &slotMap, aoaReport->samples);
+#endif // AOA_STREAM
+          memcpy(aoaReport->advAddr, pAdvAddr, B_ADDR_LEN);
         
           // Queue the event.
-          AoAReceiver_enqueueMsg(AOA_REPORT_EVT, SUCCESS, (uint8_t *) aoaReport);
+          if (AoAReceiver_enqueueMsg(AOA_REPORT_EVT, SUCCESS, (uint8_t *) aoaReport) == FALSE)
+          {
+            AoAReceiver_freeReport(aoaReport);
+          }
           return;
         }
         else
@@ -2107,24 +5117,31 @@ static void AoAReceiver_aoaStart()
 {
   AoA_AntennaConfig * config;
 
-  // Scan one channel at a time
-  if (!AoAReceiver_antA1Result->updated && !AoAReceiver_antA2Result->updated)
+  // Scan one channel at a time. A2 follows A1 on the next channel and
+  // the next pair starts on the channel A2 used, so both arrays take
+  // every channel of the list in turn, whatever its length.
+  if (!aoaCaptureA2)
   {
-    channelIdx = 0;
+#if defined( AOA_STREAM )
+    // Only A1 captures, it steps through the list by itself
+    channelIdx = (channelIdx + 1) % numChannels;
+#endif // AOA_STREAM
+    aoaArmedConfig = AoAReceiver_antA1Config;
+    aoaArmedResult = AoAReceiver_antA1Result;
   }
   else
   {
-    channelIdx = (channelIdx + 1) % (sizeof(channels)/sizeof(channels[0]));
+    channelIdx = (channelIdx + 1) % numChannels;
+    aoaArmedConfig = AoAReceiver_antA2Config;
+    aoaArmedResult = AoAReceiver_antA2Result;
   }
 
-  if (!AoAReceiver_antA1Result->updated)
-  {
-    config = AoAReceiver_antA1Config;
-  }
-  else
-  {
-    config = AoAReceiver_antA2Config;
-  }
+  config = aoaArmedConfig;
+
+#if !defined( AOA_STREAM )
+  // Alternate arrays. Streaming never estimates, so it stays on A1.
+  aoaCaptureA2 = !aoaCaptureA2;
+#endif // !AOA_STREAM
 
   RF_bleScannerPar.timeoutTrigger.triggerType = TRIG_REL_START;
   RF_bleScannerPar.timeoutTime = aoaHandle->scanWindow * AOA_RAT_TICKS_IN_625US;
@@ -2143,20 +5160,213 @@ static void AoAReceiver_aoaStart()
 
     if (RF_bleScannerPar.timeoutTime > RF_cmdBleScanner.startTime)
     {
-      // Recalculate timeout time
-      RF_bleScannerPar.timeoutTime -= RF_cmdBleScanner.startTime;
+      // Recalculate timeout time
+      RF_bleScannerPar.timeoutTime -= RF_cmdBleScanner.startTime;
+    }
+  }
+
+  // Range check
+  if (channelIdx < numChannels)
+  {
+    AoADuty_radioOn(Clock_getTicks());
+    AOA_run(aoaHandle, channels[channelIdx], config, AOA_PACKETID_DEFAULT);
+  }
+  else
+  {
+    // Range check failed
+  }
+}
+
+/*********************************************************************
+* @fn      AoAReceiver_aoaRetry
+*
+* @brief   Arm the last capture again, on the same antenna array and
+*          channel, after it was dropped.
+*
+* @return  None
+*/
+static void AoAReceiver_aoaRetry(void)
+{
+  // AoAReceiver_aoaStart advances array and channel, step back first
+  aoaCaptureA2 = (aoaArmedConfig == AoAReceiver_antA2Config);
+#if !defined( AOA_STREAM )
+  if (aoaCaptureA2)
+#endif // !AOA_STREAM
+  {
+    channelIdx = (channelIdx + numChannels - 1) % numChannels;
+  }
+
+  AoAReceiver_aoaSchedule();
+}
+
+/*********************************************************************
+* @fn      AoAReceiver_aoaSchedule
+*
+* @brief   Arm the next idle AoA capture now, or stand by until the
+*          duty cycle allows it.
+*
+* @return  None
+*/
+static void AoAReceiver_aoaSchedule(void)
+{
+  uint32_t delay = 0;
+
+  // The second array of a round follows the first without a gap, both
+  // captures should see the tag at the same place
+  if (!aoaCaptureA2)
+  {
+    delay = AoADuty_nextRound(Clock_getTicks());
+  }
+
+  if (delay != 0)
+  {
+    Util_restartClock(&aoaDutyClock, delay);
+    return;
+  }
+
+  AoAReceiver_aoaStart();
+}
+
+/*********************************************************************
+* @fn      AoAReceiver_aoaDutyHandler
+*
+* @brief   Duty cycle clock handler, runs in SWI context.
+*
+* @param   a0 - ignored
+*
+* @return  None
+*/
+static void AoAReceiver_aoaDutyHandler(UArg a0)
+{
+  Event_post(syncEvent, AOA_DUTY_EVT);
+}
+
+#if defined( AOA_HUB_LINK )
+/*********************************************************************
+* @fn      AoAReceiver_backhaulHandler
+*
+* @brief   Backhaul flush clock handler, runs in SWI context.
+*
+* @param   a0 - ignored
+*
+* @return  None
+*/
+static void AoAReceiver_backhaulHandler(UArg a0)
+{
+  Event_post(syncEvent, AOA_BACKHAUL_EVT);
+}
+
+/*********************************************************************
+* @fn      AoAReceiver_backhaulPut
+*
+* @brief   Batch an angle for the backhaul subscribers. The first angle
+*          of a batch starts the flush clock, a full batch is sent at
+*          once.
+*
+* @param   pAddr   - tag address
+* @param   pSample - angle
+*
+* @return  None
+*/
+static void AoAReceiver_backhaulPut(uint8_t *pAddr, AoA_Sample *pSample)
+{
+  uint8_t numRecords;
+
+  if (!AoABackhaul_subscribed())
+  {
+    return;
+  }
+
+  numRecords = AoABackhaul_put(pAddr, pSample->angle,
+                               pSample->hasElevation ? pSample->elevation :
+                                                       AOA_BACKHAUL_NO_ELEVATION,
+                               pSample->rssi, pSample->channel);
+
+  if (numRecords >= AOA_BACKHAUL_MAX_RECORDS)
+  {
+    Util_stopClock(&aoaBackhaulClock);
+    AoABackhaul_flush();
+  }
+  else if (numRecords == 1)
+  {
+    Util_restartClock(&aoaBackhaulClock, aoaBackhaulFlush);
+  }
+}
+#endif // AOA_HUB_LINK
+
+/*********************************************************************
+* @fn      AoAReceiver_filterMatch
+*
+* @brief   Check an advertiser address against the filter list. Called
+*          from the AoA driver callback.
+*
+* @param   pAddr - advertiser address
+*
+* @return  TRUE if the list is empty or holds pAddr
+*/
+static bool AoAReceiver_filterMatch(const uint8_t *pAddr)
+{
+  uint8_t i;
+
+  if (aoaFilterCount == 0)
+  {
+    return TRUE;
+  }
+
+  for (i = 0; i < aoaFilterCount; i++)
+  {
+    if (memcmp(aoaFilterList[i], pAddr, B_ADDR_LEN) == 0)
+    {
+      return TRUE;
     }
   }
 
-  // Range check
-  if (channelIdx == (channelIdx % (sizeof(channels)/sizeof(channels[0]))))
+  return FALSE;
+}
+
+/*********************************************************************
+* @fn      AoAReceiver_filterAdd
+*
+* @brief   Add an advertiser address to the filter list.
+*
+* @param   pAddr - advertiser address
+*
+* @return  SUCCESS, or bleNoResources if the list is full
+*/
+static bStatus_t AoAReceiver_filterAdd(const uint8_t *pAddr)
+{
+  uint8_t i;
+
+  for (i = 0; i < aoaFilterCount; i++)
   {
-    AOA_run(aoaHandle, channels[channelIdx], config, AOA_PACKETID_DEFAULT);
+    if (memcmp(aoaFilterList[i], pAddr, B_ADDR_LEN) == 0)
+    {
+      return SUCCESS;
+    }
   }
-  else
+
+  if (aoaFilterCount >= AOA_FILTER_LIST_SIZE)
   {
-    // Range check failed
+    return bleNoResources;
   }
+
+  // Fill the entry before it becomes visible to the callback
+  memcpy(aoaFilterList[aoaFilterCount], pAddr, B_ADDR_LEN);
+  aoaFilterCount++;
+
+  return SUCCESS;
+}
+
+/*********************************************************************
+* @fn      AoAReceiver_filterClear
+*
+* @brief   Empty the filter list, accepting every advertiser.
+*
+* @return  None
+*/
+static void AoAReceiver_filterClear(void)
+{
+  aoaFilterCount = 0;
 }
 
 /*********************************************************************
@@ -2170,7 +5380,19 @@ static void AoAReceiver_aoaStart()
 */
 static void AoAReceiver_aoaEnableSender(bool enable)
 {
-  if (charHdl != 0 && GATTProcedureInProgress == FALSE)
+  if (ctrlHdl != 0 && (!gattCacheHit || GATTProcedureInProgress == FALSE))
+  {
+    // Write command, nothing to wait for and no ATT procedure to block on.
+    // Cached handles are confirmed by a write request first.
+    if (AoAReceiver_senderControl(enable ? AOA_SENDER_CTRL_START :
+                                           AOA_SENDER_CTRL_STOP,
+                                  gattCacheHit) == SUCCESS)
+    {
+      aoaSenderActive = enable;
+      AoATrigger_senderChanged(connHandle, Clock_getTicks());
+    }
+  }
+  else if (charHdl != 0 && GATTProcedureInProgress == FALSE)
   {
     bStatus_t status;
     attWriteReq_t req;
@@ -2193,6 +5415,7 @@ static void AoAReceiver_aoaEnableSender(bool enable)
       if (status == SUCCESS)
       {
         aoaSenderActive = enable;
+        AoATrigger_senderChanged(connHandle, Clock_getTicks());
       }
       else
       {
@@ -2206,6 +5429,182 @@ static void AoAReceiver_aoaEnableSender(bool enable)
   }
 }
 
+/*********************************************************************
+* @fn      AoAReceiver_senderControl
+*
+* @brief   Write a control message to a sender with the control
+*          characteristic. START carries the channels the receiver
+*          scans and the traffic it can capture.
+*
+* @param   op      - AOA_SENDER_CTRL_START or AOA_SENDER_CTRL_STOP
+* @param   confirm - send a write request instead of a write command,
+*                    to learn whether the handle is still valid
+*
+* @return  SUCCESS or the GATT error
+*/
+static bStatus_t AoAReceiver_senderControl(uint8_t op, bool confirm)
+{
+  bStatus_t status;
+  attWriteReq_t req;
+  uint8_t method = confirm ? ATT_WRITE_REQ : ATT_WRITE_CMD;
+  uint16_t period = senderPeriod;
+  uint8_t i;
+
+  if (period == 0)
+  {
+    period = AoAConnCtrl_getInterval(connHandle);
+  }
+
+  req.pValue = GATT_bm_alloc(connHandle, method, AOA_SENDER_CTRL_LEN, NULL);
+
+  if (req.pValue == NULL)
+  {
+    return bleMemAllocError;
+  }
+
+  memset(req.pValue, 0, AOA_SENDER_CTRL_LEN);
+  req.pValue[0] = op;
+  req.pValue[1] = AOA_PACKETID_DEFAULT;
+  for (i = 0; i < numChannels; i++)
+  {
+    req.pValue[2 + channels[i] / 8] |= 1 << (channels[i] % 8);
+  }
+  req.pValue[7] = LO_UINT16(period);
+  req.pValue[8] = HI_UINT16(period);
+  req.pValue[9] = senderBurst;
+
+  req.handle = ctrlHdl;
+  req.len = AOA_SENDER_CTRL_LEN;
+  req.sig = 0;
+  req.cmd = !confirm;
+
+  if (confirm)
+  {
+    status = GATT_WriteCharValue(connHandle, &req, selfEntity);
+    GATTProcedureInProgress = (status == SUCCESS);
+  }
+  else
+  {
+    status = GATT_WriteNoRsp(connHandle, &req);
+  }
+
+  if (status != SUCCESS)
+  {
+    GATT_bm_free((gattMsg_t *) &req, method);
+  }
+
+  return status;
+}
+
+/*********************************************************************
+* @fn      AoAReceiver_senderUpdate
+*
+* @brief   Send the current channels and traffic to an active sender
+*          after one of them changed.
+*
+* @return  None
+*/
+static void AoAReceiver_senderUpdate(void)
+{
+  if (ctrlHdl != 0 && aoaSenderActive)
+  {
+    VOID AoAReceiver_senderControl(AOA_SENDER_CTRL_START, FALSE);
+  }
+}
+
+/*********************************************************************
+* @fn      AoAReceiver_connCtrlPoll
+*
+* @brief   Request the connection interval the controller wants for a
+*          link, if it differs enough from the one in use.
+*
+* @param   handle - connection handle
+*
+* @return  None
+*/
+static void AoAReceiver_connCtrlPoll(uint16_t handle)
+{
+  uint16_t interval;
+
+  if (AoAConnCtrl_poll(handle, aoaSenderActive, Clock_getTicks(), &interval))
+  {
+    if (GAPCentralRole_UpdateLink(handle, interval, interval, DEFAULT_UPDATE_SLAVE_LATENCY,
+                                  AoAReceiver_connTimeout(interval, DEFAULT_UPDATE_SLAVE_LATENCY)) != SUCCESS)
+    {
+      // Busy with another update, polled again after the update gap
+      AoAConnCtrl_requestFailed(handle);
+    }
+  }
+}
+
+/*********************************************************************
+* @fn      AoAReceiver_replyParamUpdate
+*
+* @brief   Answer a connection parameter request of the peripheral.
+*          With the controller enabled the link gets the interval it
+*          wants instead, so the peripheral cannot slow connected AoA
+*          down.
+*
+* @param   pReq - request
+*
+* @return  None
+*/
+static void AoAReceiver_replyParamUpdate(gapUpdateLinkParamReq_t *pReq)
+{
+  gapUpdateLinkParamReqReply_t rsp;
+  uint16_t target = AoAConnCtrl_target(pReq->connectionHandle, aoaSenderActive,
+                                       Clock_getTicks());
+
+  rsp.connectionHandle = pReq->connectionHandle;
+  rsp.signalIdentifier = pReq->signalIdentifier;
+  rsp.accepted = TRUE;
+
+  if (target == 0)
+  {
+    rsp.intervalMin = pReq->intervalMin;
+    rsp.intervalMax = pReq->intervalMax;
+    rsp.connLatency = pReq->connLatency;
+    rsp.connTimeout = pReq->connTimeout;
+  }
+  else
+  {
+    rsp.intervalMin = target;
+    rsp.intervalMax = target;
+    rsp.connLatency = DEFAULT_UPDATE_SLAVE_LATENCY;
+    rsp.connTimeout = AoAReceiver_connTimeout(target, DEFAULT_UPDATE_SLAVE_LATENCY);
+  }
+
+  VOID GAP_UpdateLinkParamReqReply(&rsp);
+}
+
+/*********************************************************************
+* @fn      AoAReceiver_connTimeout
+*
+* @brief   Supervision timeout for a connection interval, at least the
+*          default and three times the minimum the specification allows.
+*
+* @param   interval - connection interval, 1.25 ms units
+* @param   latency  - slave latency
+*
+* @return  supervision timeout, 10 ms units
+*/
+static uint16_t AoAReceiver_connTimeout(uint16_t interval, uint16_t latency)
+{
+  // Minimum is (1 + latency) * interval * 2, i.e. / 4 in 10 ms units
+  uint32_t timeout = (uint32_t)(1 + latency) * interval * 3 / 4;
+
+  if (timeout < DEFAULT_UPDATE_CONN_TIMEOUT)
+  {
+    timeout = DEFAULT_UPDATE_CONN_TIMEOUT;
+  }
+  else if (timeout > AOA_MAX_CONN_TIMEOUT)
+  {
+    timeout = AOA_MAX_CONN_TIMEOUT;
+  }
+
+  return (uint16_t)timeout;
+}
+
 /*********************************************************************
 * @fn      AoAReceiver_processAoAEvt
 *
@@ -2217,6 +5616,8 @@ static void AoAReceiver_aoaEnableSender(bool enable)
 */
 static void AoAReceiver_processAoAEvt(aoaReport_t *aoaReport, uint8_t aoaReportState)
 {
+  bool rearmed = FALSE;
+
   if (aoaReportState == SUCCESS &&
       ((state == BLE_STATE_IDLE_AOA_SCANNING) ||
        (state == BLE_STATE_CONNECTED_AOA_SCANNING)))
@@ -2230,8 +5631,8 @@ static void AoAReceiver_processAoAEvt(aoaReport_t *aoaReport, uint8_t aoaReportS
     }
     Display_print0(dispHandle, 9, 0, "]");
 
-    ICall_free(aoaReport);
-    aoaAllocated = false;
+    AoAReceiver_freeReport(aoaReport);
+    aoaReport = NULL;
 
     if (AoAReceiver_antA1Result->updated && AoAReceiver_antA2Result->updated)
     {
@@ -2239,31 +5640,25 @@ static void AoAReceiver_processAoAEvt(aoaReport_t *aoaReport, uint8_t aoaReportS
       AoAReceiver_antA2Result->updated = false;
     }
 #else
-    uint8_t aoaAdvAddr[6];
-    memcpy(aoaAdvAddr, aoaReport->advAddr, 6);
-
-    /*
-     * With the I/Q samples stored in `samples` calculate the relative angles
-     * for the different pairs of antennas specified in `*curConfig`.
-     * -> Result is stored in curConfig->result
-     */
-    AOA_getPairAngles(aoaReport->channel,
-                      aoaReport->antConfig,
-                      aoaReport->antResult,
-                      aoaReport->samples);
-
-    // The message buffer is quite large (full of AoA samples)
-    // We will free it here
-    ICall_free(aoaReport);
-    aoaAllocated = false;
+    // Pipelined: arm the next capture, which lands in the other report
+    // buffer, before this one is estimated
+    if (aoaPipelined && state == BLE_STATE_IDLE_AOA_SCANNING && aoaIdleScanStarted)
+    {
+      AoAReceiver_aoaSchedule();
+      rearmed = TRUE;
+    }
 
-    if (AoAReceiver_antA1Result->updated && AoAReceiver_antA2Result->updated)
+    // Recorded before the worker takes over the buffer
+    if (aoaIqInd)
     {
-      // Print AoA results via UART
-      AoAReceiver_displayEstimatedAngle(aoaAdvAddr, AoAReceiver_estimateAngle(AoAReceiver_antA1Result, AoAReceiver_antA2Result));
+      AoAReceiver_sendIq(aoaReport);
+    }
 
-      AoAReceiver_antA1Result->updated = false;
-      AoAReceiver_antA2Result->updated = false;
+    // Hand the capture to the estimation worker. It owns the buffer from
+    // here on and a serial idle scan is re-armed once it is done.
+    if (AoAReceiver_workerPost(aoaReport))
+    {
+      return;
     }
 #endif // AOA_STREAM
   }
@@ -2271,22 +5666,297 @@ static void AoAReceiver_processAoAEvt(aoaReport_t *aoaReport, uint8_t aoaReportS
   {
     Display_print0(dispHandle, 3, 0, "AoA Out of Memory!");
   }
+  else if (aoaReportState == AOA_REPORT_FILTERED)
+  {
+    aoaFilteredCnt++;
+
+    // Nothing was armed after the dropped capture, so repeat it on the
+    // same array and channel
+    if (state == BLE_STATE_IDLE_AOA_SCANNING && aoaIdleScanStarted)
+    {
+      AoAReceiver_aoaRetry();
+      rearmed = TRUE;
+    }
+  }
 
   // We still need to deallocate the buffer even if the AoA event
   // was not successful
-  if (aoaAllocated == true)
+  if (aoaReport != NULL)
   {
-    ICall_free(aoaReport);
-    aoaAllocated = false;
+    AoAReceiver_freeReport(aoaReport);
   }
 
   // If we are in non-connected AoA, always start a new scan
-  if (state == BLE_STATE_IDLE_AOA_SCANNING && aoaIdleScanStarted)
+  if (!rearmed && state == BLE_STATE_IDLE_AOA_SCANNING && aoaIdleScanStarted)
+  {
+    AoAReceiver_aoaSchedule();
+  }
+}
+
+/*********************************************************************
+* @fn      AoAReceiver_freeReport
+*
+* @brief   Return an I/Q report buffer to the pool
+*
+* @param   aoaReport - report to free
+*
+* @return  None
+*/
+static void AoAReceiver_freeReport(aoaReport_t *aoaReport)
+{
+  UInt key;
+
+  MsgPool_free(aoaReport);
+
+  key = Hwi_disable();
+  aoaReportsAllocated--;
+  Hwi_restore(key);
+}
+
+#if !defined( AOA_STREAM )
+/*********************************************************************
+* @fn      AoAReceiver_workerFxn
+*
+* @brief   Estimation worker task entry point. Turns queued I/Q reports
+*          into angles so the application task never runs the math.
+*
+* @param   a0, a1 - not used
+*
+* @return  None
+*/
+static void AoAReceiver_workerFxn(UArg a0, UArg a1)
+{
+  for (;;)
+  {
+    aoaReport_t *aoaReport;
+
+    Semaphore_pend(Semaphore_handle(&aoaWorkerSem), BIOS_WAIT_FOREVER);
+
+    aoaReport = AoAReceiver_workerGet();
+
+    if (aoaReport != NULL)
+    {
+      AoAReceiver_estimateReport(aoaReport);
+
+      // Let the application task re-arm the capture
+      Event_post(syncEvent, AOA_ESTIMATE_DONE_EVT);
+    }
+  }
+}
+
+/*********************************************************************
+* @fn      AoAReceiver_workerPost
+*
+* @brief   Queue an I/Q report for the estimation worker
+*
+* @param   aoaReport - report to estimate, owned by the worker on success
+*
+* @return  TRUE if queued, FALSE if the queue was full
+*/
+static bool AoAReceiver_workerPost(aoaReport_t *aoaReport)
+{
+  bool queued = FALSE;
+  UInt key = Hwi_disable();
+
+  if (aoaWorkerQueueCount < AOA_WORKER_QUEUE_DEPTH)
+  {
+    aoaWorkerQueue[(aoaWorkerQueueHead + aoaWorkerQueueCount) % AOA_WORKER_QUEUE_DEPTH] = aoaReport;
+    aoaWorkerQueueCount++;
+    queued = TRUE;
+  }
+  else
+  {
+    aoaWorkerDropCnt++;
+  }
+
+  Hwi_restore(key);
+
+  if (queued)
+  {
+    Semaphore_post(Semaphore_handle(&aoaWorkerSem));
+  }
+
+  return queued;
+}
+
+/*********************************************************************
+* @fn      AoAReceiver_workerGet
+*
+* @brief   Take the oldest I/Q report from the estimation worker queue
+*
+* @return  report, NULL if the queue is empty
+*/
+static aoaReport_t *AoAReceiver_workerGet(void)
+{
+  aoaReport_t *aoaReport = NULL;
+  UInt key = Hwi_disable();
+
+  if (aoaWorkerQueueCount > 0)
   {
-    AoAReceiver_aoaStart();
+    aoaReport = aoaWorkerQueue[aoaWorkerQueueHead];
+    aoaWorkerQueueHead = (aoaWorkerQueueHead + 1) % AOA_WORKER_QUEUE_DEPTH;
+    aoaWorkerQueueCount--;
   }
+
+  Hwi_restore(key);
+
+  return aoaReport;
+}
+
+/*********************************************************************
+* @fn      AoAReceiver_estimateReport
+*
+* @brief   Estimate the pair angles of one I/Q report and, once both
+*          antenna arrays are updated, the angle of arrival. Runs in
+*          the estimation worker task.
+*
+* @param   aoaReport - report to estimate, freed here
+*
+* @return  None
+*/
+static void AoAReceiver_estimateReport(aoaReport_t *aoaReport)
+{
+  uint32_t startTicks = Clock_getTicks();
+  uint8_t aoaAdvAddr[6];
+  memcpy(aoaAdvAddr, aoaReport->advAddr, 6);
+
+  // Drop captures that would only pollute the moving average, before
+  // spending time on the pair angles
+  switch (AoAIQ_gate(aoaReport->samples, aoaReport->numSamples,
+                     aoaReport->slotLen, aoaReport->iqShift,
+                     &aoaIqGateCfg, NULL))
+  {
+    case AOA_IQ_GATE_LOW_AMPLITUDE:
+      aoaIqLowAmplitudeCnt++;
+      AoAReceiver_freeReport(aoaReport);
+      return;
+
+    case AOA_IQ_GATE_LOW_COHERENCE:
+      aoaIqLowCoherenceCnt++;
+      AoAReceiver_freeReport(aoaReport);
+      return;
+
+    default:
+      break;
+  }
+
+  /*
+   * With the packed I/Q samples stored in `samples` calculate the relative
+   * angles for the different pairs of antennas specified in `*antConfig`.
+   * -> Result is stored in antResult
+   */
+  AoAEst_getPairAngles(aoaReport->channel,
+                       aoaReport->rssi,
+                       aoaReport->antConfig,
+                       aoaReport->antResult,
+                       aoaReport->samples,
+                       aoaReport->numSamples,
+                       aoaReport->slotLen,
+                       aoaReport->slotPeriod,
+                       aoaReport->iqShift);
+
+  // The message buffer is quite large (full of AoA samples)
+  // We will free it here
+  AoAReceiver_freeReport(aoaReport);
+
+  if (AoAReceiver_antA1Result->updated && AoAReceiver_antA2Result->updated)
+  {
+    aoaAngleRpt_t *pAngle = MsgPool_alloc(sizeof(aoaAngleRpt_t));
+    uint32_t estimateUs;
+
+    if (pAngle != NULL)
+    {
+      memcpy(pAngle->advAddr, aoaAdvAddr, B_ADDR_LEN);
+      pAngle->sample = AoAReceiver_estimateAngle(AoAReceiver_antA1Result, AoAReceiver_antA2Result);
+
+      // Both captures' pair angles and the angle itself, preemption included
+      estimateUs = (aoaEstimateTicks + Clock_getTicks() - startTicks) * Clock_tickPeriod;
+      pAngle->estimateUs = (estimateUs < 0xFFFF) ? estimateUs : 0xFFFF;
+
+      // Display happens in the application task
+      if (AoAReceiver_enqueueMsg(AOA_ANGLE_EVT, SUCCESS, (uint8_t *)pAngle) == FALSE)
+      {
+        MsgPool_free(pAngle);
+      }
+    }
+
+    AoAReceiver_antA1Result->updated = false;
+    AoAReceiver_antA2Result->updated = false;
+    aoaEstimateTicks = 0;
+  }
+  else
+  {
+    aoaEstimateTicks += Clock_getTicks() - startTicks;
+  }
+}
+
+/*********************************************************************
+* @fn      AoAReceiver_setSlotMap
+*
+* @brief   Set which samples of each antenna slot are kept. Must fit the
+*          slots of both antenna arrays and the report buffers.
+*
+* @param   skip - samples dropped after each antenna switch
+* @param   keep - samples kept per slot
+*
+* @return  SUCCESS or INVALIDPARAMETER
+*/
+static bStatus_t AoAReceiver_setSlotMap(uint8_t skip, uint8_t keep)
+{
+  UInt key;
+
+  if (!AoAReceiver_slotMapFits(AoAReceiver_antA1Config->pattern->numPatterns, skip, keep) ||
+      !AoAReceiver_slotMapFits(AoAReceiver_antA2Config->pattern->numPatterns, skip, keep))
+  {
+    return INVALIDPARAMETER;
+  }
+
+  // Read as a pair by the RF callback
+  key = Hwi_disable();
+  aoaSlotSkip = skip;
+  aoaSlotKeep = keep;
+  Hwi_restore(key);
+
+  return SUCCESS;
+}
+
+/*********************************************************************
+* @fn      AoAReceiver_slotMapFits
+*
+* @brief   Check a slot map against an antenna pattern length and the
+*          report buffers.
+*
+* @param   numPatterns - antenna switch slots per capture
+* @param   skip        - samples dropped after each antenna switch
+* @param   keep        - samples kept per slot
+*
+* @return  TRUE if captures with this map fit a report buffer
+*/
+static bool AoAReceiver_slotMapFits(uint8_t numPatterns, uint8_t skip, uint8_t keep)
+{
+  AoAIQ_SlotMap slotMap;
+
+  return AoAIQ_slotMapInit(&slotMap, numPatterns, NUM_AOA_SAMPLES, skip, keep) &&
+         slotMap.numSlots * slotMap.keep <= AOA_REPORT_SAMPLES;
+}
+#endif // !AOA_STREAM
+
+/*********************************************************************
+* @fn      AoAReceiver_antConfigBusy
+*
+* @brief   Check whether an antenna configuration may be in use by an
+*          armed capture or a report still being estimated.
+*
+* @return  TRUE if the configuration must not be changed now
+*/
+static bool AoAReceiver_antConfigBusy(void)
+{
+  return (state == BLE_STATE_IDLE_AOA_SCANNING ||
+          state == BLE_STATE_CONNECTED_AOA_SCANNING ||
+          aoaReportsAllocated != 0);
 }
 
+#if !defined( AOA_STREAM )
 /*********************************************************************
 * @fn      AoAReceiver_calculateRSSI
 *
@@ -2305,5 +5975,7 @@ static void AoAReceiver_calculateRSSI(int lastRssi)
         ((AOA_ALPHA_FILTER_MAX_VALUE - aoaReceiverRssi.alpha) * (aoaReceiverRssi.currentRssi) + aoaReceiverRssi.alpha * lastRssi) >> 4;
   }
 }
+#endif // !AOA_STREAM
+
 /*********************************************************************
 *********************************************************************/
@@ -0,0 +1,378 @@
+/******************************************************************************
+
+ @file       aoa_trigger.c
+
+ @brief Per-peer trigger policy for RSSI triggered connected AoA.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+
+#include "aoa_trigger.h"
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Trigger state of one peer
+typedef struct
+{
+  AoATrigger_Cfg cfg;
+  int16_t  rssiQ4;        // Filtered RSSI, 1/16 dBm
+  bool     hasRssi;
+  bool     changed;       // lastChange is valid
+  bool     requested;     // lastRequest is valid
+  uint32_t lastChange;    // Sender last started or stopped
+  uint32_t lastRequest;   // Last request to the sender
+} AoATrigger_Peer;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint32_t trigTicksPerMs = 1;
+static AoATrigger_Cfg trigDefaultCfg;
+static AoATrigger_Peer trigPeers[AOA_TRIGGER_MAX_PEERS];
+static AoATrigger_Stats trigStats;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static bool AoATrigger_validCfg(const AoATrigger_Cfg *pCfg);
+static bool AoATrigger_elapsed(uint32_t now, uint32_t since, uint16_t ms);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      AoATrigger_init
+ *
+ * @brief   Initialize the engine.
+ *
+ * @param   pCfg       - policy of every peer
+ * @param   ticksPerMs - ticks per millisecond
+ *
+ * @return  None
+ */
+void AoATrigger_init(const AoATrigger_Cfg *pCfg, uint32_t ticksPerMs)
+{
+  uint8_t i;
+
+  trigTicksPerMs = (ticksPerMs != 0) ? ticksPerMs : 1;
+  trigDefaultCfg = *pCfg;
+
+  memset(trigPeers, 0, sizeof(trigPeers));
+  memset(&trigStats, 0, sizeof(trigStats));
+
+  for (i = 0; i < AOA_TRIGGER_MAX_PEERS; i++)
+  {
+    trigPeers[i].cfg = *pCfg;
+  }
+}
+
+/*********************************************************************
+ * @fn      AoATrigger_setCfg
+ *
+ * @brief   Set the policy of a peer.
+ *
+ * @param   connHandle - peer or AOA_TRIGGER_ALL_PEERS
+ * @param   pCfg       - policy
+ *
+ * @return  SUCCESS or INVALIDPARAMETER
+ */
+bStatus_t AoATrigger_setCfg(uint16_t connHandle, const AoATrigger_Cfg *pCfg)
+{
+  uint8_t i;
+
+  if (!AoATrigger_validCfg(pCfg))
+  {
+    return INVALIDPARAMETER;
+  }
+
+  if (connHandle == AOA_TRIGGER_ALL_PEERS)
+  {
+    trigDefaultCfg = *pCfg;
+
+    for (i = 0; i < AOA_TRIGGER_MAX_PEERS; i++)
+    {
+      trigPeers[i].cfg = *pCfg;
+    }
+  }
+  else if (connHandle < AOA_TRIGGER_MAX_PEERS)
+  {
+    trigPeers[connHandle].cfg = *pCfg;
+  }
+  else
+  {
+    return INVALIDPARAMETER;
+  }
+
+  return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      AoATrigger_getCfg
+ *
+ * @brief   Read the policy of a peer.
+ *
+ * @param   connHandle - peer or AOA_TRIGGER_ALL_PEERS
+ * @param   pCfg       - filled with the policy
+ *
+ * @return  SUCCESS or INVALIDPARAMETER
+ */
+bStatus_t AoATrigger_getCfg(uint16_t connHandle, AoATrigger_Cfg *pCfg)
+{
+  if (connHandle == AOA_TRIGGER_ALL_PEERS)
+  {
+    *pCfg = trigDefaultCfg;
+  }
+  else if (connHandle < AOA_TRIGGER_MAX_PEERS)
+  {
+    *pCfg = trigPeers[connHandle].cfg;
+  }
+  else
+  {
+    return INVALIDPARAMETER;
+  }
+
+  return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      AoATrigger_open
+ *
+ * @brief   A peer connected.
+ *
+ * @param   connHandle - peer
+ * @param   now        - current time
+ *
+ * @return  None
+ */
+void AoATrigger_open(uint16_t connHandle, uint32_t now)
+{
+  AoATrigger_Peer *pPeer;
+
+  if (connHandle >= AOA_TRIGGER_MAX_PEERS)
+  {
+    return;
+  }
+
+  pPeer = &trigPeers[connHandle];
+
+  memset(pPeer, 0, sizeof(*pPeer));
+  pPeer->cfg = trigDefaultCfg;
+
+  // A new link starts in the off dwell, so the first few events fill
+  // the filter before the sender is asked for anything
+  pPeer->changed = true;
+  pPeer->lastChange = now;
+}
+
+/*********************************************************************
+ * @fn      AoATrigger_update
+ *
+ * @brief   Feed a connection event RSSI and get the action to take.
+ *
+ * @param   connHandle   - peer
+ * @param   rssi         - RSSI of the event, dBm
+ * @param   senderActive - the sender was asked to transmit
+ * @param   now          - current time
+ *
+ * @return  AOA_TRIGGER_xxx
+ */
+uint8_t AoATrigger_update(uint16_t connHandle, int8_t rssi,
+                          bool senderActive, uint32_t now)
+{
+  AoATrigger_Peer *pPeer;
+  uint8_t keep = senderActive ? AOA_TRIGGER_CAPTURE : AOA_TRIGGER_NONE;
+  int16_t filtered;
+  bool wantActive;
+
+  if (connHandle >= AOA_TRIGGER_MAX_PEERS)
+  {
+    return keep;
+  }
+
+  pPeer = &trigPeers[connHandle];
+
+  // Single pole low pass in 1/16 dB, seeded by the first sample
+  if (!pPeer->hasRssi)
+  {
+    pPeer->rssiQ4 = (int16_t)rssi * 16;
+    pPeer->hasRssi = true;
+  }
+  else
+  {
+    pPeer->rssiQ4 += ((int32_t)pPeer->cfg.alpha * ((int16_t)rssi * 16 - pPeer->rssiQ4)) / 16;
+  }
+
+  filtered = (pPeer->rssiQ4 + 8) >> 4;
+
+  if (senderActive)
+  {
+    wantActive = (filtered >= pPeer->cfg.threshold + pPeer->cfg.hysteresis);
+  }
+  else
+  {
+    wantActive = (filtered >= pPeer->cfg.threshold);
+  }
+
+  if (wantActive == senderActive)
+  {
+    return keep;
+  }
+
+  // Hold the crossing until the sender has dwelt long enough in its
+  // state and the previous request is old enough
+  if ((pPeer->changed &&
+       !AoATrigger_elapsed(now, pPeer->lastChange,
+                           senderActive ? pPeer->cfg.minOnTime : pPeer->cfg.minOffTime)) ||
+      (pPeer->requested &&
+       !AoATrigger_elapsed(now, pPeer->lastRequest, pPeer->cfg.minRequestGap)))
+  {
+    trigStats.numHeld++;
+    return keep;
+  }
+
+  pPeer->requested = true;
+  pPeer->lastRequest = now;
+  trigStats.numRequests++;
+
+  return senderActive ? AOA_TRIGGER_DISABLE : AOA_TRIGGER_ENABLE;
+}
+
+/*********************************************************************
+ * @fn      AoATrigger_senderChanged
+ *
+ * @brief   The sender of a peer was started or stopped.
+ *
+ * @param   connHandle - peer
+ * @param   now        - current time
+ *
+ * @return  None
+ */
+void AoATrigger_senderChanged(uint16_t connHandle, uint32_t now)
+{
+  if (connHandle < AOA_TRIGGER_MAX_PEERS)
+  {
+    trigPeers[connHandle].changed = true;
+    trigPeers[connHandle].lastChange = now;
+  }
+}
+
+/*********************************************************************
+ * @fn      AoATrigger_getRssi
+ *
+ * @brief   Filtered RSSI of a peer.
+ *
+ * @param   connHandle - peer
+ * @param   pRssi      - filled with the RSSI, dBm
+ *
+ * @return  false if the peer has no RSSI yet
+ */
+bool AoATrigger_getRssi(uint16_t connHandle, int8_t *pRssi)
+{
+  if (connHandle >= AOA_TRIGGER_MAX_PEERS || !trigPeers[connHandle].hasRssi)
+  {
+    return false;
+  }
+
+  *pRssi = (int8_t)((trigPeers[connHandle].rssiQ4 + 8) >> 4);
+
+  return true;
+}
+
+/*********************************************************************
+ * @fn      AoATrigger_getStats
+ *
+ * @brief   Read the statistics.
+ *
+ * @param   pStats - filled with a snapshot of the statistics
+ *
+ * @return  None
+ */
+void AoATrigger_getStats(AoATrigger_Stats *pStats)
+{
+  *pStats = trigStats;
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      AoATrigger_validCfg
+ *
+ * @brief   Check a policy.
+ *
+ * @param   pCfg - policy
+ *
+ * @return  true if usable
+ */
+static bool AoATrigger_validCfg(const AoATrigger_Cfg *pCfg)
+{
+  // Hysteresis lowers the threshold the sender is stopped at
+  return pCfg->hysteresis <= 0 &&
+         pCfg->alpha != 0 && pCfg->alpha <= AOA_TRIGGER_ALPHA_MAX;
+}
+
+/*********************************************************************
+ * @fn      AoATrigger_elapsed
+ *
+ * @brief   Check whether a time span has passed.
+ *
+ * @param   now   - current time
+ * @param   since - start of the span
+ * @param   ms    - length of the span
+ *
+ * @return  true if at least ms have passed since since
+ */
+static bool AoATrigger_elapsed(uint32_t now, uint32_t since, uint16_t ms)
+{
+  return (now - since) >= (uint32_t)ms * trigTicksPerMs;
+}
+
+/*********************************************************************
+*********************************************************************/
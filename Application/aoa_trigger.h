@@ -0,0 +1,213 @@
+/******************************************************************************
+
+ @file       aoa_trigger.h
+
+ @brief Per-peer trigger policy for RSSI triggered connected AoA.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+#ifndef AOATRIGGER_H
+#define AOATRIGGER_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bcomdef.h"
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Peers tracked, indexed by connection handle
+#ifndef AOA_TRIGGER_MAX_PEERS
+#if defined(MAX_NUM_BLE_CONNS)
+#define AOA_TRIGGER_MAX_PEERS                 MAX_NUM_BLE_CONNS
+#else
+#define AOA_TRIGGER_MAX_PEERS                 1
+#endif
+#endif
+
+// AoATrigger_setCfg handle addressing the default and every peer
+#define AOA_TRIGGER_ALL_PEERS                 0xFFFF
+
+// Largest RSSI filter weight, the filter keeps (16 - alpha) / 16 of
+// the previous value
+#define AOA_TRIGGER_ALPHA_MAX                 16
+
+// AoATrigger_update actions
+#define AOA_TRIGGER_NONE                      0
+#define AOA_TRIGGER_CAPTURE                   1  // Sender is on, capture
+#define AOA_TRIGGER_ENABLE                    2  // Ask the sender to start
+#define AOA_TRIGGER_DISABLE                   3  // Ask the sender to stop
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Trigger policy. The sender is started once the filtered RSSI reaches
+// threshold and stopped once it falls below threshold + hysteresis. It
+// stays in either state for at least the dwell time, and requests to
+// the sender are spaced by at least minRequestGap.
+typedef struct
+{
+  int8_t   threshold;     // dBm
+  int8_t   hysteresis;    // dB, <= 0
+  uint8_t  alpha;         // RSSI filter weight of a new sample, 1..16
+  uint16_t minOnTime;     // ms the sender stays on
+  uint16_t minOffTime;    // ms the sender stays off
+  uint16_t minRequestGap; // ms between two requests, also retries
+} AoATrigger_Cfg;
+
+// Statistics, all peers
+typedef struct
+{
+  uint32_t numRequests;   // Enable and disable requests issued
+  uint32_t numHeld;       // Events a crossing was held back by dwell or rate limit
+} AoATrigger_Stats;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * @brief   Initialize the engine. All times are in the caller's tick
+ *          unit.
+ *
+ * @param   pCfg       - policy of every peer
+ * @param   ticksPerMs - ticks per millisecond
+ */
+extern void AoATrigger_init(const AoATrigger_Cfg *pCfg, uint32_t ticksPerMs);
+
+/*
+ * @brief   Set the policy of a peer.
+ *
+ * @param   connHandle - peer, AOA_TRIGGER_ALL_PEERS for all peers and
+ *                       those connecting later
+ * @param   pCfg       - policy
+ *
+ * @return  SUCCESS or INVALIDPARAMETER
+ */
+extern bStatus_t AoATrigger_setCfg(uint16_t connHandle, const AoATrigger_Cfg *pCfg);
+
+/*
+ * @brief   Read the policy of a peer.
+ *
+ * @param   connHandle - peer, AOA_TRIGGER_ALL_PEERS for the default
+ * @param   pCfg       - filled with the policy
+ *
+ * @return  SUCCESS or INVALIDPARAMETER
+ */
+extern bStatus_t AoATrigger_getCfg(uint16_t connHandle, AoATrigger_Cfg *pCfg);
+
+/*
+ * @brief   A peer connected. Restarts its filter and timers with the
+ *          default policy.
+ *
+ * @param   connHandle - peer
+ * @param   now        - current time
+ */
+extern void AoATrigger_open(uint16_t connHandle, uint32_t now);
+
+/*
+ * @brief   Feed a connection event RSSI and get the action to take.
+ *          A returned ENABLE or DISABLE counts as a request, report it
+ *          with AoATrigger_senderChanged once it was sent.
+ *
+ * @param   connHandle   - peer
+ * @param   rssi         - RSSI of the event, dBm
+ * @param   senderActive - the sender was asked to transmit
+ * @param   now          - current time
+ *
+ * @return  AOA_TRIGGER_xxx
+ */
+extern uint8_t AoATrigger_update(uint16_t connHandle, int8_t rssi,
+                                 bool senderActive, uint32_t now);
+
+/*
+ * @brief   The sender of a peer was started or stopped, by the engine
+ *          or by hand. Starts the dwell time.
+ *
+ * @param   connHandle - peer
+ * @param   now        - current time
+ */
+extern void AoATrigger_senderChanged(uint16_t connHandle, uint32_t now);
+
+/*
+ * @brief   Filtered RSSI of a peer.
+ *
+ * @param   connHandle - peer
+ * @param   pRssi      - filled with the RSSI, dBm
+ *
+ * @return  false if the peer has no RSSI yet
+ */
+extern bool AoATrigger_getRssi(uint16_t connHandle, int8_t *pRssi);
+
+/*
+ * @brief   Read the statistics.
+ *
+ * @param   pStats - filled with a snapshot of the statistics
+ */
+extern void AoATrigger_getStats(AoATrigger_Stats *pStats);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AOATRIGGER_H */
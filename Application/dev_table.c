@@ -0,0 +1,294 @@
+/******************************************************************************
+
+ @file       dev_table.c
+
+ @brief Hash indexed table of discovered devices.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+
+#include "dev_table.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Index slot that holds no entry
+#define DEV_TABLE_EMPTY                       0xFFFF
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Entries in first seen order
+static DevTable_Entry devTable[DEV_TABLE_SIZE];
+static uint16_t devTableCount = 0;
+
+// Open addressing index, linear probing. Each slot holds a position in
+// devTable or DEV_TABLE_EMPTY.
+static uint16_t devTableIndex[DEV_TABLE_INDEX_SIZE];
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint16_t DevTable_hash(const uint8_t *pAddr);
+static uint16_t DevTable_findSlot(const uint8_t *pAddr);
+static void DevTable_reindex(void);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      DevTable_clear
+ *
+ * @brief   Empty the table.
+ *
+ * @return  none
+ */
+void DevTable_clear(void)
+{
+  devTableCount = 0;
+  memset(devTableIndex, 0xFF, sizeof(devTableIndex));
+}
+
+/*********************************************************************
+ * @fn      DevTable_update
+ *
+ * @brief   Add a device or refresh the one already in the table.
+ *
+ * @param   pAddr    - device address
+ * @param   addrType - device address type
+ * @param   rssi     - RSSI of the advertisement
+ * @param   flags    - DEV_TABLE_FLAG_xxx seen in the advertisement
+ * @param   now      - current time
+ *
+ * @return  the entry, NULL if the device is new and the table is full
+ */
+DevTable_Entry *DevTable_update(const uint8_t *pAddr, uint8_t addrType,
+                                int8_t rssi, uint8_t flags, uint32_t now)
+{
+  uint16_t slot = DevTable_findSlot(pAddr);
+  DevTable_Entry *pEntry;
+
+  if (devTableIndex[slot] != DEV_TABLE_EMPTY)
+  {
+    pEntry = &devTable[devTableIndex[slot]];
+  }
+  else
+  {
+    if (devTableCount >= DEV_TABLE_SIZE)
+    {
+      return NULL;
+    }
+
+    pEntry = &devTable[devTableCount];
+    devTableIndex[slot] = devTableCount++;
+
+    memcpy(pEntry->addr, pAddr, B_ADDR_LEN);
+    pEntry->flags = 0;
+  }
+
+  pEntry->addrType = addrType;
+  pEntry->rssi = rssi;
+  pEntry->flags |= flags;
+  pEntry->lastSeen = now;
+
+  return pEntry;
+}
+
+/*********************************************************************
+ * @fn      DevTable_find
+ *
+ * @brief   Look up a device.
+ *
+ * @param   pAddr - device address
+ *
+ * @return  the entry, NULL if the device is not in the table
+ */
+DevTable_Entry *DevTable_find(const uint8_t *pAddr)
+{
+  uint16_t pos = devTableIndex[DevTable_findSlot(pAddr)];
+
+  return (pos != DEV_TABLE_EMPTY) ? &devTable[pos] : NULL;
+}
+
+/*********************************************************************
+ * @fn      DevTable_get
+ *
+ * @brief   Get an entry by position.
+ *
+ * @param   idx - position
+ *
+ * @return  the entry, NULL if idx is out of range
+ */
+DevTable_Entry *DevTable_get(uint16_t idx)
+{
+  return (idx < devTableCount) ? &devTable[idx] : NULL;
+}
+
+/*********************************************************************
+ * @fn      DevTable_count
+ *
+ * @brief   Number of devices in the table.
+ *
+ * @return  number of entries
+ */
+uint16_t DevTable_count(void)
+{
+  return devTableCount;
+}
+
+/*********************************************************************
+ * @fn      DevTable_age
+ *
+ * @brief   Remove devices not seen for more than maxAge, keeping the
+ *          order of the rest, and rebuild the index.
+ *
+ * @param   now    - current time
+ * @param   maxAge - maximum time since lastSeen
+ *
+ * @return  number of devices removed
+ */
+uint16_t DevTable_age(uint32_t now, uint32_t maxAge)
+{
+  uint16_t src;
+  uint16_t dst = 0;
+  uint16_t removed;
+
+  for (src = 0; src < devTableCount; src++)
+  {
+    if ((uint32_t)(now - devTable[src].lastSeen) <= maxAge)
+    {
+      if (dst != src)
+      {
+        devTable[dst] = devTable[src];
+      }
+      dst++;
+    }
+  }
+
+  removed = devTableCount - dst;
+
+  if (removed > 0)
+  {
+    devTableCount = dst;
+    DevTable_reindex();
+  }
+
+  return removed;
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      DevTable_hash
+ *
+ * @brief   FNV-1a hash of a device address, folded to an index slot.
+ *
+ * @param   pAddr - device address
+ *
+ * @return  home slot of the address
+ */
+static uint16_t DevTable_hash(const uint8_t *pAddr)
+{
+  uint32_t hash = 2166136261u;
+  uint8_t i;
+
+  for (i = 0; i < B_ADDR_LEN; i++)
+  {
+    hash ^= pAddr[i];
+    hash *= 16777619u;
+  }
+
+  return (uint16_t)((hash ^ (hash >> 16)) & (DEV_TABLE_INDEX_SIZE - 1));
+}
+
+/*********************************************************************
+ * @fn      DevTable_findSlot
+ *
+ * @brief   Probe the index for an address. The index is never full, so
+ *          the probe ends on the address or on an empty slot.
+ *
+ * @param   pAddr - device address
+ *
+ * @return  slot holding the address, or the empty slot to insert it in
+ */
+static uint16_t DevTable_findSlot(const uint8_t *pAddr)
+{
+  uint16_t slot = DevTable_hash(pAddr);
+
+  while (devTableIndex[slot] != DEV_TABLE_EMPTY &&
+         memcmp(devTable[devTableIndex[slot]].addr, pAddr, B_ADDR_LEN) != 0)
+  {
+    slot = (slot + 1) & (DEV_TABLE_INDEX_SIZE - 1);
+  }
+
+  return slot;
+}
+
+/*********************************************************************
+ * @fn      DevTable_reindex
+ *
+ * @brief   Rebuild the index after entries moved.
+ *
+ * @return  none
+ */
+static void DevTable_reindex(void)
+{
+  uint16_t i;
+
+  memset(devTableIndex, 0xFF, sizeof(devTableIndex));
+
+  for (i = 0; i < devTableCount; i++)
+  {
+    devTableIndex[DevTable_findSlot(devTable[i].addr)] = i;
+  }
+}
+
+/*********************************************************************
+*********************************************************************/
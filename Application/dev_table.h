@@ -0,0 +1,171 @@
+/******************************************************************************
+
+ @file       dev_table.h
+
+ @brief Hash indexed table of discovered devices.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+#ifndef DEVTABLE_H
+#define DEVTABLE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bcomdef.h"
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Number of devices the table can hold
+#ifndef DEV_TABLE_SIZE
+#define DEV_TABLE_SIZE                        128
+#endif
+
+// Number of hash index slots. Must be a power of two and at least
+// twice DEV_TABLE_SIZE so probe sequences stay short.
+#ifndef DEV_TABLE_INDEX_SIZE
+#define DEV_TABLE_INDEX_SIZE                  256
+#endif
+
+// Entry flags
+#define DEV_TABLE_FLAG_AOA                    0x01  // Advertises the AoA service
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Discovered device
+typedef struct
+{
+  uint8_t  addr[B_ADDR_LEN];  // Device address
+  uint8_t  addrType;          // Device address type
+  int8_t   rssi;              // RSSI of the last advertisement
+  uint8_t  flags;             // DEV_TABLE_FLAG_xxx, accumulated
+  uint32_t lastSeen;          // Caller's time base at the last advertisement
+} DevTable_Entry;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * @brief   Empty the table. Also initializes it, call once before
+ *          any other API.
+ */
+extern void DevTable_clear(void);
+
+/*
+ * @brief   Add a device or refresh the one already in the table.
+ *          Flags are OR-ed into the entry so information split over
+ *          advertisement and scan response is kept.
+ *
+ * @param   pAddr    - device address
+ * @param   addrType - device address type
+ * @param   rssi     - RSSI of the advertisement
+ * @param   flags    - DEV_TABLE_FLAG_xxx seen in the advertisement
+ * @param   now      - current time
+ *
+ * @return  the entry, NULL if the device is new and the table is full
+ */
+extern DevTable_Entry *DevTable_update(const uint8_t *pAddr, uint8_t addrType,
+                                       int8_t rssi, uint8_t flags, uint32_t now);
+
+/*
+ * @brief   Look up a device.
+ *
+ * @param   pAddr - device address
+ *
+ * @return  the entry, NULL if the device is not in the table
+ */
+extern DevTable_Entry *DevTable_find(const uint8_t *pAddr);
+
+/*
+ * @brief   Get an entry by position. Entries are kept in the order
+ *          they were first seen.
+ *
+ * @param   idx - position, less than DevTable_count()
+ *
+ * @return  the entry, NULL if idx is out of range
+ */
+extern DevTable_Entry *DevTable_get(uint16_t idx);
+
+/*
+ * @brief   Number of devices in the table.
+ */
+extern uint16_t DevTable_count(void);
+
+/*
+ * @brief   Remove devices not seen for more than maxAge. Positions of
+ *          the remaining entries may change.
+ *
+ * @param   now    - current time
+ * @param   maxAge - maximum time since lastSeen, same unit as now
+ *
+ * @return  number of devices removed
+ */
+extern uint16_t DevTable_age(uint32_t now, uint32_t maxAge);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DEVTABLE_H */
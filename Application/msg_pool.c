@@ -0,0 +1,265 @@
+/******************************************************************************
+
+ @file       msg_pool.c
+
+ @brief This file contains a fixed-size block pool with a few size
+        classes for application messages.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stddef.h>
+#include <ti/sysbios/hal/Hwi.h>
+
+#include "msg_pool.h"
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Free block. The link lives in the first word of the unused block.
+typedef struct freeBlock_t
+{
+  struct freeBlock_t *pNext;
+} freeBlock_t;
+
+// Size class control block
+typedef struct
+{
+  uint8_t       *pStart;   // First byte of the class storage
+  uint8_t       *pEnd;     // One past the last byte of the class storage
+  freeBlock_t   *pFree;    // Head of the free list
+  MsgPool_Stats stats;
+} poolClass_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static poolClass_t poolClasses[MSG_POOL_MAX_CLASSES];
+static uint8_t poolNumClasses = 0;
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      MsgPool_init
+ *
+ * @brief   Initialize the pool and thread every block of every class
+ *          onto its class free list.
+ *
+ * @param   pCfg       - size class table, increasing blockSize order
+ * @param   numClasses - number of entries in pCfg
+ *
+ * @return  none
+ */
+void MsgPool_init(const MsgPool_ClassCfg *pCfg, uint8_t numClasses)
+{
+  uint8_t c;
+
+  if (numClasses > MSG_POOL_MAX_CLASSES)
+  {
+    numClasses = MSG_POOL_MAX_CLASSES;
+  }
+
+  for (c = 0; c < numClasses; c++)
+  {
+    poolClass_t *pClass = &poolClasses[c];
+    uint16_t blockSize = ((pCfg[c].blockSize + 3) / 4) * 4;
+    uint8_t *pBlock = (uint8_t *)pCfg[c].pStorage;
+    uint8_t i;
+
+    pClass->pStart = pBlock;
+    pClass->pEnd = pBlock + ((uint32_t)blockSize * pCfg[c].numBlocks);
+    pClass->pFree = NULL;
+
+    pClass->stats.blockSize = blockSize;
+    pClass->stats.numBlocks = pCfg[c].numBlocks;
+    pClass->stats.inUse = 0;
+    pClass->stats.maxInUse = 0;
+    pClass->stats.numAllocs = 0;
+    pClass->stats.numFails = 0;
+
+    // Build the free list back to front so blocks are handed out in
+    // address order
+    for (i = pCfg[c].numBlocks; i > 0; i--)
+    {
+      freeBlock_t *pFreeBlock = (freeBlock_t *)(pBlock + ((uint32_t)blockSize * (i - 1)));
+
+      pFreeBlock->pNext = pClass->pFree;
+      pClass->pFree = pFreeBlock;
+    }
+  }
+
+  poolNumClasses = numClasses;
+}
+
+/*********************************************************************
+ * @fn      MsgPool_alloc
+ *
+ * @brief   Allocate a block from the smallest class that fits size.
+ *          A class that is exhausted does not spill into a larger one,
+ *          so small messages can never starve large ones.
+ *
+ * @param   size - number of bytes required
+ *
+ * @return  pointer to the block, NULL on failure
+ */
+void *MsgPool_alloc(uint16_t size)
+{
+  uint8_t c;
+
+  for (c = 0; c < poolNumClasses; c++)
+  {
+    poolClass_t *pClass = &poolClasses[c];
+
+    if (size <= pClass->stats.blockSize)
+    {
+      freeBlock_t *pBlock;
+      UInt key = Hwi_disable();
+
+      pBlock = pClass->pFree;
+
+      if (pBlock != NULL)
+      {
+        pClass->pFree = pBlock->pNext;
+
+        pClass->stats.numAllocs++;
+        if (++pClass->stats.inUse > pClass->stats.maxInUse)
+        {
+          pClass->stats.maxInUse = pClass->stats.inUse;
+        }
+      }
+      else
+      {
+        pClass->stats.numFails++;
+      }
+
+      Hwi_restore(key);
+
+      return pBlock;
+    }
+  }
+
+  // No class is large enough
+  return NULL;
+}
+
+/*********************************************************************
+ * @fn      MsgPool_free
+ *
+ * @brief   Return a block to the class that owns its address.
+ *
+ * @param   pBlock - block previously returned by MsgPool_alloc
+ *
+ * @return  none
+ */
+void MsgPool_free(void *pBlock)
+{
+  uint8_t c;
+
+  if (pBlock == NULL)
+  {
+    return;
+  }
+
+  for (c = 0; c < poolNumClasses; c++)
+  {
+    poolClass_t *pClass = &poolClasses[c];
+
+    if (((uint8_t *)pBlock >= pClass->pStart) && ((uint8_t *)pBlock < pClass->pEnd))
+    {
+      UInt key = Hwi_disable();
+
+      ((freeBlock_t *)pBlock)->pNext = pClass->pFree;
+      pClass->pFree = (freeBlock_t *)pBlock;
+      pClass->stats.inUse--;
+
+      Hwi_restore(key);
+
+      return;
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      MsgPool_getStats
+ *
+ * @brief   Read the statistics of a size class.
+ *
+ * @param   classIdx - index of the class in the init table
+ * @param   pStats   - filled with a snapshot of the class statistics
+ *
+ * @return  TRUE if classIdx is valid, FALSE otherwise
+ */
+bool MsgPool_getStats(uint8_t classIdx, MsgPool_Stats *pStats)
+{
+  UInt key;
+
+  if (classIdx >= poolNumClasses || pStats == NULL)
+  {
+    return false;
+  }
+
+  key = Hwi_disable();
+  *pStats = poolClasses[classIdx].stats;
+  Hwi_restore(key);
+
+  return true;
+}
+
+/*********************************************************************
+ * @fn      MsgPool_numClasses
+ *
+ * @brief   Number of size classes the pool was initialized with.
+ *
+ * @return  number of classes
+ */
+uint8_t MsgPool_numClasses(void)
+{
+  return poolNumClasses;
+}
+
+/*********************************************************************
+*********************************************************************/
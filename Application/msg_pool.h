@@ -0,0 +1,160 @@
+/******************************************************************************
+
+ @file       msg_pool.h
+
+ @brief This file contains the fixed-size block pool used for
+        application messages.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+#ifndef MSGPOOL_H
+#define MSGPOOL_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+/*********************************************************************
+*  EXTERNAL VARIABLES
+*/
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Maximum number of size classes a pool can be configured with
+#define MSG_POOL_MAX_CLASSES                  4
+
+/*********************************************************************
+ * MACROS
+ */
+
+// Number of 32-bit words needed to back numBlocks blocks of blockSize
+// bytes. Use this to size the storage handed to MsgPool_init.
+#define MSG_POOL_STORAGE_WORDS(blockSize, numBlocks) \
+  ((((blockSize) + 3) / 4) * (numBlocks))
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Size class configuration
+typedef struct
+{
+  uint16_t blockSize;   // Bytes per block
+  uint8_t  numBlocks;   // Number of blocks in this class
+  uint32_t *pStorage;   // MSG_POOL_STORAGE_WORDS(blockSize, numBlocks) words
+} MsgPool_ClassCfg;
+
+// Per size class statistics
+typedef struct
+{
+  uint16_t blockSize;   // Bytes per block (rounded up to a word)
+  uint8_t  numBlocks;   // Number of blocks in this class
+  uint8_t  inUse;       // Blocks currently allocated
+  uint8_t  maxInUse;    // High-water mark of inUse
+  uint32_t numAllocs;   // Successful allocations
+  uint32_t numFails;    // Allocations refused because the class was empty
+} MsgPool_Stats;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * @brief   Initialize the pool. Classes must be listed in increasing
+ *          blockSize order. Must be called before any other API.
+ *
+ * @param   pCfg       - size class table
+ * @param   numClasses - number of entries in pCfg
+ *                       (at most MSG_POOL_MAX_CLASSES)
+ */
+extern void MsgPool_init(const MsgPool_ClassCfg *pCfg, uint8_t numClasses);
+
+/*
+ * @brief   Allocate a block from the smallest class that fits size.
+ *          Safe to call from Hwi, Swi and Task context.
+ *
+ * @param   size - number of bytes required
+ *
+ * @return  pointer to the block, NULL if the class is exhausted or no
+ *          class is large enough
+ */
+extern void *MsgPool_alloc(uint16_t size);
+
+/*
+ * @brief   Return a block to its class. Safe to call from Hwi, Swi and
+ *          Task context. NULL is ignored.
+ *
+ * @param   pBlock - block previously returned by MsgPool_alloc
+ */
+extern void MsgPool_free(void *pBlock);
+
+/*
+ * @brief   Read the statistics of a size class.
+ *
+ * @param   classIdx - index of the class in the init table
+ * @param   pStats   - filled with a snapshot of the class statistics
+ *
+ * @return  TRUE if classIdx is valid, FALSE otherwise
+ */
+extern bool MsgPool_getStats(uint8_t classIdx, MsgPool_Stats *pStats);
+
+/*
+ * @brief   Number of size classes the pool was initialized with.
+ */
+extern uint8_t MsgPool_numClasses(void);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MSGPOOL_H */
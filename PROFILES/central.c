@@ -136,6 +136,18 @@ static uint32_t gapCentralRoleSignCounter;
 static uint8_t  gapCentralRoleBdAddr[B_ADDR_LEN];
 static uint8_t  gapCentralRoleMaxScanRes = 0;
 static uint8_t  gapCentralRoleParamUpdateReqReply = GAPCENTRALROLE_PARAM_UPDATE_REQ_AUTO_ACCEPT;
+static uint8_t  gapCentralRoleAdvEnabled = FALSE;
+static uint8_t  gapCentralRoleAdvertData[B_MAX_ADV_LEN];
+static uint8_t  gapCentralRoleAdvertDataLen = 0;
+static uint8_t  gapCentralRoleScanRspData[B_MAX_ADV_LEN];
+static uint8_t  gapCentralRoleScanRspDataLen = 0;
+static uint16_t gapCentralRoleAdvConnHandle = GAP_CONNHANDLE_INIT;
+
+// Roles the device was started in, 0 until the stack is initialized
+static uint8_t  gapCentralRoleProfileRole = 0;
+
+// Connectable advertising is on
+static uint8_t  gapCentralRoleAdvertising = FALSE;
 
 /*********************************************************************
  * LOCAL FUNCTIONS
@@ -145,6 +157,7 @@ static void gapCentralRole_taskFxn(UArg a0, UArg a1);
 
 static uint8_t gapCentralRole_processStackMsg(ICall_Hdr *pMsg);
 static uint8_t gapCentralRole_ProcessGAPMsg(gapEventHdr_t *pMsg);
+static void gapCentralRole_setAdvertising(void);
 
 /*********************************************************************
  * CALLBACKS
@@ -167,7 +180,9 @@ bStatus_t GAPCentralRole_StartDevice(gapCentralRoleCB_t *pAppCallbacks)
     pGapCentralRoleCB = pAppCallbacks;
   }
 
-  return GAP_DeviceInit(selfEntity, GAP_PROFILE_CENTRAL,
+  return GAP_DeviceInit(selfEntity,
+                        GAP_PROFILE_CENTRAL |
+                        (gapCentralRoleAdvEnabled ? GAP_PROFILE_PERIPHERAL : 0),
                         gapCentralRoleMaxScanRes, gapCentralRoleIRK,
                         gapCentralRoleSRK, (uint32*)&gapCentralRoleSignCounter);
 }
@@ -235,6 +250,66 @@ bStatus_t GAPCentralRole_SetParameter(uint16_t param, uint8_t len, void *pValue)
       }
       break;
 
+    case GAPCENTRALROLE_ADVERT_ENABLED:
+      if (len == sizeof (uint8_t))
+      {
+        // Once started, only a device started as a peripheral can advertise
+        if (*((uint8_t*)pValue) && gapCentralRoleProfileRole &&
+            !(gapCentralRoleProfileRole & GAP_PROFILE_PERIPHERAL))
+        {
+          ret = bleIncorrectMode;
+        }
+        else
+        {
+          gapCentralRoleAdvEnabled = *((uint8_t*)pValue);
+          gapCentralRole_setAdvertising();
+        }
+      }
+      else
+      {
+        ret = bleInvalidRange;
+      }
+      break;
+
+    case GAPCENTRALROLE_ADVERT_DATA:
+      if (len <= B_MAX_ADV_LEN)
+      {
+        VOID memcpy(gapCentralRoleAdvertData, pValue, len);
+        gapCentralRoleAdvertDataLen = len;
+
+        // The scan response follows once the advertising data is taken
+        if (gapCentralRoleProfileRole & GAP_PROFILE_PERIPHERAL)
+        {
+          ret = GAP_UpdateAdvertisingData(selfEntity, TRUE,
+                                          gapCentralRoleAdvertDataLen,
+                                          gapCentralRoleAdvertData);
+        }
+      }
+      else
+      {
+        ret = bleInvalidRange;
+      }
+      break;
+
+    case GAPCENTRALROLE_SCAN_RSP_DATA:
+      if (len <= B_MAX_ADV_LEN)
+      {
+        VOID memcpy(gapCentralRoleScanRspData, pValue, len);
+        gapCentralRoleScanRspDataLen = len;
+
+        if (gapCentralRoleProfileRole & GAP_PROFILE_PERIPHERAL)
+        {
+          ret = GAP_UpdateAdvertisingData(selfEntity, FALSE,
+                                          gapCentralRoleScanRspDataLen,
+                                          gapCentralRoleScanRspData);
+        }
+      }
+      else
+      {
+        ret = bleInvalidRange;
+      }
+      break;
+
     default:
       ret = INVALIDPARAMETER;
       break;
@@ -274,6 +349,14 @@ bStatus_t GAPCentralRole_GetParameter(uint16_t param, void *pValue)
       *((uint8_t*)pValue) = gapCentralRoleMaxScanRes;
       break;
 
+    case GAPCENTRALROLE_ADVERT_ENABLED:
+      *((uint8_t*)pValue) = gapCentralRoleAdvEnabled;
+      break;
+
+    case GAPCENTRALROLE_ADVERT_CONNHANDLE:
+      *((uint16_t*)pValue) = gapCentralRoleAdvConnHandle;
+      break;
+
     default:
       ret = INVALIDPARAMETER;
       break;
@@ -521,19 +604,65 @@ static uint8_t gapCentralRole_ProcessGAPMsg(gapEventHdr_t *pMsg)
 
           // Save off the information
           VOID memcpy(gapCentralRoleBdAddr, pPkt->devAddr, B_ADDR_LEN);
+
+          gapCentralRoleProfileRole = GAP_PROFILE_CENTRAL |
+            (gapCentralRoleAdvEnabled ? GAP_PROFILE_PERIPHERAL : 0);
+
+          // Advertising starts once the data is in place
+          if (gapCentralRoleProfileRole & GAP_PROFILE_PERIPHERAL)
+          {
+            VOID GAP_UpdateAdvertisingData(selfEntity, TRUE,
+                                           gapCentralRoleAdvertDataLen,
+                                           gapCentralRoleAdvertData);
+          }
         }
       }
       break;
 
+    case GAP_ADV_DATA_UPDATE_DONE_EVENT:
+      {
+        gapAdvDataUpdateEvent_t *pPkt = (gapAdvDataUpdateEvent_t *) pMsg;
+
+        if (pPkt->hdr.status == SUCCESS && pPkt->adType)
+        {
+          VOID GAP_UpdateAdvertisingData(selfEntity, FALSE,
+                                         gapCentralRoleScanRspDataLen,
+                                         gapCentralRoleScanRspData);
+        }
+        else
+        {
+          gapCentralRole_setAdvertising();
+        }
+      }
+      break;
+
+    case GAP_MAKE_DISCOVERABLE_DONE_EVENT:
+      gapCentralRoleAdvertising = (pMsg->hdr.status == SUCCESS);
+      break;
+
+    case GAP_END_DISCOVERABLE_DONE_EVENT:
+      if (pMsg->hdr.status == SUCCESS)
+      {
+        gapCentralRoleAdvertising = FALSE;
+      }
+      break;
+
     case GAP_LINK_ESTABLISHED_EVENT:
       {
         gapEstLinkReqEvent_t *pPkt = (gapEstLinkReqEvent_t *) pMsg;
 
         if (pPkt->hdr.status == SUCCESS)
         {
+          // A peer connected to the advertising, which stopped with it
+          if (pPkt->connRole == GAP_PROFILE_PERIPHERAL)
+          {
+            gapCentralRoleAdvConnHandle = pPkt->connectionHandle;
+            gapCentralRoleAdvertising = FALSE;
+          }
+
           // Notify the Bond Manager of the connection
           VOID GAPBondMgr_LinkEst(pPkt->devAddrType, pPkt->devAddr,
-                                   pPkt->connectionHandle, GAP_PROFILE_CENTRAL);
+                                   pPkt->connectionHandle, pPkt->connRole);
         }
       }
       break;
@@ -543,6 +672,13 @@ static uint8_t gapCentralRole_ProcessGAPMsg(gapEventHdr_t *pMsg)
         uint16_t connHandle = ((gapTerminateLinkEvent_t *)pMsg)->connectionHandle;
 
         GAPBondMgr_LinkTerm(connHandle);
+
+        // Let the next peer connect
+        if (connHandle == gapCentralRoleAdvConnHandle)
+        {
+          gapCentralRoleAdvConnHandle = GAP_CONNHANDLE_INIT;
+          gapCentralRole_setAdvertising();
+        }
       }
       break;
 
@@ -605,6 +741,41 @@ static uint8_t gapCentralRole_ProcessGAPMsg(gapEventHdr_t *pMsg)
   return (TRUE);
 }
 
+/*********************************************************************
+ * @fn      gapCentralRole_setAdvertising
+ *
+ * @brief   Start or stop connectable advertising to match
+ *          GAPCENTRALROLE_ADVERT_ENABLED. Nothing is advertised while a
+ *          peer is connected to it.
+ *
+ * @return  none
+ */
+static void gapCentralRole_setAdvertising(void)
+{
+  if (!(gapCentralRoleProfileRole & GAP_PROFILE_PERIPHERAL))
+  {
+    return;
+  }
+
+  if (gapCentralRoleAdvEnabled && !gapCentralRoleAdvertising &&
+      gapCentralRoleAdvConnHandle == GAP_CONNHANDLE_INIT)
+  {
+    gapAdvertisingParams_t params;
+
+    params.eventType = GAP_ADTYPE_ADV_IND;
+    params.initiatorAddrType = ADDRTYPE_PUBLIC;
+    VOID memset(params.initiatorAddr, 0, B_ADDR_LEN);
+    params.channelMap = GAP_ADVCHAN_ALL;
+    params.filterPolicy = GAP_FILTER_POLICY_ALL;
+
+    VOID GAP_MakeDiscoverable(selfEntity, &params);
+  }
+  else if (!gapCentralRoleAdvEnabled && gapCentralRoleAdvertising)
+  {
+    VOID GAP_EndDiscoverable(selfEntity);
+  }
+}
+
 
 /*********************************************************************
 *********************************************************************/
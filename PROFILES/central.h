@@ -148,6 +148,52 @@ extern "C"
  * range: @ref Central_Param_Update_Options
  */
 #define GAPCENTRALROLE_LINK_PARAM_UPDATE_REQ_REPLY 0x405
+
+/**
+ * @brief Connectable advertising next to the central links (Read/Write)
+ *
+ * Lets one peer connect to this device as a peripheral, e.g. to read its
+ * GATT server, while it keeps scanning and initiating its own links.
+ * The device is started in both roles if this is TRUE when
+ * @ref GAPCentralRole_StartDevice is called, the stack must be built with
+ * the peripheral role and room for the extra connection. Advertising
+ * resumes when the peripheral link is lost.
+ *
+ * size: uint8_t
+ *
+ * default: FALSE
+ *
+ * range: TRUE (advertise) or FALSE (stop advertising)
+ */
+#define GAPCENTRALROLE_ADVERT_ENABLED              0x406
+
+/**
+ * @brief Advertising data (Write-only)
+ *
+ * size: uint8_t[0..B_MAX_ADV_LEN]
+ *
+ * default: empty
+ */
+#define GAPCENTRALROLE_ADVERT_DATA                 0x407
+
+/**
+ * @brief Scan response data (Write-only)
+ *
+ * size: uint8_t[0..B_MAX_ADV_LEN]
+ *
+ * default: empty
+ */
+#define GAPCENTRALROLE_SCAN_RSP_DATA               0x408
+
+/**
+ * @brief Handle of the link a peer made to this device (Read-only)
+ *
+ * size: uint16_t
+ *
+ * default: GAP_CONNHANDLE_INIT, no peripheral link
+ */
+#define GAPCENTRALROLE_ADVERT_CONNHANDLE           0x409
+
 /** @} End Central_Params */
 
 /** @defgroup Central_Param_Update_Options Param Update Request Reply operations
@@ -178,7 +178,7 @@ int main()
   /* Kick off profile - Priority 3 */
   GAPCentralRole_createTask();
 
-  /* Kick off application - Priority 1 */
+  /* Kick off application - Priority 2, estimation worker - Priority 1 */
   AoAReceiver_createTask();
 
   /* enable interrupts and start SYS/BIOS */
@@ -0,0 +1,782 @@
+#!/usr/bin/env python
+"""
+Host client for the AoA Receiver UART command interface.
+
+Frames, both directions:  SOF(0xFE) | LEN | CMD | DATA[LEN] | FCS
+FCS is the XOR of LEN, CMD and DATA. Responses echo CMD | 0x80 and start
+DATA with a status byte. Display text shares the UART and is skipped.
+
+Examples:
+  aoa_cmd.py -p COM5 ping
+  aoa_cmd.py -p COM5 discover --continuous --auto-connect
+  aoa_cmd.py -p COM5 monitor 30
+  aoa_cmd.py -p /dev/ttyACM0 -p /dev/ttyACM2 channels 37 38 39
+  aoa_cmd.py -p COM5 connect 0x001122334455 --addr-type 0
+  aoa_cmd.py -p COM5 script fleet.txt
+  aoa_cmd.py -p COM5 ant-load a2 array.json --save
+  aoa_cmd.py -p COM5 duty 10 --min-rate 1 --per-tag 2
+
+An antenna configuration file is JSON:
+  {"antennas": 3, "initial": "0x20000000",
+   "patterns": ["0x40000000", "0x20000000", ...],
+   "pairs": [{"a": 0, "b": 1, "sign": -1, "offset": -25, "gain": 0.8}, ...]}
+Patterns are the antenna switch pins set in each slot. Optional
+"elements": [[x, y], ...] gives the position of each antenna in 0.1 mm
+and "mount_azimuth" the azimuth of the x axis in degrees; with them the
+receiver solves azimuth and, for planar arrays, elevation. The pair
+offset and gain must then calibrate the pair angle to the phase of b
+relative to a in degrees.
+
+A script holds one command per line, as typed after the port options.
+Blank lines and lines starting with '#' are ignored.
+
+Receivers built with AOA_INJECT accept inject-adv, inject-conn-evt and
+inject-iq, so a script can play a scenario through the real state
+machine. An I/Q capture file is JSON, samples packed as the receiver
+stores them (raw value = packed << shift):
+  {"array": "a1", "channel": 37, "rssi": -55, "shift": 4, "slot_len": 8,
+   "addr": "0xAABBCCDDEEFF", "samples": [[i, q], ...]}
+
+Receivers built with AOA_BENCH time code sections of the capture and
+discovery paths on synthetic input, with AoA stopped. bench prints one
+JSON object per line, times in CPU cycles:
+  {"port": "COM5", "label": "r2", "section": "pair_angles",
+   "unit": "cycles", "iterations": 100, "min": 51234, "avg": 51301,
+   "max": 52410}
+After all sections a "per_capture" line adds up the averages of one
+capture's path: copy, queue, pair angles and half an estimate (one per
+A1/A2 pair).
+
+SimPort stands in for the serial port with the host simulation
+(host/sim, aoa_sim --serve), so the tools run without a board.
+
+Requires pyserial, except on a SimPort.
+"""
+
+import argparse
+import json
+import os
+import select
+import shlex
+import struct
+import subprocess
+import sys
+import time
+
+try:
+    import serial
+except ImportError:
+    serial = None
+
+SOF = 0xFE
+RSP_FLAG = 0x80
+MAX_PAYLOAD = 64
+
+CMD_PING = 0x01
+CMD_GET_STATE = 0x02
+CMD_GET_STATS = 0x03
+CMD_GET_DEVICES = 0x04
+CMD_IDLE_AOA_START = 0x10
+CMD_IDLE_AOA_STOP = 0x11
+CMD_DISCOVER = 0x12
+CMD_CONNECT = 0x13
+CMD_DISCONNECT = 0x14
+CMD_CONN_AOA = 0x15
+CMD_DISCOVER_STOP = 0x16
+CMD_SET_CHANNELS = 0x20
+CMD_SET_RSSI_THRESHOLD = 0x21
+CMD_SET_RSSI_FILTER = 0x22
+CMD_SET_OPTIONS = 0x23
+CMD_FILTER_ADD = 0x24
+CMD_FILTER_CLEAR = 0x25
+CMD_SET_IQ_GATE = 0x26
+CMD_SET_SLOT_MAP = 0x27
+CMD_ANT_BEGIN = 0x28
+CMD_ANT_PATTERNS = 0x29
+CMD_ANT_PAIR = 0x2A
+CMD_ANT_COMMIT = 0x2B
+CMD_ANT_RESTORE = 0x2C
+CMD_ANT_GEOMETRY = 0x2D
+CMD_SET_DUTY = 0x2E
+CMD_SET_TRIGGER = 0x2F
+CMD_SET_CONN_CTRL = 0x30
+CMD_SET_SENDER = 0x31
+CMD_SET_BACKHAUL = 0x32
+CMD_INJECT_ADV = 0x33
+CMD_INJECT_CONN_EVT = 0x34
+CMD_INJECT_IQ_BEGIN = 0x35
+CMD_INJECT_IQ_DATA = 0x36
+CMD_INJECT_IQ_COMMIT = 0x37
+CMD_BENCH = 0x38
+
+IND_DEVICE = 0x40
+IND_ANGLE = 0x41
+IND_IQ_BEGIN = 0x42
+IND_IQ_DATA = 0x43
+
+NO_ELEVATION = 0x7FFF
+
+DISC_CONTINUOUS = 0x01
+DISC_AUTO_CONNECT = 0x02
+
+CONN_AOA_MODES = {'off': 0, 'manual': 1, 'auto': 2}
+
+ANT_ARRAYS = {'a1': 0, 'a2': 1}
+ANT_SOURCES = ['built-in', 'stored', 'loaded']
+ANT_PERSIST = 0x01
+ANT_PATTERNS_PER_FRAME = (MAX_PAYLOAD - 2) // 4
+INJECT_IQ_PER_FRAME = (MAX_PAYLOAD - 2) // 2
+
+BENCH_SECTIONS = ['pair_angles', 'estimate', 'find_svc', 'add_device', 'queue',
+                  'util_queue', 'iq_copy']
+BENCH_UNITS = ['cycles', 'ns']
+
+OPT_PIPELINED = 0x01
+OPT_COALESCE = 0x02
+OPT_FAST_DISC = 0x04
+OPT_ANGLE_IND = 0x08
+OPT_IQ_IND = 0x10
+OPT_FUSION = 0x20
+
+DEVICE_ENTRY_LEN = 11
+DEV_FLAG_AOA = 0x01
+
+STATS_COUNTERS = 0x00
+STATS_TRIGGER = 0x01
+STATS_CONN_CTRL = 0x02
+STATS_LINK = 0x03
+STATS_BACKHAUL = 0x04
+STATS_POOL = 0x10
+
+COUNTER_NAMES = ['aoa_reports', 'aoa_failures', 'angles', 'worker_drops',
+                 'conn_evt_coalesced', 'cmd_frames', 'cmd_fcs_errors',
+                 'cmd_overruns', 'aoa_filtered', 'iq_low_amplitude',
+                 'iq_low_coherence', 'radio_on_ms', 'duty_rounds',
+                 'duty_waits']
+
+STATE_NAMES = ['idle', 'connecting', 'connected', 'disconnecting',
+               'idle_aoa_scanning', 'connected_aoa_scanning']
+
+STATUS_NAMES = {0x00: 'SUCCESS', 0x01: 'FAILURE', 0x02: 'INVALIDPARAMETER',
+                0x12: 'bleIncorrectMode',
+                0x15: 'bleNoResources', 0xE0: 'UNKNOWN_CMD',
+                0xE1: 'BAD_LENGTH'}
+
+
+class CmdError(Exception):
+    pass
+
+
+class SimPort(object):
+    """Runs the host simulation in serve mode and talks to its command
+    UART over pipes. Reads return what arrived within the timeout, as on
+    a serial port."""
+
+    def __init__(self, command, timeout=1.0, log=None):
+        self.proc = subprocess.Popen(shlex.split(command) + ['--serve'],
+                                     stdin=subprocess.PIPE,
+                                     stdout=subprocess.PIPE, stderr=log)
+        self.timeout = timeout
+
+    def read(self, size=1):
+        fd = self.proc.stdout.fileno()
+        ready = select.select([fd], [], [], self.timeout)[0]
+        return os.read(fd, size) if ready else b''
+
+    def write(self, data):
+        self.proc.stdin.write(bytes(data))
+        self.proc.stdin.flush()
+
+    def close(self):
+        self.proc.stdin.close()
+        self.proc.wait()
+
+
+class AoAReceiver(object):
+    def __init__(self, port, baud=115200, timeout=1.0, ser=None):
+        if ser is None:
+            if serial is None:
+                raise CmdError('%s: pyserial is not installed' % port)
+            ser = serial.Serial(port, baud, timeout=timeout)
+        self.ser = ser
+        self.port = port
+        self.timeout = timeout
+        self.buf = bytearray()
+        self.indications = []
+
+    def close(self):
+        self.ser.close()
+
+    def _read_frame(self):
+        deadline = time.time() + self.timeout
+        while time.time() < deadline:
+            self.buf += bytearray(self.ser.read(1))
+            while True:
+                # Display text shares the UART, skip to the next SOF
+                start = self.buf.find(bytearray([SOF]))
+                if start < 0:
+                    del self.buf[:]
+                    break
+                del self.buf[:start]
+                if len(self.buf) > 1 and self.buf[1] > MAX_PAYLOAD:
+                    del self.buf[:1]
+                    continue
+                if len(self.buf) < 3 or len(self.buf) < self.buf[1] + 4:
+                    break
+                length, cmd = self.buf[1], self.buf[2]
+                data = self.buf[3:3 + length]
+                fcs = length ^ cmd
+                for x in data:
+                    fcs ^= x
+                if fcs != self.buf[3 + length]:
+                    # Not a frame, resume after this SOF
+                    del self.buf[:1]
+                    continue
+                del self.buf[:4 + length]
+                return cmd, data
+        raise CmdError('%s: no response' % self.port)
+
+    def request(self, cmd, data=b''):
+        data = bytearray(data)
+        frame = bytearray([SOF, len(data), cmd]) + data
+        fcs = 0
+        for x in frame[1:]:
+            fcs ^= x
+        frame.append(fcs)
+        self.ser.write(frame)
+        while True:
+            rcmd, rdata = self._read_frame()
+            if rcmd == (cmd | RSP_FLAG):
+                break
+            if not rcmd & RSP_FLAG:
+                self.indications.append((rcmd, bytes(rdata)))
+        status = rdata[0]
+        if status != 0:
+            raise CmdError('%s: command 0x%02X failed: %s'
+                           % (self.port, cmd,
+                              STATUS_NAMES.get(status, '0x%02X' % status)))
+        return bytes(rdata[1:])
+
+    def wait_indication(self, timeout):
+        """Return the next (cmd, data) indication, None on timeout."""
+        if self.indications:
+            return self.indications.pop(0)
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            try:
+                rcmd, rdata = self._read_frame()
+            except CmdError:
+                continue
+            if not rcmd & RSP_FLAG:
+                return rcmd, bytes(rdata)
+        return None
+
+    def ping(self):
+        return bytearray(self.request(CMD_PING))[0]
+
+    def get_state(self):
+        d = bytearray(self.request(CMD_GET_STATE))
+        flags = d[1]
+        n = d[8]
+        return {
+            'state': STATE_NAMES[d[0]] if d[0] < len(STATE_NAMES) else d[0],
+            'idle_aoa': bool(flags & 0x01),
+            'conn_aoa': bool(flags & 0x02),
+            'auto_aoa': bool(flags & 0x04),
+            'sender_active': bool(flags & 0x08),
+            'discovering': bool(flags & 0x10),
+            'continuous_discovery': bool(flags & 0x20),
+            'auto_connect': bool(flags & 0x40),
+            'conn_handle': d[2] | (d[3] << 8),
+            'rssi_threshold': struct.unpack('b', bytes(d[4:5]))[0],
+            'rssi_hysteresis': struct.unpack('b', bytes(d[5:6]))[0],
+            'rssi_alpha': d[6],
+            'rssi': struct.unpack('b', bytes(d[7:8]))[0],
+            'channels': list(d[9:9 + n]),
+            'antennas': [ANT_SOURCES[x] if x < len(ANT_SOURCES) else x
+                         for x in d[9 + n:11 + n]],
+            'duty_rate': d[11 + n],
+            'duty_tags': d[12 + n],
+        }
+
+    def get_counters(self):
+        d = self.request(CMD_GET_STATS, [STATS_COUNTERS])
+        values = struct.unpack('<%dI' % (len(d) // 4), d)
+        return dict(zip(COUNTER_NAMES, values))
+
+    def get_trigger_stats(self):
+        d = self.request(CMD_GET_STATS, [STATS_TRIGGER])
+        return dict(zip(['trigger_requests', 'trigger_held'],
+                        struct.unpack('<II', d)))
+
+    def get_conn_ctrl_stats(self):
+        d = self.request(CMD_GET_STATS, [STATS_CONN_CTRL])
+        return dict(zip(['conn_updates', 'conn_update_failures',
+                         'conn_interval'], struct.unpack('<IIH', d)))
+
+    def get_link_stats(self):
+        d = self.request(CMD_GET_STATS, [STATS_LINK])
+        return dict(zip(['link_disc_ms', 'link_first_angle_ms'],
+                        struct.unpack('<II', d)))
+
+    def get_backhaul_stats(self):
+        d = self.request(CMD_GET_STATS, [STATS_BACKHAUL])
+        return dict(zip(['backhaul_records', 'backhaul_notifications',
+                         'backhaul_dropped'], struct.unpack('<III', d)))
+
+    def get_pool(self, idx):
+        d = self.request(CMD_GET_STATS, [STATS_POOL + idx])
+        keys = ['block_size', 'num_blocks', 'in_use', 'max_in_use',
+                'num_allocs', 'num_fails']
+        return dict(zip(keys, struct.unpack('<HBBBII', d)))
+
+    def get_pools(self):
+        pools = []
+        while True:
+            try:
+                pools.append(self.get_pool(len(pools)))
+            except CmdError:
+                return pools
+
+    def get_devices(self):
+        devices = []
+        while True:
+            d = self.request(CMD_GET_DEVICES, struct.pack('<H', len(devices)))
+            count, first = struct.unpack('<HH', d[:4])
+            entries = d[4:]
+            for i in range(0, len(entries) - DEVICE_ENTRY_LEN + 1,
+                           DEVICE_ENTRY_LEN):
+                e = entries[i:i + DEVICE_ENTRY_LEN]
+                addr_type, rssi, flags, age = struct.unpack('<B6xbBH', e)
+                devices.append({'addr': format_addr(e[1:7]),
+                                'addr_type': addr_type, 'rssi': rssi,
+                                'aoa': bool(flags & DEV_FLAG_AOA),
+                                'age_ms': age})
+            if len(devices) >= count or not entries:
+                return devices
+
+    def connect(self, addr, addr_type):
+        self.request(CMD_CONNECT, [addr_type] + parse_addr(addr))
+
+    def set_channels(self, channels):
+        self.request(CMD_SET_CHANNELS, channels)
+
+    def set_rssi_threshold(self, threshold, hysteresis):
+        self.request(CMD_SET_RSSI_THRESHOLD,
+                     struct.pack('bb', threshold, hysteresis))
+
+    def set_rssi_filter(self, alpha):
+        self.request(CMD_SET_RSSI_FILTER, [alpha])
+
+    def set_options(self, pipelined, coalesce, fast_disc, angle_ind=False,
+                    iq_ind=False, fusion=False):
+        opts = (OPT_PIPELINED if pipelined else 0) | \
+               (OPT_COALESCE if coalesce else 0) | \
+               (OPT_FAST_DISC if fast_disc else 0) | \
+               (OPT_ANGLE_IND if angle_ind else 0) | \
+               (OPT_IQ_IND if iq_ind else 0) | \
+               (OPT_FUSION if fusion else 0)
+        self.request(CMD_SET_OPTIONS, [opts])
+
+    def load_antenna_config(self, array, config, save):
+        patterns = [int(str(x), 0) for x in config['patterns']]
+        pairs = config['pairs']
+        self.request(CMD_ANT_BEGIN,
+                     struct.pack('<BBBBI', array, config['antennas'],
+                                 len(patterns), len(pairs),
+                                 int(str(config['initial']), 0)))
+        for first in range(0, len(patterns), ANT_PATTERNS_PER_FRAME):
+            chunk = patterns[first:first + ANT_PATTERNS_PER_FRAME]
+            self.request(CMD_ANT_PATTERNS,
+                         struct.pack('<BB%dI' % len(chunk), array, first,
+                                     *chunk))
+        for i, pair in enumerate(pairs):
+            self.request(CMD_ANT_PAIR,
+                         struct.pack('<BBBBbbf', array, i, pair['a'],
+                                     pair['b'], pair['sign'],
+                                     pair['offset'], pair['gain']))
+        if 'elements' in config:
+            elements = [v for xy in config['elements'] for v in xy]
+            self.request(CMD_ANT_GEOMETRY,
+                         struct.pack('<Bh%dh' % len(elements), array,
+                                     config.get('mount_azimuth', 0),
+                                     *elements))
+        self.request(CMD_ANT_COMMIT, [array, ANT_PERSIST if save else 0])
+
+    def bench(self, section, iterations):
+        if section not in BENCH_SECTIONS:
+            raise CmdError('%s: unknown bench section %s'
+                           % (self.port, section))
+        d = self.request(CMD_BENCH,
+                         struct.pack('<BH', BENCH_SECTIONS.index(section),
+                                     iterations))
+        unit, count, lo, avg, hi = struct.unpack('<BHIII', d[:15])
+        return {'section': section, 'unit': BENCH_UNITS[unit],
+                'iterations': count, 'min': lo, 'avg': avg, 'max': hi}
+
+    def inject_iq(self, capture):
+        samples = capture['samples']
+        slot_len = capture['slot_len']
+        self.request(CMD_INJECT_IQ_BEGIN,
+                     struct.pack('<BBbBBH', ANT_ARRAYS[capture['array']],
+                                 capture['channel'], capture['rssi'],
+                                 capture.get('shift', 0), slot_len,
+                                 len(samples)) +
+                     bytearray(parse_addr(capture['addr'])))
+        for first in range(0, len(samples), INJECT_IQ_PER_FRAME):
+            chunk = [v for iq in samples[first:first + INJECT_IQ_PER_FRAME]
+                     for v in iq]
+            self.request(CMD_INJECT_IQ_DATA,
+                         struct.pack('<H%db' % len(chunk), first, *chunk))
+        self.request(CMD_INJECT_IQ_COMMIT)
+
+
+def parse_angle(data):
+    """Decode an IND_ANGLE. 'current' and 'current_elevation' are the
+    angle of the capture pair alone, the others the moving average."""
+    keys = ['angle', 'current', 'elevation', 'current_elevation', 'rssi',
+            'channel', 'antenna', 'estimate_us']
+    angle = dict(zip(keys, struct.unpack('<hhhhbBBH', data[6:19])))
+    for k in ('elevation', 'current_elevation'):
+        if angle[k] == NO_ELEVATION:
+            angle[k] = None
+    angle['addr'] = format_addr(data[0:6])
+    return angle
+
+
+def parse_addr(text):
+    """Parse '0xAABBCCDDEEFF' (as displayed) or 'AA:BB:CC:DD:EE:FF' into
+    over-the-air order."""
+    text = text.lower().replace('0x', '').replace(':', '')
+    if len(text) != 12:
+        raise ValueError('bad address %r' % text)
+    return list(reversed(bytearray.fromhex(text)))
+
+
+def format_addr(addr):
+    return '0x' + ''.join('%02X' % x for x in reversed(bytearray(addr)))
+
+
+def on_off(text):
+    if text.lower() in ('1', 'on', 'true', 'yes'):
+        return True
+    if text.lower() in ('0', 'off', 'false', 'no'):
+        return False
+    raise argparse.ArgumentTypeError('expected on/off')
+
+
+def build_parser():
+    p = argparse.ArgumentParser(description=__doc__.split('\n\n')[1],
+                                formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument('-p', '--port', action='append', required=True,
+                   help='serial port, repeat to address several receivers')
+    p.add_argument('-b', '--baud', type=int, default=115200)
+    p.add_argument('-t', '--timeout', type=float, default=1.0)
+    p.add_argument('command', nargs=argparse.REMAINDER,
+                   help='command and arguments, see "help"')
+    return p
+
+
+def build_cmd_parser():
+    p = argparse.ArgumentParser(prog='command', add_help=False)
+    sub = p.add_subparsers(dest='cmd')
+    sub.add_parser('ping')
+    sub.add_parser('state')
+    sub.add_parser('stats')
+    sub.add_parser('devices')
+    c = sub.add_parser('discover')
+    c.add_argument('--continuous', action='store_true')
+    c.add_argument('--auto-connect', action='store_true')
+    sub.add_parser('discover-stop')
+    c = sub.add_parser('monitor')
+    c.add_argument('seconds', type=float)
+    sub.add_parser('idle-start')
+    sub.add_parser('idle-stop')
+    c = sub.add_parser('connect')
+    c.add_argument('addr')
+    c.add_argument('--addr-type', type=int, default=0)
+    sub.add_parser('disconnect')
+    c = sub.add_parser('conn-aoa')
+    c.add_argument('mode', choices=sorted(CONN_AOA_MODES))
+    c = sub.add_parser('channels')
+    c.add_argument('channel', type=int, nargs='+')
+    c = sub.add_parser('rssi-threshold')
+    c.add_argument('threshold', type=int)
+    c.add_argument('hysteresis', type=int)
+    c = sub.add_parser('rssi-filter')
+    c.add_argument('alpha', type=int)
+    c = sub.add_parser('options')
+    c.add_argument('--pipelined', type=on_off, default=False)
+    c.add_argument('--coalesce', type=on_off, default=False)
+    c.add_argument('--fast-disc', type=on_off, default=False)
+    c.add_argument('--angle-ind', type=on_off, default=False,
+                   help='send every angle, shown by monitor')
+    c.add_argument('--iq-ind', type=on_off, default=False,
+                   help='send every capture, see aoa_corpus.py')
+    c.add_argument('--fusion', type=on_off, default=False,
+                   help='one angle per tag and channel cycle')
+    c = sub.add_parser('filter-add')
+    c.add_argument('addr', nargs='+')
+    sub.add_parser('filter-clear')
+    c = sub.add_parser('iq-gate')
+    c.add_argument('min_amplitude', type=int)
+    c.add_argument('min_coherence', type=int, help='percent, 0 disables')
+    c = sub.add_parser('slot-map')
+    c.add_argument('skip', type=int, help='samples dropped after each switch')
+    c.add_argument('keep', type=int, help='samples kept per slot')
+    c = sub.add_parser('trigger')
+    c.add_argument('threshold', type=int, help='dBm')
+    c.add_argument('hysteresis', type=int, help='dB, <= 0')
+    c.add_argument('--alpha', type=int, default=4, help='RSSI filter, 1..16')
+    c.add_argument('--min-on', type=int, default=2000, help='ms')
+    c.add_argument('--min-off', type=int, default=1000, help='ms')
+    c.add_argument('--gap', type=int, default=500,
+                   help='ms between requests to the sender')
+    c.add_argument('--handle', type=int, default=0xFFFF,
+                   help='connection handle, default all peers')
+    c = sub.add_parser('conn-ctrl')
+    c.add_argument('active_rate', type=int,
+                   help='angles per second while the tag moves, 0 disables')
+    c.add_argument('--still-rate', type=int, default=2,
+                   help='angles per second while the tag is still')
+    c.add_argument('--idle-interval', type=int, default=800,
+                   help='1.25 ms units while the sender is off')
+    c.add_argument('--motion', type=int, default=5,
+                   help='degrees that count as movement')
+    c.add_argument('--hold', type=int, default=3000,
+                   help='ms the tag counts as moving')
+    c.add_argument('--gap', type=int, default=2000,
+                   help='ms between update requests')
+    c.add_argument('--handle', type=int, default=0xFFFF,
+                   help='connection handle, default all peers')
+    c = sub.add_parser('sender')
+    c.add_argument('burst', type=int, help='AoA packets per burst')
+    c.add_argument('--period', type=int, default=0,
+                   help='1.25 ms units between bursts, 0 follows the '
+                        'connection interval')
+    c = sub.add_parser('backhaul')
+    c.add_argument('flush', type=int,
+                   help='ms an angle waits for the batch to fill')
+    c = sub.add_parser('inject-adv')
+    c.add_argument('addr')
+    c.add_argument('--addr-type', type=int, default=0)
+    c.add_argument('--rssi', type=int, default=-60)
+    c.add_argument('--data', default='0303B0FF',
+                   help='advertising data in hex, default lists the AoA '
+                        'service')
+    c = sub.add_parser('inject-conn-evt')
+    c.add_argument('--handle', type=int, default=0)
+    c.add_argument('--status', type=int, default=0,
+                   help='0 for a successful event')
+    c.add_argument('--rssi', type=int, default=-60)
+    c = sub.add_parser('inject-iq')
+    c.add_argument('file', help='JSON capture, see above')
+    c = sub.add_parser('bench')
+    c.add_argument('section', nargs='*',
+                   help='default all: %s' % ', '.join(BENCH_SECTIONS))
+    c.add_argument('--iterations', type=int, default=100)
+    c.add_argument('--label', default='',
+                   help='release or build the results belong to')
+    c = sub.add_parser('duty')
+    c.add_argument('max_rate', type=int,
+                   help='rounds per second, 0 scans continuously')
+    c.add_argument('--min-rate', type=int, default=1,
+                   help='rounds per second without recent tags')
+    c.add_argument('--per-tag', type=int, default=2,
+                   help='rounds per second added per recent tag')
+    c.add_argument('--tag-window', type=int, default=5000,
+                   help='ms a tag counts as recent')
+    c = sub.add_parser('ant-load')
+    c.add_argument('array', choices=sorted(ANT_ARRAYS))
+    c.add_argument('file', help='JSON antenna configuration')
+    c.add_argument('--save', action='store_true',
+                   help='keep it across resets')
+    c = sub.add_parser('ant-restore')
+    c.add_argument('array', choices=sorted(ANT_ARRAYS))
+    c = sub.add_parser('sleep')
+    c.add_argument('seconds', type=float)
+    c = sub.add_parser('script')
+    c.add_argument('file')
+    sub.add_parser('help')
+    return p
+
+
+def run(rx, cmd_parser, argv, out):
+    a = cmd_parser.parse_args(argv)
+    tag = rx.port + ': '
+
+    if a.cmd == 'ping':
+        out.write(tag + 'version %d\n' % rx.ping())
+    elif a.cmd == 'state':
+        for k, v in sorted(rx.get_state().items()):
+            out.write(tag + '%s = %s\n' % (k, v))
+    elif a.cmd == 'stats':
+        counters = rx.get_counters()
+        for k in COUNTER_NAMES:
+            out.write(tag + '%s = %d\n' % (k, counters.get(k, 0)))
+        stats = rx.get_trigger_stats()
+        stats.update(rx.get_conn_ctrl_stats())
+        stats.update(rx.get_link_stats())
+        try:
+            stats.update(rx.get_backhaul_stats())
+        except CmdError:
+            pass  # Receiver built without AOA_HUB_LINK
+        for k, v in sorted(stats.items()):
+            out.write(tag + '%s = %d\n' % (k, v))
+        if counters.get('angles'):
+            out.write(tag + 'radio_ms_per_angle = %.1f\n' %
+                      (float(counters.get('radio_on_ms', 0)) /
+                       counters['angles']))
+        for i, pool in enumerate(rx.get_pools()):
+            out.write(tag + 'pool[%d] %s\n' % (
+                i, ' '.join('%s=%d' % (k, pool[k]) for k in sorted(pool))))
+    elif a.cmd == 'devices':
+        for i, dev in enumerate(rx.get_devices()):
+            out.write(tag + '%d %s type %d rssi %d age %d ms%s\n'
+                      % (i, dev['addr'], dev['addr_type'], dev['rssi'],
+                         dev['age_ms'], ' aoa' if dev['aoa'] else ''))
+    elif a.cmd == 'discover':
+        opts = (DISC_CONTINUOUS if a.continuous else 0) | \
+               (DISC_AUTO_CONNECT if a.auto_connect else 0)
+        rx.request(CMD_DISCOVER, [opts])
+    elif a.cmd == 'discover-stop':
+        rx.request(CMD_DISCOVER_STOP)
+    elif a.cmd == 'monitor':
+        deadline = time.time() + a.seconds
+        while time.time() < deadline:
+            ind = rx.wait_indication(deadline - time.time())
+            if ind is None:
+                break
+            cmd, data = ind
+            if cmd == IND_DEVICE and len(data) == 8:
+                out.write(tag + 'device %s type %d rssi %d\n'
+                          % (format_addr(data[1:7]), bytearray(data)[0],
+                             struct.unpack('b', data[7:8])[0]))
+            elif cmd == IND_ANGLE and len(data) == 19:
+                out.write(tag + 'angle %s\n'
+                          % json.dumps(parse_angle(data), sort_keys=True))
+            elif cmd in (IND_IQ_BEGIN, IND_IQ_DATA):
+                pass
+            else:
+                out.write(tag + 'indication 0x%02X %s\n'
+                          % (cmd, ' '.join('%02X' % x for x in bytearray(data))))
+    elif a.cmd == 'idle-start':
+        rx.request(CMD_IDLE_AOA_START)
+    elif a.cmd == 'idle-stop':
+        rx.request(CMD_IDLE_AOA_STOP)
+    elif a.cmd == 'connect':
+        rx.connect(a.addr, a.addr_type)
+    elif a.cmd == 'disconnect':
+        rx.request(CMD_DISCONNECT)
+    elif a.cmd == 'conn-aoa':
+        rx.request(CMD_CONN_AOA, [CONN_AOA_MODES[a.mode]])
+    elif a.cmd == 'channels':
+        rx.set_channels(a.channel)
+    elif a.cmd == 'rssi-threshold':
+        rx.set_rssi_threshold(a.threshold, a.hysteresis)
+    elif a.cmd == 'rssi-filter':
+        rx.set_rssi_filter(a.alpha)
+    elif a.cmd == 'options':
+        rx.set_options(a.pipelined, a.coalesce, a.fast_disc, a.angle_ind,
+                       a.iq_ind, a.fusion)
+    elif a.cmd == 'filter-add':
+        for addr in a.addr:
+            rx.request(CMD_FILTER_ADD, parse_addr(addr))
+    elif a.cmd == 'filter-clear':
+        rx.request(CMD_FILTER_CLEAR)
+    elif a.cmd == 'iq-gate':
+        rx.request(CMD_SET_IQ_GATE,
+                   struct.pack('<HB', a.min_amplitude, a.min_coherence))
+    elif a.cmd == 'slot-map':
+        rx.request(CMD_SET_SLOT_MAP, [a.skip, a.keep])
+    elif a.cmd == 'trigger':
+        rx.request(CMD_SET_TRIGGER,
+                   struct.pack('<HbbBHHH', a.handle, a.threshold,
+                               a.hysteresis, a.alpha, a.min_on, a.min_off,
+                               a.gap))
+    elif a.cmd == 'conn-ctrl':
+        rx.request(CMD_SET_CONN_CTRL,
+                   struct.pack('<HBBHBHH', a.handle, a.active_rate,
+                               a.still_rate, a.idle_interval, a.motion,
+                               a.hold, a.gap))
+    elif a.cmd == 'sender':
+        rx.request(CMD_SET_SENDER, struct.pack('<BH', a.burst, a.period))
+    elif a.cmd == 'backhaul':
+        rx.request(CMD_SET_BACKHAUL, struct.pack('<H', a.flush))
+    elif a.cmd == 'inject-adv':
+        rx.request(CMD_INJECT_ADV,
+                   bytearray([a.addr_type]) + bytearray(parse_addr(a.addr)) +
+                   struct.pack('<b', a.rssi) + bytearray.fromhex(a.data))
+    elif a.cmd == 'inject-conn-evt':
+        rx.request(CMD_INJECT_CONN_EVT,
+                   struct.pack('<HBb', a.handle, a.status, a.rssi))
+    elif a.cmd == 'inject-iq':
+        with open(a.file) as f:
+            rx.inject_iq(json.load(f))
+    elif a.cmd == 'bench':
+        avg = {}
+        for section in a.section or BENCH_SECTIONS:
+            try:
+                result = rx.bench(section, a.iterations)
+            except CmdError as e:
+                # Sections missing from this build are reported, not fatal
+                result = {'section': section, 'error': str(e)}
+            else:
+                avg[section] = result['avg']
+                unit = result['unit']
+            result.update(port=rx.port, label=a.label)
+            out.write(json.dumps(result, sort_keys=True) + '\n')
+        if all(s in avg for s in ('iq_copy', 'queue', 'pair_angles',
+                                  'estimate')):
+            out.write(json.dumps({'port': rx.port, 'label': a.label,
+                                  'section': 'per_capture', 'unit': unit,
+                                  'avg': avg['iq_copy'] + avg['queue'] +
+                                         avg['pair_angles'] +
+                                         avg['estimate'] // 2},
+                                 sort_keys=True) + '\n')
+    elif a.cmd == 'duty':
+        rx.request(CMD_SET_DUTY,
+                   struct.pack('<BBBH', a.max_rate, a.min_rate, a.per_tag,
+                               a.tag_window))
+    elif a.cmd == 'ant-load':
+        with open(a.file) as f:
+            rx.load_antenna_config(ANT_ARRAYS[a.array], json.load(f), a.save)
+    elif a.cmd == 'ant-restore':
+        rx.request(CMD_ANT_RESTORE, [ANT_ARRAYS[a.array]])
+    elif a.cmd == 'sleep':
+        time.sleep(a.seconds)
+    elif a.cmd == 'script':
+        with open(a.file) as f:
+            for line in f:
+                line = line.strip()
+                if line and not line.startswith('#'):
+                    run(rx, cmd_parser, shlex.split(line), out)
+    else:
+        cmd_parser.print_help(out)
+
+
+def main():
+    args = build_parser().parse_args()
+    cmd_parser = build_cmd_parser()
+    failed = False
+
+    for port in args.port:
+        try:
+            rx = AoAReceiver(port, args.baud, args.timeout)
+        except CmdError as e:
+            sys.stderr.write('%s\n' % e)
+            failed = True
+            continue
+        try:
+            run(rx, cmd_parser, args.command or ['help'], sys.stdout)
+        except CmdError as e:
+            sys.stderr.write('%s\n' % e)
+            failed = True
+        finally:
+            rx.close()
+
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,367 @@
+#!/usr/bin/env python
+"""
+Golden I/Q capture corpus for the AoA Receiver: record real captures with
+a known direction, then replay them through a receiver's estimator and
+report angle error and processing time.
+
+Examples:
+  aoa_corpus.py -p COM5 record corpus --addr 0x001122334455 \\
+      --azimuth 30 --scene near --count 20
+  aoa_corpus.py -p COM5 run corpus --label r2 --max-p95-error 10
+  aoa_corpus.py --sim sim/aoa_sim run corpus/seed --max-p95-error 10
+
+A corpus is a directory with a manifest, corpus.json:
+  {"format": 1, "revision": 3,
+   "entries": [{"name": "near-az+30-0000", "azimuth": 30,
+                "elevation": null, "scene": "near", "channels": [37, 38],
+                "rssi": -48, "a1": "captures/near-az+30-0000-a1.json",
+                "a2": "captures/near-az+30-0000-a2.json"}, ...],
+   "arrays": {"a1": "arrays/a1.json", "a2": "arrays/a2.json"}}
+Each entry is one A1 capture and the A2 capture that followed it, which
+the receiver turns into one angle. Capture files use the aoa_cmd.py
+inject-iq format. "revision" counts the recordings added, keep the
+directory under version control and quote it with the results.
+"arrays" is optional: antenna configuration files, in the aoa_cmd.py
+ant-load format, that run loads before replaying and restores after.
+List them when the captures were taken with a loaded configuration.
+
+record needs a receiver built without AOA_STREAM. It keeps the default
+options, enables capture indications and limits AoA to the tag with the
+address filter. Point the tag from the given azimuth (and elevation, for
+planar arrays) and name the scene, e.g. near, far or multipath. Cover
+both arrays' channels by recording with different channel lists.
+
+run needs a receiver built with AOA_INJECT. It sets the address filter
+to an unused address so live captures are dropped, serial idle AoA and
+angle indications, then injects every entry and compares the angle of
+the capture pair with the ground truth. It prints one JSON line per
+entry and per summary group (all, scene, array, channel), and fails if
+a --max-* limit is exceeded. The options and filter are reset to the
+defaults afterwards.
+
+--sim runs the host simulation (host/sim) in place of a board, which
+replays a corpus without hardware. host/corpus/seed is a corpus of
+generated captures (aoa_corpusgen, see host/sim/Makefile) that make
+check replays this way.
+
+Requires pyserial, except with --sim.
+"""
+
+import argparse
+import json
+import os
+import struct
+import sys
+import time
+
+from aoa_cmd import (AoAReceiver, CmdError, SimPort, CMD_ANT_RESTORE,
+                     CMD_FILTER_ADD, CMD_FILTER_CLEAR, CMD_IDLE_AOA_START,
+                     CMD_IDLE_AOA_STOP, IND_ANGLE, IND_IQ_BEGIN, IND_IQ_DATA,
+                     ANT_ARRAYS, format_addr, parse_addr, parse_angle)
+
+CORPUS_FORMAT = 1
+MANIFEST = 'corpus.json'
+
+# Address no tag uses, set as the only filter entry while replaying
+UNUSED_ADDR = '0x000000000000'
+
+ARRAY_NAMES = dict((v, k) for k, v in ANT_ARRAYS.items())
+
+
+def load_manifest(path, create=False):
+    name = os.path.join(path, MANIFEST)
+    if create and not os.path.exists(name):
+        return {'format': CORPUS_FORMAT, 'revision': 0, 'entries': []}
+    with open(name) as f:
+        manifest = json.load(f)
+    if manifest.get('format') != CORPUS_FORMAT:
+        raise ValueError('%s: unsupported format %r'
+                         % (name, manifest.get('format')))
+    return manifest
+
+
+def save_manifest(path, manifest):
+    with open(os.path.join(path, MANIFEST), 'w') as f:
+        json.dump(manifest, f, indent=1, sort_keys=True)
+        f.write('\n')
+
+
+def restore_defaults(rx, arrays=()):
+    rx.request(CMD_IDLE_AOA_STOP)
+    rx.request(CMD_FILTER_CLEAR)
+    rx.set_options(False, False, False)
+    for name in arrays:
+        rx.request(CMD_ANT_RESTORE, [ANT_ARRAYS[name]])
+
+
+def read_capture(rx, deadline):
+    """Assemble the next capture sent as IND_IQ_BEGIN + IND_IQ_DATA into
+    the inject-iq format. None on timeout."""
+    capture = None
+    while time.time() < deadline:
+        ind = rx.wait_indication(deadline - time.time())
+        if ind is None:
+            break
+        cmd, data = ind
+        if cmd == IND_IQ_BEGIN and len(data) == 13:
+            array, channel, rssi, shift, slot_len, num = \
+                struct.unpack('<BBbBBH', data[:7])
+            capture = {'array': ARRAY_NAMES[array], 'channel': channel,
+                       'rssi': rssi, 'shift': shift, 'slot_len': slot_len,
+                       'addr': format_addr(data[7:13]),
+                       'samples': [None] * num}
+        elif cmd == IND_IQ_DATA and capture is not None:
+            first = struct.unpack('<H', data[:2])[0]
+            values = struct.unpack('<%db' % (len(data) - 2), data[2:])
+            for n in range(len(values) // 2):
+                if first + n < len(capture['samples']):
+                    capture['samples'][first + n] = list(values[2 * n:2 * n + 2])
+            if None not in capture['samples']:
+                return capture
+    return None
+
+
+def record(rx, a, out):
+    manifest = load_manifest(a.corpus, create=True)
+    captures_dir = os.path.join(a.corpus, 'captures')
+    if not os.path.isdir(captures_dir):
+        os.makedirs(captures_dir)
+    addr = format_addr(parse_addr(a.addr))
+
+    rx.set_options(False, False, False, iq_ind=True)
+    rx.request(CMD_FILTER_CLEAR)
+    rx.request(CMD_FILTER_ADD, parse_addr(addr))
+    rx.request(CMD_IDLE_AOA_START)
+    try:
+        recorded = 0
+        a1 = None
+        deadline = time.time() + a.max_time
+        while recorded < a.count:
+            capture = read_capture(rx, deadline)
+            if capture is None:
+                break
+            if capture['addr'] != addr:
+                continue
+            if capture['array'] == 'a1':
+                a1 = capture
+                continue
+            if a1 is None:
+                continue
+
+            name = '%s-az%+d-%04d' % (a.scene, a.azimuth,
+                                      len(manifest['entries']))
+            entry = {'name': name, 'azimuth': a.azimuth,
+                     'elevation': a.elevation, 'scene': a.scene,
+                     'channels': [a1['channel'], capture['channel']],
+                     'rssi': max(a1['rssi'], capture['rssi'])}
+            for key, cap in (('a1', a1), ('a2', capture)):
+                entry[key] = 'captures/%s-%s.json' % (name, key)
+                with open(os.path.join(a.corpus, entry[key]), 'w') as f:
+                    json.dump(cap, f)
+            manifest['entries'].append(entry)
+            out.write(json.dumps(entry, sort_keys=True) + '\n')
+            recorded += 1
+            a1 = None
+    finally:
+        restore_defaults(rx)
+
+    if recorded:
+        manifest['revision'] += 1
+        save_manifest(a.corpus, manifest)
+    if recorded < a.count:
+        raise CmdError('%s: recorded %d of %d pairs'
+                       % (rx.port, recorded, a.count))
+
+
+def wrap(degrees):
+    return (degrees + 180) % 360 - 180
+
+
+def percentile(values, p):
+    """Nearest-rank percentile of a non-empty list."""
+    values = sorted(values)
+    rank = max(1, int(-(-p * len(values) // 100)))
+    return values[rank - 1]
+
+
+def summarize(group, results):
+    found = [r for r in results if 'error' in r]
+    line = {'group': group, 'count': len(found),
+            'missing': len(results) - len(found)}
+    if found:
+        errors = [abs(r['error']) for r in found]
+        times = [r['estimate_us'] for r in found]
+        line.update(mean_abs_error=round(float(sum(errors)) / len(errors), 2),
+                    p50_error=percentile(errors, 50),
+                    p90_error=percentile(errors, 90),
+                    p95_error=percentile(errors, 95),
+                    max_error=max(errors),
+                    mean_estimate_us=sum(times) // len(times),
+                    p95_estimate_us=percentile(times, 95))
+        elevations = [abs(r['elevation_error']) for r in found
+                      if r.get('elevation_error') is not None]
+        if elevations:
+            line.update(mean_abs_elevation_error=round(
+                float(sum(elevations)) / len(elevations), 2))
+    return line
+
+
+def wait_angle(rx, addr, deadline):
+    while time.time() < deadline:
+        ind = rx.wait_indication(deadline - time.time())
+        if ind is None:
+            break
+        cmd, data = ind
+        if cmd == IND_ANGLE and len(data) == 19:
+            angle = parse_angle(data)
+            if angle['addr'] == addr:
+                return angle
+    return None
+
+
+def replay(rx, a, out):
+    manifest = load_manifest(a.corpus)
+    common = {'port': rx.port, 'label': a.label,
+              'revision': manifest['revision']}
+    arrays = manifest.get('arrays', {})
+    results = []
+
+    try:
+        for name in sorted(arrays):
+            with open(os.path.join(a.corpus, arrays[name])) as f:
+                rx.load_antenna_config(ANT_ARRAYS[name], json.load(f), False)
+        rx.set_options(False, False, False, angle_ind=True)
+        rx.request(CMD_FILTER_CLEAR)
+        rx.request(CMD_FILTER_ADD, parse_addr(UNUSED_ADDR))
+        rx.request(CMD_IDLE_AOA_START)
+
+        for entry in manifest['entries']:
+            captures = []
+            for key in ('a1', 'a2'):
+                with open(os.path.join(a.corpus, entry[key])) as f:
+                    captures.append(json.load(f))
+            addr = format_addr(parse_addr(captures[0]['addr']))
+
+            for _ in range(a.repeat):
+                for capture in captures:
+                    rx.inject_iq(capture)
+                angle = wait_angle(rx, addr, time.time() + a.angle_timeout)
+
+                result = {'name': entry['name'], 'scene': entry['scene']}
+                if angle is not None:
+                    result.update(array='a%d' % angle['antenna'],
+                                  channel=angle['channel'],
+                                  azimuth=entry['azimuth'],
+                                  measured=angle['current'],
+                                  error=wrap(angle['current'] -
+                                             entry['azimuth']),
+                                  estimate_us=angle['estimate_us'])
+                    if entry.get('elevation') is not None and \
+                            angle['current_elevation'] is not None:
+                        result['elevation_error'] = \
+                            angle['current_elevation'] - entry['elevation']
+                results.append(result)
+                result.update(common)
+                out.write(json.dumps(result, sort_keys=True) + '\n')
+    finally:
+        restore_defaults(rx, sorted(arrays))
+
+    groups = [('all', results)]
+    for key in ('scene', 'array', 'channel'):
+        for value in sorted(set(r[key] for r in results if key in r)):
+            groups.append(('%s:%s' % (key, value),
+                           [r for r in results if r.get(key) == value]))
+    total = None
+    for group, members in groups:
+        line = summarize(group, members)
+        line.update(common)
+        out.write(json.dumps(line, sort_keys=True) + '\n')
+        if total is None:
+            total = line
+
+    failures = []
+    if total['missing']:
+        failures.append('%d entries gave no angle' % total['missing'])
+    for key, limit in (('mean_abs_error', a.max_mean_error),
+                       ('p95_error', a.max_p95_error),
+                       ('p95_estimate_us', a.max_estimate_us)):
+        if limit is not None and total.get(key, 0) > limit:
+            failures.append('%s %s > %s' % (key, total[key], limit))
+    if failures:
+        raise CmdError('%s: %s' % (rx.port, ', '.join(failures)))
+
+
+def build_parser():
+    p = argparse.ArgumentParser(description=__doc__.split('\n\n')[0],
+                                formatter_class=argparse.RawDescriptionHelpFormatter)
+    port = p.add_mutually_exclusive_group(required=True)
+    port.add_argument('-p', '--port')
+    port.add_argument('--sim', metavar='COMMAND',
+                      help='host simulation to run in place of a board, '
+                           'e.g. host/sim/aoa_sim')
+    p.add_argument('--sim-log', default=os.devnull,
+                   help='file for the simulation log')
+    p.add_argument('-b', '--baud', type=int, default=115200)
+    p.add_argument('-t', '--timeout', type=float, default=1.0)
+    sub = p.add_subparsers(dest='cmd')
+    c = sub.add_parser('record')
+    c.add_argument('corpus', help='corpus directory, created if needed')
+    c.add_argument('--addr', required=True, help='tag address')
+    c.add_argument('--azimuth', type=int, required=True,
+                   help='true azimuth of the tag, degrees')
+    c.add_argument('--elevation', type=int, default=None,
+                   help='true elevation of the tag, degrees')
+    c.add_argument('--scene', required=True,
+                   help='e.g. near, far, multipath')
+    c.add_argument('--count', type=int, default=10,
+                   help='A1/A2 capture pairs to record')
+    c.add_argument('--max-time', type=float, default=60.0,
+                   help='seconds to wait for the pairs')
+    c = sub.add_parser('run')
+    c.add_argument('corpus', help='corpus directory')
+    c.add_argument('--label', default='',
+                   help='release or build the results belong to')
+    c.add_argument('--repeat', type=int, default=1,
+                   help='times each entry is replayed')
+    c.add_argument('--angle-timeout', type=float, default=2.0,
+                   help='seconds to wait for the angle of an entry')
+    c.add_argument('--max-mean-error', type=float, default=None)
+    c.add_argument('--max-p95-error', type=float, default=None)
+    c.add_argument('--max-estimate-us', type=int, default=None,
+                   help='limit on the p95 estimation time')
+    return p
+
+
+def main():
+    a = build_parser().parse_args()
+    if a.cmd is None:
+        build_parser().print_help()
+        return 1
+
+    try:
+        if a.sim is not None:
+            log = open(a.sim_log, 'w')
+            rx = AoAReceiver('sim', timeout=a.timeout,
+                             ser=SimPort(a.sim, a.timeout, log))
+        else:
+            rx = AoAReceiver(a.port, a.baud, a.timeout)
+    except (CmdError, OSError) as e:
+        sys.stderr.write('%s\n' % e)
+        return 1
+
+    try:
+        if a.cmd == 'record':
+            record(rx, a, sys.stdout)
+        else:
+            replay(rx, a, sys.stdout)
+    except CmdError as e:
+        sys.stderr.write('%s\n' % e)
+        return 1
+    finally:
+        rx.close()
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,1321 @@
+/******************************************************************************
+
+ @file       sim_sdk.h
+
+ @brief Stand-ins for the SDK declarations used by the receiver, for the
+        host simulation build.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+#ifndef SIM_SDK_H
+#define SIM_SDK_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdarg.h>
+
+/*********************************************************************
+ * XDC / COMPILER
+ */
+
+typedef uint8_t   uint8;
+typedef int8_t    int8;
+typedef uint16_t  uint16;
+typedef int16_t   int16;
+typedef uint32_t  uint32;
+typedef int32_t   int32;
+typedef uintptr_t UArg;
+typedef char      Char;
+typedef int       Int;
+typedef unsigned  UInt;
+typedef uint32_t  UInt32;
+typedef bool      Bool;
+typedef void     *Ptr;
+
+#ifndef TRUE
+#define TRUE                                  1
+#endif
+#ifndef FALSE
+#define FALSE                                 0
+#endif
+#ifndef NULL
+#define NULL                                  ((void *)0)
+#endif
+#ifndef CONST
+#define CONST                                 const
+#endif
+#define VOID                                  (void)
+
+#define HWREG(x)                              (*((volatile uint32_t *)(x)))
+
+#define BIOS_WAIT_FOREVER                     (~0u)
+#define BIOS_NO_WAIT                          0
+
+typedef struct
+{
+  int unused;
+} Error_Block;
+
+#define Error_init(eb)                        ((void)(eb))
+
+extern void BIOS_start(void);
+
+/*********************************************************************
+ * BCOMDEF
+ */
+
+typedef uint8_t bStatus_t;
+
+#define SUCCESS                               0x00
+#define FAILURE                               0x01
+#define INVALIDPARAMETER                      0x02
+#define INVALID_TASK                          0x03
+#define MSG_BUFFER_NOT_AVAIL                  0x04
+#define INVALID_MSG_POINTER                   0x05
+#define bleNotReady                           0x10
+#define bleAlreadyInRequestedMode             0x11
+#define bleIncorrectMode                      0x12
+#define bleMemAllocError                      0x13
+#define bleNotConnected                       0x14
+#define bleNoResources                        0x15
+#define blePending                            0x16
+#define bleTimeout                            0x17
+#define bleInvalidRange                       0x18
+#define bleLinkEncrypted                      0x19
+#define bleProcedureComplete                  0x1A
+
+#define B_ADDR_LEN                            6
+#define KEYLEN                                16
+#define B_MAX_ADV_LEN                         31
+
+#define LO_UINT16(a)                          ((uint8_t)((a) & 0xFF))
+#define HI_UINT16(a)                          ((uint8_t)(((a) >> 8) & 0xFF))
+#define BUILD_UINT16(lo, hi)                  ((uint16_t)(((lo) & 0xFF) + (((hi) & 0xFF) << 8)))
+#define BREAK_UINT32(v, b)                    ((uint8_t)(((v) >> ((b) * 8)) & 0xFF))
+#define BUILD_UINT32(b0, b1, b2, b3)          ((uint32_t)(((uint32_t)(b0) & 0xFF) | \
+                                                          (((uint32_t)(b1) & 0xFF) << 8) | \
+                                                          (((uint32_t)(b2) & 0xFF) << 16) | \
+                                                          (((uint32_t)(b3) & 0xFF) << 24)))
+
+#define ADDRTYPE_PUBLIC                       0x00
+#define ADDRTYPE_RANDOM                       0x01
+#define BLE_ADDR_TYPE_PUBLIC                  ADDRTYPE_PUBLIC
+
+// SNV items of the stack, the application owns BLE_NVID_CUST_xxx
+#define BLE_NVID_IRK                          0x02
+#define BLE_NVID_CSRK                         0x03
+#define BLE_NVID_SIGNCOUNTER                  0x04
+#define BLE_NVID_CUST_START                   0x80
+#define BLE_NVID_CUST_END                     0x8F
+
+typedef struct
+{
+  uint8_t event;
+  uint8_t status;
+} osal_event_hdr_t;
+
+extern uint8_t osal_snv_read(uint8_t id, uint8_t len, void *pBuf);
+extern uint8_t osal_snv_write(uint8_t id, uint8_t len, void *pBuf);
+
+/*********************************************************************
+ * TI-RTOS KERNEL
+ */
+
+struct SimTask;
+
+// Ticks of Clock_tickPeriod microseconds
+extern uint32_t Clock_tickPeriod;
+
+typedef void (*Clock_FuncPtr)(UArg arg);
+
+typedef struct Clock_Struct
+{
+  struct Clock_Struct *next;
+  Clock_FuncPtr fxn;
+  UArg     arg;
+  uint32_t timeout;
+  uint32_t period;
+  uint64_t due;
+  bool     active;
+} Clock_Struct;
+
+typedef Clock_Struct *Clock_Handle;
+
+typedef struct
+{
+  UArg     arg;
+  uint32_t period;
+  bool     startFlag;
+} Clock_Params;
+
+#define Clock_handle(p)                       ((Clock_Handle)(p))
+
+extern void Clock_Params_init(Clock_Params *pParams);
+extern void Clock_construct(Clock_Struct *pClock, Clock_FuncPtr fxn,
+                            uint32_t timeout, const Clock_Params *pParams);
+extern void Clock_start(Clock_Handle handle);
+extern void Clock_stop(Clock_Handle handle);
+extern bool Clock_isActive(Clock_Handle handle);
+extern void Clock_setTimeout(Clock_Handle handle, uint32_t timeout);
+extern void Clock_setPeriod(Clock_Handle handle, uint32_t period);
+extern uint32_t Clock_getTicks(void);
+
+#define Event_Id_NONE                         0
+#define Event_Id_00                           (1u << 0)
+#define Event_Id_01                           (1u << 1)
+#define Event_Id_02                           (1u << 2)
+#define Event_Id_03                           (1u << 3)
+#define Event_Id_04                           (1u << 4)
+#define Event_Id_05                           (1u << 5)
+#define Event_Id_06                           (1u << 6)
+#define Event_Id_07                           (1u << 7)
+#define Event_Id_08                           (1u << 8)
+#define Event_Id_09                           (1u << 9)
+#define Event_Id_10                           (1u << 10)
+#define Event_Id_29                           (1u << 29)
+#define Event_Id_30                           (1u << 30)
+#define Event_Id_31                           (1u << 31)
+
+typedef struct
+{
+  uint32_t posted;
+  uint32_t andMask;
+  uint32_t orMask;
+  struct SimTask *pWaiter;
+} Event_Struct;
+
+typedef Event_Struct *Event_Handle;
+
+typedef struct
+{
+  int unused;
+} Event_Params;
+
+#define Event_handle(p)                       ((Event_Handle)(p))
+
+extern void Event_Params_init(Event_Params *pParams);
+extern void Event_construct(Event_Struct *pEvent, const Event_Params *pParams);
+extern Event_Handle Event_create(const Event_Params *pParams, Error_Block *pEb);
+extern void Event_post(Event_Handle handle, uint32_t eventIds);
+extern uint32_t Event_pend(Event_Handle handle, uint32_t andMask,
+                           uint32_t orMask, uint32_t timeout);
+
+typedef struct Queue_Elem
+{
+  struct Queue_Elem *next;
+  struct Queue_Elem *prev;
+} Queue_Elem;
+
+typedef struct
+{
+  Queue_Elem elem;
+} Queue_Struct;
+
+typedef Queue_Struct *Queue_Handle;
+
+#define Queue_handle(p)                       ((Queue_Handle)(p))
+
+extern void Queue_construct(Queue_Struct *pQueue, void *pParams);
+extern void Queue_put(Queue_Handle handle, Queue_Elem *pElem);
+extern void *Queue_get(Queue_Handle handle);
+extern bool Queue_empty(Queue_Handle handle);
+
+typedef void (*Task_FuncPtr)(UArg arg0, UArg arg1);
+
+typedef struct
+{
+  struct SimTask *pTask;
+} Task_Struct;
+
+typedef struct
+{
+  void    *stack;
+  size_t   stackSize;
+  int      priority;
+  UArg     arg0;
+  UArg     arg1;
+} Task_Params;
+
+extern void Task_Params_init(Task_Params *pParams);
+extern void Task_construct(Task_Struct *pTask, Task_FuncPtr fxn,
+                           const Task_Params *pParams, Error_Block *pEb);
+
+#define Semaphore_Mode_COUNTING               0
+#define Semaphore_Mode_BINARY                 1
+
+typedef struct
+{
+  int      count;
+  int      mode;
+  struct SimTask *pWaiters;
+} Semaphore_Struct;
+
+typedef Semaphore_Struct *Semaphore_Handle;
+
+typedef struct
+{
+  int mode;
+} Semaphore_Params;
+
+#define Semaphore_handle(p)                   ((Semaphore_Handle)(p))
+
+extern void Semaphore_Params_init(Semaphore_Params *pParams);
+extern void Semaphore_construct(Semaphore_Struct *pSem, int count,
+                                const Semaphore_Params *pParams);
+extern bool Semaphore_pend(Semaphore_Handle handle, uint32_t timeout);
+extern void Semaphore_post(Semaphore_Handle handle);
+
+typedef struct
+{
+  int unused;
+} Hwi_Struct;
+
+extern UInt Hwi_disable(void);
+extern void Hwi_restore(UInt key);
+extern UInt Swi_disable(void);
+extern void Swi_restore(UInt key);
+
+/*********************************************************************
+ * DPL
+ */
+
+extern int SystemP_vsnprintf(char *pBuf, size_t n, const char *fmt, va_list va);
+
+/*********************************************************************
+ * DISPLAY
+ */
+
+#define Display_Type_LCD                      0x01
+#define Display_Type_UART                     0x02
+
+#define DISPLAY_STATUS_UNDEFINEDCMD           (-2)
+
+typedef struct Display_Config_ *Display_Handle;
+
+typedef struct Display_Params_ Display_Params;
+
+typedef void (*Display_initFxn)(void);
+typedef Display_Handle (*Display_openFxn)(Display_Handle handle,
+                                          Display_Params *pParams);
+typedef void (*Display_clearFxn)(Display_Handle handle);
+typedef void (*Display_clearLinesFxn)(Display_Handle handle, uint8_t fromLine,
+                                      uint8_t toLine);
+typedef void (*Display_vprintfFxn)(Display_Handle handle, uint8_t line,
+                                   uint8_t column, char *fmt, va_list va);
+typedef void (*Display_closeFxn)(Display_Handle handle);
+typedef int (*Display_controlFxn)(Display_Handle handle, unsigned int cmd,
+                                  void *arg);
+typedef unsigned int (*Display_getTypeFxn)(void);
+
+typedef struct Display_FxnTable_
+{
+  Display_initFxn       initFxn;
+  Display_openFxn       openFxn;
+  Display_clearFxn      clearFxn;
+  Display_clearLinesFxn clearLinesFxn;
+  Display_vprintfFxn    vprintfFxn;
+  Display_closeFxn      closeFxn;
+  Display_controlFxn    controlFxn;
+  Display_getTypeFxn    getTypeFxn;
+} Display_FxnTable;
+
+typedef struct Display_Config_
+{
+  const Display_FxnTable *fxnTablePtr;
+  void                   *object;
+  const void             *hwAttrs;
+} Display_Config;
+
+extern Display_Handle Display_open(uint32_t type, void *pParams);
+extern void Display_printf(Display_Handle handle, uint8_t line,
+                           uint8_t column, char *fmt, ...);
+extern void Display_clearLine(Display_Handle handle, uint8_t line);
+extern void Display_doClearLines(Display_Handle handle, uint8_t fromLine,
+                                 uint8_t toLine);
+
+#define Display_print0(h, l, c, f)            Display_printf(h, l, c, f)
+#define Display_print1(h, l, c, f, a)         Display_printf(h, l, c, f, a)
+#define Display_print2(h, l, c, f, a, b)      Display_printf(h, l, c, f, a, b)
+#define Display_print3(h, l, c, f, a, b, d)   Display_printf(h, l, c, f, a, b, d)
+#define Display_print4(h, l, c, f, a, b, d, e) Display_printf(h, l, c, f, a, b, d, e)
+#define Display_print5(h, l, c, f, a, b, d, e, g) Display_printf(h, l, c, f, a, b, d, e, g)
+#define Display_clearLines                    Display_doClearLines
+
+/*********************************************************************
+ * UART
+ */
+
+#define UART_MODE_BLOCKING                    0
+#define UART_MODE_CALLBACK                    1
+#define UART_DATA_BINARY                      0
+#define UART_DATA_TEXT                        1
+#define UART_RETURN_FULL                      0
+#define UART_RETURN_NEWLINE                   1
+#define UART_ECHO_OFF                         0
+#define UART_ECHO_ON                          1
+#define UART_ERROR                            (-1)
+
+#define UARTCC26XX_CMD_RETURN_PARTIAL_ENABLE  10
+#define UARTCC26XX_CMD_RETURN_PARTIAL_DISABLE 11
+
+struct SimUart;
+
+typedef struct SimUart *UART_Handle;
+
+typedef void (*UART_Callback)(UART_Handle handle, void *pBuf, size_t count);
+
+typedef struct
+{
+  int      readMode;
+  int      writeMode;
+  uint32_t readTimeout;
+  uint32_t writeTimeout;
+  UART_Callback readCallback;
+  UART_Callback writeCallback;
+  int      readReturnMode;
+  int      readDataMode;
+  int      writeDataMode;
+  int      readEcho;
+  uint32_t baudRate;
+} UART_Params;
+
+extern void UART_Params_init(UART_Params *pParams);
+extern UART_Handle UART_open(uint32_t index, const UART_Params *pParams);
+extern int UART_control(UART_Handle handle, unsigned int cmd, void *pArg);
+extern int UART_read(UART_Handle handle, void *pBuf, size_t size);
+extern int UART_write(UART_Handle handle, const void *pBuf, size_t size);
+
+/*********************************************************************
+ * PINS AND BOARD
+ */
+
+#define IOID_13                               13
+#define IOID_14                               14
+#define IOID_27                               27
+#define IOID_28                               28
+#define IOID_29                               29
+#define IOID_30                               30
+
+typedef uint32_t PIN_Config;
+typedef uint32_t PIN_Id;
+
+typedef struct
+{
+  int unused;
+} PIN_State;
+
+typedef PIN_State *PIN_Handle;
+
+typedef void (*PIN_IntCb)(PIN_Handle handle, PIN_Id pinId);
+
+#define PIN_TERMINATE                         0xFE
+#define PIN_ID(x)                             ((x) & 0xFF)
+#define PIN_GPIO_OUTPUT_DIS                   0
+#define PIN_INPUT_EN                          0
+#define PIN_PULLUP                            0
+#define PIN_BM_IRQ                            (1u << 16)
+#define PIN_IRQ_NEGEDGE                       (1u << 16)
+#define PINCC26XX_BM_WAKEUP                   (1u << 27)
+#define PINCC26XX_WAKEUP_NEGEDGE              (1u << 27)
+
+extern PIN_Handle PIN_open(PIN_State *pState, const PIN_Config *pConfig);
+extern int PIN_registerIntCb(PIN_Handle handle, PIN_IntCb callback);
+extern int PIN_setConfig(PIN_Handle handle, PIN_Config bitMask, PIN_Config config);
+extern uint32_t PIN_getInputValue(PIN_Id pinId);
+
+#define Board_BTN1                            IOID_13
+#define Board_BTN2                            IOID_14
+#define Board_UART0                           0
+#define Board_GPTIMER0A                       0
+
+/*********************************************************************
+ * ICALL
+ */
+
+typedef uint8_t ICall_EntityID;
+typedef Event_Handle ICall_SyncHandle;
+typedef int ICall_ServiceEnum;
+typedef int ICall_Errno;
+typedef uint32_t ICall_CSState;
+
+typedef struct
+{
+  uint8_t event;
+  uint8_t status;
+} ICall_Hdr;
+
+typedef struct
+{
+  ICall_Hdr hdr;
+} ICall_HciExtEvt;
+
+// Stack event flags are sent with signature 0xffff, messages start with
+// an osal_event_hdr_t followed by the opcode
+typedef struct
+{
+  ICall_Hdr hdr;
+  uint16_t  signature;
+  uint32_t  event_flag;
+} ICall_Stack_Event;
+
+#define ICALL_MSG_EVENT_ID                    Event_Id_31
+#define ICALL_TIMEOUT_FOREVER                 0xFFFFFFFF
+#define ICALL_ERRNO_SUCCESS                   0
+#define ICALL_ERRNO_NOMSG                     (-4)
+#define ICALL_SERVICE_CLASS_BLE               0x0018
+#define ICALL_SERVICE_CLASS_BLE_MSG           0x0050
+
+extern void ICall_registerApp(ICall_EntityID *pEntity, ICall_SyncHandle *pSyncHandle);
+extern ICall_Errno ICall_fetchServiceMsg(ICall_ServiceEnum *pSrc,
+                                         ICall_EntityID *pDest, void **ppMsg);
+extern void *ICall_malloc(size_t size);
+extern void ICall_free(void *pMsg);
+extern void *ICall_mallocLimited(size_t size);
+extern void ICall_freeMsg(void *pMsg);
+extern ICall_EntityID ICall_getLocalMsgEntityId(ICall_ServiceEnum service,
+                                                ICall_EntityID entity);
+extern ICall_CSState ICall_enterCriticalSection(void);
+extern void ICall_leaveCriticalSection(ICall_CSState key);
+
+/*********************************************************************
+ * HCI
+ */
+
+#define HCI_GAP_EVENT_EVENT                   0x91
+#define HCI_EXT_CMD_EVENT                     0x93
+#define HCI_COMMAND_COMPLETE_EVENT_CODE       0x0E
+#define HCI_BLE_HARDWARE_ERROR_EVENT_CODE     0x10
+#define HCI_DISCONNECT_REMOTE_USER_TERM       0x13
+#define HCI_SUCCESS                           0x00
+
+#define HAL_ASSERT_CAUSE_HARDWARE_ERROR       0x06
+
+#define LL_RF_RSSI_UNDEFINED                  0x81
+#define LL_RF_RSSI_INVALID                    0x7F
+#define LL_RSSI_NOT_AVAILABLE                 0x7F
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8_t  status;
+  uint16_t cmdOpcode;
+  uint8_t *pReturnParam;
+} hciEvt_CmdComplete_t;
+
+typedef struct
+{
+  uint32_t accessAddr;
+  uint16_t connInterval;
+  uint8_t  hopValue;
+  uint16_t mSCA;
+  uint8_t  nextChan;
+  uint8_t  chanMap[5];
+  uint8_t  crcInit[3];
+} hciActiveConnInfo_t;
+
+extern bStatus_t HCI_EXT_GetActiveConnInfoCmd(uint8_t connId,
+                                              hciActiveConnInfo_t *pConnInfo);
+extern bStatus_t HCI_LE_WriteSuggestedDefaultDataLenCmd(uint16_t txOctets,
+                                                        uint16_t txTime);
+
+/*********************************************************************
+ * GAP
+ */
+
+#define GAP_MSG_EVENT                         0xD0
+
+#define GAP_DEVICE_INIT_DONE_EVENT            0x00
+#define GAP_DEVICE_DISCOVERY_EVENT            0x01
+#define GAP_ADV_DATA_UPDATE_DONE_EVENT        0x02
+#define GAP_MAKE_DISCOVERABLE_DONE_EVENT      0x03
+#define GAP_END_DISCOVERABLE_DONE_EVENT       0x04
+#define GAP_LINK_ESTABLISHED_EVENT            0x05
+#define GAP_LINK_TERMINATED_EVENT             0x06
+#define GAP_LINK_PARAM_UPDATE_EVENT           0x07
+#define GAP_SLAVE_REQUESTED_SECURITY_EVENT    0x0C
+#define GAP_DEVICE_INFO_EVENT                 0x0D
+#define GAP_UPDATE_LINK_PARAM_REQ_EVENT       0x12
+
+#define GAP_PROFILE_BROADCASTER               0x01
+#define GAP_PROFILE_OBSERVER                  0x02
+#define GAP_PROFILE_PERIPHERAL                0x04
+#define GAP_PROFILE_CENTRAL                   0x08
+
+#define GAP_CONNHANDLE_INIT                   0xFFFE
+#define GAP_CONNHANDLE_ALL                    0xFFFF
+#define GAP_DEVICE_NAME_LEN                   21
+
+// Discovery modes
+#define DEVDISC_MODE_NONDISCOVERABLE          0x00
+#define DEVDISC_MODE_GENERAL                  0x01
+#define DEVDISC_MODE_LIMITED                  0x02
+#define DEVDISC_MODE_ALL                      0x03
+
+// Advertising report event types
+#define GAP_ADRPT_ADV_IND                     0x00
+#define GAP_ADRPT_ADV_DIRECT_IND              0x01
+#define GAP_ADRPT_ADV_DISC_IND                0x02
+#define GAP_ADRPT_ADV_NONCONN_IND             0x03
+#define GAP_ADRPT_SCAN_RSP                    0x04
+
+// Advertising data types
+#define GAP_ADTYPE_FLAGS                      0x01
+#define GAP_ADTYPE_16BIT_MORE                 0x02
+#define GAP_ADTYPE_16BIT_COMPLETE             0x03
+#define GAP_ADTYPE_LOCAL_NAME_SHORT           0x08
+#define GAP_ADTYPE_LOCAL_NAME_COMPLETE        0x09
+#define GAP_ADTYPE_FLAGS_GENERAL              0x02
+#define GAP_ADTYPE_FLAGS_BREDR_NOT_SUPPORTED  0x04
+#define GAP_ADTYPE_ADV_IND                    0x00
+#define GAP_ADVCHAN_ALL                       0x07
+#define GAP_FILTER_POLICY_ALL                 0x00
+
+// Connection event reports
+#define GAP_CB_UNREGISTER                     0x00
+#define GAP_CB_REGISTER                       0x01
+#define GAP_CONN_EVT_STAT_SUCCESS             0x00
+#define GAP_CONN_EVT_STAT_CRC_ERROR           0x01
+#define GAP_CONN_EVT_STAT_MISSED              0x02
+
+#define GAP_EVENT_SIGN_COUNTER_CHANGED        0x4000
+
+// GAP parameters
+#define TGAP_GEN_DISC_ADV_MIN                 0
+#define TGAP_LIM_ADV_TIMEOUT                  1
+#define TGAP_GEN_DISC_SCAN                    2
+#define TGAP_LIM_DISC_SCAN                    3
+#define TGAP_CONN_EST_ADV_TIMEOUT             4
+#define TGAP_CONN_PARAM_TIMEOUT               5
+#define TGAP_LIM_DISC_ADV_INT_MIN             6
+#define TGAP_LIM_DISC_ADV_INT_MAX             7
+#define TGAP_GEN_DISC_ADV_INT_MIN             8
+#define TGAP_GEN_DISC_ADV_INT_MAX             9
+#define TGAP_CONN_ADV_INT_MIN                 10
+#define TGAP_CONN_ADV_INT_MAX                 11
+#define TGAP_CONN_SCAN_INT                    12
+#define TGAP_CONN_SCAN_WIND                   13
+#define TGAP_CONN_HIGH_SCAN_INT               14
+#define TGAP_CONN_HIGH_SCAN_WIND              15
+#define TGAP_GEN_DISC_SCAN_INT                16
+#define TGAP_GEN_DISC_SCAN_WIND               17
+#define TGAP_LIM_DISC_SCAN_INT                18
+#define TGAP_LIM_DISC_SCAN_WIND               19
+#define TGAP_CONN_EST_ADV                     20
+#define TGAP_CONN_EST_INT_MIN                 21
+#define TGAP_CONN_EST_INT_MAX                 22
+#define TGAP_CONN_EST_SCAN_INT                23
+#define TGAP_CONN_EST_SCAN_WIND               24
+#define TGAP_CONN_EST_SUPERV_TIMEOUT          25
+#define TGAP_CONN_EST_LATENCY                 26
+#define TGAP_CONN_EST_MIN_CE_LEN              27
+#define TGAP_CONN_EST_MAX_CE_LEN              28
+#define TGAP_PRIVATE_ADDR_INT                 29
+#define TGAP_CONN_PAUSE_CENTRAL               30
+#define TGAP_CONN_PAUSE_PERIPHERAL            31
+#define TGAP_SM_TIMEOUT                       32
+#define TGAP_SM_MIN_KEY_LEN                   33
+#define TGAP_SM_MAX_KEY_LEN                   34
+#define TGAP_FILTER_ADV_REPORTS               35
+#define TGAP_SCAN_RSP_RSSI_MIN                36
+#define TGAP_REJECT_CONN_PARAMS               37
+#define TGAP_PARAMID_MAX                      38
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8_t opcode;
+} gapEventHdr_t;
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8_t  opcode;
+  uint8_t  devAddr[B_ADDR_LEN];
+  uint16_t dataPktLen;
+  uint8_t  numDataPkts;
+} gapDeviceInitDoneEvent_t;
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8_t  opcode;
+  uint8_t  eventType;
+  uint8_t  addrType;
+  uint8_t  addr[B_ADDR_LEN];
+  int8_t   rssi;
+  uint8_t  dataLen;
+  uint8_t *pEvtData;
+} gapDeviceInfoEvent_t;
+
+typedef struct
+{
+  uint8_t eventType;
+  uint8_t addrType;
+  uint8_t addr[B_ADDR_LEN];
+} gapDevRec_t;
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8_t      opcode;
+  uint8_t      numDevs;
+  gapDevRec_t *pDevList;
+} gapDevDiscEvent_t;
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8_t  opcode;
+  uint8_t  devAddrType;
+  uint8_t  devAddr[B_ADDR_LEN];
+  uint16_t connectionHandle;
+  uint8_t  connRole;
+  uint16_t connInterval;
+  uint16_t connLatency;
+  uint16_t connTimeout;
+  uint8_t  clockAccuracy;
+} gapEstLinkReqEvent_t;
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8_t  opcode;
+  uint8_t  status;
+  uint16_t connectionHandle;
+  uint16_t connInterval;
+  uint16_t connLatency;
+  uint16_t connTimeout;
+} gapLinkUpdateEvent_t;
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8_t  opcode;
+  uint16_t connectionHandle;
+  uint8_t  reason;
+} gapTerminateLinkEvent_t;
+
+typedef struct
+{
+  uint16_t connectionHandle;
+  uint16_t intervalMin;
+  uint16_t intervalMax;
+  uint16_t connLatency;
+  uint16_t connTimeout;
+  uint8_t  signalIdentifier;
+} gapUpdateLinkParamReq_t;
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8_t opcode;
+  gapUpdateLinkParamReq_t req;
+} gapUpdateLinkParamReqEvent_t;
+
+typedef struct
+{
+  uint16_t connectionHandle;
+  uint16_t intervalMin;
+  uint16_t intervalMax;
+  uint16_t connLatency;
+  uint16_t connTimeout;
+  uint8_t  signalIdentifier;
+  uint8_t  accepted;
+} gapUpdateLinkParamReqReply_t;
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8_t  opcode;
+  uint8_t  adType;
+} gapAdvDataUpdateEvent_t;
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8_t  opcode;
+  uint16_t connectionHandle;
+  uint8_t  deviceAddr[B_ADDR_LEN];
+  uint8_t  authReq;
+} gapSlaveSecurityReqEvent_t;
+
+typedef struct
+{
+  uint8_t taskID;
+  uint8_t mode;
+  uint8_t activeScan;
+  uint8_t whiteList;
+} gapDevDiscReq_t;
+
+typedef struct
+{
+  uint8_t taskID;
+  uint8_t highDutyCycle;
+  uint8_t whiteList;
+  uint8_t addrTypePeer;
+  uint8_t peerAddr[B_ADDR_LEN];
+} gapEstLinkReq_t;
+
+typedef struct
+{
+  uint8_t eventType;
+  uint8_t initiatorAddrType;
+  uint8_t initiatorAddr[B_ADDR_LEN];
+  uint8_t channelMap;
+  uint8_t filterPolicy;
+} gapAdvertisingParams_t;
+
+typedef struct
+{
+  uint8_t  status;
+  uint16_t handle;
+  uint8_t  channel;
+  uint8_t  phy;
+  int8_t   lastRssi;
+  uint16_t packets;
+  uint16_t errors;
+  uint8_t  nextTaskType;
+  uint32_t nextTaskTime;
+  uint16_t eventCounter;
+  uint32_t timeStamp;
+} Gap_ConnEventRpt_t;
+
+typedef void (*pfnGapConnEvtCB_t)(Gap_ConnEventRpt_t *pReport);
+
+extern bStatus_t GAP_DeviceInit(uint8_t taskID, uint8_t profileRole,
+                                uint8_t maxScanResponses, uint8_t *pIRK,
+                                uint8_t *pSRK, uint32_t *pSignCounter);
+extern void GAP_SetParamValue(uint16_t paramID, uint16_t paramValue);
+extern uint16_t GAP_GetParamValue(uint16_t paramID);
+extern bStatus_t GAP_DeviceDiscoveryRequest(gapDevDiscReq_t *pParams);
+extern bStatus_t GAP_DeviceDiscoveryCancel(uint8_t taskID);
+extern bStatus_t GAP_EstablishLinkReq(gapEstLinkReq_t *pParams);
+extern bStatus_t GAP_TerminateLinkReq(uint8_t taskID, uint16_t connHandle,
+                                      uint8_t reason);
+extern bStatus_t GAP_UpdateLinkParamReq(gapUpdateLinkParamReq_t *pParams);
+extern bStatus_t GAP_UpdateLinkParamReqReply(gapUpdateLinkParamReqReply_t *pParams);
+extern bStatus_t GAP_MakeDiscoverable(uint8_t taskID,
+                                      gapAdvertisingParams_t *pParams);
+extern bStatus_t GAP_EndDiscoverable(uint8_t taskID);
+extern bStatus_t GAP_UpdateAdvertisingData(uint8_t taskID, uint8_t adType,
+                                           uint16_t dataLen, uint8_t *pAdvData);
+extern bStatus_t GAP_RegisterConnEventCb(pfnGapConnEvtCB_t cb, uint8_t action,
+                                         uint16_t connHandle);
+
+/*********************************************************************
+ * GAP BOND MANAGER
+ */
+
+#define GAPBOND_PAIRING_MODE                  0x400
+#define GAPBOND_INITIATE_WAIT                 0x401
+#define GAPBOND_MITM_PROTECTION               0x402
+#define GAPBOND_IO_CAPABILITIES               0x403
+#define GAPBOND_OOB_ENABLED                   0x404
+#define GAPBOND_OOB_DATA                      0x405
+#define GAPBOND_BONDING_ENABLED               0x406
+
+#define GAPBOND_PAIRING_MODE_NO_PAIRING       0x00
+#define GAPBOND_PAIRING_MODE_WAIT_FOR_REQ     0x01
+#define GAPBOND_PAIRING_MODE_INITIATE         0x02
+
+#define GAPBOND_IO_CAP_DISPLAY_ONLY           0x00
+#define GAPBOND_IO_CAP_NO_INPUT_NO_OUTPUT     0x03
+
+#define GAPBOND_PAIRING_STATE_STARTED         0x00
+#define GAPBOND_PAIRING_STATE_COMPLETE        0x01
+#define GAPBOND_PAIRING_STATE_BONDED          0x02
+#define GAPBOND_PAIRING_STATE_BOND_SAVED      0x03
+
+#define B_APP_DEFAULT_PASSCODE                123456
+
+typedef void (*pfnPasscodeCB_t)(uint8_t *deviceAddr, uint16_t connectionHandle,
+                                uint8_t uiInputs, uint8_t uiOutputs);
+typedef void (*pfnPairStateCB_t)(uint16_t connectionHandle, uint8_t state,
+                                 uint8_t status);
+
+typedef struct
+{
+  pfnPasscodeCB_t  passcodeCB;
+  pfnPairStateCB_t pairStateCB;
+} gapBondCBs_t;
+
+extern bStatus_t GAPBondMgr_SetParameter(uint16_t param, uint8_t len, void *pValue);
+extern bStatus_t GAPBondMgr_Register(gapBondCBs_t *pCB);
+extern bStatus_t GAPBondMgr_PasscodeRsp(uint16_t connectionHandle,
+                                        uint8_t status, uint32_t passcode);
+extern uint8_t GAPBondMgr_LinkEst(uint8_t addrType, uint8_t *pDevAddr,
+                                  uint16_t connHandle, uint8_t role);
+extern void GAPBondMgr_LinkTerm(uint16_t connHandle);
+extern void GAPBondMgr_SlaveReqSecurity(uint16_t connHandle, uint8_t authReq);
+extern bStatus_t GAPBondMgr_FindAddr(uint8_t *pDevAddr, uint8_t addrType,
+                                     uint8_t *pIdx, uint8_t *pIdAddrType,
+                                     uint8_t *pIdAddr);
+
+/*********************************************************************
+ * ATT / GATT
+ */
+
+#define GATT_MSG_EVENT                        0xB0
+
+#define ATT_BT_UUID_SIZE                      2
+#define ATT_MTU_SIZE                          23
+#define L2CAP_HDR_SIZE                        4
+
+#define ATT_ERROR_RSP                         0x01
+#define ATT_EXCHANGE_MTU_REQ                  0x02
+#define ATT_EXCHANGE_MTU_RSP                  0x03
+#define ATT_FIND_BY_TYPE_VALUE_REQ            0x06
+#define ATT_FIND_BY_TYPE_VALUE_RSP            0x07
+#define ATT_READ_BY_TYPE_REQ                  0x08
+#define ATT_READ_BY_TYPE_RSP                  0x09
+#define ATT_READ_REQ                          0x0A
+#define ATT_READ_RSP                          0x0B
+#define ATT_WRITE_REQ                         0x12
+#define ATT_WRITE_RSP                         0x13
+#define ATT_HANDLE_VALUE_NOTI                 0x1B
+#define ATT_WRITE_CMD                         0x52
+#define ATT_FLOW_CTRL_VIOLATED_EVENT          0x7E
+#define ATT_MTU_UPDATED_EVENT                 0x7F
+
+#define ATT_ERR_INVALID_HANDLE                0x01
+#define ATT_ERR_READ_NOT_PERMITTED            0x02
+#define ATT_ERR_WRITE_NOT_PERMITTED           0x03
+#define ATT_ERR_INVALID_PDU                   0x04
+#define ATT_ERR_INSUFFICIENT_AUTHEN           0x05
+#define ATT_ERR_UNSUPPORTED_REQ               0x06
+#define ATT_ERR_INVALID_OFFSET                0x07
+#define ATT_ERR_ATTR_NOT_FOUND                0x0A
+#define ATT_ERR_ATTR_NOT_LONG                 0x0B
+#define ATT_ERR_INVALID_VALUE_SIZE            0x0D
+#define ATT_ERR_UNLIKELY                      0x0E
+
+// Handles information list of a Find By Type Value Response
+#define ATT_ATTR_HANDLE_IDX(i)                ((i) * 4)
+#define ATT_GRP_END_HANDLE_IDX(i)             (ATT_ATTR_HANDLE_IDX((i)) + 2)
+#define ATT_ATTR_HANDLE(info, i)              (BUILD_UINT16((info)[ATT_ATTR_HANDLE_IDX((i))], \
+                                                            (info)[ATT_ATTR_HANDLE_IDX((i)) + 1]))
+#define ATT_GRP_END_HANDLE(info, i)           (BUILD_UINT16((info)[ATT_GRP_END_HANDLE_IDX((i))], \
+                                                            (info)[ATT_GRP_END_HANDLE_IDX((i)) + 1]))
+
+#define GATT_MIN_HANDLE                       0x0001
+#define GATT_MAX_HANDLE                       0xFFFF
+#define GATT_INVALID_HANDLE                   0x0000
+#define GATT_ALL_SERVICES                     0xFFFFFFFF
+#define GATT_MAX_ENCRYPT_KEY_SIZE             16
+#define GATT_NUM_ATTRS(attrs)                 (sizeof(attrs) / sizeof(attrs[0]))
+
+#define GATT_PERMIT_READ                      0x01
+#define GATT_PERMIT_WRITE                     0x02
+
+#define GATT_PROP_BCAST                       0x01
+#define GATT_PROP_READ                        0x02
+#define GATT_PROP_WRITE_NO_RSP                0x04
+#define GATT_PROP_WRITE                       0x08
+#define GATT_PROP_NOTIFY                      0x10
+
+#define GATT_CLIENT_CFG_NOTIFY                0x0001
+#define GATT_CFG_NO_AUTHORIZATION             0x00
+
+#define GATT_PRIMARY_SERVICE_UUID             0x2800
+#define GATT_CHARACTER_UUID                   0x2803
+#define GATT_CHAR_USER_DESC_UUID              0x2901
+#define GATT_CLIENT_CHAR_CFG_UUID             0x2902
+
+#define INVALID_CONNHANDLE                    0xFFFF
+
+typedef struct
+{
+  uint8_t  reqOpcode;
+  uint16_t handle;
+  uint8_t  errCode;
+} attErrorRsp_t;
+
+typedef struct
+{
+  uint16_t clientRxMTU;
+} attExchangeMTUReq_t;
+
+typedef struct
+{
+  uint16_t serverRxMTU;
+} attExchangeMTURsp_t;
+
+typedef struct
+{
+  uint16_t numInfo;
+  uint8_t *pHandlesInfo;
+} attFindByTypeValueRsp_t;
+
+typedef struct
+{
+  uint8_t len;
+  uint8_t uuid[16];
+} attAttrType_t;
+
+typedef struct
+{
+  uint16_t startHandle;
+  uint16_t endHandle;
+  attAttrType_t type;
+} attReadByTypeReq_t;
+
+typedef struct
+{
+  uint16_t numPairs;
+  uint16_t len;
+  uint8_t *pDataList;
+  uint16_t dataLen;
+} attReadByTypeRsp_t;
+
+typedef struct
+{
+  uint16_t len;
+  uint8_t *pValue;
+} attReadRsp_t;
+
+typedef struct
+{
+  uint16_t handle;
+  uint16_t len;
+  uint8_t *pValue;
+  uint8_t  sig;
+  uint8_t  cmd;
+} attWriteReq_t;
+
+typedef struct
+{
+  uint16_t handle;
+  uint16_t len;
+  uint8_t *pValue;
+} attHandleValueNoti_t;
+
+typedef struct
+{
+  uint8_t opcode;
+  uint8_t pendingOpcode;
+} attFlowCtrlViolatedEvt_t;
+
+typedef struct
+{
+  uint16_t MTU;
+} attMtuUpdatedEvt_t;
+
+typedef union
+{
+  attErrorRsp_t            errorRsp;
+  attExchangeMTUReq_t      exchangeMTUReq;
+  attExchangeMTURsp_t      exchangeMTURsp;
+  attFindByTypeValueRsp_t  findByTypeValueRsp;
+  attReadByTypeRsp_t       readByTypeRsp;
+  attReadRsp_t             readRsp;
+  attWriteReq_t            writeReq;
+  attHandleValueNoti_t     handleValueNoti;
+  attFlowCtrlViolatedEvt_t flowCtrlEvt;
+  attMtuUpdatedEvt_t       mtuEvt;
+} gattMsg_t;
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint16_t  connHandle;
+  uint8_t   method;
+  gattMsg_t msg;
+} gattMsgEvent_t;
+
+extern bStatus_t GATT_InitClient(void);
+extern bStatus_t GATT_RegisterForInd(uint8_t taskId);
+extern void GATT_RegisterForMsgs(uint8_t taskId);
+extern uint16_t GATT_GetMTU(uint16_t connHandle);
+extern bStatus_t GATT_ExchangeMTU(uint16_t connHandle, attExchangeMTUReq_t *pReq,
+                                  uint8_t taskId);
+extern bStatus_t GATT_DiscPrimaryServiceByUUID(uint16_t connHandle, uint8_t *pUUID,
+                                               uint8_t len, uint8_t taskId);
+extern bStatus_t GATT_DiscCharsByUUID(uint16_t connHandle, attReadByTypeReq_t *pReq,
+                                      uint8_t taskId);
+extern bStatus_t GATT_DiscAllChars(uint16_t connHandle, uint16_t startHandle,
+                                   uint16_t endHandle, uint8_t taskId);
+extern bStatus_t GATT_WriteCharValue(uint16_t connHandle, attWriteReq_t *pReq,
+                                     uint8_t taskId);
+extern bStatus_t GATT_WriteNoRsp(uint16_t connHandle, attWriteReq_t *pReq);
+extern bStatus_t GATT_Notification(uint16_t connHandle, attHandleValueNoti_t *pNoti,
+                                   uint8_t authenticated);
+extern void *GATT_bm_alloc(uint16_t connHandle, uint8_t opcode, uint16_t size,
+                           uint16_t *pSizeAlloc);
+extern void GATT_bm_free(gattMsg_t *pMsg, uint8_t opcode);
+
+/*********************************************************************
+ * GATT SERVER
+ */
+
+typedef struct
+{
+  uint8_t len;
+  const uint8_t *uuid;
+} gattAttrType_t;
+
+typedef struct
+{
+  gattAttrType_t type;
+  uint8_t  permissions;
+  uint16_t handle;
+  uint8_t *const pValue;
+} gattAttribute_t;
+
+typedef struct
+{
+  uint16_t connHandle;
+  uint8_t  value;
+} gattCharCfg_t;
+
+typedef bStatus_t (*pfnGATTReadAttrCB_t)(uint16_t connHandle, gattAttribute_t *pAttr,
+                                         uint8_t *pValue, uint16_t *pLen,
+                                         uint16_t offset, uint16_t maxLen,
+                                         uint8_t method);
+typedef bStatus_t (*pfnGATTWriteAttrCB_t)(uint16_t connHandle, gattAttribute_t *pAttr,
+                                          uint8_t *pValue, uint16_t len,
+                                          uint16_t offset, uint8_t method);
+typedef bStatus_t (*pfnGATTAuthorizeAttrCB_t)(uint16_t connHandle,
+                                              gattAttribute_t *pAttr,
+                                              uint8_t opcode);
+
+typedef struct
+{
+  pfnGATTReadAttrCB_t      pfnReadAttrCB;
+  pfnGATTWriteAttrCB_t     pfnWriteAttrCB;
+  pfnGATTAuthorizeAttrCB_t pfnAuthorizeAttrCB;
+} gattServiceCBs_t;
+
+extern const uint8_t primaryServiceUUID[ATT_BT_UUID_SIZE];
+extern const uint8_t characterUUID[ATT_BT_UUID_SIZE];
+extern const uint8_t clientCharCfgUUID[ATT_BT_UUID_SIZE];
+extern const uint8_t charUserDescUUID[ATT_BT_UUID_SIZE];
+
+extern bStatus_t GATTServApp_AddService(uint32_t services);
+extern bStatus_t GATTServApp_RegisterService(gattAttribute_t *pAttrs, uint16_t numAttrs,
+                                             uint8_t encKeySize,
+                                             CONST gattServiceCBs_t *pServiceCBs);
+extern void GATTServApp_InitCharCfg(uint16_t connHandle, gattCharCfg_t *pCharCfgTbl);
+extern uint16_t GATTServApp_ReadCharCfg(uint16_t connHandle, gattCharCfg_t *pCharCfgTbl);
+extern bStatus_t GATTServApp_ProcessCCCWriteReq(uint16_t connHandle, gattAttribute_t *pAttr,
+                                                uint8_t *pValue, uint16_t len,
+                                                uint16_t offset, uint16_t validCfg);
+
+#define GGS_DEVICE_NAME_ATT                   0
+
+extern bStatus_t GGS_AddService(uint32_t services);
+extern bStatus_t GGS_SetParameter(uint8_t param, uint8_t len, void *pValue);
+
+// Connection records
+#define LINKDB_STATUS_UPDATE_NEW              0
+#define LINKDB_STATUS_UPDATE_REMOVED          1
+#define LINKDB_STATUS_UPDATE_STATEFLAGS       2
+
+#define LINKDB_CONNHANDLE_ALL                 0xFFFF
+
+extern uint8_t linkDBNumConns;
+
+extern uint8_t linkDB_NumConns(void);
+extern uint8_t linkDB_Up(uint16_t connectionHandle);
+
+/*********************************************************************
+ * RF CORE AND AOA DRIVER
+ */
+
+#define TRIG_NOW                              0
+#define TRIG_NEVER                            1
+#define TRIG_ABSTIME                          2
+#define TRIG_REL_SUBMIT                       3
+#define TRIG_REL_START                        4
+
+typedef struct
+{
+  uint8_t triggerType;
+} rfc_trigger_t;
+
+typedef struct
+{
+  uint16_t commandNo;
+  uint16_t status;
+  void    *pNextOp;
+  uint32_t startTime;
+  rfc_trigger_t startTrigger;
+  uint8_t  channel;
+  uint8_t  whitening;
+  void    *pParams;
+  void    *pOutput;
+} rfc_CMD_BLE_SCANNER_t;
+
+typedef struct
+{
+  rfc_trigger_t timeoutTrigger;
+  uint32_t timeoutTime;
+} rfc_bleScannerPar_t;
+
+typedef struct
+{
+  uint16_t nRxAdvOk;
+  int8_t   lastRssi;
+  uint32_t timeStamp;
+} rfc_bleScannerOutput_t;
+
+typedef struct
+{
+  uint8_t *pNextEntry;
+  uint8_t  status;
+  uint8_t  config;
+  uint16_t length;
+  uint8_t  data;
+} rfc_dataEntryGeneral_t;
+
+extern rfc_CMD_BLE_SCANNER_t RF_cmdBleScanner;
+extern rfc_bleScannerPar_t RF_bleScannerPar;
+
+extern rfc_dataEntryGeneral_t *RFQueue_getDataEntry(void);
+
+#define AOA_PIN(x)                            (1 << (x&0xff))
+
+#define AOA_ROLE_RECEIVER                     0
+#define AOA_ROLE_SENDER                       1
+
+// Events of the completion callback
+#define AOA_EventRxIQ                         0x01
+#define AOA_EventTimeout                      0x02
+
+#define AOA_PACKETID_DEFAULT                  0xFF
+
+typedef struct
+{
+  int16_t i;
+  int16_t q;
+} AoA_IQSample;
+
+typedef struct
+{
+  uint8_t a;
+  uint8_t b;
+  int8_t  sign;
+  int8_t  offset;
+  float   gain;
+} AoA_AntennaPair;
+
+typedef struct
+{
+  uint8_t  numPatterns;
+  uint32_t initialPattern;
+  uint32_t toggles[];
+} AoA_Pattern;
+
+typedef struct
+{
+  uint8_t          numAntennas;
+  AoA_Pattern     *pattern;
+  uint8_t          numPairs;
+  AoA_AntennaPair *pairs;
+} AoA_AntennaConfig;
+
+typedef struct
+{
+  uint32_t *signalStrength;
+  int16_t  *pairAngle;
+  int8_t    rssi;
+  uint8_t   ch;
+  bool      updated;
+} AoA_AntennaResult;
+
+typedef struct
+{
+  uint32_t scanInterval;
+  uint32_t scanWindow;
+} AoA_Object;
+
+typedef AoA_Object *AoA_Handle;
+
+typedef struct
+{
+  AoA_Object object;
+} AoA_Struct;
+
+typedef void (*AoA_Callback)(uint8_t event);
+
+extern AoA_Handle AOA_init(uint8_t role, uint8_t aodPacketId,
+                           uint8_t aoaPacketId, uint32_t antennaPins,
+                           uint32_t timerIndex, AoA_Callback callback);
+extern void AOA_run(AoA_Handle handle, uint8_t channel,
+                    AoA_AntennaConfig *pConfig, uint8_t packetId);
+extern void AOA_getRxIQ(uint8_t *pPacketId, AoA_IQSample **ppSamples);
+extern void AOA_getPairAngles(uint8_t channel, AoA_AntennaConfig *pConfig,
+                              AoA_AntennaResult *pResult, AoA_IQSample *pSamples);
+extern void AOA_toggleMaker(const uint32_t *pPatterns, uint32_t initialPattern,
+                            uint8_t numPatterns, uint32_t *pToggles);
+
+/*********************************************************************
+ * POWER
+ */
+
+#define PowerCC26XX_SB_DISALLOW               0
+#define PowerCC26XX_IDLE_PD_DISALLOW          1
+
+#define Power_setConstraint(x)                ((void)(x))
+#define Power_releaseConstraint(x)            ((void)(x))
+
+/*********************************************************************
+ * ASSERT
+ */
+
+extern void AssertHandler(uint8_t assertCause, uint8_t assertSubcause);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_SDK_H */
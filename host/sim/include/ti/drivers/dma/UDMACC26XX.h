@@ -0,0 +1,2 @@
+// Host simulation stand-in, the declarations live in sim_sdk.h
+#include "sim_sdk.h"
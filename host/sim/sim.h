@@ -0,0 +1,249 @@
+/******************************************************************************
+
+ @file       sim.h
+
+ @brief Host simulation of the AoA receiver: interfaces shared by the
+        stand-ins.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+#ifndef SIM_H
+#define SIM_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sim_sdk.h"
+#include "aoa_estimator.h"
+#include "aoa_iqgen.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Stack of every simulated task. The target sizes are for the target's
+// code generation, host builds (and -O0 or sanitizer builds) need more.
+#define SIM_TASK_STACK_SIZE                   (256 * 1024)
+
+// Tags the world can hold
+#define SIM_MAX_TAGS                          8
+
+// Raw samples of one capture, as the AoA driver takes them
+#define SIM_NUM_IQ_SAMPLES                    512
+
+// Connection handle of the tag link, the only link simulated
+#define SIM_CONN_HANDLE                       0
+
+// ATT MTU of the simulated sender
+#define SIM_PEER_MTU                          247
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// A tag in range of the receiver
+typedef struct
+{
+  bool     present;         // Advertising, or keeping its link up
+  uint8_t  addrType;
+  uint8_t  addr[B_ADDR_LEN];
+  int16_t  azimuth;         // Degrees from the receiver reference
+  int16_t  elevation;       // Degrees above the array plane
+  int8_t   rssi;            // dBm at the receiver
+  int8_t   snrDb;           // Per I/Q sample, AOA_IQGEN_NO_NOISE for none
+  int16_t  cfoKhz;          // Carrier frequency offset
+  uint8_t  numReflections;
+  AoAIQGen_Path reflections[AOA_IQGEN_MAX_PATHS - 1];
+  uint16_t advInterval;     // ms
+  bool     aoa;             // AoA sender: service UUID and AoA packets
+  bool     legacy;          // Sender without the control characteristic
+} SimTag;
+
+// Element positions the world uses for one array, all zero for a line
+// along x spaced half a wavelength
+typedef struct
+{
+  bool           known;
+  int16_t        mountAzimuth;
+  AoAEst_Element elements[AOA_EST_MAX_ELEMENTS];
+} SimArray;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+// sim_rtos.c: kernel, simulated time
+
+/*
+ * @brief   Simulated time, microseconds since BIOS_start.
+ */
+extern uint64_t SimRtos_now(void);
+
+/*
+ * @brief   Run the tasks and clocks until SimRtos_stop is called or
+ *          nothing is left to run. Called by BIOS_start.
+ */
+extern void SimRtos_run(void);
+
+/*
+ * @brief   End the simulation once the current task or clock returns.
+ */
+extern void SimRtos_stop(void);
+
+/*
+ * @brief   Let the simulated time follow the wall clock.
+ */
+extern void SimRtos_realTime(void);
+
+/*
+ * @brief   Name of the running task, "isr" outside of tasks.
+ */
+extern const char *SimRtos_taskName(void);
+
+/*
+ * @brief   Handle of the running task, NULL outside of tasks.
+ */
+extern void *SimRtos_task(void);
+
+// sim_stack.c: ICall, GAP, GATT and the sender's GATT server
+
+/*
+ * @brief   Queue a message allocated with ICall_malloc to an entity
+ *          and post its ICall event.
+ */
+extern void SimICall_send(ICall_EntityID dest, void *pMsg);
+
+/*
+ * @brief   Tag on the other end of the link, NULL if not connected.
+ */
+extern const SimTag *SimStack_peer(void);
+
+/*
+ * @brief   Whether the connected sender transmits AoA packets on a
+ *          channel.
+ */
+extern bool SimStack_senderOn(uint8_t channel);
+
+// sim_radio.c: AoA driver and RF core
+
+/*
+ * @brief   Captures completed and timed out since BIOS_start.
+ */
+extern void SimRadio_getCounts(uint32_t *pCaptures, uint32_t *pTimeouts);
+
+// sim_io.c: Display, UART, keys
+
+/*
+ * @brief   Receive bytes on the command UART.
+ */
+extern void SimIo_uartRx(const uint8_t *pData, uint16_t len);
+
+/*
+ * @brief   Press or release a key.
+ */
+extern void SimIo_key(PIN_Id pinId, bool pressed);
+
+/*
+ * @brief   Print a line of the simulation log.
+ */
+extern void SimIo_log(const char *fmt, ...);
+
+/*
+ * @brief   Serve the command UART to a host on stdin and stdout, in
+ *          real time.
+ */
+extern void SimIo_serve(void);
+
+/*
+ * @brief   Wait up to timeoutUs (UINT64_MAX for ever) for the host and
+ *          pass what it wrote to the UART. FALSE on timeout.
+ */
+extern bool SimIo_hostRead(uint64_t timeoutUs);
+
+// sim_main.c: scenario and world
+
+/*
+ * @brief   Tag by index, NULL past the last one.
+ */
+extern SimTag *SimWorld_tag(uint8_t idx);
+
+/*
+ * @brief   Tag by address, NULL if unknown.
+ */
+extern SimTag *SimWorld_find(const uint8_t *pAddr);
+
+/*
+ * @brief   Element positions of an array.
+ */
+extern const SimArray *SimWorld_array(uint8_t array);
+
+/*
+ * @brief   Deterministic pseudo random number.
+ */
+extern uint32_t SimWorld_rand(void);
+
+/*
+ * @brief   Response and indication frames written by the receiver, for
+ *          the scenario's expectations.
+ */
+extern void SimWorld_frame(const uint8_t *pFrame, uint8_t len);
+
+/*
+ * @brief   Text printed by the receiver on the Display.
+ */
+extern void SimWorld_display(const char *pText);
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_H */
@@ -0,0 +1,452 @@
+/******************************************************************************
+
+ @file       sim_corpusgen.c
+
+ @brief Seed corpus of generated captures for host/aoa_corpus.py.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "sim_sdk.h"
+#include "aoa_iq.h"
+#include "aoa_iqgen.h"
+#include "aoa_estimator.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Capture layout and slot map as on the receiver by default
+#define CG_NUM_SAMPLES                        512
+#define CG_NUM_PATTERNS                       32
+#define CG_SLOT_SKIP                          4
+#define CG_SLOT_KEEP                          8
+
+// Elements per array and tag directions per scene
+#define CG_NUM_ANTENNAS                       3
+#define CG_NUM_AZIMUTHS                       8
+
+// The array not preferred for an entry hears the tag this much weaker
+#define CG_WEAKER_DB                          4
+
+// Corpus format of host/aoa_corpus.py, and the revision written
+#define CG_FORMAT                             1
+#define CG_REVISION                           1
+
+#define CG_ADDR                               "0x112233445566"
+#define CG_MAX_PATH                           512
+
+// Words holding an AoA_Pattern followed by its toggles
+#define CG_PATTERN_WORDS                      ((sizeof(AoA_Pattern) + CG_NUM_PATTERNS * sizeof(uint32_t) + 3) / 4)
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Conditions shared by the entries of a scene
+typedef struct
+{
+  const char *pName;
+  int8_t      rssi;           // dBm of the preferred array
+  int8_t      snrDb;          // Per sample
+  int8_t      reflectionDb;   // Gain of a reflection, 0 for none
+  int16_t     reflectionAz;   // Degrees from the tag
+} CorpusGen_Scene;
+
+// One of the receiver's arrays as loaded by the corpus
+typedef struct
+{
+  const char *pName;
+  uint32_t    pins[CG_NUM_ANTENNAS];
+} CorpusGen_Array;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Near and far differ in strength and noise. The reflector of the
+// multipath scene sits at a fixed angle from the tag, its phase turns
+// from entry to entry.
+static const CorpusGen_Scene cgScenes[] =
+{
+  {"near",      -45, 30,   0,   0},
+  {"far",       -85, 10,   0,   0},
+  {"multipath", -60, 25, -12, 110},
+};
+
+// Pins as in the BOOSTXL board: IOID_27 selects A1, IOID_28..30 the
+// element
+static const CorpusGen_Array cgArrays[] =
+{
+  {"a1", {0x18000000, 0x28000000, 0x48000000}},
+  {"a2", {0x10000000, 0x20000000, 0x40000000}},
+};
+
+// Both arrays planar, element spacing 50 mm, x axis at azimuth 0
+static const AoAEst_Element cgElements[CG_NUM_ANTENNAS] = {{0, 0}, {500, 0}, {250, 433}};
+
+static AoA_AntennaPair cgPairs[] =
+{
+  {.a = 0, .b = 1, .sign = 1, .offset = 0, .gain = 1.0f},
+  {.a = 0, .b = 2, .sign = 1, .offset = 0, .gain = 1.0f},
+};
+
+static uint32_t cgPatternWords[CG_PATTERN_WORDS];
+
+static AoA_IQSample cgRaw[CG_NUM_SAMPLES];
+static AoAIQ_Sample cgPacked[CG_NUM_SAMPLES];
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static AoA_Pattern *CorpusGen_pattern(const CorpusGen_Array *pArray);
+static bool CorpusGen_writeArray(const char *pDir, const CorpusGen_Array *pArray);
+static bool CorpusGen_writeCapture(const char *pPath, const CorpusGen_Array *pArray,
+                                   const AoAIQGen_Scene *pScene, int8_t rssi,
+                                   uint32_t *pSeed);
+static bool CorpusGen_mkdir(const char *pPath);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Write the seed corpus: each scene with the tag at
+ *          CG_NUM_AZIMUTHS directions, cycling through channels 37, 38
+ *          and 39 and alternating the array that hears it best, so
+ *          every scene covers both arrays and all three channels. The
+ *          output is the same on every run.
+ *
+ * @param   argc - 2
+ * @param   argv - program, corpus directory
+ *
+ * @return  EXIT_SUCCESS, or EXIT_FAILURE if a file cannot be written
+ */
+int main(int argc, char *argv[])
+{
+  char path[CG_MAX_PATH];
+  uint32_t seed = 1;
+  FILE *pManifest;
+  uint8_t s;
+  uint8_t k;
+  bool first = TRUE;
+
+  if (argc != 2)
+  {
+    fprintf(stderr, "usage: %s <corpus directory>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  snprintf(path, sizeof(path), "%s/arrays", argv[1]);
+  if (!CorpusGen_mkdir(argv[1]) || !CorpusGen_mkdir(path) ||
+      !CorpusGen_writeArray(argv[1], &cgArrays[0]) ||
+      !CorpusGen_writeArray(argv[1], &cgArrays[1]))
+  {
+    return EXIT_FAILURE;
+  }
+
+  snprintf(path, sizeof(path), "%s/captures", argv[1]);
+  if (!CorpusGen_mkdir(path))
+  {
+    return EXIT_FAILURE;
+  }
+
+  snprintf(path, sizeof(path), "%s/corpus.json", argv[1]);
+  if ((pManifest = fopen(path, "w")) == NULL)
+  {
+    perror(path);
+    return EXIT_FAILURE;
+  }
+
+  fprintf(pManifest, "{\n \"arrays\": {\n  \"a1\": \"arrays/a1.json\",\n"
+                     "  \"a2\": \"arrays/a2.json\"\n },\n \"entries\": [");
+
+  for (s = 0; s < sizeof(cgScenes) / sizeof(cgScenes[0]); s++)
+  {
+    const CorpusGen_Scene *pScene = &cgScenes[s];
+
+    for (k = 0; k < CG_NUM_AZIMUTHS; k++)
+    {
+      int16_t azimuth = -160 + k * (360 / CG_NUM_AZIMUTHS);
+      uint8_t preferred = k % 2;
+      AoAIQGen_Scene scene;
+      char name[64];
+      uint8_t a;
+
+      AoAIQGen_sceneInit(&scene, 37 + k % 3, azimuth, 0);
+      scene.snrDb = pScene->snrDb;
+
+      if (pScene->reflectionDb != 0)
+      {
+        scene.numPaths = 2;
+        scene.paths[1].azimuth = azimuth + pScene->reflectionAz;
+        scene.paths[1].gainDb = pScene->reflectionDb;
+        scene.paths[1].phase = k * 45;
+      }
+
+      snprintf(name, sizeof(name), "%s-az%+d-%04u", pScene->pName, azimuth,
+               (unsigned)(s * CG_NUM_AZIMUTHS + k));
+
+      for (a = 0; a < 2; a++)
+      {
+        int8_t rssi = pScene->rssi - ((a == preferred) ? 0 : CG_WEAKER_DB);
+
+        snprintf(path, sizeof(path), "%s/captures/%s-%s.json", argv[1], name,
+                 cgArrays[a].pName);
+        if (!CorpusGen_writeCapture(path, &cgArrays[a], &scene, rssi, &seed))
+        {
+          fclose(pManifest);
+          return EXIT_FAILURE;
+        }
+      }
+
+      fprintf(pManifest, "%s\n  {\n   \"a1\": \"captures/%s-a1.json\",\n"
+                         "   \"a2\": \"captures/%s-a2.json\",\n"
+                         "   \"azimuth\": %d,\n   \"channels\": [\n    %u,\n    %u\n   ],\n"
+                         "   \"elevation\": null,\n   \"name\": \"%s\",\n"
+                         "   \"rssi\": %d,\n   \"scene\": \"%s\"\n  }",
+              first ? "" : ",", name, name, azimuth, scene.channel, scene.channel,
+              name, pScene->rssi, pScene->pName);
+      first = FALSE;
+    }
+  }
+
+  fprintf(pManifest, "\n ],\n \"format\": %d,\n \"revision\": %d\n}\n",
+          CG_FORMAT, CG_REVISION);
+
+  if (fclose(pManifest) != 0)
+  {
+    perror(path);
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      CorpusGen_pattern
+ *
+ * @brief   Build the pattern of an array as the receiver stores it once
+ *          loaded: the pins cycle through the elements, starting from
+ *          the last one.
+ *
+ * @param   pArray - array
+ *
+ * @return  pattern, valid until the next call
+ */
+static AoA_Pattern *CorpusGen_pattern(const CorpusGen_Array *pArray)
+{
+  AoA_Pattern *pPattern = (AoA_Pattern *)cgPatternWords;
+  uint32_t previous = pArray->pins[CG_NUM_ANTENNAS - 1];
+  uint8_t slot;
+
+  pPattern->numPatterns = CG_NUM_PATTERNS;
+  pPattern->initialPattern = previous;
+
+  for (slot = 0; slot < CG_NUM_PATTERNS; slot++)
+  {
+    pPattern->toggles[slot] = pArray->pins[slot % CG_NUM_ANTENNAS] ^ previous;
+    previous = pArray->pins[slot % CG_NUM_ANTENNAS];
+  }
+
+  return pPattern;
+}
+
+/*********************************************************************
+ * @fn      CorpusGen_writeArray
+ *
+ * @brief   Write the antenna configuration of an array in the
+ *          aoa_cmd.py ant-load format, with its element positions.
+ *
+ * @param   pDir   - corpus directory
+ * @param   pArray - array
+ *
+ * @return  FALSE if the file cannot be written
+ */
+static bool CorpusGen_writeArray(const char *pDir, const CorpusGen_Array *pArray)
+{
+  char path[CG_MAX_PATH];
+  FILE *pFile;
+  uint8_t i;
+
+  snprintf(path, sizeof(path), "%s/arrays/%s.json", pDir, pArray->pName);
+  if ((pFile = fopen(path, "w")) == NULL)
+  {
+    perror(path);
+    return FALSE;
+  }
+
+  fprintf(pFile, "{\"antennas\": %d, \"initial\": \"0x%08X\", \"mount_azimuth\": 0,\n"
+                 " \"elements\": [", CG_NUM_ANTENNAS,
+          (unsigned)pArray->pins[CG_NUM_ANTENNAS - 1]);
+  for (i = 0; i < CG_NUM_ANTENNAS; i++)
+  {
+    fprintf(pFile, "%s[%d, %d]", i ? ", " : "", cgElements[i].x, cgElements[i].y);
+  }
+
+  fprintf(pFile, "],\n \"patterns\": [");
+  for (i = 0; i < CG_NUM_PATTERNS; i++)
+  {
+    fprintf(pFile, "%s\"0x%08X\"", (i == 0) ? "" : (i % 6 == 0) ? ",\n  " : ", ",
+            (unsigned)pArray->pins[i % CG_NUM_ANTENNAS]);
+  }
+
+  fprintf(pFile, "],\n \"pairs\": [");
+  for (i = 0; i < sizeof(cgPairs) / sizeof(cgPairs[0]); i++)
+  {
+    fprintf(pFile, "%s{\"a\": %u, \"b\": %u, \"sign\": %d, \"offset\": %d, \"gain\": %.1f}",
+            i ? ",\n  " : "", cgPairs[i].a, cgPairs[i].b, cgPairs[i].sign,
+            cgPairs[i].offset, cgPairs[i].gain);
+  }
+  fprintf(pFile, "]}\n");
+
+  if (fclose(pFile) != 0)
+  {
+    perror(path);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/*********************************************************************
+ * @fn      CorpusGen_writeCapture
+ *
+ * @brief   Generate a capture on an array, pack it with the receiver's
+ *          default slot map and write it in the aoa_cmd.py inject-iq
+ *          format.
+ *
+ * @param   pPath  - file to write
+ * @param   pArray - array
+ * @param   pScene - conditions
+ * @param   rssi   - RSSI reported with the capture
+ * @param   pSeed  - noise generator state, updated
+ *
+ * @return  FALSE if the capture cannot be generated or written
+ */
+static bool CorpusGen_writeCapture(const char *pPath, const CorpusGen_Array *pArray,
+                                   const AoAIQGen_Scene *pScene, int8_t rssi,
+                                   uint32_t *pSeed)
+{
+  AoA_AntennaConfig config;
+  AoAIQ_SlotMap map;
+  FILE *pFile;
+  uint16_t numSamples;
+  uint16_t i;
+  uint8_t shift;
+
+  config.numAntennas = CG_NUM_ANTENNAS;
+  config.numPairs = sizeof(cgPairs) / sizeof(cgPairs[0]);
+  config.pairs = cgPairs;
+  config.pattern = CorpusGen_pattern(pArray);
+
+  if (!AoAIQ_slotMapInit(&map, CG_NUM_PATTERNS, CG_NUM_SAMPLES, CG_SLOT_SKIP, CG_SLOT_KEEP) ||
+      !AoAIQGen_capture(&config, cgElements, 0, pScene, pSeed, cgRaw, CG_NUM_SAMPLES))
+  {
+    fprintf(stderr, "%s: capture refused\n", pPath);
+    return FALSE;
+  }
+
+  shift = AoAIQ_pack(cgRaw, &map, cgPacked);
+  numSamples = map.numSlots * map.keep;
+
+  if ((pFile = fopen(pPath, "w")) == NULL)
+  {
+    perror(pPath);
+    return FALSE;
+  }
+
+  fprintf(pFile, "{\"addr\": \"%s\", \"array\": \"%s\", \"channel\": %u, \"rssi\": %d,"
+                 " \"shift\": %u, \"slot_len\": %u,\n \"samples\": [",
+          CG_ADDR, pArray->pName, pScene->channel, rssi, shift, map.keep);
+
+  for (i = 0; i < numSamples; i++)
+  {
+    fprintf(pFile, "%s[%d, %d]", (i == 0) ? "" : (i % map.keep == 0) ? ",\n  " : ", ",
+            cgPacked[i].i, cgPacked[i].q);
+  }
+  fprintf(pFile, "]}\n");
+
+  if (fclose(pFile) != 0)
+  {
+    perror(pPath);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/*********************************************************************
+ * @fn      CorpusGen_mkdir
+ *
+ * @brief   Create a directory unless it exists.
+ *
+ * @param   pPath - directory
+ *
+ * @return  FALSE on error
+ */
+static bool CorpusGen_mkdir(const char *pPath)
+{
+  if (mkdir(pPath, 0777) != 0 && errno != EEXIST)
+  {
+    perror(pPath);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/*********************************************************************
+*********************************************************************/
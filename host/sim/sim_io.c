@@ -0,0 +1,424 @@
+/******************************************************************************
+
+ @file       sim_io.c
+
+ @brief Host simulation of the Display, the command UART and the keys.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "aoa_cmd.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Bytes the UART receive ring buffer holds
+#define SIM_UART_RX_SIZE                      1024
+
+// Pins the key stand-in tracks, IOIDs
+#define SIM_NUM_PINS                          32
+
+// Bytes taken from the host per read
+#define SIM_HOST_READ_SIZE                    256
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+struct SimUart
+{
+  Semaphore_Struct rxAvail;
+  uint8_t  rxBuf[SIM_UART_RX_SIZE];
+  uint16_t rxHead;
+  uint16_t rxCount;
+};
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static struct SimUart simUart;
+static bool simUartOpen = FALSE;
+
+// The UART is served to a host on stdin and stdout, the log goes to
+// stderr
+static bool simServing = FALSE;
+
+// Pin levels, pulled up: 1 while a key is released
+static uint8_t simPinLevel[SIM_NUM_PINS];
+static PIN_State *simPinState = NULL;
+static PIN_IntCb simPinCb = NULL;
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      SimIo_uartRx
+ *
+ * @brief   Receive bytes on the command UART. Bytes that do not fit
+ *          the ring buffer are dropped, as by the driver.
+ *
+ * @param   pData - bytes
+ * @param   len   - number of bytes
+ *
+ * @return  none
+ */
+void SimIo_uartRx(const uint8_t *pData, uint16_t len)
+{
+  uint16_t i;
+
+  for (i = 0; i < len && simUart.rxCount < SIM_UART_RX_SIZE; i++)
+  {
+    simUart.rxBuf[(simUart.rxHead + simUart.rxCount) % SIM_UART_RX_SIZE] = pData[i];
+    simUart.rxCount++;
+  }
+
+  if (simUartOpen)
+  {
+    Semaphore_post(Semaphore_handle(&simUart.rxAvail));
+  }
+}
+
+/*********************************************************************
+ * @fn      SimIo_key
+ *
+ * @brief   Press or release a key and raise its pin interrupt.
+ *
+ * @param   pinId   - IOID of the key
+ * @param   pressed - TRUE to press, FALSE to release
+ *
+ * @return  none
+ */
+void SimIo_key(PIN_Id pinId, bool pressed)
+{
+  if (pinId >= SIM_NUM_PINS)
+  {
+    return;
+  }
+
+  simPinLevel[pinId] = !pressed;
+
+  if (pressed && simPinCb != NULL)
+  {
+    simPinCb(simPinState, pinId);
+  }
+}
+
+/*********************************************************************
+ * @fn      SimIo_log
+ *
+ * @brief   Print a line of the simulation log, stamped with the
+ *          simulated time and the running task.
+ *
+ * @param   fmt - printf format
+ *
+ * @return  none
+ */
+void SimIo_log(const char *fmt, ...)
+{
+  FILE *pOut = simServing ? stderr : stdout;
+  uint64_t now = SimRtos_now();
+  va_list args;
+
+  fprintf(pOut, "[%6u.%03u %-5s] ", (unsigned)(now / 1000), (unsigned)(now % 1000),
+          SimRtos_taskName());
+
+  va_start(args, fmt);
+  vfprintf(pOut, fmt, args);
+  va_end(args);
+
+  fputc('\n', pOut);
+}
+
+/*********************************************************************
+ * @fn      SimIo_serve
+ *
+ * @brief   Serve the command UART to a host: what it writes on stdin is
+ *          received, what the receiver writes goes to stdout as on the
+ *          wire, Display text included. The time follows the wall
+ *          clock so that the host's timeouts hold.
+ *
+ * @return  none
+ */
+void SimIo_serve(void)
+{
+  simServing = TRUE;
+  SimRtos_realTime();
+}
+
+/*********************************************************************
+ * @fn      SimIo_hostRead
+ *
+ * @brief   Wait for the host and receive what it wrote on the UART.
+ *          The simulation stops when the host closes stdin.
+ *
+ * @param   timeoutUs - longest wait, UINT64_MAX for no limit
+ *
+ * @return  FALSE on timeout
+ */
+bool SimIo_hostRead(uint64_t timeoutUs)
+{
+  struct pollfd pfd = {.fd = STDIN_FILENO, .events = POLLIN};
+  uint8_t buf[SIM_HOST_READ_SIZE];
+  int timeoutMs = -1;
+  ssize_t len;
+
+  if (timeoutUs != UINT64_MAX)
+  {
+    timeoutMs = (timeoutUs < 1000000000) ? (int)((timeoutUs + 999) / 1000) : 1000000;
+  }
+
+  if (poll(&pfd, 1, timeoutMs) <= 0)
+  {
+    return FALSE;
+  }
+
+  // Never more than the ring buffer takes, the host waits for each
+  // response before the next frame
+  len = read(STDIN_FILENO, buf, sizeof(buf));
+  if (len <= 0)
+  {
+    SimIo_log("host closed the UART");
+    SimRtos_stop();
+    return TRUE;
+  }
+
+  SimIo_uartRx(buf, (uint16_t)len);
+
+  return TRUE;
+}
+
+/*********************************************************************
+ * DPL
+ */
+
+int SystemP_vsnprintf(char *pBuf, size_t n, const char *fmt, va_list va)
+{
+  return vsnprintf(pBuf, n, fmt, va);
+}
+
+/*********************************************************************
+ * Display
+ */
+
+// The board has no Display of its own: the only UART is the command
+// UART, and the application prints through that
+Display_Handle Display_open(uint32_t type, void *pParams)
+{
+  (void)type;
+  (void)pParams;
+
+  return NULL;
+}
+
+void Display_printf(Display_Handle handle, uint8_t line, uint8_t column,
+                    char *fmt, ...)
+{
+  va_list args;
+
+  if (handle == NULL)
+  {
+    return;
+  }
+
+  va_start(args, fmt);
+  handle->fxnTablePtr->vprintfFxn(handle, line, column, fmt, args);
+  va_end(args);
+}
+
+void Display_clearLine(Display_Handle handle, uint8_t line)
+{
+  if (handle != NULL)
+  {
+    handle->fxnTablePtr->clearLinesFxn(handle, line, line);
+  }
+}
+
+void Display_doClearLines(Display_Handle handle, uint8_t fromLine, uint8_t toLine)
+{
+  if (handle != NULL)
+  {
+    handle->fxnTablePtr->clearLinesFxn(handle, fromLine, toLine);
+  }
+}
+
+/*********************************************************************
+ * UART
+ */
+
+void UART_Params_init(UART_Params *pParams)
+{
+  memset(pParams, 0, sizeof(UART_Params));
+  pParams->readTimeout = BIOS_WAIT_FOREVER;
+  pParams->writeTimeout = BIOS_WAIT_FOREVER;
+  pParams->baudRate = 115200;
+}
+
+UART_Handle UART_open(uint32_t index, const UART_Params *pParams)
+{
+  Semaphore_Params semParams;
+
+  (void)pParams;
+
+  if (index != Board_UART0 || simUartOpen)
+  {
+    return NULL;
+  }
+
+  Semaphore_Params_init(&semParams);
+  semParams.mode = Semaphore_Mode_BINARY;
+  Semaphore_construct(&simUart.rxAvail, 0, &semParams);
+  simUartOpen = TRUE;
+
+  return &simUart;
+}
+
+int UART_control(UART_Handle handle, unsigned int cmd, void *pArg)
+{
+  (void)handle;
+  (void)cmd;
+  (void)pArg;
+  return 0;
+}
+
+int UART_read(UART_Handle handle, void *pBuf, size_t size)
+{
+  uint8_t *pDst = pBuf;
+  size_t n;
+
+  // Partial returns are enabled: whatever arrived, once there is any
+  while (handle->rxCount == 0)
+  {
+    Semaphore_pend(Semaphore_handle(&handle->rxAvail), BIOS_WAIT_FOREVER);
+  }
+
+  for (n = 0; n < size && handle->rxCount > 0; n++)
+  {
+    pDst[n] = handle->rxBuf[handle->rxHead];
+    handle->rxHead = (handle->rxHead + 1) % SIM_UART_RX_SIZE;
+    handle->rxCount--;
+  }
+
+  return (int)n;
+}
+
+int UART_write(UART_Handle handle, const void *pBuf, size_t size)
+{
+  const uint8_t *pBytes = pBuf;
+
+  (void)handle;
+
+  if (simServing)
+  {
+    fwrite(pBytes, 1, size, stdout);
+    fflush(stdout);
+  }
+
+  // The command link writes whole frames and whole Display lines
+  if (size > 0 && pBytes[0] == AOA_CMD_SOF)
+  {
+    SimWorld_frame(pBytes, (uint8_t)size);
+  }
+  else
+  {
+    char text[256];
+    size_t len = (size < sizeof(text)) ? size : sizeof(text) - 1;
+
+    memcpy(text, pBytes, len);
+    text[len] = '\0';
+    text[strcspn(text, "\r\n")] = '\0';
+
+    SimIo_log("display: %s", text);
+    SimWorld_display(text);
+  }
+
+  return (int)size;
+}
+
+/*********************************************************************
+ * PIN
+ */
+
+PIN_Handle PIN_open(PIN_State *pState, const PIN_Config *pConfig)
+{
+  (void)pConfig;
+
+  memset(simPinLevel, 1, sizeof(simPinLevel));
+  simPinState = pState;
+
+  return pState;
+}
+
+int PIN_registerIntCb(PIN_Handle handle, PIN_IntCb callback)
+{
+  (void)handle;
+
+  simPinCb = callback;
+
+  return 0;
+}
+
+int PIN_setConfig(PIN_Handle handle, PIN_Config bitMask, PIN_Config config)
+{
+  (void)handle;
+  (void)bitMask;
+  (void)config;
+  return 0;
+}
+
+uint32_t PIN_getInputValue(PIN_Id pinId)
+{
+  return (pinId < SIM_NUM_PINS) ? simPinLevel[pinId] : 1;
+}
+
+/*********************************************************************
+*********************************************************************/
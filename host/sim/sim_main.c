@@ -0,0 +1,1021 @@
+/******************************************************************************
+
+ @file       sim_main.c
+
+ @brief Host simulation of the AoA receiver: start-up as on the target, the
+        simulated world and the scenario that drives and checks it.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+#include "central.h"
+#include "aoa_receiver.h"
+#include "aoa_cmd.h"
+#include "aoa_iqgen.h"
+#include "ant_config.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Scenario steps and the length of a step line
+#define SIM_MAX_STEPS                         256
+#define SIM_MAX_LINE                          512
+
+// Responses held for expect-rsp
+#define SIM_MAX_RSPS                          64
+
+// Largest frame the receiver writes: SOF, LEN, CMD, DATA, FCS
+#define SIM_MAX_FRAME                         (AOA_CMD_MAX_PAYLOAD + 4)
+
+// Tag defaults
+#define SIM_DEFAULT_RSSI                      (-50)
+#define SIM_DEFAULT_ADV_INTERVAL              100
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// One line of the scenario
+typedef struct
+{
+  uint32_t at;              // ms
+  uint16_t lineNo;
+  char     text[SIM_MAX_LINE];
+} SimStep;
+
+// Response seen on the UART
+typedef struct
+{
+  uint8_t cmd;
+  uint8_t status;
+  uint8_t len;              // Of data, after the status
+  uint8_t data[AOA_CMD_MAX_PAYLOAD];
+} SimRsp;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static SimTag simTags[SIM_MAX_TAGS];
+static SimArray simArrays[ANT_CONFIG_NUM_ARRAYS];
+static uint32_t simRandState = 12345;
+
+static SimStep simSteps[SIM_MAX_STEPS];
+static uint16_t simNumSteps = 0;
+static uint16_t simNextStep = 0;
+static Clock_Struct simStepClock;
+static const char *simScenarioName;
+static uint16_t simFailures = 0;
+static bool simEnded = FALSE;
+
+// What the receiver said since the last check of each kind
+static SimRsp simRsps[SIM_MAX_RSPS];
+static uint8_t simNumRsps = 0;
+static char simDisplayText[4096];
+static uint16_t simDisplayLen = 0;
+static uint32_t simNumAngles = 0;
+static uint32_t simTotalAngles = 0;
+static bool simAngleValid = FALSE;
+static int16_t simLastAngle;
+static int16_t simLastCurrent;
+static uint64_t simAngleChannels = 0;       // Bit per RF channel
+static int16_t simAngleMin = INT16_MAX;     // Of both angles of each IND
+static int16_t simAngleMax = INT16_MIN;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static bool SimWorld_load(const char *pPath);
+static void SimWorld_stepHandler(UArg a0);
+static void SimWorld_run(const SimStep *pStep);
+static void SimWorld_fail(const SimStep *pStep, const char *fmt, ...);
+static bool SimWorld_takeRsp(const SimStep *pStep, uint8_t cmd, uint8_t status,
+                             SimRsp *pRsp);
+static bool SimWorld_parseAddr(const char *pText, uint8_t *pAddr);
+static void SimWorld_angleSeen(int16_t angle);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Start the receiver as Startup/main.c does on the target and
+ *          run a scenario on it.
+ *
+ * @param   argc, argv - scenario file
+ *
+ * @return  0 if every expectation of the scenario held
+ */
+int main(int argc, char *argv[])
+{
+  Clock_Params clockParams;
+  uint32_t captures;
+  uint32_t timeouts;
+
+  setvbuf(stdout, NULL, _IOLBF, 0);
+
+  if (argc != 2)
+  {
+    fprintf(stderr, "usage: %s <scenario> | --serve\n", argv[0]);
+    return 2;
+  }
+
+  simScenarioName = argv[1];
+  if (strcmp(argv[1], "--serve") == 0)
+  {
+    // An empty world, the host drives the receiver over the UART
+    SimIo_serve();
+  }
+  else if (!SimWorld_load(argv[1]))
+  {
+    return 2;
+  }
+
+  Clock_Params_init(&clockParams);
+  Clock_construct(&simStepClock, SimWorld_stepHandler, 0, &clockParams);
+  if (simNumSteps > 0)
+  {
+    Clock_setTimeout(Clock_handle(&simStepClock),
+                     simSteps[0].at * (1000 / Clock_tickPeriod));
+    Clock_start(Clock_handle(&simStepClock));
+  }
+
+  /* Kick off profile - Priority 3 */
+  GAPCentralRole_createTask();
+
+  /* Kick off application - Priority 2, estimation worker - Priority 1 */
+  AoAReceiver_createTask();
+
+  BIOS_start();
+
+  SimRadio_getCounts(&captures, &timeouts);
+  SimIo_log("%u captures, %u timeouts, %u angles", (unsigned)captures,
+            (unsigned)timeouts, (unsigned)simTotalAngles);
+
+  if (strcmp(argv[1], "--serve") == 0)
+  {
+    return 0;
+  }
+
+  if (!simEnded)
+  {
+    printf("%s: FAIL: ended before its end step\n", simScenarioName);
+    simFailures++;
+  }
+
+  if (simFailures != 0)
+  {
+    printf("%s: FAIL (%u)\n", simScenarioName, simFailures);
+    return 1;
+  }
+
+  printf("%s: PASS\n", simScenarioName);
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      AssertHandler
+ *
+ * @brief   Stack and application asserts end the run.
+ *
+ * @param   assertCause    - HAL_ASSERT_CAUSE_xxx
+ * @param   assertSubcause - HAL_ASSERT_SUBCAUSE_xxx
+ *
+ * @return  none
+ */
+void AssertHandler(uint8_t assertCause, uint8_t assertSubcause)
+{
+  printf("%s: FAIL: assert %u/%u\n", simScenarioName, assertCause, assertSubcause);
+  exit(1);
+}
+
+/*********************************************************************
+ * @fn      SimWorld_tag
+ *
+ * @brief   Tag by index.
+ *
+ * @param   idx - 0 to SIM_MAX_TAGS - 1
+ *
+ * @return  tag, NULL past the last one or if the slot is unused
+ */
+SimTag *SimWorld_tag(uint8_t idx)
+{
+  if (idx >= SIM_MAX_TAGS || simTags[idx].advInterval == 0)
+  {
+    return NULL;
+  }
+
+  return &simTags[idx];
+}
+
+/*********************************************************************
+ * @fn      SimWorld_find
+ *
+ * @brief   Tag by address.
+ *
+ * @param   pAddr - address, over the air byte order
+ *
+ * @return  tag, NULL if unknown
+ */
+SimTag *SimWorld_find(const uint8_t *pAddr)
+{
+  uint8_t i;
+
+  for (i = 0; i < SIM_MAX_TAGS; i++)
+  {
+    if (simTags[i].advInterval != 0 && memcmp(simTags[i].addr, pAddr, B_ADDR_LEN) == 0)
+    {
+      return &simTags[i];
+    }
+  }
+
+  return NULL;
+}
+
+/*********************************************************************
+ * @fn      SimWorld_array
+ *
+ * @brief   Element positions the world uses for an array.
+ *
+ * @param   array - ANT_CONFIG_ARRAY_xxx
+ *
+ * @return  positions, NULL for an unknown array
+ */
+const SimArray *SimWorld_array(uint8_t array)
+{
+  return (array < ANT_CONFIG_NUM_ARRAYS) ? &simArrays[array] : NULL;
+}
+
+/*********************************************************************
+ * @fn      SimWorld_rand
+ *
+ * @brief   Pseudo random number, the same sequence on every run.
+ *
+ * @return  31 bit number
+ */
+uint32_t SimWorld_rand(void)
+{
+  simRandState = simRandState * 1103515245 + 12345;
+
+  return (simRandState >> 1) & 0x7FFFFFFF;
+}
+
+/*********************************************************************
+ * @fn      SimWorld_frame
+ *
+ * @brief   Frame written by the receiver on the command UART.
+ *
+ * @param   pFrame - frame
+ * @param   len    - length of the frame
+ *
+ * @return  none
+ */
+void SimWorld_frame(const uint8_t *pFrame, uint8_t len)
+{
+  const uint8_t *pData = &pFrame[3];
+  uint8_t fcs = 0;
+  uint8_t i;
+
+  if (len < 4 || pFrame[0] != AOA_CMD_SOF || pFrame[1] + 4 != len)
+  {
+    SimIo_log("uart: malformed frame");
+    simFailures++;
+    return;
+  }
+
+  for (i = 1; i < len - 1; i++)
+  {
+    fcs ^= pFrame[i];
+  }
+  if (fcs != pFrame[len - 1])
+  {
+    SimIo_log("uart: bad FCS");
+    simFailures++;
+    return;
+  }
+
+  if (pFrame[2] & AOA_CMD_RSP_FLAG)
+  {
+    uint8_t status = (pFrame[1] > 0) ? pData[0] : 0xFF;
+
+    SimIo_log("uart: rsp 0x%02x status 0x%02x, %u bytes",
+              pFrame[2] & ~AOA_CMD_RSP_FLAG, status, pFrame[1]);
+
+    if (simNumRsps < SIM_MAX_RSPS)
+    {
+      simRsps[simNumRsps].cmd = pFrame[2] & ~AOA_CMD_RSP_FLAG;
+      simRsps[simNumRsps].status = status;
+      simRsps[simNumRsps].len = (pFrame[1] > 1) ? pFrame[1] - 1 : 0;
+      memcpy(simRsps[simNumRsps].data, &pData[1], simRsps[simNumRsps].len);
+      simNumRsps++;
+    }
+  }
+  else if (pFrame[2] == AOA_CMD_IND_ANGLE && pFrame[1] >= B_ADDR_LEN + 4)
+  {
+    simLastAngle = (int16_t)BUILD_UINT16(pData[6], pData[7]);
+    simLastCurrent = (int16_t)BUILD_UINT16(pData[8], pData[9]);
+    simAngleValid = TRUE;
+    SimWorld_angleSeen(simLastAngle);
+    SimWorld_angleSeen(simLastCurrent);
+    simNumAngles++;
+    simTotalAngles++;
+
+    if (pFrame[1] >= B_ADDR_LEN + 10 && pData[B_ADDR_LEN + 9] < 64)
+    {
+      simAngleChannels |= (uint64_t)1 << pData[B_ADDR_LEN + 9];
+    }
+
+    SimIo_log("uart: angle %d, current %d, channel %u", simLastAngle, simLastCurrent,
+              (pFrame[1] >= B_ADDR_LEN + 10) ? pData[B_ADDR_LEN + 9] : 0);
+  }
+  else
+  {
+    SimIo_log("uart: ind 0x%02x, %u bytes", pFrame[2], pFrame[1]);
+  }
+}
+
+/*********************************************************************
+ * @fn      SimWorld_display
+ *
+ * @brief   Text the receiver printed, kept for expect-display.
+ *
+ * @param   pText - line
+ *
+ * @return  none
+ */
+void SimWorld_display(const char *pText)
+{
+  size_t len = strlen(pText);
+
+  // Keep the most recent text if the checks are far apart
+  if (simDisplayLen + len + 2 > sizeof(simDisplayText))
+  {
+    simDisplayLen = 0;
+  }
+
+  memcpy(&simDisplayText[simDisplayLen], pText, len);
+  simDisplayLen += len;
+  simDisplayText[simDisplayLen++] = '\n';
+  simDisplayText[simDisplayLen] = '\0';
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      SimWorld_load
+ *
+ * @brief   Read a scenario. Each line is "at <ms> <step>", blank lines
+ *          and lines starting with # are skipped. Steps must be in time
+ *          order.
+ *
+ * @param   pPath - scenario file
+ *
+ * @return  FALSE if it cannot be read
+ */
+static bool SimWorld_load(const char *pPath)
+{
+  FILE *pFile = fopen(pPath, "r");
+  char line[SIM_MAX_LINE];
+  uint16_t lineNo = 0;
+  uint32_t last = 0;
+
+  if (pFile == NULL)
+  {
+    perror(pPath);
+    return FALSE;
+  }
+
+  while (fgets(line, sizeof(line), pFile) != NULL)
+  {
+    SimStep *pStep = &simSteps[simNumSteps];
+    unsigned at;
+    int used;
+
+    lineNo++;
+    line[strcspn(line, "\r\n")] = '\0';
+
+    if (line[strspn(line, " \t")] == '\0' || line[strspn(line, " \t")] == '#')
+    {
+      continue;
+    }
+
+    if (sscanf(line, " at %u %n", &at, &used) != 1 || at < last ||
+        simNumSteps == SIM_MAX_STEPS)
+    {
+      fprintf(stderr, "%s:%u: bad step\n", pPath, lineNo);
+      fclose(pFile);
+      return FALSE;
+    }
+
+    pStep->at = last = at;
+    pStep->lineNo = lineNo;
+    strcpy(pStep->text, &line[used]);
+    simNumSteps++;
+  }
+
+  fclose(pFile);
+
+  return TRUE;
+}
+
+/*********************************************************************
+ * @fn      SimWorld_stepHandler
+ *
+ * @brief   Run the steps that are due and arm the clock for the next.
+ *
+ * @param   a0 - not used
+ *
+ * @return  none
+ */
+static void SimWorld_stepHandler(UArg a0)
+{
+  uint32_t now = (uint32_t)(SimRtos_now() / 1000);
+
+  (void)a0;
+
+  while (simNextStep < simNumSteps && simSteps[simNextStep].at <= now && !simEnded)
+  {
+    SimWorld_run(&simSteps[simNextStep++]);
+  }
+
+  if (simNextStep < simNumSteps && !simEnded)
+  {
+    Clock_setTimeout(Clock_handle(&simStepClock),
+                     (simSteps[simNextStep].at - now) * (1000 / Clock_tickPeriod));
+    Clock_start(Clock_handle(&simStepClock));
+  }
+}
+
+/*********************************************************************
+ * @fn      SimWorld_run
+ *
+ * @brief   Run one step.
+ *
+ *          tag <addr> [az=] [el=] [rssi=] [snr=] [cfo=] [adv=] [aoa] [legacy]
+ *              [path=<az>:<el>:<gainDb>:<phase>|none ...]
+ *          tag-gone <addr>
+ *          array A1|A2 <mountAzimuth> <x> <y> ...   (0.1 mm)
+ *          key left|right
+ *          cmd <CMD> [DATA...]                        (hex, framed here)
+ *          expect-rsp <CMD> <status>
+ *          expect-rsp-u32 <CMD> <offset> <min> <max>  (offset after status)
+ *          expect-display <text>
+ *          expect-angles <min>
+ *          expect-azimuth <degrees> <tolerance>
+ *          expect-angle-range <min> <max>
+ *          expect-channels <channel> ...              (decimal)
+ *          end
+ *
+ *          Addresses are written most significant byte first. The
+ *          expectations look at what the receiver sent since the last
+ *          expectation of the same kind. The reflections given on a tag
+ *          line replace those of earlier lines, path=none removes them.
+ *
+ * @param   pStep - step
+ *
+ * @return  none
+ */
+static void SimWorld_run(const SimStep *pStep)
+{
+  char text[SIM_MAX_LINE];
+  char *pSave;
+  char *pVerb;
+  char *pArg;
+
+  strcpy(text, pStep->text);
+  pVerb = strtok_r(text, " \t", &pSave);
+
+  SimIo_log("step %u: %s", pStep->lineNo, pStep->text);
+
+  if (strcmp(pVerb, "tag") == 0)
+  {
+    uint8_t addr[B_ADDR_LEN];
+    SimTag *pTag;
+    bool pathsGiven = FALSE;
+
+    if ((pArg = strtok_r(NULL, " \t", &pSave)) == NULL || !SimWorld_parseAddr(pArg, addr))
+    {
+      SimWorld_fail(pStep, "bad address");
+      return;
+    }
+
+    if ((pTag = SimWorld_find(addr)) == NULL)
+    {
+      uint8_t i;
+
+      for (i = 0; i < SIM_MAX_TAGS && simTags[i].advInterval != 0; i++);
+      if (i == SIM_MAX_TAGS)
+      {
+        SimWorld_fail(pStep, "too many tags");
+        return;
+      }
+
+      pTag = &simTags[i];
+      memcpy(pTag->addr, addr, B_ADDR_LEN);
+      pTag->rssi = SIM_DEFAULT_RSSI;
+      pTag->snrDb = AOA_IQGEN_NO_NOISE;
+      pTag->advInterval = SIM_DEFAULT_ADV_INTERVAL;
+    }
+
+    pTag->present = TRUE;
+
+    while ((pArg = strtok_r(NULL, " \t", &pSave)) != NULL)
+    {
+      if (strncmp(pArg, "az=", 3) == 0)
+      {
+        pTag->azimuth = atoi(&pArg[3]);
+      }
+      else if (strncmp(pArg, "el=", 3) == 0)
+      {
+        pTag->elevation = atoi(&pArg[3]);
+      }
+      else if (strncmp(pArg, "rssi=", 5) == 0)
+      {
+        pTag->rssi = atoi(&pArg[5]);
+      }
+      else if (strncmp(pArg, "snr=", 4) == 0)
+      {
+        pTag->snrDb = atoi(&pArg[4]);
+      }
+      else if (strncmp(pArg, "cfo=", 4) == 0)
+      {
+        pTag->cfoKhz = atoi(&pArg[4]);
+      }
+      else if (strncmp(pArg, "path=", 5) == 0)
+      {
+        int az, el, gainDb, phase;
+
+        if (!pathsGiven)
+        {
+          pTag->numReflections = 0;
+          pathsGiven = TRUE;
+        }
+
+        if (strcmp(&pArg[5], "none") == 0)
+        {
+          continue;
+        }
+
+        if (sscanf(&pArg[5], "%d:%d:%d:%d", &az, &el, &gainDb, &phase) != 4 ||
+            gainDb > 0 || gainDb < -60)
+        {
+          SimWorld_fail(pStep, "bad path %s", pArg);
+        }
+        else if (pTag->numReflections == AOA_IQGEN_MAX_PATHS - 1)
+        {
+          SimWorld_fail(pStep, "too many paths");
+        }
+        else
+        {
+          AoAIQGen_Path *pPath = &pTag->reflections[pTag->numReflections++];
+
+          pPath->azimuth = az;
+          pPath->elevation = el;
+          pPath->gainDb = gainDb;
+          pPath->phase = phase;
+        }
+      }
+      else if (strncmp(pArg, "adv=", 4) == 0 && atoi(&pArg[4]) > 0)
+      {
+        pTag->advInterval = atoi(&pArg[4]);
+      }
+      else if (strcmp(pArg, "aoa") == 0)
+      {
+        pTag->aoa = TRUE;
+      }
+      else if (strcmp(pArg, "legacy") == 0)
+      {
+        pTag->legacy = TRUE;
+      }
+      else
+      {
+        SimWorld_fail(pStep, "unknown tag option %s", pArg);
+      }
+    }
+  }
+  else if (strcmp(pVerb, "tag-gone") == 0)
+  {
+    uint8_t addr[B_ADDR_LEN];
+    SimTag *pTag;
+
+    if ((pArg = strtok_r(NULL, " \t", &pSave)) == NULL || !SimWorld_parseAddr(pArg, addr) ||
+        (pTag = SimWorld_find(addr)) == NULL)
+    {
+      SimWorld_fail(pStep, "unknown tag");
+      return;
+    }
+
+    // A link to it is lost after the supervision timeout
+    pTag->present = FALSE;
+  }
+  else if (strcmp(pVerb, "array") == 0)
+  {
+    SimArray *pArray;
+    uint8_t n;
+
+    pArg = strtok_r(NULL, " \t", &pSave);
+    if (pArg == NULL || (strcmp(pArg, "A1") != 0 && strcmp(pArg, "A2") != 0))
+    {
+      SimWorld_fail(pStep, "bad array");
+      return;
+    }
+
+    pArray = &simArrays[(pArg[1] == '1') ? ANT_CONFIG_ARRAY_A1 : ANT_CONFIG_ARRAY_A2];
+    memset(pArray, 0, sizeof(SimArray));
+
+    if ((pArg = strtok_r(NULL, " \t", &pSave)) != NULL)
+    {
+      pArray->mountAzimuth = atoi(pArg);
+    }
+
+    for (n = 0; n < 2 * AOA_EST_MAX_ELEMENTS &&
+                (pArg = strtok_r(NULL, " \t", &pSave)) != NULL; n++)
+    {
+      if (n & 1)
+      {
+        pArray->elements[n / 2].y = atoi(pArg);
+      }
+      else
+      {
+        pArray->elements[n / 2].x = atoi(pArg);
+      }
+      pArray->known = TRUE;
+    }
+  }
+  else if (strcmp(pVerb, "key") == 0)
+  {
+    PIN_Id pin;
+
+    pArg = strtok_r(NULL, " \t", &pSave);
+    if (pArg != NULL && strcmp(pArg, "left") == 0)
+    {
+      pin = Board_BTN1;
+    }
+    else if (pArg != NULL && strcmp(pArg, "right") == 0)
+    {
+      pin = Board_BTN2;
+    }
+    else
+    {
+      SimWorld_fail(pStep, "bad key");
+      return;
+    }
+
+    // The debounce clock reads the pin after the press, release later
+    SimIo_key(pin, TRUE);
+  }
+  else if (strcmp(pVerb, "release") == 0)
+  {
+    SimIo_key(Board_BTN1, FALSE);
+    SimIo_key(Board_BTN2, FALSE);
+  }
+  else if (strcmp(pVerb, "cmd") == 0)
+  {
+    uint8_t frame[SIM_MAX_FRAME];
+    uint8_t len = 0;
+    uint8_t fcs = 0;
+    uint8_t i;
+
+    // CMD then DATA, framed with SOF, LEN and FCS
+    while ((pArg = strtok_r(NULL, " \t", &pSave)) != NULL && len < AOA_CMD_MAX_PAYLOAD + 1)
+    {
+      frame[2 + len++] = (uint8_t)strtoul(pArg, NULL, 16);
+    }
+
+    if (len == 0)
+    {
+      SimWorld_fail(pStep, "no command");
+      return;
+    }
+
+    frame[0] = AOA_CMD_SOF;
+    frame[1] = len - 1;
+    for (i = 1; i < len + 2; i++)
+    {
+      fcs ^= frame[i];
+    }
+    frame[len + 2] = fcs;
+
+    SimIo_uartRx(frame, len + 3);
+  }
+  else if (strcmp(pVerb, "expect-rsp") == 0)
+  {
+    char *pStatus;
+    SimRsp rsp;
+
+    pArg = strtok_r(NULL, " \t", &pSave);
+    pStatus = strtok_r(NULL, " \t", &pSave);
+    if (pArg == NULL || pStatus == NULL)
+    {
+      SimWorld_fail(pStep, "expect-rsp <cmd> <status>");
+      return;
+    }
+
+    VOID SimWorld_takeRsp(pStep, (uint8_t)strtoul(pArg, NULL, 16),
+                          (uint8_t)strtoul(pStatus, NULL, 16), &rsp);
+  }
+  else if (strcmp(pVerb, "expect-rsp-u32") == 0)
+  {
+    char *pOffset = NULL;
+    char *pMin = NULL;
+    char *pMax = NULL;
+    uint8_t offset;
+    uint32_t value;
+    SimRsp rsp;
+
+    if ((pArg = strtok_r(NULL, " \t", &pSave)) == NULL ||
+        (pOffset = strtok_r(NULL, " \t", &pSave)) == NULL ||
+        (pMin = strtok_r(NULL, " \t", &pSave)) == NULL ||
+        (pMax = strtok_r(NULL, " \t", &pSave)) == NULL)
+    {
+      SimWorld_fail(pStep, "expect-rsp-u32 <cmd> <offset> <min> <max>");
+      return;
+    }
+
+    if (!SimWorld_takeRsp(pStep, (uint8_t)strtoul(pArg, NULL, 16), 0, &rsp))
+    {
+      return;
+    }
+
+    offset = atoi(pOffset);
+    if (offset + 4 > rsp.len)
+    {
+      SimWorld_fail(pStep, "response to 0x%02x has %u bytes", rsp.cmd, rsp.len);
+      return;
+    }
+
+    value = BUILD_UINT32(rsp.data[offset], rsp.data[offset + 1],
+                         rsp.data[offset + 2], rsp.data[offset + 3]);
+    if (value < strtoul(pMin, NULL, 0) || value > strtoul(pMax, NULL, 0))
+    {
+      SimWorld_fail(pStep, "%u at %u, expected %s to %s", (unsigned)value, offset, pMin, pMax);
+    }
+  }
+  else if (strcmp(pVerb, "expect-display") == 0)
+  {
+    const char *pText = pStep->text + strlen("expect-display");
+
+    pText += strspn(pText, " \t");
+    if (strstr(simDisplayText, pText) == NULL)
+    {
+      SimWorld_fail(pStep, "display did not show \"%s\"", pText);
+    }
+
+    simDisplayLen = 0;
+    simDisplayText[0] = '\0';
+  }
+  else if (strcmp(pVerb, "expect-angles") == 0)
+  {
+    uint32_t min = ((pArg = strtok_r(NULL, " \t", &pSave)) != NULL) ? atoi(pArg) : 1;
+
+    if (simNumAngles < min)
+    {
+      SimWorld_fail(pStep, "%u angles, expected at least %u", (unsigned)simNumAngles,
+                    (unsigned)min);
+    }
+
+    simNumAngles = 0;
+  }
+  else if (strcmp(pVerb, "expect-azimuth") == 0)
+  {
+    char *pTol;
+    int azimuth;
+    int error;
+
+    pArg = strtok_r(NULL, " \t", &pSave);
+    pTol = strtok_r(NULL, " \t", &pSave);
+    if (pArg == NULL || pTol == NULL)
+    {
+      SimWorld_fail(pStep, "expect-azimuth <degrees> <tolerance>");
+      return;
+    }
+
+    azimuth = atoi(pArg);
+    error = ((simLastCurrent - azimuth) % 360 + 540) % 360 - 180;
+
+    if (!simAngleValid)
+    {
+      SimWorld_fail(pStep, "no angle");
+    }
+    else if (abs(error) > atoi(pTol))
+    {
+      SimWorld_fail(pStep, "angle %d, expected %d +- %s", simLastCurrent, azimuth, pTol);
+    }
+  }
+  else if (strcmp(pVerb, "expect-angle-range") == 0)
+  {
+    char *pMax;
+
+    pArg = strtok_r(NULL, " \t", &pSave);
+    pMax = strtok_r(NULL, " \t", &pSave);
+    if (pArg == NULL || pMax == NULL)
+    {
+      SimWorld_fail(pStep, "expect-angle-range <min> <max>");
+      return;
+    }
+
+    if (simAngleMin > simAngleMax)
+    {
+      SimWorld_fail(pStep, "no angle");
+    }
+    else if (simAngleMin < atoi(pArg) || simAngleMax > atoi(pMax))
+    {
+      SimWorld_fail(pStep, "angles %d to %d, expected %s to %s", simAngleMin, simAngleMax,
+                    pArg, pMax);
+    }
+
+    simAngleMin = INT16_MAX;
+    simAngleMax = INT16_MIN;
+  }
+  else if (strcmp(pVerb, "expect-channels") == 0)
+  {
+    while ((pArg = strtok_r(NULL, " \t", &pSave)) != NULL)
+    {
+      int channel = atoi(pArg);
+
+      if (channel < 0 || channel >= 64 ||
+          !(simAngleChannels & ((uint64_t)1 << channel)))
+      {
+        SimWorld_fail(pStep, "no angle on channel %s", pArg);
+      }
+    }
+
+    simAngleChannels = 0;
+  }
+  else if (strcmp(pVerb, "end") == 0)
+  {
+    simEnded = TRUE;
+    SimRtos_stop();
+  }
+  else
+  {
+    SimWorld_fail(pStep, "unknown step");
+  }
+}
+
+/*********************************************************************
+ * @fn      SimWorld_fail
+ *
+ * @brief   Report a failed step.
+ *
+ * @param   pStep - step
+ * @param   fmt   - printf format of the reason
+ *
+ * @return  none
+ */
+static void SimWorld_fail(const SimStep *pStep, const char *fmt, ...)
+{
+  va_list args;
+
+  printf("%s:%u: FAIL: ", simScenarioName, pStep->lineNo);
+  va_start(args, fmt);
+  vprintf(fmt, args);
+  va_end(args);
+  putchar('\n');
+
+  simFailures++;
+}
+
+/*********************************************************************
+ * @fn      SimWorld_takeRsp
+ *
+ * @brief   Consume the first held response to a command and those
+ *          before it, and check its status.
+ *
+ * @param   pStep  - step, for failures
+ * @param   cmd    - command
+ * @param   status - status expected
+ * @param   pRsp   - filled with the response
+ *
+ * @return  FALSE if there is none or its status differs
+ */
+static bool SimWorld_takeRsp(const SimStep *pStep, uint8_t cmd, uint8_t status,
+                             SimRsp *pRsp)
+{
+  uint8_t i;
+
+  for (i = 0; i < simNumRsps && simRsps[i].cmd != cmd; i++);
+
+  if (i == simNumRsps)
+  {
+    SimWorld_fail(pStep, "no response to 0x%02x", cmd);
+    return FALSE;
+  }
+
+  *pRsp = simRsps[i];
+
+  // Consume it and everything before it
+  simNumRsps -= i + 1;
+  memmove(simRsps, &simRsps[i + 1], simNumRsps * sizeof(SimRsp));
+
+  if (pRsp->status != status)
+  {
+    SimWorld_fail(pStep, "response to 0x%02x has status 0x%02x", cmd, pRsp->status);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/*********************************************************************
+ * @fn      SimWorld_parseAddr
+ *
+ * @brief   Parse an address written most significant byte first.
+ *
+ * @param   pText - aa:bb:cc:dd:ee:ff
+ * @param   pAddr - filled over the air order, least significant first
+ *
+ * @return  FALSE if malformed
+ */
+static bool SimWorld_parseAddr(const char *pText, uint8_t *pAddr)
+{
+  unsigned b[B_ADDR_LEN];
+  uint8_t i;
+
+  if (sscanf(pText, "%x:%x:%x:%x:%x:%x", &b[5], &b[4], &b[3], &b[2], &b[1], &b[0]) != 6)
+  {
+    return FALSE;
+  }
+
+  for (i = 0; i < B_ADDR_LEN; i++)
+  {
+    pAddr[i] = (uint8_t)b[i];
+  }
+
+  return TRUE;
+}
+
+/*********************************************************************
+ * @fn      SimWorld_angleSeen
+ *
+ * @brief   Widen the range of angles seen for expect-angle-range.
+ *
+ * @param   angle - degrees
+ *
+ * @return  none
+ */
+static void SimWorld_angleSeen(int16_t angle)
+{
+  if (angle < simAngleMin)
+  {
+    simAngleMin = angle;
+  }
+  if (angle > simAngleMax)
+  {
+    simAngleMax = angle;
+  }
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,353 @@
+/******************************************************************************
+
+ @file       sim_radio.c
+
+ @brief Host simulation of the AoA driver and the RF core: captures of the
+        simulated tags, generated for the array geometry of the world.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+
+#include "sim.h"
+#include "aoa_iq.h"
+#include "aoa_iqgen.h"
+#include "ant_config.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Radio timer ticks per microsecond
+#define SIM_RAT_TICKS_PER_US                  4
+
+// Delay of a capture of the connected sender, us. It transmits its AoA
+// packets right after the connection event.
+#define SIM_CONN_CAPTURE_DELAY                1000
+
+// Offset of the advertiser address in the received entry: header and
+// length precede it
+#define SIM_ENTRY_ADDR_OFFSET                 2
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static AoA_Object aoaObject;
+static AoA_Callback aoaCallback = NULL;
+static Clock_Struct aoaDoneClock;
+
+// Outcome of the capture in progress
+static uint8_t aoaEvent;
+
+static AoA_IQSample aoaSamples[SIM_NUM_IQ_SAMPLES];
+static uint32_t aoaSeed = 1;
+static uint32_t aoaCaptures = 0;
+static uint32_t aoaTimeouts = 0;
+
+static rfc_bleScannerOutput_t rfScannerOutput;
+static uint8_t rfEntryBuf[sizeof(rfc_dataEntryGeneral_t) + SIM_ENTRY_ADDR_OFFSET + B_ADDR_LEN];
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+rfc_bleScannerPar_t RF_bleScannerPar;
+
+rfc_CMD_BLE_SCANNER_t RF_cmdBleScanner =
+{
+  .pParams = &RF_bleScannerPar,
+  .pOutput = &rfScannerOutput,
+};
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void SimRadio_doneHandler(UArg a0);
+static bool SimRadio_capture(const SimTag *pTag, uint8_t channel,
+                             AoA_AntennaConfig *pConfig);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      SimRadio_getCounts
+ *
+ * @brief   Captures completed and timed out since BIOS_start.
+ *
+ * @param   pCaptures - filled with the completed captures
+ * @param   pTimeouts - filled with the timed out captures
+ *
+ * @return  none
+ */
+void SimRadio_getCounts(uint32_t *pCaptures, uint32_t *pTimeouts)
+{
+  *pCaptures = aoaCaptures;
+  *pTimeouts = aoaTimeouts;
+}
+
+AoA_Handle AOA_init(uint8_t role, uint8_t aodPacketId, uint8_t aoaPacketId,
+                    uint32_t antennaPins, uint32_t timerIndex, AoA_Callback callback)
+{
+  Clock_Params clockParams;
+
+  (void)role;
+  (void)aodPacketId;
+  (void)aoaPacketId;
+  (void)antennaPins;
+  (void)timerIndex;
+
+  aoaCallback = callback;
+
+  Clock_Params_init(&clockParams);
+  Clock_construct(&aoaDoneClock, SimRadio_doneHandler, 0, &clockParams);
+
+  return &aoaObject;
+}
+
+void AOA_run(AoA_Handle handle, uint8_t channel, AoA_AntennaConfig *pConfig,
+             uint8_t packetId)
+{
+  const SimTag *pPeer = SimStack_peer();
+  uint32_t start = 0;
+  uint32_t window = RF_bleScannerPar.timeoutTime / SIM_RAT_TICKS_PER_US;
+  uint32_t at;
+
+  (void)handle;
+  (void)packetId;
+
+  RF_cmdBleScanner.channel = channel;
+
+  if (RF_cmdBleScanner.startTrigger.triggerType == TRIG_REL_SUBMIT)
+  {
+    start = RF_cmdBleScanner.startTime / SIM_RAT_TICKS_PER_US;
+  }
+
+  aoaEvent = AOA_EventTimeout;
+  at = start + window;
+
+  if (pPeer != NULL)
+  {
+    // Connected: the sender transmits on the channels it was asked to
+    if (SimStack_senderOn(channel) && SIM_CONN_CAPTURE_DELAY < window &&
+        SimRadio_capture(pPeer, channel, pConfig))
+    {
+      at = start + SIM_CONN_CAPTURE_DELAY;
+    }
+  }
+  else
+  {
+    // Advertising AoA senders, the one heard first is captured
+    uint32_t first = window;
+    SimTag *pFirst = NULL;
+    uint8_t i;
+
+    for (i = 0; i < SIM_MAX_TAGS; i++)
+    {
+      SimTag *pTag = SimWorld_tag(i);
+      uint32_t heard;
+
+      if (pTag == NULL || !pTag->present || !pTag->aoa || pTag->advInterval == 0 ||
+          channel < 37)
+      {
+        continue;
+      }
+
+      heard = SimWorld_rand() % ((uint32_t)pTag->advInterval * 1000);
+      if (heard < first)
+      {
+        first = heard;
+        pFirst = pTag;
+      }
+    }
+
+    if (pFirst != NULL && SimRadio_capture(pFirst, channel, pConfig))
+    {
+      at = start + first;
+    }
+  }
+
+  Clock_setTimeout(Clock_handle(&aoaDoneClock),
+                   (at >= Clock_tickPeriod) ? at / Clock_tickPeriod : 1);
+  Clock_start(Clock_handle(&aoaDoneClock));
+}
+
+void AOA_getRxIQ(uint8_t *pPacketId, AoA_IQSample **ppSamples)
+{
+  // Like the driver, the buffer stays valid, only its contents are
+  // replaced by the next capture
+  *pPacketId = AOA_PACKETID_DEFAULT;
+  *ppSamples = aoaSamples;
+}
+
+void AOA_getPairAngles(uint8_t channel, AoA_AntennaConfig *pConfig,
+                       AoA_AntennaResult *pResult, AoA_IQSample *pSamples)
+{
+  static AoAIQ_Sample packed[SIM_NUM_IQ_SAMPLES];
+  AoAIQ_SlotMap slotMap;
+  uint8_t shift;
+
+  // Every sample of every slot, as the driver does
+  if (!AoAIQ_slotMapInit(&slotMap, pConfig->pattern->numPatterns, SIM_NUM_IQ_SAMPLES,
+                         0, SIM_NUM_IQ_SAMPLES / pConfig->pattern->numPatterns))
+  {
+    return;
+  }
+
+  shift = AoAIQ_pack(pSamples, &slotMap, packed);
+  AoAEst_getPairAngles(channel, rfScannerOutput.lastRssi, pConfig, pResult, packed,
+                       slotMap.numSlots * slotMap.keep, slotMap.keep,
+                       slotMap.slotSamples, shift);
+}
+
+void AOA_toggleMaker(const uint32_t *pPatterns, uint32_t initialPattern,
+                     uint8_t numPatterns, uint32_t *pToggles)
+{
+  uint32_t previous = initialPattern;
+  uint8_t i;
+
+  // In place is allowed: each pattern is read before its toggle is
+  // written
+  for (i = 0; i < numPatterns; i++)
+  {
+    uint32_t pattern = pPatterns[i];
+
+    pToggles[i] = pattern ^ previous;
+    previous = pattern;
+  }
+}
+
+rfc_dataEntryGeneral_t *RFQueue_getDataEntry(void)
+{
+  return (rfc_dataEntryGeneral_t *)rfEntryBuf;
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      SimRadio_doneHandler
+ *
+ * @brief   End of the capture armed by AOA_run.
+ *
+ * @param   a0 - not used
+ *
+ * @return  none
+ */
+static void SimRadio_doneHandler(UArg a0)
+{
+  (void)a0;
+
+  if (aoaEvent == AOA_EventRxIQ)
+  {
+    aoaCaptures++;
+  }
+  else
+  {
+    aoaTimeouts++;
+  }
+
+  if (aoaCallback != NULL)
+  {
+    aoaCallback(aoaEvent);
+  }
+}
+
+/*********************************************************************
+ * @fn      SimRadio_capture
+ *
+ * @brief   Generate the capture of a tag's packet with the array of
+ *          the world and fill in what the RF core reports with it.
+ *
+ * @param   pTag     - tag
+ * @param   channel  - RF channel
+ * @param   pConfig  - antenna array armed
+ *
+ * @return  FALSE if the array cannot be simulated
+ */
+static bool SimRadio_capture(const SimTag *pTag, uint8_t channel,
+                             AoA_AntennaConfig *pConfig)
+{
+  const SimArray *pArray = NULL;
+  rfc_dataEntryGeneral_t *pEntry = RFQueue_getDataEntry();
+  AoAIQGen_Scene scene;
+  uint8_t array;
+
+  for (array = 0; array < ANT_CONFIG_NUM_ARRAYS; array++)
+  {
+    if (AntConfig_get(array) == pConfig)
+    {
+      pArray = SimWorld_array(array);
+    }
+  }
+
+  AoAIQGen_sceneInit(&scene, channel, pTag->azimuth, pTag->elevation);
+  scene.snrDb = pTag->snrDb;
+  scene.cfoKhz = pTag->cfoKhz;
+  scene.numPaths = 1 + pTag->numReflections;
+  memcpy(&scene.paths[1], pTag->reflections,
+         pTag->numReflections * sizeof(AoAIQGen_Path));
+
+  if (!AoAIQGen_capture(pConfig, (pArray != NULL && pArray->known) ? pArray->elements : NULL,
+                        (pArray != NULL) ? pArray->mountAzimuth : 0, &scene, &aoaSeed,
+                        aoaSamples, SIM_NUM_IQ_SAMPLES))
+  {
+    return FALSE;
+  }
+
+  rfScannerOutput.nRxAdvOk++;
+  rfScannerOutput.lastRssi = pTag->rssi;
+  rfScannerOutput.timeStamp = Clock_getTicks();
+
+  memcpy(((uint8_t *)&pEntry->data) + SIM_ENTRY_ADDR_OFFSET, pTag->addr, B_ADDR_LEN);
+
+  aoaEvent = AOA_EventRxIQ;
+
+  return TRUE;
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,421 @@
+/******************************************************************************
+
+ @file       sim_roundtrip.c
+
+ @brief Round trip of the AoA generator through the packer and the
+        estimator.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_sdk.h"
+#include "aoa_iq.h"
+#include "aoa_iqgen.h"
+#include "aoa_estimator.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Capture layout as on the receiver: 32 slots of 16 samples. Without a
+// carrier offset a slot is a whole number of tone periods, the offsets
+// swept below turn the carrier up to 648 degrees more per repetition.
+#define RT_NUM_SAMPLES                        512
+#define RT_NUM_PATTERNS                       32
+#define RT_SLOT_LEN                           (RT_NUM_SAMPLES / RT_NUM_PATTERNS)
+
+// Antenna pins of the patterns, one per element
+#define RT_ANT1                               0x01
+#define RT_ANT2                               0x02
+#define RT_ANT3                               0x04
+
+// Channels the sweeps are run on, their wavelengths differ by 3 %
+#define RT_NUM_CHANNELS                       3
+
+// Words holding an AoA_Pattern followed by its toggles
+#define RT_PATTERN_WORDS                      ((sizeof(AoA_Pattern) + RT_NUM_PATTERNS * sizeof(uint32_t) + 3) / 4)
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Conditions of one sweep and the largest direction error accepted
+typedef struct
+{
+  const char   *pName;
+  int16_t       mountAzimuth;   // Degrees
+  int8_t        snrDb;          // Per sample, or AOA_IQGEN_NO_NOISE
+  uint8_t       settleSamples;  // Skipped when packing
+  int16_t       cfoKhz;
+  int8_t        reflectionDb;   // Gain of a reflection, 0 for none
+  int16_t       reflectionAz;   // Azimuth of the reflector, degrees
+  int16_t       reflectionPhase;
+  uint8_t       maxError;       // Degrees
+} RoundTrip_Case;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Single path scenes are within the arctangent error of the estimator.
+// A reflection 20 dB down bends the angle by up to about 6 degrees,
+// one 10 dB down by up to about 17.
+static const RoundTrip_Case rtCases[] =
+{
+  {"planar",                  0, AOA_IQGEN_NO_NOISE, 0,    0,   0,   0,  0,  3},
+  {"planar mounted at 90",   90, AOA_IQGEN_NO_NOISE, 0,    0,   0,   0,  0,  3},
+  {"planar 30 dB, settling",  0, 30,                 2,    0,   0,   0,  0,  3},
+  {"cfo -150 kHz",            0, AOA_IQGEN_NO_NOISE, 0, -150,   0,   0,  0,  5},
+  {"cfo -75 kHz",             0, AOA_IQGEN_NO_NOISE, 0,  -75,   0,   0,  0,  5},
+  {"cfo -25 kHz",             0, AOA_IQGEN_NO_NOISE, 0,  -25,   0,   0,  0,  5},
+  {"cfo 25 kHz",              0, AOA_IQGEN_NO_NOISE, 0,   25,   0,   0,  0,  5},
+  {"cfo 75 kHz",              0, AOA_IQGEN_NO_NOISE, 0,   75,   0,   0,  0,  5},
+  {"cfo 150 kHz",             0, AOA_IQGEN_NO_NOISE, 0,  150,   0,   0,  0,  5},
+  {"cfo 150 kHz 20 dB",       0, 20,                 2,  150,   0,   0,  0,  5},
+  {"reflection -20 dB",       0, AOA_IQGEN_NO_NOISE, 0,    0, -20, 100, 90,  8},
+  {"reflection -10 dB",       0, AOA_IQGEN_NO_NOISE, 0,    0, -10, 100, 90, 20},
+  {"reflection -10 dB, 180",  0, AOA_IQGEN_NO_NOISE, 0,    0, -10, -30, 180, 20},
+  {"reflection, cfo, noise",  0, 20,                 2, -150, -20, 100,  0, 10},
+};
+
+static const uint8_t rtChannels[RT_NUM_CHANNELS] = {0, 17, 38};
+
+// Planar array, element spacing 50 mm, below half a wavelength
+static const AoAEst_Element rtPlanar[] = {{0, 0}, {500, 0}, {250, 433}};
+
+static AoA_AntennaPair rtPairs[] =
+{
+  {.a = 0, .b = 1, .sign = 1, .offset = 0, .gain = 1.0f},
+  {.a = 0, .b = 2, .sign = 1, .offset = 0, .gain = 1.0f},
+};
+
+static uint32_t rtPatternWords[RT_PATTERN_WORDS];
+
+static AoA_IQSample rtRaw[RT_NUM_SAMPLES];
+static AoAIQ_Sample rtPacked[RT_NUM_SAMPLES];
+
+// Failed checks
+static int rtFailures;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static AoA_Pattern *RoundTrip_pattern(const uint32_t *pPins,
+                                      uint8_t numPins, uint8_t numPatterns);
+static void RoundTrip_sweep(const RoundTrip_Case *pCase,
+                            AoA_AntennaConfig *pConfig);
+static void RoundTrip_checkSlots(void);
+static int16_t RoundTrip_error(int16_t estimate, int16_t truth);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Generate captures of a tag swept around a planar array, pack
+ *          and estimate them as the receiver does and check that the
+ *          direction comes back, with carrier offsets, noise and a
+ *          reflection. Then check that the generator switches the
+ *          elements its pattern selects.
+ *
+ * @return  0 if every check passed
+ */
+int main(void)
+{
+  static const uint32_t cycle[] = {RT_ANT1, RT_ANT2, RT_ANT3};
+  // The first repetition numbers the elements, whatever their pins
+  static const uint32_t rotated[] = {RT_ANT3, RT_ANT1, RT_ANT2};
+  static const RoundTrip_Case rotatedCase =
+    {"planar rotated pins", 0, AOA_IQGEN_NO_NOISE, 0, 0, 0, 0, 0, 3};
+  AoA_AntennaConfig config;
+  uint8_t i;
+
+  config.numAntennas = 3;
+  config.numPairs = sizeof(rtPairs) / sizeof(rtPairs[0]);
+  config.pairs = rtPairs;
+
+  config.pattern = RoundTrip_pattern(cycle, 3, RT_NUM_PATTERNS);
+  for (i = 0; i < sizeof(rtCases) / sizeof(rtCases[0]); i++)
+  {
+    RoundTrip_sweep(&rtCases[i], &config);
+  }
+
+  config.pattern = RoundTrip_pattern(rotated, 3, RT_NUM_PATTERNS);
+  RoundTrip_sweep(&rotatedCase, &config);
+
+  RoundTrip_checkSlots();
+
+  if (rtFailures != 0)
+  {
+    printf("roundtrip: FAIL (%d)\n", rtFailures);
+    return EXIT_FAILURE;
+  }
+
+  printf("roundtrip: PASS\n");
+  return EXIT_SUCCESS;
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      RoundTrip_pattern
+ *
+ * @brief   Build a pattern cycling through the given pins, as the
+ *          receiver stores it: initial pins and toggles.
+ *
+ * @param   pPins       - pins of one repetition
+ * @param   numPins     - entries in pPins
+ * @param   numPatterns - slots of the pattern
+ *
+ * @return  pattern, valid until the next call
+ */
+static AoA_Pattern *RoundTrip_pattern(const uint32_t *pPins,
+                                      uint8_t numPins, uint8_t numPatterns)
+{
+  AoA_Pattern *pPattern = (AoA_Pattern *)rtPatternWords;
+  uint32_t previous = 0;
+  uint8_t slot;
+
+  pPattern->numPatterns = numPatterns;
+  pPattern->initialPattern = previous;
+
+  for (slot = 0; slot < numPatterns; slot++)
+  {
+    pPattern->toggles[slot] = pPins[slot % numPins] ^ previous;
+    previous = pPins[slot % numPins];
+  }
+
+  return pPattern;
+}
+
+/*********************************************************************
+ * @fn      RoundTrip_sweep
+ *
+ * @brief   Sweep a tag in the array plane around the planar array on
+ *          each of rtChannels and check the estimated azimuth. The
+ *          settling samples are skipped when packing, as the receiver's
+ *          slot map would. The reflector stays put while the tag moves.
+ *
+ * @param   pCase   - conditions and error bound
+ * @param   pConfig - antenna array
+ *
+ * @return  None
+ */
+static void RoundTrip_sweep(const RoundTrip_Case *pCase,
+                            AoA_AntennaConfig *pConfig)
+{
+  uint32_t strength[AOA_EST_MAX_PAIRS];
+  int16_t pairAngle[AOA_EST_MAX_PAIRS];
+  AoA_AntennaResult result = {.signalStrength = strength, .pairAngle = pairAngle};
+  AoAEst_Geometry geometry;
+  AoAIQ_SlotMap map;
+  uint32_t seed = 1;
+  uint8_t c;
+  int16_t azimuth;
+
+  if (!AoAEst_initGeometry(&geometry, pConfig, rtPlanar, pCase->mountAzimuth) ||
+      geometry.rank != AOA_EST_GEOMETRY_PLANAR ||
+      !AoAIQ_slotMapInit(&map, RT_NUM_PATTERNS, RT_NUM_SAMPLES,
+                         pCase->settleSamples, RT_SLOT_LEN - pCase->settleSamples))
+  {
+    printf("%s: FAIL: no planar solver\n", pCase->pName);
+    rtFailures++;
+    return;
+  }
+
+  for (c = 0; c < RT_NUM_CHANNELS; c++)
+  {
+    for (azimuth = -180; azimuth < 180; azimuth += 15)
+    {
+      AoAIQGen_Scene scene;
+      AoAEst_Direction dir;
+      uint8_t shift;
+      int16_t error;
+
+      AoAIQGen_sceneInit(&scene, rtChannels[c], azimuth, 0);
+      scene.snrDb = pCase->snrDb;
+      scene.settleSamples = pCase->settleSamples;
+      scene.cfoKhz = pCase->cfoKhz;
+
+      if (pCase->reflectionDb != 0)
+      {
+        scene.numPaths = 2;
+        scene.paths[1].azimuth = pCase->reflectionAz;
+        scene.paths[1].gainDb = pCase->reflectionDb;
+        scene.paths[1].phase = pCase->reflectionPhase;
+      }
+
+      if (!AoAIQGen_capture(pConfig, rtPlanar, pCase->mountAzimuth, &scene, &seed,
+                            rtRaw, RT_NUM_SAMPLES))
+      {
+        printf("%s: FAIL: capture refused\n", pCase->pName);
+        rtFailures++;
+        return;
+      }
+
+      shift = AoAIQ_pack(rtRaw, &map, rtPacked);
+      AoAEst_getPairAngles(rtChannels[c], -50, pConfig, &result, rtPacked,
+                           map.numSlots * map.keep, map.keep, map.slotSamples, shift);
+      AoAEst_getDirection(&geometry, &result, &dir);
+
+      error = RoundTrip_error(dir.azimuth, azimuth);
+      if (error > pCase->maxError || error < -pCase->maxError)
+      {
+        printf("%s: FAIL: channel %u azimuth %d estimated %d, bound %u\n",
+               pCase->pName, rtChannels[c], azimuth, dir.azimuth, pCase->maxError);
+        rtFailures++;
+      }
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      RoundTrip_checkSlots
+ *
+ * @brief   Capture with a pattern that leaves the cycle at its end, as
+ *          the BOOSTXL A1 pattern does, and check every slot against
+ *          the pins switched in: slots on the same element two slots
+ *          apart hold the same samples, the tone turns whole periods
+ *          in between. A pattern with pins the first repetition never
+ *          visits has no element numbering and is refused.
+ *
+ * @return  None
+ */
+static void RoundTrip_checkSlots(void)
+{
+  uint32_t pins[RT_NUM_PATTERNS];
+  AoA_AntennaConfig config;
+  AoAIQGen_Scene scene;
+  uint32_t seed = 1;
+  uint8_t slot;
+
+  for (slot = 0; slot < RT_NUM_PATTERNS; slot++)
+  {
+    pins[slot] = (slot & 1) ? RT_ANT2 : RT_ANT1;
+  }
+  pins[RT_NUM_PATTERNS - 2] = RT_ANT2;
+
+  config.numAntennas = 2;
+  config.numPairs = 1;
+  config.pairs = rtPairs;
+  config.pattern = RoundTrip_pattern(pins, RT_NUM_PATTERNS, RT_NUM_PATTERNS);
+
+  AoAIQGen_sceneInit(&scene, 38, 60, 0);
+
+  if (!AoAIQGen_capture(&config, rtPlanar, 0, &scene, &seed, rtRaw,
+                        RT_NUM_SAMPLES))
+  {
+    printf("slots: FAIL: capture refused\n");
+    rtFailures++;
+    return;
+  }
+
+  for (slot = 2; slot < RT_NUM_PATTERNS; slot++)
+  {
+    const AoA_IQSample *pCur = &rtRaw[slot * RT_SLOT_LEN];
+    const AoA_IQSample *pPrev = pCur - 2 * RT_SLOT_LEN;
+    bool same = (pins[slot] == pins[slot - 2]);
+    uint8_t i;
+
+    for (i = 0; i < RT_SLOT_LEN; i++)
+    {
+      int32_t di = pCur[i].i - pPrev[i].i;
+      int32_t dq = pCur[i].q - pPrev[i].q;
+
+      // Rounding leaves a unit, the elements are 120 degrees apart here
+      if ((di * di + dq * dq > 2) == same)
+      {
+        printf("slots: FAIL: slot %u not on the element of its pins\n", slot);
+        rtFailures++;
+        break;
+      }
+    }
+  }
+
+  pins[RT_NUM_PATTERNS - 1] = RT_ANT3;
+  config.pattern = RoundTrip_pattern(pins, RT_NUM_PATTERNS, RT_NUM_PATTERNS);
+
+  if (AoAIQGen_capture(&config, rtPlanar, 0, &scene, &seed, rtRaw,
+                       RT_NUM_SAMPLES))
+  {
+    printf("slots: FAIL: unknown pins accepted\n");
+    rtFailures++;
+  }
+}
+
+/*********************************************************************
+ * @fn      RoundTrip_error
+ *
+ * @brief   Difference of two azimuths, wrapped to -180..179.
+ *
+ * @param   estimate - degrees
+ * @param   truth    - degrees
+ *
+ * @return  estimate - truth, degrees
+ */
+static int16_t RoundTrip_error(int16_t estimate, int16_t truth)
+{
+  int16_t error = (int16_t)((estimate - truth) % 360);
+
+  if (error >= 180)
+  {
+    error -= 360;
+  }
+  else if (error < -180)
+  {
+    error += 360;
+  }
+
+  return error;
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,924 @@
+/******************************************************************************
+
+ @file       sim_rtos.c
+
+ @brief Host simulation of the AoA receiver: TI-RTOS kernel stand-in.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <ucontext.h>
+
+#include "sim.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Task states
+#define SIM_TASK_READY                        0
+#define SIM_TASK_BLOCKED                      1
+#define SIM_TASK_DONE                         2
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// A task is a coroutine on its own stack. Tasks run in zero simulated
+// time, the scheduler advances the time only when all of them are
+// blocked, so clocks and the radio and stack models act as interrupts
+// arriving between two task switches.
+typedef struct SimTask
+{
+  struct SimTask *next;           // Creation order
+  struct SimTask *nextWaiter;     // Semaphore wait list
+  ucontext_t      ctx;
+  void           *pStack;
+  Task_FuncPtr    fxn;
+  UArg            arg0;
+  UArg            arg1;
+  int             priority;
+  uint8_t         state;
+  bool            timedOut;
+  uint64_t        readySeq;       // FIFO order within a priority
+  uint64_t        wakeAt;         // Pend timeout, 0 for none
+  char            name[8];
+} SimTask;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+uint32_t Clock_tickPeriod = 10;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Context of SimRtos_run, the interrupt level of the simulation
+static ucontext_t simMainCtx;
+
+static SimTask *simTasks = NULL;
+static SimTask *simCurrent = NULL;
+static uint64_t simReadySeq = 0;
+static uint8_t simNumTasks = 0;
+
+// Simulated time, us
+static uint64_t simNow = 0;
+
+// Active clocks, in the order they expire
+static Clock_Struct *simClocks = NULL;
+
+// Hwi_disable nesting, and whether a higher priority task became ready
+// while the switch could not be made
+static UInt simHwiNest = 0;
+static bool simPreemptPending = FALSE;
+
+static bool simStopped = FALSE;
+
+// Serving a host: the time follows the wall clock, from simWallStart
+static bool simRealTime = FALSE;
+static uint64_t simWallStart;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void SimRtos_taskEntry(void);
+static SimTask *SimRtos_pick(void);
+static void SimRtos_ready(SimTask *pTask);
+static void SimRtos_wake(SimTask *pTask);
+static void SimRtos_block(uint32_t timeout);
+static void SimRtos_preempt(void);
+static bool SimRtos_advance(void);
+static uint64_t SimRtos_nextDue(void);
+static uint64_t SimRtos_wallUs(void);
+static bool SimRtos_waitWall(void);
+static void SimRtos_clockInsert(Clock_Struct *pClock);
+static void SimRtos_clockRemove(Clock_Struct *pClock);
+static uint32_t SimRtos_eventMatch(const Event_Struct *pEvent);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      SimRtos_now
+ *
+ * @brief   Simulated time.
+ *
+ * @return  microseconds since BIOS_start
+ */
+uint64_t SimRtos_now(void)
+{
+  return simNow;
+}
+
+/*********************************************************************
+ * @fn      SimRtos_run
+ *
+ * @brief   Scheduler. Runs the highest priority ready task until it
+ *          blocks or is preempted, and when none is ready moves the
+ *          time to the next clock or pend timeout. In real time the
+ *          move waits for the wall clock, and for the host meanwhile.
+ *
+ * @return  none
+ */
+void SimRtos_run(void)
+{
+  while (!simStopped)
+  {
+    SimTask *pTask = SimRtos_pick();
+
+    if (pTask != NULL)
+    {
+      simCurrent = pTask;
+      swapcontext(&simMainCtx, &pTask->ctx);
+      simCurrent = NULL;
+
+      if (pTask->state == SIM_TASK_DONE)
+      {
+        SimIo_log("%s returned", pTask->name);
+      }
+      continue;
+    }
+
+    if (simRealTime && SimRtos_waitWall())
+    {
+      continue;
+    }
+
+    if (!SimRtos_advance())
+    {
+      SimIo_log("all tasks blocked, nothing scheduled");
+      break;
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      SimRtos_stop
+ *
+ * @brief   End the simulation once the current task or clock returns
+ *          to the scheduler.
+ *
+ * @return  none
+ */
+void SimRtos_stop(void)
+{
+  simStopped = TRUE;
+}
+
+/*********************************************************************
+ * @fn      SimRtos_realTime
+ *
+ * @brief   Let the time follow the wall clock from now on, so that a
+ *          host on the UART sees the receiver at its own pace.
+ *
+ * @return  none
+ */
+void SimRtos_realTime(void)
+{
+  simRealTime = TRUE;
+  simWallStart = SimRtos_wallUs() - simNow;
+}
+
+/*********************************************************************
+ * @fn      SimRtos_taskName
+ *
+ * @brief   Name of the running task.
+ *
+ * @return  "taskN" in creation order, "isr" outside of tasks
+ */
+const char *SimRtos_taskName(void)
+{
+  return (simCurrent != NULL) ? simCurrent->name : "isr";
+}
+
+/*********************************************************************
+ * @fn      SimRtos_task
+ *
+ * @brief   Handle of the running task.
+ *
+ * @return  task, NULL outside of tasks
+ */
+void *SimRtos_task(void)
+{
+  return simCurrent;
+}
+
+/*********************************************************************
+ * BIOS
+ */
+
+void BIOS_start(void)
+{
+  SimRtos_run();
+}
+
+/*********************************************************************
+ * Task
+ */
+
+void Task_Params_init(Task_Params *pParams)
+{
+  memset(pParams, 0, sizeof(Task_Params));
+  pParams->priority = 1;
+}
+
+void Task_construct(Task_Struct *pTask, Task_FuncPtr fxn,
+                    const Task_Params *pParams, Error_Block *pEb)
+{
+  SimTask *pSim = calloc(1, sizeof(SimTask));
+  SimTask **ppLast = &simTasks;
+
+  (void)pEb;
+
+  if (pSim == NULL || (pSim->pStack = malloc(SIM_TASK_STACK_SIZE)) == NULL)
+  {
+    fprintf(stderr, "sim: out of memory for a task\n");
+    exit(2);
+  }
+
+  pSim->fxn = fxn;
+  pSim->arg0 = pParams->arg0;
+  pSim->arg1 = pParams->arg1;
+  pSim->priority = pParams->priority;
+  snprintf(pSim->name, sizeof(pSim->name), "task%u", simNumTasks++);
+
+  getcontext(&pSim->ctx);
+  pSim->ctx.uc_stack.ss_sp = pSim->pStack;
+  pSim->ctx.uc_stack.ss_size = SIM_TASK_STACK_SIZE;
+  pSim->ctx.uc_link = &simMainCtx;
+  makecontext(&pSim->ctx, SimRtos_taskEntry, 0);
+
+  while (*ppLast != NULL)
+  {
+    ppLast = &(*ppLast)->next;
+  }
+  *ppLast = pSim;
+
+  pTask->pTask = pSim;
+
+  SimRtos_wake(pSim);
+}
+
+/*********************************************************************
+ * Hwi, Swi
+ */
+
+UInt Hwi_disable(void)
+{
+  return simHwiNest++;
+}
+
+void Hwi_restore(UInt key)
+{
+  simHwiNest = key;
+
+  if (simHwiNest == 0 && simPreemptPending)
+  {
+    simPreemptPending = FALSE;
+    SimRtos_preempt();
+  }
+}
+
+UInt Swi_disable(void)
+{
+  return Hwi_disable();
+}
+
+void Swi_restore(UInt key)
+{
+  Hwi_restore(key);
+}
+
+/*********************************************************************
+ * Clock
+ */
+
+void Clock_Params_init(Clock_Params *pParams)
+{
+  memset(pParams, 0, sizeof(Clock_Params));
+}
+
+void Clock_construct(Clock_Struct *pClock, Clock_FuncPtr fxn,
+                     uint32_t timeout, const Clock_Params *pParams)
+{
+  memset(pClock, 0, sizeof(Clock_Struct));
+  pClock->fxn = fxn;
+  pClock->arg = pParams->arg;
+  pClock->timeout = timeout;
+  pClock->period = pParams->period;
+
+  if (pParams->startFlag)
+  {
+    Clock_start(pClock);
+  }
+}
+
+void Clock_start(Clock_Handle handle)
+{
+  SimRtos_clockRemove(handle);
+  handle->due = simNow + (uint64_t)handle->timeout * Clock_tickPeriod;
+  SimRtos_clockInsert(handle);
+}
+
+void Clock_stop(Clock_Handle handle)
+{
+  SimRtos_clockRemove(handle);
+}
+
+bool Clock_isActive(Clock_Handle handle)
+{
+  return handle->active;
+}
+
+void Clock_setTimeout(Clock_Handle handle, uint32_t timeout)
+{
+  handle->timeout = timeout;
+}
+
+void Clock_setPeriod(Clock_Handle handle, uint32_t period)
+{
+  handle->period = period;
+}
+
+uint32_t Clock_getTicks(void)
+{
+  return (uint32_t)(simNow / Clock_tickPeriod);
+}
+
+/*********************************************************************
+ * Event
+ */
+
+void Event_Params_init(Event_Params *pParams)
+{
+  memset(pParams, 0, sizeof(Event_Params));
+}
+
+void Event_construct(Event_Struct *pEvent, const Event_Params *pParams)
+{
+  (void)pParams;
+  memset(pEvent, 0, sizeof(Event_Struct));
+}
+
+Event_Handle Event_create(const Event_Params *pParams, Error_Block *pEb)
+{
+  (void)pParams;
+  (void)pEb;
+  return calloc(1, sizeof(Event_Struct));
+}
+
+void Event_post(Event_Handle handle, uint32_t eventIds)
+{
+  handle->posted |= eventIds;
+
+  if (handle->pWaiter != NULL && SimRtos_eventMatch(handle) != 0)
+  {
+    SimTask *pWaiter = handle->pWaiter;
+
+    handle->pWaiter = NULL;
+    SimRtos_wake(pWaiter);
+  }
+}
+
+uint32_t Event_pend(Event_Handle handle, uint32_t andMask, uint32_t orMask,
+                    uint32_t timeout)
+{
+  for (;;)
+  {
+    uint32_t events;
+
+    handle->andMask = andMask;
+    handle->orMask = orMask;
+
+    if ((events = SimRtos_eventMatch(handle)) != 0)
+    {
+      handle->posted &= ~events;
+      return events;
+    }
+
+    if (timeout == BIOS_NO_WAIT || simCurrent == NULL)
+    {
+      return 0;
+    }
+
+    handle->pWaiter = simCurrent;
+    SimRtos_block(timeout);
+
+    if (simCurrent->timedOut)
+    {
+      handle->pWaiter = NULL;
+      return 0;
+    }
+  }
+}
+
+/*********************************************************************
+ * Semaphore
+ */
+
+void Semaphore_Params_init(Semaphore_Params *pParams)
+{
+  pParams->mode = Semaphore_Mode_COUNTING;
+}
+
+void Semaphore_construct(Semaphore_Struct *pSem, int count,
+                         const Semaphore_Params *pParams)
+{
+  memset(pSem, 0, sizeof(Semaphore_Struct));
+  pSem->count = count;
+  pSem->mode = (pParams != NULL) ? pParams->mode : Semaphore_Mode_COUNTING;
+}
+
+bool Semaphore_pend(Semaphore_Handle handle, uint32_t timeout)
+{
+  while (handle->count == 0)
+  {
+    SimTask **ppLast = &handle->pWaiters;
+
+    if (timeout == BIOS_NO_WAIT || simCurrent == NULL)
+    {
+      return FALSE;
+    }
+
+    while (*ppLast != NULL)
+    {
+      ppLast = &(*ppLast)->nextWaiter;
+    }
+    *ppLast = simCurrent;
+    simCurrent->nextWaiter = NULL;
+
+    SimRtos_block(timeout);
+
+    if (simCurrent->timedOut)
+    {
+      // Still on the wait list
+      for (ppLast = &handle->pWaiters; *ppLast != NULL; ppLast = &(*ppLast)->nextWaiter)
+      {
+        if (*ppLast == simCurrent)
+        {
+          *ppLast = simCurrent->nextWaiter;
+          break;
+        }
+      }
+      return FALSE;
+    }
+  }
+
+  handle->count--;
+
+  return TRUE;
+}
+
+void Semaphore_post(Semaphore_Handle handle)
+{
+  if (handle->mode == Semaphore_Mode_BINARY)
+  {
+    handle->count = 1;
+  }
+  else
+  {
+    handle->count++;
+  }
+
+  if (handle->pWaiters != NULL)
+  {
+    SimTask *pWaiter = handle->pWaiters;
+
+    handle->pWaiters = pWaiter->nextWaiter;
+    SimRtos_wake(pWaiter);
+  }
+}
+
+/*********************************************************************
+ * Queue
+ */
+
+void Queue_construct(Queue_Struct *pQueue, void *pParams)
+{
+  (void)pParams;
+  pQueue->elem.next = pQueue->elem.prev = &pQueue->elem;
+}
+
+void Queue_put(Queue_Handle handle, Queue_Elem *pElem)
+{
+  UInt key = Hwi_disable();
+
+  pElem->next = &handle->elem;
+  pElem->prev = handle->elem.prev;
+  handle->elem.prev->next = pElem;
+  handle->elem.prev = pElem;
+
+  Hwi_restore(key);
+}
+
+void *Queue_get(Queue_Handle handle)
+{
+  UInt key = Hwi_disable();
+  Queue_Elem *pElem = handle->elem.next;
+
+  // An empty queue returns its own head, as TI-RTOS does
+  pElem->next->prev = &handle->elem;
+  handle->elem.next = pElem->next;
+
+  Hwi_restore(key);
+
+  return pElem;
+}
+
+bool Queue_empty(Queue_Handle handle)
+{
+  return handle->elem.next == &handle->elem;
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      SimRtos_taskEntry
+ *
+ * @brief   First function of every task coroutine.
+ *
+ * @return  none, returns to the scheduler through uc_link
+ */
+static void SimRtos_taskEntry(void)
+{
+  SimTask *pTask = simCurrent;
+
+  pTask->fxn(pTask->arg0, pTask->arg1);
+  pTask->state = SIM_TASK_DONE;
+}
+
+/*********************************************************************
+ * @fn      SimRtos_pick
+ *
+ * @brief   Highest priority ready task, the one ready longest among
+ *          equals.
+ *
+ * @return  task, NULL if none is ready
+ */
+static SimTask *SimRtos_pick(void)
+{
+  SimTask *pBest = NULL;
+  SimTask *pTask;
+
+  for (pTask = simTasks; pTask != NULL; pTask = pTask->next)
+  {
+    if (pTask->state == SIM_TASK_READY &&
+        (pBest == NULL || pTask->priority > pBest->priority ||
+         (pTask->priority == pBest->priority && pTask->readySeq < pBest->readySeq)))
+    {
+      pBest = pTask;
+    }
+  }
+
+  return pBest;
+}
+
+/*********************************************************************
+ * @fn      SimRtos_ready
+ *
+ * @brief   Make a task ready, behind the ready tasks of its priority.
+ *
+ * @param   pTask - task
+ *
+ * @return  none
+ */
+static void SimRtos_ready(SimTask *pTask)
+{
+  pTask->state = SIM_TASK_READY;
+  pTask->readySeq = ++simReadySeq;
+  pTask->wakeAt = 0;
+}
+
+/*********************************************************************
+ * @fn      SimRtos_wake
+ *
+ * @brief   Make a blocked task ready and switch to it right away if it
+ *          preempts the running task.
+ *
+ * @param   pTask - task
+ *
+ * @return  none
+ */
+static void SimRtos_wake(SimTask *pTask)
+{
+  pTask->timedOut = FALSE;
+  SimRtos_ready(pTask);
+
+  if (simCurrent != NULL && pTask->priority > simCurrent->priority)
+  {
+    if (simHwiNest != 0)
+    {
+      simPreemptPending = TRUE;
+    }
+    else
+    {
+      SimRtos_preempt();
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      SimRtos_block
+ *
+ * @brief   Block the running task until it is woken or the timeout
+ *          expires.
+ *
+ * @param   timeout - Clock ticks, BIOS_WAIT_FOREVER for none
+ *
+ * @return  none, simCurrent->timedOut tells which
+ */
+static void SimRtos_block(uint32_t timeout)
+{
+  SimTask *pTask = simCurrent;
+
+  pTask->state = SIM_TASK_BLOCKED;
+  pTask->timedOut = FALSE;
+  pTask->wakeAt = (timeout == BIOS_WAIT_FOREVER) ? 0 :
+                  simNow + (uint64_t)timeout * Clock_tickPeriod + 1;
+
+  swapcontext(&pTask->ctx, &simMainCtx);
+}
+
+/*********************************************************************
+ * @fn      SimRtos_preempt
+ *
+ * @brief   Give the processor back to the scheduler if a higher
+ *          priority task is ready. The running task stays first in
+ *          line of its priority.
+ *
+ * @return  none
+ */
+static void SimRtos_preempt(void)
+{
+  SimTask *pTask = simCurrent;
+
+  if (pTask != NULL && SimRtos_pick() != pTask)
+  {
+    swapcontext(&pTask->ctx, &simMainCtx);
+  }
+}
+
+/*********************************************************************
+ * @fn      SimRtos_advance
+ *
+ * @brief   Move the time to the next clock or pend timeout and handle
+ *          it.
+ *
+ * @return  FALSE if nothing is scheduled
+ */
+static bool SimRtos_advance(void)
+{
+  Clock_Struct *pClock = simClocks;
+  SimTask *pTimeout = NULL;
+  SimTask *pTask;
+
+  for (pTask = simTasks; pTask != NULL; pTask = pTask->next)
+  {
+    if (pTask->state == SIM_TASK_BLOCKED && pTask->wakeAt != 0 &&
+        (pTimeout == NULL || pTask->wakeAt < pTimeout->wakeAt))
+    {
+      pTimeout = pTask;
+    }
+  }
+
+  if (pClock != NULL && (pTimeout == NULL || pClock->due <= pTimeout->wakeAt))
+  {
+    if (pClock->due > simNow)
+    {
+      simNow = pClock->due;
+    }
+
+    SimRtos_clockRemove(pClock);
+    if (pClock->period != 0)
+    {
+      pClock->due = simNow + (uint64_t)pClock->period * Clock_tickPeriod;
+      SimRtos_clockInsert(pClock);
+    }
+
+    pClock->fxn(pClock->arg);
+    return TRUE;
+  }
+
+  if (pTimeout != NULL)
+  {
+    if (pTimeout->wakeAt > simNow)
+    {
+      simNow = pTimeout->wakeAt;
+    }
+
+    SimRtos_ready(pTimeout);
+    pTimeout->timedOut = TRUE;
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+/*********************************************************************
+ * @fn      SimRtos_nextDue
+ *
+ * @brief   Time of the next clock or pend timeout.
+ *
+ * @return  us, UINT64_MAX if nothing is scheduled
+ */
+static uint64_t SimRtos_nextDue(void)
+{
+  uint64_t due = (simClocks != NULL) ? simClocks->due : UINT64_MAX;
+  SimTask *pTask;
+
+  for (pTask = simTasks; pTask != NULL; pTask = pTask->next)
+  {
+    if (pTask->state == SIM_TASK_BLOCKED && pTask->wakeAt != 0 && pTask->wakeAt < due)
+    {
+      due = pTask->wakeAt;
+    }
+  }
+
+  return due;
+}
+
+/*********************************************************************
+ * @fn      SimRtos_wallUs
+ *
+ * @brief   Wall clock.
+ *
+ * @return  us of the monotonic clock
+ */
+static uint64_t SimRtos_wallUs(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+/*********************************************************************
+ * @fn      SimRtos_waitWall
+ *
+ * @brief   Hold the time until the wall clock reaches the next clock or
+ *          pend timeout, taking the host's UART bytes meanwhile. Bytes
+ *          arrive at the wall clock time, never past the next event.
+ *
+ * @return  TRUE if the host wrote or closed the UART, FALSE once the
+ *          next event is due
+ */
+static bool SimRtos_waitWall(void)
+{
+  uint64_t due = SimRtos_nextDue();
+  uint64_t wall = SimRtos_wallUs() - simWallStart;
+
+  if (wall >= due)
+  {
+    return FALSE;
+  }
+
+  if (!SimIo_hostRead((due == UINT64_MAX) ? UINT64_MAX : due - wall))
+  {
+    return FALSE;
+  }
+
+  wall = SimRtos_wallUs() - simWallStart;
+  if (wall > due)
+  {
+    wall = due;
+  }
+  if (wall > simNow)
+  {
+    simNow = wall;
+  }
+
+  return TRUE;
+}
+
+/*********************************************************************
+ * @fn      SimRtos_clockInsert
+ *
+ * @brief   Activate a clock, behind the clocks due at the same time.
+ *
+ * @param   pClock - clock, due set
+ *
+ * @return  none
+ */
+static void SimRtos_clockInsert(Clock_Struct *pClock)
+{
+  Clock_Struct **ppNext = &simClocks;
+
+  while (*ppNext != NULL && (*ppNext)->due <= pClock->due)
+  {
+    ppNext = &(*ppNext)->next;
+  }
+
+  pClock->next = *ppNext;
+  *ppNext = pClock;
+  pClock->active = TRUE;
+}
+
+/*********************************************************************
+ * @fn      SimRtos_clockRemove
+ *
+ * @brief   Deactivate a clock.
+ *
+ * @param   pClock - clock
+ *
+ * @return  none
+ */
+static void SimRtos_clockRemove(Clock_Struct *pClock)
+{
+  Clock_Struct **ppNext;
+
+  if (!pClock->active)
+  {
+    return;
+  }
+
+  for (ppNext = &simClocks; *ppNext != NULL; ppNext = &(*ppNext)->next)
+  {
+    if (*ppNext == pClock)
+    {
+      *ppNext = pClock->next;
+      break;
+    }
+  }
+
+  pClock->active = FALSE;
+}
+
+/*********************************************************************
+ * @fn      SimRtos_eventMatch
+ *
+ * @brief   Events that satisfy the masks of the last Event_pend.
+ *
+ * @param   pEvent - event
+ *
+ * @return  events to consume, 0 if the pend must wait
+ */
+static uint32_t SimRtos_eventMatch(const Event_Struct *pEvent)
+{
+  uint32_t andEvents = pEvent->posted & pEvent->andMask;
+  uint32_t orEvents = pEvent->posted & pEvent->orMask;
+
+  if (pEvent->andMask != 0 && andEvents != pEvent->andMask)
+  {
+    return 0;
+  }
+
+  if (pEvent->orMask != 0 && orEvents == 0 && pEvent->andMask == 0)
+  {
+    return 0;
+  }
+
+  return andEvents | orEvents;
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,1636 @@
+/******************************************************************************
+
+ @file       sim_stack.c
+
+ @brief Host simulation of the AoA receiver: ICall, the GAP and GATT
+        client APIs of the stack, and the GATT server of the sender.
+
+ Group: CMCU, SCS
+ Target Device: CC2640R2
+
+ ******************************************************************************
+ 
+ Copyright (c) 2014-2018, Texas Instruments Incorporated
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ *  Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+ *  Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+ *  Neither the name of Texas Instruments Incorporated nor the names of
+    its contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ ******************************************************************************
+ Release Name: simplelink_cc2640r2_sdk_02_30_00_28
+ Release Date: 2018-10-15 15:51:38
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#define SIM_MAX_ENTITIES                      4
+
+// Links the simulated controller can hold
+#define SIM_MAX_CONNS                         1
+
+// Delay of GAP_DEVICE_INIT_DONE_EVENT, ms
+#define SIM_INIT_DELAY                        1
+
+// Advertising report tick while discovering, ms
+#define SIM_DISC_TICK                         10
+
+// Connection attempts, ms apart
+#define SIM_EST_TICK                          30
+
+// Connection events from a parameter update request to its instant
+#define SIM_UPDATE_INSTANT                    6
+
+// Clock ticks per 1.25 ms connection interval unit
+#define SIM_CONN_UNITS_TICKS(n)               ((uint32_t)(n) * 1250 / Clock_tickPeriod)
+
+// HCI reasons and GAP statuses the receiver sees
+#define SIM_HCI_CONNECTION_TIMEOUT            0x08
+#define SIM_HCI_TERMINATED_BY_LOCAL_HOST      0x16
+#define SIM_GAP_USER_CANCELED                 0x30
+#define SIM_GAP_CONN_NOT_ACCEPTABLE           0x31
+
+#define SIM_NV_OPER_FAILED                    0x0A
+
+// GATT server of the sender: the AoA service with the start and the
+// control characteristic. Legacy senders end after the start value.
+#define SIM_PEER_SVC_UUID                     0xFFB0
+#define SIM_PEER_START_UUID                   0xFFB1
+#define SIM_PEER_CTRL_UUID                    0xFFB2
+#define SIM_PEER_SVC_START                    0x0020
+#define SIM_PEER_START_DECL                   0x0021
+#define SIM_PEER_START_VALUE                  0x0022
+#define SIM_PEER_CTRL_DECL                    0x0023
+#define SIM_PEER_CTRL_VALUE                   0x0024
+#define SIM_PEER_SVC_END                      0x0026
+#define SIM_PEER_LEGACY_SVC_END               0x0022
+
+// Control value: op, packetId, channel bit-map[5], uint16 period, burst
+#define SIM_PEER_CTRL_LEN                     10
+#define SIM_PEER_CTRL_START                   0x01
+
+// Characteristic declaration entry: handle, properties, value handle,
+// 16-bit UUID
+#define SIM_CHAR_ENTRY_LEN                    7
+
+// Link states
+#define SIM_LINK_IDLE                         0
+#define SIM_LINK_CONNECTING                   1
+#define SIM_LINK_CONNECTED                    2
+#define SIM_LINK_TERMINATING                  3
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Header of every ICall_malloc block, so any block can be queued as a
+// message
+typedef union
+{
+  struct
+  {
+    Queue_Elem    elem;
+    ICall_EntityID dest;
+  } h;
+  long double align;
+} SimMsgHdr;
+
+// An entity registered with ICall_registerApp
+typedef struct
+{
+  void         *pTask;
+  Event_Struct  event;
+  Queue_Struct  queue;
+} SimEntity;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+const uint8_t primaryServiceUUID[ATT_BT_UUID_SIZE] =
+{
+  LO_UINT16(GATT_PRIMARY_SERVICE_UUID), HI_UINT16(GATT_PRIMARY_SERVICE_UUID)
+};
+
+const uint8_t characterUUID[ATT_BT_UUID_SIZE] =
+{
+  LO_UINT16(GATT_CHARACTER_UUID), HI_UINT16(GATT_CHARACTER_UUID)
+};
+
+const uint8_t clientCharCfgUUID[ATT_BT_UUID_SIZE] =
+{
+  LO_UINT16(GATT_CLIENT_CHAR_CFG_UUID), HI_UINT16(GATT_CLIENT_CHAR_CFG_UUID)
+};
+
+const uint8_t charUserDescUUID[ATT_BT_UUID_SIZE] =
+{
+  LO_UINT16(GATT_CHAR_USER_DESC_UUID), HI_UINT16(GATT_CHAR_USER_DESC_UUID)
+};
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static SimEntity simEntities[SIM_MAX_ENTITIES];
+static uint8_t simNumEntities = 0;
+
+// GAP
+static ICall_EntityID gapEntity;
+// Stack defaults, before the application changes them
+static uint16_t gapParams[TGAP_PARAMID_MAX] =
+{
+  [TGAP_GEN_DISC_SCAN] = 10240,
+  [TGAP_LIM_DISC_SCAN] = 10240,
+  [TGAP_GEN_DISC_SCAN_INT] = 16,
+  [TGAP_GEN_DISC_SCAN_WIND] = 16,
+  [TGAP_CONN_EST_INT_MIN] = 80,
+  [TGAP_CONN_EST_INT_MAX] = 80,
+  [TGAP_CONN_EST_SUPERV_TIMEOUT] = 2000,
+  [TGAP_FILTER_ADV_REPORTS] = TRUE,
+};
+static Clock_Struct gapInitClock;
+static uint16_t gapDataPktLen = 251;
+
+// Discovery
+static bool discActive = FALSE;
+static ICall_EntityID discEntity;
+static Clock_Struct discTickClock;
+static Clock_Struct discEndClock;
+static uint64_t discNextAdv[SIM_MAX_TAGS];
+static bool discReported[SIM_MAX_TAGS];
+
+// The tag link
+static uint8_t linkState = SIM_LINK_IDLE;
+static ICall_EntityID linkEntity;
+static uint8_t linkAddr[B_ADDR_LEN];
+static const SimTag *linkTag = NULL;
+static uint16_t linkInterval;
+static uint16_t linkLatency;
+static uint16_t linkTimeout;
+static uint16_t linkEventCounter;
+static uint64_t linkLastHeard;
+static Clock_Struct linkEstClock;
+static Clock_Struct linkEvtClock;
+static pfnGapConnEvtCB_t linkEvtCb = NULL;
+
+static bool linkUpdatePending = FALSE;
+static uint8_t linkUpdateCountdown;
+static gapUpdateLinkParamReq_t linkUpdateReq;
+
+// ATT client procedures, one request at a time. Responses wait for the
+// next connection event.
+static uint16_t attMtu = ATT_MTU_SIZE;
+static bool attBusy = FALSE;
+static Queue_Struct attRspQueue;
+static ICall_EntityID attMsgEntity = 0xFF;
+
+// Sender behind the link
+static bool peerSenderActive = FALSE;
+static uint8_t peerChannelMap[5];
+
+// SNV
+static struct
+{
+  uint8_t len;
+  uint8_t data[255];
+} simNv[256];
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static SimMsgHdr *SimStack_hdr(void *pMsg);
+static SimEntity *SimStack_entity(void);
+static void *SimStack_gapMsg(uint8_t opcode, uint8_t status, size_t size);
+static gattMsgEvent_t *SimStack_gattMsg(uint8_t method, uint8_t status);
+static void SimStack_attQueue(ICall_EntityID dest, gattMsgEvent_t *pMsg);
+static bStatus_t SimStack_attRequest(uint16_t connHandle);
+static uint8_t SimStack_peerWrite(uint16_t handle, const uint8_t *pValue, uint16_t len);
+static uint8_t SimStack_peerChars(uint16_t start, uint16_t end, uint16_t uuid,
+                                  uint8_t *pList);
+static void SimStack_initDoneHandler(UArg a0);
+static void SimStack_discTickHandler(UArg a0);
+static void SimStack_discEndHandler(UArg a0);
+static void SimStack_discEnd(uint8_t status);
+static void SimStack_estHandler(UArg a0);
+static void SimStack_connEvtHandler(UArg a0);
+static void SimStack_linkTerminated(uint8_t reason);
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      SimICall_send
+ *
+ * @brief   Queue a message to an entity and post its ICall event.
+ *
+ * @param   dest - entity
+ * @param   pMsg - message allocated with ICall_malloc
+ *
+ * @return  none
+ */
+void SimICall_send(ICall_EntityID dest, void *pMsg)
+{
+  SimEntity *pEntity = &simEntities[dest];
+
+  Queue_put(Queue_handle(&pEntity->queue), &SimStack_hdr(pMsg)->h.elem);
+  Event_post(Event_handle(&pEntity->event), ICALL_MSG_EVENT_ID);
+}
+
+/*********************************************************************
+ * @fn      SimStack_peer
+ *
+ * @brief   Tag on the other end of the link.
+ *
+ * @return  tag, NULL if not connected
+ */
+const SimTag *SimStack_peer(void)
+{
+  return (linkState == SIM_LINK_CONNECTED) ? linkTag : NULL;
+}
+
+/*********************************************************************
+ * @fn      SimStack_senderOn
+ *
+ * @brief   Whether the connected sender transmits AoA packets on a
+ *          channel, as asked by the last start or control write.
+ *
+ * @param   channel - RF channel
+ *
+ * @return  TRUE if it does
+ */
+bool SimStack_senderOn(uint8_t channel)
+{
+  return linkState == SIM_LINK_CONNECTED && linkTag->present &&
+         peerSenderActive && channel < 40 &&
+         (peerChannelMap[channel / 8] & (1 << (channel % 8))) != 0;
+}
+
+/*********************************************************************
+ * ICall
+ */
+
+void ICall_registerApp(ICall_EntityID *pEntity, ICall_SyncHandle *pSyncHandle)
+{
+  SimEntity *pSim = &simEntities[simNumEntities];
+
+  pSim->pTask = SimRtos_task();
+  Event_construct(&pSim->event, NULL);
+  Queue_construct(&pSim->queue, NULL);
+
+  *pEntity = simNumEntities++;
+  *pSyncHandle = Event_handle(&pSim->event);
+}
+
+ICall_Errno ICall_fetchServiceMsg(ICall_ServiceEnum *pSrc, ICall_EntityID *pDest,
+                                  void **ppMsg)
+{
+  SimEntity *pEntity = SimStack_entity();
+  Queue_Handle queue;
+  SimMsgHdr *pHdr;
+
+  if (pEntity == NULL)
+  {
+    return ICALL_ERRNO_NOMSG;
+  }
+
+  queue = Queue_handle(&pEntity->queue);
+  if (Queue_empty(queue))
+  {
+    return ICALL_ERRNO_NOMSG;
+  }
+
+  pHdr = Queue_get(queue);
+  *pSrc = ICALL_SERVICE_CLASS_BLE;
+  *pDest = (ICall_EntityID)(pEntity - simEntities);
+  *ppMsg = pHdr + 1;
+
+  // One message per wake-up, the event stays posted for the rest
+  if (!Queue_empty(queue))
+  {
+    Event_post(Event_handle(&pEntity->event), ICALL_MSG_EVENT_ID);
+  }
+
+  return ICALL_ERRNO_SUCCESS;
+}
+
+void *ICall_malloc(size_t size)
+{
+  SimMsgHdr *pHdr = calloc(1, sizeof(SimMsgHdr) + size);
+
+  return (pHdr != NULL) ? pHdr + 1 : NULL;
+}
+
+void ICall_free(void *pMsg)
+{
+  if (pMsg != NULL)
+  {
+    free(SimStack_hdr(pMsg));
+  }
+}
+
+void *ICall_mallocLimited(size_t size)
+{
+  return ICall_malloc(size);
+}
+
+void ICall_freeMsg(void *pMsg)
+{
+  ICall_free(pMsg);
+}
+
+ICall_EntityID ICall_getLocalMsgEntityId(ICall_ServiceEnum service,
+                                         ICall_EntityID entity)
+{
+  (void)service;
+  return entity;
+}
+
+ICall_CSState ICall_enterCriticalSection(void)
+{
+  return Hwi_disable();
+}
+
+void ICall_leaveCriticalSection(ICall_CSState key)
+{
+  Hwi_restore(key);
+}
+
+/*********************************************************************
+ * GAP
+ */
+
+bStatus_t GAP_DeviceInit(uint8_t taskID, uint8_t profileRole,
+                         uint8_t maxScanResponses, uint8_t *pIRK,
+                         uint8_t *pSRK, uint32_t *pSignCounter)
+{
+  Clock_Params clockParams;
+
+  (void)profileRole;
+  (void)maxScanResponses;
+  (void)pIRK;
+  (void)pSRK;
+  (void)pSignCounter;
+
+  gapEntity = taskID;
+  linkDBNumConns = SIM_MAX_CONNS;
+  Queue_construct(&attRspQueue, NULL);
+
+  Clock_Params_init(&clockParams);
+  Clock_construct(&gapInitClock, SimStack_initDoneHandler,
+                  SIM_INIT_DELAY * 1000 / Clock_tickPeriod, &clockParams);
+  Clock_construct(&discTickClock, SimStack_discTickHandler,
+                  SIM_DISC_TICK * 1000 / Clock_tickPeriod, &clockParams);
+  Clock_construct(&discEndClock, SimStack_discEndHandler, 0, &clockParams);
+  Clock_construct(&linkEstClock, SimStack_estHandler,
+                  SIM_EST_TICK * 1000 / Clock_tickPeriod, &clockParams);
+  Clock_construct(&linkEvtClock, SimStack_connEvtHandler, 0, &clockParams);
+  Clock_setPeriod(Clock_handle(&discTickClock), SIM_DISC_TICK * 1000 / Clock_tickPeriod);
+  Clock_setPeriod(Clock_handle(&linkEstClock), SIM_EST_TICK * 1000 / Clock_tickPeriod);
+
+  Clock_start(Clock_handle(&gapInitClock));
+
+  return SUCCESS;
+}
+
+void GAP_SetParamValue(uint16_t paramID, uint16_t paramValue)
+{
+  if (paramID < TGAP_PARAMID_MAX)
+  {
+    gapParams[paramID] = paramValue;
+  }
+}
+
+uint16_t GAP_GetParamValue(uint16_t paramID)
+{
+  return (paramID < TGAP_PARAMID_MAX) ? gapParams[paramID] : 0;
+}
+
+bStatus_t GAP_DeviceDiscoveryRequest(gapDevDiscReq_t *pParams)
+{
+  uint8_t i;
+
+  if (discActive)
+  {
+    return bleAlreadyInRequestedMode;
+  }
+
+  discActive = TRUE;
+  discEntity = pParams->taskID;
+
+  // Every tag is heard at a random point of its first interval
+  for (i = 0; i < SIM_MAX_TAGS; i++)
+  {
+    SimTag *pTag = SimWorld_tag(i);
+
+    discReported[i] = FALSE;
+    discNextAdv[i] = SimRtos_now();
+    if (pTag != NULL && pTag->advInterval != 0)
+    {
+      discNextAdv[i] += (uint64_t)(SimWorld_rand() % pTag->advInterval) * 1000;
+    }
+  }
+
+  Clock_start(Clock_handle(&discTickClock));
+  Clock_setTimeout(Clock_handle(&discEndClock),
+                   (uint32_t)GAP_GetParamValue(TGAP_GEN_DISC_SCAN) * 1000 / Clock_tickPeriod);
+  Clock_start(Clock_handle(&discEndClock));
+
+  return SUCCESS;
+}
+
+bStatus_t GAP_DeviceDiscoveryCancel(uint8_t taskID)
+{
+  (void)taskID;
+
+  if (!discActive)
+  {
+    return bleIncorrectMode;
+  }
+
+  SimStack_discEnd(SIM_GAP_USER_CANCELED);
+
+  return SUCCESS;
+}
+
+bStatus_t GAP_EstablishLinkReq(gapEstLinkReq_t *pParams)
+{
+  if (linkState != SIM_LINK_IDLE)
+  {
+    return bleIncorrectMode;
+  }
+
+  linkState = SIM_LINK_CONNECTING;
+  linkEntity = pParams->taskID;
+  memcpy(linkAddr, pParams->peerAddr, B_ADDR_LEN);
+
+  Clock_start(Clock_handle(&linkEstClock));
+
+  return SUCCESS;
+}
+
+bStatus_t GAP_TerminateLinkReq(uint8_t taskID, uint16_t connHandle, uint8_t reason)
+{
+  (void)taskID;
+  (void)reason;
+
+  if (linkState == SIM_LINK_CONNECTING)
+  {
+    gapEstLinkReqEvent_t *pEvt;
+
+    // Cancel the connection attempt
+    Clock_stop(Clock_handle(&linkEstClock));
+    linkState = SIM_LINK_IDLE;
+
+    pEvt = SimStack_gapMsg(GAP_LINK_ESTABLISHED_EVENT, SIM_GAP_CONN_NOT_ACCEPTABLE,
+                           sizeof(gapEstLinkReqEvent_t));
+    pEvt->connectionHandle = GAP_CONNHANDLE_INIT;
+    memcpy(pEvt->devAddr, linkAddr, B_ADDR_LEN);
+    SimICall_send(linkEntity, pEvt);
+
+    return SUCCESS;
+  }
+
+  if (linkState != SIM_LINK_CONNECTED ||
+      (connHandle != SIM_CONN_HANDLE && connHandle != GAP_CONNHANDLE_ALL))
+  {
+    return bleNotConnected;
+  }
+
+  // Gone at the next connection event
+  linkState = SIM_LINK_TERMINATING;
+
+  return SUCCESS;
+}
+
+bStatus_t GAP_UpdateLinkParamReq(gapUpdateLinkParamReq_t *pParams)
+{
+  if (linkState != SIM_LINK_CONNECTED || pParams->connectionHandle != SIM_CONN_HANDLE)
+  {
+    return bleNotConnected;
+  }
+
+  if (pParams->intervalMin < 6 || pParams->intervalMin > pParams->intervalMax ||
+      pParams->intervalMax > 3200)
+  {
+    return bleInvalidRange;
+  }
+
+  // The controller runs one procedure at a time
+  if (linkUpdatePending)
+  {
+    return bleIncorrectMode;
+  }
+
+  linkUpdateReq = *pParams;
+  linkUpdateCountdown = SIM_UPDATE_INSTANT;
+  linkUpdatePending = TRUE;
+
+  return SUCCESS;
+}
+
+bStatus_t GAP_UpdateLinkParamReqReply(gapUpdateLinkParamReqReply_t *pParams)
+{
+  (void)pParams;
+  return SUCCESS;
+}
+
+bStatus_t GAP_MakeDiscoverable(uint8_t taskID, gapAdvertisingParams_t *pParams)
+{
+  (void)taskID;
+  (void)pParams;
+  return SUCCESS;
+}
+
+bStatus_t GAP_EndDiscoverable(uint8_t taskID)
+{
+  (void)taskID;
+  return SUCCESS;
+}
+
+bStatus_t GAP_UpdateAdvertisingData(uint8_t taskID, uint8_t adType,
+                                    uint16_t dataLen, uint8_t *pAdvData)
+{
+  (void)taskID;
+  (void)adType;
+  (void)dataLen;
+  (void)pAdvData;
+  return SUCCESS;
+}
+
+bStatus_t GAP_RegisterConnEventCb(pfnGapConnEvtCB_t cb, uint8_t action,
+                                  uint16_t connHandle)
+{
+  (void)connHandle;
+
+  linkEvtCb = (action == GAP_CB_REGISTER) ? cb : NULL;
+
+  return SUCCESS;
+}
+
+/*********************************************************************
+ * GAP Bond Manager, no pairing is simulated
+ */
+
+bStatus_t GAPBondMgr_SetParameter(uint16_t param, uint8_t len, void *pValue)
+{
+  (void)param;
+  (void)len;
+  (void)pValue;
+  return SUCCESS;
+}
+
+bStatus_t GAPBondMgr_Register(gapBondCBs_t *pCB)
+{
+  (void)pCB;
+  return SUCCESS;
+}
+
+bStatus_t GAPBondMgr_PasscodeRsp(uint16_t connectionHandle, uint8_t status,
+                                 uint32_t passcode)
+{
+  (void)connectionHandle;
+  (void)status;
+  (void)passcode;
+  return SUCCESS;
+}
+
+uint8_t GAPBondMgr_LinkEst(uint8_t addrType, uint8_t *pDevAddr,
+                           uint16_t connHandle, uint8_t role)
+{
+  (void)addrType;
+  (void)pDevAddr;
+  (void)connHandle;
+  (void)role;
+  return SUCCESS;
+}
+
+void GAPBondMgr_LinkTerm(uint16_t connHandle)
+{
+  (void)connHandle;
+}
+
+void GAPBondMgr_SlaveReqSecurity(uint16_t connHandle, uint8_t authReq)
+{
+  (void)connHandle;
+  (void)authReq;
+}
+
+bStatus_t GAPBondMgr_FindAddr(uint8_t *pDevAddr, uint8_t addrType,
+                              uint8_t *pIdx, uint8_t *pIdAddrType,
+                              uint8_t *pIdAddr)
+{
+  (void)pDevAddr;
+  (void)addrType;
+  (void)pIdx;
+  (void)pIdAddrType;
+  (void)pIdAddr;
+  return FAILURE;
+}
+
+/*********************************************************************
+ * HCI
+ */
+
+bStatus_t HCI_EXT_GetActiveConnInfoCmd(uint8_t connId, hciActiveConnInfo_t *pConnInfo)
+{
+  (void)connId;
+
+  if (linkState != SIM_LINK_CONNECTED)
+  {
+    return bleNotConnected;
+  }
+
+  memset(pConnInfo, 0, sizeof(hciActiveConnInfo_t));
+  pConnInfo->accessAddr = 0x50654C3A;
+  pConnInfo->connInterval = linkInterval;
+  pConnInfo->hopValue = 7;
+  pConnInfo->mSCA = 50;
+  pConnInfo->nextChan = (linkEventCounter * 7) % 37;
+  memset(pConnInfo->chanMap, 0xFF, 4);
+  pConnInfo->chanMap[4] = 0x1F;
+
+  return SUCCESS;
+}
+
+bStatus_t HCI_LE_WriteSuggestedDefaultDataLenCmd(uint16_t txOctets, uint16_t txTime)
+{
+  (void)txOctets;
+  (void)txTime;
+  return SUCCESS;
+}
+
+/*********************************************************************
+ * GATT client
+ */
+
+bStatus_t GATT_InitClient(void)
+{
+  return SUCCESS;
+}
+
+bStatus_t GATT_RegisterForInd(uint8_t taskId)
+{
+  (void)taskId;
+  return SUCCESS;
+}
+
+void GATT_RegisterForMsgs(uint8_t taskId)
+{
+  attMsgEntity = taskId;
+}
+
+uint16_t GATT_GetMTU(uint16_t connHandle)
+{
+  (void)connHandle;
+  return attMtu;
+}
+
+bStatus_t GATT_ExchangeMTU(uint16_t connHandle, attExchangeMTUReq_t *pReq,
+                           uint8_t taskId)
+{
+  gattMsgEvent_t *pMsg;
+  bStatus_t status;
+
+  if ((status = SimStack_attRequest(connHandle)) != SUCCESS)
+  {
+    return status;
+  }
+
+  attMtu = (pReq->clientRxMTU < SIM_PEER_MTU) ? pReq->clientRxMTU : SIM_PEER_MTU;
+  if (attMtu < ATT_MTU_SIZE)
+  {
+    attMtu = ATT_MTU_SIZE;
+  }
+
+  pMsg = SimStack_gattMsg(ATT_EXCHANGE_MTU_RSP, SUCCESS);
+  pMsg->msg.exchangeMTURsp.serverRxMTU = SIM_PEER_MTU;
+  SimStack_attQueue(taskId, pMsg);
+
+  pMsg = SimStack_gattMsg(ATT_MTU_UPDATED_EVENT, SUCCESS);
+  pMsg->msg.mtuEvt.MTU = attMtu;
+  SimStack_attQueue((attMsgEntity != 0xFF) ? attMsgEntity : taskId, pMsg);
+
+  return SUCCESS;
+}
+
+bStatus_t GATT_DiscPrimaryServiceByUUID(uint16_t connHandle, uint8_t *pUUID,
+                                        uint8_t len, uint8_t taskId)
+{
+  gattMsgEvent_t *pMsg;
+  bStatus_t status;
+
+  if ((status = SimStack_attRequest(connHandle)) != SUCCESS)
+  {
+    return status;
+  }
+
+  if (linkTag->aoa && len == ATT_BT_UUID_SIZE &&
+      BUILD_UINT16(pUUID[0], pUUID[1]) == SIM_PEER_SVC_UUID)
+  {
+    uint16_t end = linkTag->legacy ? SIM_PEER_LEGACY_SVC_END : SIM_PEER_SVC_END;
+
+    pMsg = SimStack_gattMsg(ATT_FIND_BY_TYPE_VALUE_RSP, SUCCESS);
+    pMsg->msg.findByTypeValueRsp.numInfo = 1;
+    pMsg->msg.findByTypeValueRsp.pHandlesInfo = GATT_bm_alloc(connHandle,
+                                                              ATT_FIND_BY_TYPE_VALUE_RSP,
+                                                              4, NULL);
+    pMsg->msg.findByTypeValueRsp.pHandlesInfo[0] = LO_UINT16(SIM_PEER_SVC_START);
+    pMsg->msg.findByTypeValueRsp.pHandlesInfo[1] = HI_UINT16(SIM_PEER_SVC_START);
+    pMsg->msg.findByTypeValueRsp.pHandlesInfo[2] = LO_UINT16(end);
+    pMsg->msg.findByTypeValueRsp.pHandlesInfo[3] = HI_UINT16(end);
+    SimStack_attQueue(taskId, pMsg);
+  }
+
+  SimStack_attQueue(taskId, SimStack_gattMsg(ATT_FIND_BY_TYPE_VALUE_RSP,
+                                             bleProcedureComplete));
+
+  return SUCCESS;
+}
+
+bStatus_t GATT_DiscCharsByUUID(uint16_t connHandle, attReadByTypeReq_t *pReq,
+                               uint8_t taskId)
+{
+  uint8_t list[2 * SIM_CHAR_ENTRY_LEN];
+  gattMsgEvent_t *pMsg;
+  bStatus_t status;
+  uint8_t num;
+
+  if ((status = SimStack_attRequest(connHandle)) != SUCCESS)
+  {
+    return status;
+  }
+
+  num = SimStack_peerChars(pReq->startHandle, pReq->endHandle,
+                           (pReq->type.len == ATT_BT_UUID_SIZE) ?
+                           BUILD_UINT16(pReq->type.uuid[0], pReq->type.uuid[1]) : 0,
+                           list);
+
+  // Nothing found ends the procedure with the server's error
+  if (num == 0)
+  {
+    pMsg = SimStack_gattMsg(ATT_ERROR_RSP, SUCCESS);
+    pMsg->msg.errorRsp.reqOpcode = ATT_READ_BY_TYPE_REQ;
+    pMsg->msg.errorRsp.handle = pReq->startHandle;
+    pMsg->msg.errorRsp.errCode = ATT_ERR_ATTR_NOT_FOUND;
+    SimStack_attQueue(taskId, pMsg);
+
+    return SUCCESS;
+  }
+
+  pMsg = SimStack_gattMsg(ATT_READ_BY_TYPE_RSP, SUCCESS);
+  pMsg->msg.readByTypeRsp.numPairs = num;
+  pMsg->msg.readByTypeRsp.len = SIM_CHAR_ENTRY_LEN;
+  pMsg->msg.readByTypeRsp.dataLen = num * SIM_CHAR_ENTRY_LEN;
+  pMsg->msg.readByTypeRsp.pDataList = GATT_bm_alloc(connHandle, ATT_READ_BY_TYPE_RSP,
+                                                    num * SIM_CHAR_ENTRY_LEN, NULL);
+  memcpy(pMsg->msg.readByTypeRsp.pDataList, list, num * SIM_CHAR_ENTRY_LEN);
+  SimStack_attQueue(taskId, pMsg);
+
+  SimStack_attQueue(taskId, SimStack_gattMsg(ATT_READ_BY_TYPE_RSP, bleProcedureComplete));
+
+  return SUCCESS;
+}
+
+bStatus_t GATT_DiscAllChars(uint16_t connHandle, uint16_t startHandle,
+                            uint16_t endHandle, uint8_t taskId)
+{
+  uint8_t list[2 * SIM_CHAR_ENTRY_LEN];
+  gattMsgEvent_t *pMsg;
+  bStatus_t status;
+  uint8_t num;
+
+  if ((status = SimStack_attRequest(connHandle)) != SUCCESS)
+  {
+    return status;
+  }
+
+  num = SimStack_peerChars(startHandle, endHandle, 0, list);
+
+  if (num > 0)
+  {
+    pMsg = SimStack_gattMsg(ATT_READ_BY_TYPE_RSP, SUCCESS);
+    pMsg->msg.readByTypeRsp.numPairs = num;
+    pMsg->msg.readByTypeRsp.len = SIM_CHAR_ENTRY_LEN;
+    pMsg->msg.readByTypeRsp.dataLen = num * SIM_CHAR_ENTRY_LEN;
+    pMsg->msg.readByTypeRsp.pDataList = GATT_bm_alloc(connHandle, ATT_READ_BY_TYPE_RSP,
+                                                      num * SIM_CHAR_ENTRY_LEN, NULL);
+    memcpy(pMsg->msg.readByTypeRsp.pDataList, list, num * SIM_CHAR_ENTRY_LEN);
+    SimStack_attQueue(taskId, pMsg);
+  }
+
+  SimStack_attQueue(taskId, SimStack_gattMsg(ATT_READ_BY_TYPE_RSP, bleProcedureComplete));
+
+  return SUCCESS;
+}
+
+bStatus_t GATT_WriteCharValue(uint16_t connHandle, attWriteReq_t *pReq, uint8_t taskId)
+{
+  gattMsgEvent_t *pMsg;
+  bStatus_t status;
+  uint8_t errCode;
+
+  if ((status = SimStack_attRequest(connHandle)) != SUCCESS)
+  {
+    return status;
+  }
+
+  errCode = SimStack_peerWrite(pReq->handle, pReq->pValue, pReq->len);
+
+  // The stack owns the value once the request is accepted
+  GATT_bm_free((gattMsg_t *)pReq, ATT_WRITE_REQ);
+
+  if (errCode != 0)
+  {
+    pMsg = SimStack_gattMsg(ATT_ERROR_RSP, SUCCESS);
+    pMsg->msg.errorRsp.reqOpcode = ATT_WRITE_REQ;
+    pMsg->msg.errorRsp.handle = pReq->handle;
+    pMsg->msg.errorRsp.errCode = errCode;
+  }
+  else
+  {
+    pMsg = SimStack_gattMsg(ATT_WRITE_RSP, SUCCESS);
+  }
+  SimStack_attQueue(taskId, pMsg);
+
+  return SUCCESS;
+}
+
+bStatus_t GATT_WriteNoRsp(uint16_t connHandle, attWriteReq_t *pReq)
+{
+  if (linkState != SIM_LINK_CONNECTED || connHandle != SIM_CONN_HANDLE)
+  {
+    return bleNotConnected;
+  }
+
+  VOID SimStack_peerWrite(pReq->handle, pReq->pValue, pReq->len);
+
+  GATT_bm_free((gattMsg_t *)pReq, ATT_WRITE_CMD);
+
+  return SUCCESS;
+}
+
+bStatus_t GATT_Notification(uint16_t connHandle, attHandleValueNoti_t *pNoti,
+                            uint8_t authenticated)
+{
+  (void)connHandle;
+  (void)pNoti;
+  (void)authenticated;
+
+  // No hub is simulated
+  return bleNotConnected;
+}
+
+void *GATT_bm_alloc(uint16_t connHandle, uint8_t opcode, uint16_t size,
+                    uint16_t *pSizeAlloc)
+{
+  (void)connHandle;
+  (void)opcode;
+
+  if (pSizeAlloc != NULL)
+  {
+    *pSizeAlloc = size;
+  }
+
+  return ICall_malloc(size);
+}
+
+void GATT_bm_free(gattMsg_t *pMsg, uint8_t opcode)
+{
+  switch (opcode)
+  {
+    case ATT_FIND_BY_TYPE_VALUE_RSP:
+      ICall_free(pMsg->findByTypeValueRsp.pHandlesInfo);
+      pMsg->findByTypeValueRsp.pHandlesInfo = NULL;
+      break;
+
+    case ATT_READ_BY_TYPE_RSP:
+      ICall_free(pMsg->readByTypeRsp.pDataList);
+      pMsg->readByTypeRsp.pDataList = NULL;
+      break;
+
+    case ATT_READ_RSP:
+      ICall_free(pMsg->readRsp.pValue);
+      pMsg->readRsp.pValue = NULL;
+      break;
+
+    case ATT_WRITE_REQ:
+    case ATT_WRITE_CMD:
+      ICall_free(pMsg->writeReq.pValue);
+      pMsg->writeReq.pValue = NULL;
+      break;
+
+    case ATT_HANDLE_VALUE_NOTI:
+      ICall_free(pMsg->handleValueNoti.pValue);
+      pMsg->handleValueNoti.pValue = NULL;
+      break;
+
+    default:
+      break;
+  }
+}
+
+/*********************************************************************
+ * GATT server of the receiver, only used with a hub
+ */
+
+bStatus_t GATTServApp_AddService(uint32_t services)
+{
+  (void)services;
+  return SUCCESS;
+}
+
+bStatus_t GATTServApp_RegisterService(gattAttribute_t *pAttrs, uint16_t numAttrs,
+                                      uint8_t encKeySize,
+                                      CONST gattServiceCBs_t *pServiceCBs)
+{
+  (void)pAttrs;
+  (void)numAttrs;
+  (void)encKeySize;
+  (void)pServiceCBs;
+  return SUCCESS;
+}
+
+void GATTServApp_InitCharCfg(uint16_t connHandle, gattCharCfg_t *pCharCfgTbl)
+{
+  uint8_t i;
+
+  for (i = 0; i < linkDBNumConns; i++)
+  {
+    pCharCfgTbl[i].connHandle = connHandle;
+    pCharCfgTbl[i].value = 0;
+  }
+}
+
+uint16_t GATTServApp_ReadCharCfg(uint16_t connHandle, gattCharCfg_t *pCharCfgTbl)
+{
+  (void)connHandle;
+  (void)pCharCfgTbl;
+  return 0;
+}
+
+bStatus_t GATTServApp_ProcessCCCWriteReq(uint16_t connHandle, gattAttribute_t *pAttr,
+                                         uint8_t *pValue, uint16_t len,
+                                         uint16_t offset, uint16_t validCfg)
+{
+  (void)connHandle;
+  (void)pAttr;
+  (void)pValue;
+  (void)len;
+  (void)offset;
+  (void)validCfg;
+  return SUCCESS;
+}
+
+bStatus_t GGS_AddService(uint32_t services)
+{
+  (void)services;
+  return SUCCESS;
+}
+
+bStatus_t GGS_SetParameter(uint8_t param, uint8_t len, void *pValue)
+{
+  (void)param;
+  (void)len;
+  (void)pValue;
+  return SUCCESS;
+}
+
+uint8_t linkDB_NumConns(void)
+{
+  // Size of the link DB, like the stack's, not the number of live links
+  return SIM_MAX_CONNS;
+}
+
+uint8_t linkDB_Up(uint16_t connectionHandle)
+{
+  return linkState == SIM_LINK_CONNECTED && connectionHandle == SIM_CONN_HANDLE;
+}
+
+/*********************************************************************
+ * SNV, kept in memory for the run
+ */
+
+uint8_t osal_snv_read(uint8_t id, uint8_t len, void *pBuf)
+{
+  if (simNv[id].len != len)
+  {
+    return SIM_NV_OPER_FAILED;
+  }
+
+  memcpy(pBuf, simNv[id].data, len);
+
+  return SUCCESS;
+}
+
+uint8_t osal_snv_write(uint8_t id, uint8_t len, void *pBuf)
+{
+  simNv[id].len = len;
+  memcpy(simNv[id].data, pBuf, len);
+
+  return SUCCESS;
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      SimStack_hdr
+ *
+ * @brief   Header of an ICall_malloc block.
+ *
+ * @param   pMsg - block
+ *
+ * @return  header
+ */
+static SimMsgHdr *SimStack_hdr(void *pMsg)
+{
+  return (SimMsgHdr *)pMsg - 1;
+}
+
+/*********************************************************************
+ * @fn      SimStack_entity
+ *
+ * @brief   Entity registered by the running task.
+ *
+ * @return  entity, NULL if the task has none
+ */
+static SimEntity *SimStack_entity(void)
+{
+  void *pTask = SimRtos_task();
+  uint8_t i;
+
+  for (i = 0; i < simNumEntities; i++)
+  {
+    if (simEntities[i].pTask == pTask)
+    {
+      return &simEntities[i];
+    }
+  }
+
+  return NULL;
+}
+
+/*********************************************************************
+ * @fn      SimStack_gapMsg
+ *
+ * @brief   Allocate a GAP event message.
+ *
+ * @param   opcode - GAP event
+ * @param   status - header status
+ * @param   size   - size of the event structure and its data
+ *
+ * @return  message, hdr and opcode set
+ */
+static void *SimStack_gapMsg(uint8_t opcode, uint8_t status, size_t size)
+{
+  gapEventHdr_t *pEvt = ICall_malloc(size);
+
+  pEvt->hdr.event = GAP_MSG_EVENT;
+  pEvt->hdr.status = status;
+  pEvt->opcode = opcode;
+
+  return pEvt;
+}
+
+/*********************************************************************
+ * @fn      SimStack_gattMsg
+ *
+ * @brief   Allocate a GATT message of the tag link.
+ *
+ * @param   method - ATT method
+ * @param   status - header status
+ *
+ * @return  message
+ */
+static gattMsgEvent_t *SimStack_gattMsg(uint8_t method, uint8_t status)
+{
+  gattMsgEvent_t *pMsg = ICall_malloc(sizeof(gattMsgEvent_t));
+
+  pMsg->hdr.event = GATT_MSG_EVENT;
+  pMsg->hdr.status = status;
+  pMsg->connHandle = SIM_CONN_HANDLE;
+  pMsg->method = method;
+
+  return pMsg;
+}
+
+/*********************************************************************
+ * @fn      SimStack_attQueue
+ *
+ * @brief   Hold a GATT message until the next connection event.
+ *
+ * @param   dest - entity to deliver it to
+ * @param   pMsg - message
+ *
+ * @return  none
+ */
+static void SimStack_attQueue(ICall_EntityID dest, gattMsgEvent_t *pMsg)
+{
+  SimMsgHdr *pHdr = SimStack_hdr(pMsg);
+
+  pHdr->h.dest = dest;
+  Queue_put(Queue_handle(&attRspQueue), &pHdr->h.elem);
+}
+
+/*********************************************************************
+ * @fn      SimStack_attRequest
+ *
+ * @brief   Start an ATT request on the tag link.
+ *
+ * @param   connHandle - link
+ *
+ * @return  SUCCESS, bleNotConnected, or blePending while a request is
+ *          outstanding
+ */
+static bStatus_t SimStack_attRequest(uint16_t connHandle)
+{
+  if (linkState != SIM_LINK_CONNECTED || connHandle != SIM_CONN_HANDLE)
+  {
+    return bleNotConnected;
+  }
+
+  if (attBusy)
+  {
+    return blePending;
+  }
+
+  attBusy = TRUE;
+
+  return SUCCESS;
+}
+
+/*********************************************************************
+ * @fn      SimStack_peerWrite
+ *
+ * @brief   Write to the sender's GATT server.
+ *
+ * @param   handle - attribute
+ * @param   pValue - value
+ * @param   len    - length of the value
+ *
+ * @return  0 or the ATT error code
+ */
+static uint8_t SimStack_peerWrite(uint16_t handle, const uint8_t *pValue, uint16_t len)
+{
+  if (!linkTag->aoa)
+  {
+    return ATT_ERR_INVALID_HANDLE;
+  }
+
+  if (handle == SIM_PEER_START_VALUE)
+  {
+    if (len < 1)
+    {
+      return ATT_ERR_INVALID_VALUE_SIZE;
+    }
+
+    // Legacy start: AoA packets on the advertising channels
+    peerSenderActive = (pValue[0] != 0);
+    memset(peerChannelMap, 0, sizeof(peerChannelMap));
+    peerChannelMap[37 / 8] |= 1 << (37 % 8);
+    peerChannelMap[38 / 8] |= 1 << (38 % 8);
+    peerChannelMap[39 / 8] |= 1 << (39 % 8);
+  }
+  else if (handle == SIM_PEER_CTRL_VALUE && !linkTag->legacy)
+  {
+    if (len != SIM_PEER_CTRL_LEN)
+    {
+      return ATT_ERR_INVALID_VALUE_SIZE;
+    }
+
+    peerSenderActive = (pValue[0] == SIM_PEER_CTRL_START);
+    memcpy(peerChannelMap, &pValue[2], sizeof(peerChannelMap));
+  }
+  else
+  {
+    return ATT_ERR_INVALID_HANDLE;
+  }
+
+  SimIo_log("sender %s", peerSenderActive ? "started" : "stopped");
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      SimStack_peerChars
+ *
+ * @brief   Characteristic declarations of the sender in a handle range.
+ *
+ * @param   start - first handle
+ * @param   end   - last handle
+ * @param   uuid  - characteristic UUID, 0 for all
+ * @param   pList - filled with SIM_CHAR_ENTRY_LEN byte entries
+ *
+ * @return  number of entries
+ */
+static uint8_t SimStack_peerChars(uint16_t start, uint16_t end, uint16_t uuid,
+                                  uint8_t *pList)
+{
+  static const struct
+  {
+    uint16_t decl;
+    uint8_t  props;
+    uint16_t value;
+    uint16_t uuid;
+  } chars[] =
+  {
+    { SIM_PEER_START_DECL, GATT_PROP_READ | GATT_PROP_WRITE,
+      SIM_PEER_START_VALUE, SIM_PEER_START_UUID },
+    { SIM_PEER_CTRL_DECL, GATT_PROP_WRITE | GATT_PROP_WRITE_NO_RSP,
+      SIM_PEER_CTRL_VALUE, SIM_PEER_CTRL_UUID },
+  };
+  uint8_t num = 0;
+  uint8_t i;
+
+  if (!linkTag->aoa)
+  {
+    return 0;
+  }
+
+  for (i = 0; i < sizeof(chars) / sizeof(chars[0]); i++)
+  {
+    if ((i == 1 && linkTag->legacy) ||
+        chars[i].decl < start || chars[i].value > end ||
+        (uuid != 0 && chars[i].uuid != uuid))
+    {
+      continue;
+    }
+
+    pList[0] = LO_UINT16(chars[i].decl);
+    pList[1] = HI_UINT16(chars[i].decl);
+    pList[2] = chars[i].props;
+    pList[3] = LO_UINT16(chars[i].value);
+    pList[4] = HI_UINT16(chars[i].value);
+    pList[5] = LO_UINT16(chars[i].uuid);
+    pList[6] = HI_UINT16(chars[i].uuid);
+    pList += SIM_CHAR_ENTRY_LEN;
+    num++;
+  }
+
+  return num;
+}
+
+/*********************************************************************
+ * @fn      SimStack_initDoneHandler
+ *
+ * @brief   GAP_DeviceInit is done.
+ *
+ * @param   a0 - not used
+ *
+ * @return  none
+ */
+static void SimStack_initDoneHandler(UArg a0)
+{
+  static const uint8_t ownAddr[B_ADDR_LEN] = { 0x01, 0x00, 0x00, 0xA0, 0xA0, 0xA0 };
+  gapDeviceInitDoneEvent_t *pEvt;
+
+  (void)a0;
+
+  pEvt = SimStack_gapMsg(GAP_DEVICE_INIT_DONE_EVENT, SUCCESS,
+                         sizeof(gapDeviceInitDoneEvent_t));
+  memcpy(pEvt->devAddr, ownAddr, B_ADDR_LEN);
+  pEvt->dataPktLen = gapDataPktLen;
+  pEvt->numDataPkts = 4;
+
+  SimICall_send(gapEntity, pEvt);
+}
+
+/*********************************************************************
+ * @fn      SimStack_discTickHandler
+ *
+ * @brief   Report the tags heard since the last tick, once per
+ *          discovery as the stack filters duplicates.
+ *
+ * @param   a0 - not used
+ *
+ * @return  none
+ */
+static void SimStack_discTickHandler(UArg a0)
+{
+  uint8_t i;
+
+  (void)a0;
+
+  for (i = 0; i < SIM_MAX_TAGS; i++)
+  {
+    SimTag *pTag = SimWorld_tag(i);
+    gapDeviceInfoEvent_t *pEvt;
+    uint8_t *pData;
+    uint8_t len;
+
+    if (pTag == NULL || !pTag->present || discReported[i] ||
+        SimRtos_now() < discNextAdv[i])
+    {
+      continue;
+    }
+
+    len = pTag->aoa ? 7 : 3;
+    pEvt = SimStack_gapMsg(GAP_DEVICE_INFO_EVENT, SUCCESS,
+                           sizeof(gapDeviceInfoEvent_t) + len);
+    pEvt->eventType = GAP_ADRPT_ADV_IND;
+    pEvt->addrType = pTag->addrType;
+    memcpy(pEvt->addr, pTag->addr, B_ADDR_LEN);
+    pEvt->rssi = pTag->rssi;
+    pEvt->dataLen = len;
+    pEvt->pEvtData = pData = (uint8_t *)(pEvt + 1);
+
+    pData[0] = 2;
+    pData[1] = GAP_ADTYPE_FLAGS;
+    pData[2] = GAP_ADTYPE_FLAGS_GENERAL | GAP_ADTYPE_FLAGS_BREDR_NOT_SUPPORTED;
+    if (pTag->aoa)
+    {
+      pData[3] = 3;
+      pData[4] = GAP_ADTYPE_16BIT_COMPLETE;
+      pData[5] = LO_UINT16(SIM_PEER_SVC_UUID);
+      pData[6] = HI_UINT16(SIM_PEER_SVC_UUID);
+    }
+
+    discReported[i] = TRUE;
+    SimICall_send(discEntity, pEvt);
+  }
+}
+
+/*********************************************************************
+ * @fn      SimStack_discEndHandler
+ *
+ * @brief   The discovery duration is over.
+ *
+ * @param   a0 - not used
+ *
+ * @return  none
+ */
+static void SimStack_discEndHandler(UArg a0)
+{
+  (void)a0;
+
+  SimStack_discEnd(SUCCESS);
+}
+
+/*********************************************************************
+ * @fn      SimStack_discEnd
+ *
+ * @brief   End the discovery with the list of the tags reported.
+ *
+ * @param   status - SUCCESS, or canceled
+ *
+ * @return  none
+ */
+static void SimStack_discEnd(uint8_t status)
+{
+  gapDevDiscEvent_t *pEvt;
+  uint8_t numDevs = 0;
+  uint8_t i;
+
+  Clock_stop(Clock_handle(&discTickClock));
+  Clock_stop(Clock_handle(&discEndClock));
+  discActive = FALSE;
+
+  for (i = 0; i < SIM_MAX_TAGS; i++)
+  {
+    numDevs += discReported[i];
+  }
+
+  pEvt = SimStack_gapMsg(GAP_DEVICE_DISCOVERY_EVENT, status,
+                         sizeof(gapDevDiscEvent_t) + numDevs * sizeof(gapDevRec_t));
+  pEvt->numDevs = numDevs;
+  pEvt->pDevList = (gapDevRec_t *)(pEvt + 1);
+
+  for (i = 0, numDevs = 0; i < SIM_MAX_TAGS; i++)
+  {
+    if (discReported[i])
+    {
+      SimTag *pTag = SimWorld_tag(i);
+
+      pEvt->pDevList[numDevs].eventType = GAP_ADRPT_ADV_IND;
+      pEvt->pDevList[numDevs].addrType = pTag->addrType;
+      memcpy(pEvt->pDevList[numDevs].addr, pTag->addr, B_ADDR_LEN);
+      numDevs++;
+    }
+  }
+
+  SimICall_send(discEntity, pEvt);
+}
+
+/*********************************************************************
+ * @fn      SimStack_estHandler
+ *
+ * @brief   Connection attempt: the link comes up once the tag is
+ *          heard.
+ *
+ * @param   a0 - not used
+ *
+ * @return  none
+ */
+static void SimStack_estHandler(UArg a0)
+{
+  gapEstLinkReqEvent_t *pEvt;
+  SimTag *pTag = SimWorld_find(linkAddr);
+
+  (void)a0;
+
+  if (pTag == NULL || !pTag->present)
+  {
+    return;
+  }
+
+  Clock_stop(Clock_handle(&linkEstClock));
+
+  linkState = SIM_LINK_CONNECTED;
+  linkTag = pTag;
+  linkInterval = GAP_GetParamValue(TGAP_CONN_EST_INT_MIN);
+  linkLatency = GAP_GetParamValue(TGAP_CONN_EST_LATENCY);
+  linkTimeout = GAP_GetParamValue(TGAP_CONN_EST_SUPERV_TIMEOUT);
+  linkEventCounter = 0;
+  linkLastHeard = SimRtos_now();
+  linkUpdatePending = FALSE;
+  attMtu = ATT_MTU_SIZE;
+  attBusy = FALSE;
+  peerSenderActive = FALSE;
+
+  Clock_setTimeout(Clock_handle(&linkEvtClock), SIM_CONN_UNITS_TICKS(linkInterval));
+  Clock_setPeriod(Clock_handle(&linkEvtClock), SIM_CONN_UNITS_TICKS(linkInterval));
+  Clock_start(Clock_handle(&linkEvtClock));
+
+  pEvt = SimStack_gapMsg(GAP_LINK_ESTABLISHED_EVENT, SUCCESS,
+                         sizeof(gapEstLinkReqEvent_t));
+  pEvt->devAddrType = pTag->addrType;
+  memcpy(pEvt->devAddr, pTag->addr, B_ADDR_LEN);
+  pEvt->connectionHandle = SIM_CONN_HANDLE;
+  pEvt->connRole = GAP_PROFILE_CENTRAL;
+  pEvt->connInterval = linkInterval;
+  pEvt->connLatency = linkLatency;
+  pEvt->connTimeout = linkTimeout;
+  pEvt->clockAccuracy = 0;
+
+  SimIo_log("link up, interval %u", linkInterval);
+
+  SimICall_send(linkEntity, pEvt);
+}
+
+/*********************************************************************
+ * @fn      SimStack_connEvtHandler
+ *
+ * @brief   Connection event of the tag link: ends a pending
+ *          termination, applies a parameter update at its instant,
+ *          delivers the ATT responses and reports the event.
+ *
+ * @param   a0 - not used
+ *
+ * @return  none
+ */
+static void SimStack_connEvtHandler(UArg a0)
+{
+  bool heard = linkTag->present;
+
+  (void)a0;
+
+  linkEventCounter++;
+
+  if (linkState == SIM_LINK_TERMINATING)
+  {
+    SimStack_linkTerminated(SIM_HCI_TERMINATED_BY_LOCAL_HOST);
+    return;
+  }
+
+  if (heard)
+  {
+    linkLastHeard = SimRtos_now();
+  }
+  else if (SimRtos_now() - linkLastHeard >= (uint64_t)linkTimeout * 10000)
+  {
+    SimStack_linkTerminated(SIM_HCI_CONNECTION_TIMEOUT);
+    return;
+  }
+
+  if (linkUpdatePending && --linkUpdateCountdown == 0)
+  {
+    gapLinkUpdateEvent_t *pEvt;
+
+    linkUpdatePending = FALSE;
+    linkInterval = linkUpdateReq.intervalMin;
+    linkLatency = linkUpdateReq.connLatency;
+    linkTimeout = linkUpdateReq.connTimeout;
+
+    Clock_setTimeout(Clock_handle(&linkEvtClock), SIM_CONN_UNITS_TICKS(linkInterval));
+    Clock_setPeriod(Clock_handle(&linkEvtClock), SIM_CONN_UNITS_TICKS(linkInterval));
+    Clock_start(Clock_handle(&linkEvtClock));
+
+    pEvt = SimStack_gapMsg(GAP_LINK_PARAM_UPDATE_EVENT, SUCCESS,
+                           sizeof(gapLinkUpdateEvent_t));
+    pEvt->status = SUCCESS;
+    pEvt->connectionHandle = SIM_CONN_HANDLE;
+    pEvt->connInterval = linkInterval;
+    pEvt->connLatency = linkLatency;
+    pEvt->connTimeout = linkTimeout;
+
+    SimIo_log("link interval %u", linkInterval);
+
+    SimICall_send(gapEntity, pEvt);
+  }
+
+  // The responses to the requests of the last event
+  if (heard && !Queue_empty(Queue_handle(&attRspQueue)))
+  {
+    while (!Queue_empty(Queue_handle(&attRspQueue)))
+    {
+      SimMsgHdr *pHdr = Queue_get(Queue_handle(&attRspQueue));
+
+      SimICall_send(pHdr->h.dest, pHdr + 1);
+    }
+    attBusy = FALSE;
+  }
+
+  if (linkEvtCb != NULL)
+  {
+    Gap_ConnEventRpt_t *pReport = ICall_malloc(sizeof(Gap_ConnEventRpt_t));
+
+    pReport->status = heard ? GAP_CONN_EVT_STAT_SUCCESS : GAP_CONN_EVT_STAT_MISSED;
+    pReport->handle = SIM_CONN_HANDLE;
+    pReport->channel = (linkEventCounter * 7) % 37;
+    pReport->lastRssi = heard ? linkTag->rssi : LL_RSSI_NOT_AVAILABLE;
+    pReport->eventCounter = linkEventCounter;
+    pReport->timeStamp = Clock_getTicks();
+
+    // The receiver frees the report
+    linkEvtCb(pReport);
+  }
+}
+
+/*********************************************************************
+ * @fn      SimStack_linkTerminated
+ *
+ * @brief   Take the tag link down and report it.
+ *
+ * @param   reason - HCI reason
+ *
+ * @return  none
+ */
+static void SimStack_linkTerminated(uint8_t reason)
+{
+  gapTerminateLinkEvent_t *pEvt;
+
+  Clock_stop(Clock_handle(&linkEvtClock));
+
+  linkState = SIM_LINK_IDLE;
+  linkTag = NULL;
+  linkUpdatePending = FALSE;
+  attBusy = FALSE;
+  peerSenderActive = FALSE;
+
+  // Responses never sent
+  while (!Queue_empty(Queue_handle(&attRspQueue)))
+  {
+    SimMsgHdr *pHdr = Queue_get(Queue_handle(&attRspQueue));
+    gattMsgEvent_t *pMsg = (gattMsgEvent_t *)(pHdr + 1);
+
+    GATT_bm_free(&pMsg->msg, pMsg->method);
+    free(pHdr);
+  }
+
+  pEvt = SimStack_gapMsg(GAP_LINK_TERMINATED_EVENT, SUCCESS,
+                         sizeof(gapTerminateLinkEvent_t));
+  pEvt->connectionHandle = SIM_CONN_HANDLE;
+  pEvt->reason = reason;
+
+  SimIo_log("link down, reason 0x%02x", reason);
+
+  SimICall_send(gapEntity, pEvt);
+}
+
+/*********************************************************************
+*********************************************************************/